@@ -4,6 +4,11 @@ Simple interface to the Globus GridFTP client API.
 import sys
 import exceptions
 import types
+import collections
+import array
+import struct
+import threading
+import time
 import gridftpwrapper
 
 class GridFTPClientException(exceptions.Exception):
@@ -87,6 +92,35 @@ class HandleAttr(object):
             ex = GridFTPClientException(msg)
             raise ex
 
+    def set_pipeline(self, outstanding = 16):
+        """
+        Turn on command pipelining for clients created from this
+        attribute set.
+
+        With pipelining the commands for the next transfers are sent
+        on the session before the current one completes, so a list of
+        small files is not paid for with a control channel round trip
+        per file. Use FTPClient.third_party_transfer_pipelined() on a
+        client created from this attribute set. The servers must
+        support pipelining.
+
+        @param outstanding: the largest number of transfers to have
+        commands in flight at once
+        @type outstanding: integer
+
+        @rtype: None
+        @return: None
+
+        @raise GridFTPClientException: raised if unable to
+        set pipelining for the handle attribute.
+        """
+        try:
+            gridftpwrapper.gridftp_handleattr_set_pipeline(self._attr, outstanding)
+        except Exception, e:
+            msg = "Unable to set pipeline for handle attr: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
 class OperationAttr(object):
     """
     A wrapping of the Globus GridFTP API globus_ftp_client_operationattr_t.
@@ -429,13 +463,25 @@ class TcpBuffer(object):
 class Buffer(object):
     """
     A wrapping of the Globus API globus_byte_t.
+
+    The memory comes from the wrapper's buffer pool: it is page aligned,
+    rounded up to the pool's size class and returned to the pool for
+    reuse by destroy().
     """
-    def __init__(self, size):
+    def __init__(self, size, zero = True):
         """
         Constructs an instance. A wrapped pointer to the Globus C type
         that is created is stored as the ._buffer attribute to the 
         instance.
 
+        @param size: the size of the buffer in bytes
+        @type size: integer
+
+        @param zero: set the contents of the buffer to zero; pass False
+        when the buffer is only read into, since zeroing a large buffer
+        that Globus overwrites anyway is wasted work
+        @type zero: boolean
+
         @rtype: instance
         @return: an instance of the class
 
@@ -445,7 +491,7 @@ class Buffer(object):
         self._buffer = None
 
         try:
-            self._buffer = gridftpwrapper.gridftp_create_buffer(size)
+            self._buffer = gridftpwrapper.gridftp_create_buffer(size, int(bool(zero)))
         except Exception, e:
             msg = "Unable to create buffer: %s" % e
             ex = GridFTPClientException(msg)
@@ -496,6 +542,59 @@ class Buffer(object):
                 
             return self.string    
 
+def buffer_pool_configure(hugepages = False, max_idle = 16):
+    """
+    Set the options of the buffer pool used by Buffer and by the
+    wrapper's own transfer buffers.
+
+    @param hugepages: back large buffers with huge pages when the system
+    has them configured, falling back to transparent huge pages
+    @type hugepages: boolean
+
+    @param max_idle: the number of freed buffers of each size class the
+    pool keeps for reuse; further buffers are returned to the system
+    @type max_idle: integer
+
+    @return: None
+    @rtype: None
+
+    @raise GridFTPClientException: raised if unable to configure the pool
+    """
+    try:
+        gridftpwrapper.gridftp_buffer_pool_configure(int(bool(hugepages)), max_idle)
+    except Exception, e:
+        msg = "Unable to configure buffer pool: %s" % e
+        ex = GridFTPClientException(msg)
+        raise ex
+
+def buffer_pool_trim():
+    """
+    Return all idle buffers held by the buffer pool to the system.
+
+    @return: None
+    @rtype: None
+    """
+    gridftpwrapper.gridftp_buffer_pool_trim()
+
+def buffer_pool_stats():
+    """
+    Return statistics for each size class of the buffer pool that has
+    been used.
+
+    Each entry is a dictionary with the keys:
+        - size: the size in bytes of buffers in the class
+        - used: the number of buffers currently handed out
+        - idle: the number of freed buffers kept for reuse
+        - hits: the number of allocations served from idle buffers
+        - misses: the number of allocations that needed new memory
+        - hugepage_misses: the number of misses that were given huge
+          page memory rather than normal pages
+
+    @return: the statistics, one dictionary per size class
+    @rtype: list
+    """
+    return gridftpwrapper.gridftp_buffer_pool_stats()
+
 class PerformanceMarkerPlugin(object):
     """
     A wrapping of the Globus GridFTP API globus_ftp_client_plugin_t for use
@@ -565,7 +664,7 @@ class PerformanceMarkerPlugin(object):
         self._callback = None
 
         try:
-            self._plugin, self._callback = gridftpwrapper.gridftp_perf_plugin_init(beginCB, markerCB, completeCB, arg)
+            self._plugin, self._callback = gridftpwrapper.gridftp_perf_plugin_init(_callback_object(beginCB), _callback_object(markerCB), _callback_object(completeCB), arg)
         except Exception, e:
             msg = "Unable to initialize perf plugin: %s" % e
             ex = GridFTPClientException(msg)
@@ -593,798 +692,4833 @@ class PerformanceMarkerPlugin(object):
                 ex = GridFTPClientException(msg)
 
 
-class FTPClient(object):
-    """
-    A class to wrap the GridFTP client functions
+class RestartMarker(object):
     """
+    A wrapping of the Globus GridFTP API globus_ftp_client_restart_marker_t.
 
-    def __init__(self, handleAttr):
+    A restart marker records which byte ranges of a file have already
+    been transferred. Passing it to get, get_to_file, put or
+    third_party_transfer makes the transfer skip those ranges, so a
+    failed transfer can be retried without re-sending what arrived.
+    """
+    def __init__(self, marker = None):
         """
-        Constructs an instance. A wrapped pointer to the Globus C type 
-        globus_ftp_client_handle_t is stored in the ._handle attribute.
+        Constructs an instance. A wrapped pointer to the Globus C type
+        that is created is stored as the ._marker attribute to the 
+        instance; it is freed once the instance and every transfer and
+        plugin using it are gone.
 
-        @param handleAttr: instance of the HandleAttr class
-        @type handleAttr: instance of HandleAttr class
+        @param marker: the string form of a marker, as returned by
+        str() on a RestartMarker, or None for an empty marker
+        @type marker: string
 
-        @return: an instance of class GridFTPClient
-        @rtype: instance of class GridFTPClient
+        @rtype: instance
+        @return: an instance of the class
 
-        @raise GridFTPClientException:  thrown if unable to init the module
-        or open the connection to the server.
+        @raise GridFTPClientException: raised if unable to initialize
+        the Globus C type
         """
+        self._marker = None
 
-        self._handleAttr = handleAttr
-        self._handle = None
-
-        # create a handle for this client
         try:
-            self._handle = gridftpwrapper.gridftp_handle_init(self._handleAttr._attr)
+            self._marker = gridftpwrapper.gridftp_restart_marker_init(marker)
         except Exception, e:
-            msg = "Unable to create a handle: %s" % e
+            msg = "Unable to initialize a restart marker: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
     def destroy(self):
         """
-        Destroys an instance. The wrapped pointer to the Globus C type is
-        used by globus_free() to free all the memory associated with the C
-        type.
+        Drop the reference the instance holds to the Globus C type. A
+        get_to_file or a RestartMarkerPlugin still updating the marker
+        keeps it until it is done with it.
 
-        @return: None
         @rtype: None
-        
-        @raise GridFTPClientException: thrown if unable to destroy the
-        instance
+        @return: None
         """
+        self._marker = None
 
-        if self._handle:
-            try: 
-                gridftpwrapper.gridftp_handle_destroy(self._handle)
-            except Exception, e:
-                msg = "Unable to destroy client handle: %s" % e
-                ex = GridFTPClientException(msg)
-                raise ex
+    def __str__(self):
+        """
+        Return the string form of the marker, from which an equal marker
+        can be created later, possibly by another process.
 
-    def add_plugin(self, plugin):
+        @rtype: string
+        @return: the marker as a string
         """
-        Add a plugin to the handle associated with this instance.
+        try:
+            return gridftpwrapper.gridftp_restart_marker_to_string(self._marker)
+        except Exception, e:
+            msg = "Unable to convert restart marker to string: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        @param plugin: an instance of a plugin class, currently only the
-        PerformanceMarkerPlugin class is supported
-        @type plugin: instance of PerformanceMarkerPlugin
+    def insert_range(self, offset, end):
+        """
+        Record the bytes from offset up to, but not including, end as
+        transferred, for example from the offset and length given to a
+        register_read data callback.
+
+        @param offset: the offset of the first byte of the range
+        @type offset: integer
+
+        @param end: the offset one past the last byte of the range
+        @type end: integer
 
-        @return: None
         @rtype: None
+        @return: None
 
-        @raise GridFTPClientException: thrown if unable to add the plugin
-        to the handle
+        @raise GridFTPClientException: raised if unable to insert the
+        range
         """
-        if self._handle:
-            try:
-                gridftpwrapper.gridftp_handle_add_plugin(self._handle, plugin._plugin)
-            except Exception, e:
-                msg = "Unable to add plugin: %s" % e
-                ex = GridFTPClientException(msg)
-                raise ex
+        try:
+            gridftpwrapper.gridftp_restart_marker_insert_range(self._marker, offset, end)
+        except Exception, e:
+            msg = "Unable to insert range into restart marker: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-    def remove_plugin(self, plugin):
+    def total(self):
         """
-        Remove a plugin from the handle associated with this instance. The
-        plugin must have already been added using the add_plugin() method.
+        Return the number of bytes the marker records as transferred.
+
+        @rtype: integer
+        @return: the number of bytes
+        """
+        try:
+            return gridftpwrapper.gridftp_restart_marker_get_total(self._marker)
+        except Exception, e:
+            msg = "Unable to get total from restart marker: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        @param plugin: an instance of a plugin class, currently only the
-        PerformanceMarkerPlugin class is supported
-        @type plugin: instance of PerformanceMarkerPlugin
+class RestartMarkerPlugin(object):
+    """
+    A wrapping of the Globus GridFTP restart marker plugin.
+
+    Once added to an FTPClient with add_plugin(), the plugin keeps a
+    RestartMarker up to date with the restart markers the server sends
+    during third party transfers and puts. If the transfer fails, pass
+    the marker to the retry so only the missing ranges are sent.
+    """
+    def __init__(self, marker):
+        """
+        Constructs an instance. Wrapped pointers to the Globus C type
+        and to the plugin state are stored as the ._plugin and
+        ._callback attributes to the instance.
+
+        @param marker: the marker to keep up to date
+        @type marker: instance of RestartMarker
+
+        @rtype: instance
+        @return: an instance of the class
+
+        @raise GridFTPClientException: raised if unable to initialize
+        the Globus C type
+        """
+        self._plugin = None
+        self._callback = None
+        self.marker = marker
+
+        try:
+            self._plugin, self._callback = gridftpwrapper.gridftp_restart_marker_plugin_init(marker._marker)
+        except Exception, e:
+            msg = "Unable to initialize restart marker plugin: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def destroy(self):
+        """
+        Destroy an instance. The marker is left as it is.
 
-        @return: None
         @rtype: None
+        @return: None
 
-        @raise GridFTPClientException: thrown if unable to remove the plugin
-        to the handle
+        @raise GridFTPClientException: raised if unable to free the
+        memory associated with the Globus C type
         """
-        if self._handle:
+        if self._plugin and self._callback:
             try:
-                gridftpwrapper.gridftp_handle_remove_plugin(self._handle, plugin._plugin)
+                gridftpwrapper.gridftp_restart_marker_plugin_destroy(self._plugin, self._callback)
+                self._plugin = None
+                self._callback = None
             except Exception, e:
-                msg = "Unable to remove plugin: %s" % e
+                msg = "Unable to destroy restart marker plugin: %s" % e
                 ex = GridFTPClientException(msg)
                 raise ex
 
-    def third_party_transfer(self, src, dst, completeCallback, arg, 
-                srcOpAttr = None, dstOpAttr = None, restartMarker = None):
+class StreamDigest(object):
+    """
+    A checksum computed by the wrapper on the data of a get as the data
+    arrives, so a download can be checked against the checksum reported
+    by the server (see FTPClient.cksm) without reading the file again.
+
+    Pass the instance as digest to get(), partial_get() or get_to_file(),
+    and for get() and partial_get() also to each register_read() or
+    register_read_ring() reading the data. The sum is taken in C before
+    the data reaches Python, and is finished when the get completes; its
+    complete callback is then given the hex digest as an extra, last
+    argument, None if the digest failed.
+
+    Blocks from parallel data channels arrive out of order. ADLER32 and
+    CRC32C sum each block as it arrives and combine the sums, so any
+    order costs nothing. MD5 must see the bytes in order, so blocks that
+    arrive early are copied and held until the gap before them fills;
+    the digest fails if more than maxPending bytes are held at once.
+    A digest also fails if its get fails or if the data does not cover
+    every byte from start on, for example when a get resumes from a
+    restart marker.
+    """
+    def __init__(self, algorithm = "ADLER32", start = 0, maxPending = 67108864):
         """
-        Initiate a third party transfer between to servers. This function
-        returns immediately.  When the transfer is completed or if the
-        transfer is aborted, the completeCallback function will be invoked with the
-        final status of the transfer.
+        Constructs an instance. A wrapped pointer to the C state is
+        stored as the ._digest attribute to the instance; it is freed
+        once the instance and every get using it are gone.
 
-        The completeCallback must have the form:
+        @param algorithm: MD5, ADLER32 or CRC32C
+        @type algorithm: string
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the transfer was
-              initiated
-            - handle is the wrapped pointer to the client handle
-            - error is None for success or a string if an error occurred
+        @param start: the offset in the file of the first byte summed,
+        the offset given to partial_get()
+        @type start: integer
 
-        @param src: the source URL for the transfer
-        @type src: string
+        @param maxPending: the most bytes held for an MD5 digest while
+        waiting for earlier data
+        @type maxPending: integer
 
-        @param dst: the destination URL for the transfer
-        @type dst: string
+        @rtype: instance
+        @return: an instance of the class
 
-        @param completeCallback: the function to call when the transfer is
-        complete
-        @type completeCallback: callable
+        @raise GridFTPClientException: raised if the algorithm is not
+        supported or the state cannot be created
+        """
+        self.algorithm = algorithm.upper()
+        self._digest = None
 
-        @param arg: user argument to pass to the completion callback 
-        @type arg: any
+        try:
+            self._digest = gridftpwrapper.gridftp_stream_digest_init(algorithm, start, maxPending)
+        except Exception, e:
+            msg = "Unable to initialize a stream digest: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        @param srcOpAttr: an instance of OperationAttr for the source
-        @type srcOpAttr: instance of OperationAttr
+    def result(self):
+        """
+        Return the outcome of the digest.
 
-        @param dstOpAttr: an instance of OperationAttr for the destination
-        @type dstOpAttr: instance of OperationAttr
+        @rtype: tuple
+        @return: (digest, nbytes, reason) where digest is the lower case
+        hex digest once the get has completed, or None, nbytes is the
+        number of bytes summed and reason is why the digest failed, or
+        None if it has not
+        """
+        try:
+            return gridftpwrapper.gridftp_stream_digest_result(self._digest)
+        except Exception, e:
+            msg = "Unable to get stream digest result: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        @param restartMarker: not currently supported, please pass in None
-        @type restartMarker: None
+    def update(self, offset, data):
+        """
+        Feed a block of the file to the digest, as a get does with the
+        data it reads, for data that arrives some other way. Blocks may
+        be fed in any order.
 
-        @return: None
-        @rtype: None
+        @param offset: the offset of the block in the file
+        @type offset: integer
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        third party transfer
-        """
+        @param data: the bytes of the block
+        @type data: string
 
-        if not srcOpAttr or not dstOpAttr:
-            msg = "Both a source and destination OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+        @rtype: None
+        @return: None
 
+        @raise GridFTPClientException: raised if the block cannot be fed
+        """
         try:
-            gridftpwrapper.gridftp_third_party_transfer(
-                self._handle,
-                src,
-                srcOpAttr._attr,
-                dst,
-                dstOpAttr._attr,
-                None,
-                completeCallback,
-                arg
-                )
+            gridftpwrapper.gridftp_stream_digest_update(self._digest, offset, data)
         except Exception, e:
-            msg = "Unable to initiate third party transfer: %s" % e
+            msg = "Unable to update stream digest: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
+    def finish(self):
+        """
+        Finish a digest fed with update(), as a get does when it
+        completes; the digest fails if the blocks fed leave a gap.
 
+        @rtype: None
+        @return: None
 
-    def get(self, url, completeCallback, arg, opAttr = None, marker = None):
+        @raise GridFTPClientException: raised if the digest cannot be
+        finished
         """
-        Get a file from an FTP server.
+        try:
+            gridftpwrapper.gridftp_stream_digest_finish(self._digest)
+        except Exception, e:
+            msg = "Unable to finish stream digest: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        This function starts a get file transfer from an FTP server. If
-        this function returns without exception then the user may immediately
-        begin calling register_read() to retrieve the data associated with this URL.
+    def hexdigest(self):
+        """
+        Return the hex digest, or None if the get has not completed or
+        the digest failed.
 
-        When all of the data associated with this URL is retrieved, and all
-        of the data callbacks have been called, or if the get request is
-        aborted, the completeCallback will be invoked with the final
-        status of the get.
+        @rtype: string
+        @return: the lower case hex digest
+        """
+        return self.result()[0]
 
-        The completeCallback function must have the form:
+    def matches(self, cksm):
+        """
+        Return True if the digest equals a checksum reported by a server
+        with the same algorithm. Case is ignored, as are the leading
+        zeros some servers leave off ADLER32 and CRC32C sums.
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the transfer was
-              initiated
-            - handle is the wrapped pointer to the client handle
-            - error is None for success or a string if an error occurred
+        @param cksm: the checksum reported by the server
+        @type cksm: string
 
-        @param url: the source URL to get
-        @type url: string
+        @rtype: boolean
+        @return: True if the digest is finished and equal to cksm
+        """
+        return _cksm_equal(self.algorithm, self.hexdigest(), cksm)
 
-        @param completeCallback: function to call when the transfer is
-        complete
-        @type completeCallback: callable
+    def destroy(self):
+        """
+        Drop the reference the instance holds to the C state. Gets still
+        using the digest keep it until they complete.
 
-        @param arg: user argument to pass to the callback
-        @type arg: any
+        @rtype: None
+        @return: None
+        """
+        self._digest = None
 
-        @param opAttr: an instance of OperationAttr for the transfer
-        @type opAttr: instance of OperationAttr
+class CompletionQueue(object):
+    """
+    A queue that collects the completions of operations so they can be
+    handled in batches instead of one callback at a time.
+
+    An instance may be passed to any FTPClient method, or to
+    PerformanceMarkerPlugin, in place of a callback function. The
+    Globus threads then record the event in C without taking the Python
+    interpreter lock, and the events are picked up with drain(). With
+    many operations in flight this avoids every Globus thread contending
+    for the interpreter lock.
+
+    Each event is returned as a tuple (kind, args) where kind is one of
+    the COMPLETION_ constants below and args is the tuple of arguments
+    the callback function would have been called with, so that
+
+        for kind, args in queue.drain():
+            callbacks[kind](*args)
+
+    behaves like passing the callbacks directly. The user argument,
+    always args[0] except for cksm where it is args[1], identifies
+    the operation.
+
+    Buffers reported by register_read events stay valid until they are
+    registered again. A queue cannot be used with register_read_ring
+    since the ring re-registers its buffers as soon as its callback
+    returns. Events of a PerformanceMarkerPlugin refer to the argument
+    the plugin holds, so drain them before destroying the plugin.
+
+    The queue also has a file descriptor, returned by fileno(), that is
+    readable whenever events are waiting, so an instance can be handed
+    directly to select, poll or epoll and serviced with poll() from a
+    single threaded event loop:
+
+        r, w, x = select.select([queue, ...], [], [])
+        if queue in r:
+            for kind, args in queue.poll():
+                ...
+    """
 
-        @param marker: not currently supported, please pass in None
-        @type marker: None
+    THIRD_PARTY = gridftpwrapper.COMPLETION_THIRD_PARTY
+    CKSM = gridftpwrapper.COMPLETION_CKSM
+    MKDIR = gridftpwrapper.COMPLETION_MKDIR
+    RMDIR = gridftpwrapper.COMPLETION_RMDIR
+    DELETE = gridftpwrapper.COMPLETION_DELETE
+    MOVE = gridftpwrapper.COMPLETION_MOVE
+    CHMOD = gridftpwrapper.COMPLETION_CHMOD
+    GET = gridftpwrapper.COMPLETION_GET
+    GET_DATA = gridftpwrapper.COMPLETION_GET_DATA
+    PUT = gridftpwrapper.COMPLETION_PUT
+    PUT_DATA = gridftpwrapper.COMPLETION_PUT_DATA
+    GET_TO_FILE = gridftpwrapper.COMPLETION_GET_TO_FILE
+    EXISTS = gridftpwrapper.COMPLETION_EXISTS
+    PERF_BEGIN = gridftpwrapper.COMPLETION_PERF_BEGIN
+    PERF_MARKER = gridftpwrapper.COMPLETION_PERF_MARKER
+    PERF_COMPLETE = gridftpwrapper.COMPLETION_PERF_COMPLETE
+    STRIPED_GET = gridftpwrapper.COMPLETION_STRIPED_GET
+    PREWARM = gridftpwrapper.COMPLETION_PREWARM
+    PIPELINED = gridftpwrapper.COMPLETION_PIPELINED
+    TRANSFER = gridftpwrapper.COMPLETION_TRANSFER
+
+    # functions run on drained events before they are returned, keyed
+    # by (kind, id(arg)) to run once or by kind to run for every event
+    _once = None
+    _each = None
 
-        @return: None
-        @rtype: None
+    def __init__(self):
+        """
+        Constructs an instance. A wrapped pointer to the C queue is
+        stored as the ._queue attribute to the instance.
 
-        @raise GridFTPClientException: raised if unable to initaite the get
-        operation
+        @rtype: instance
+        @return: an instance of the class
 
+        @raise GridFTPClientException: raised if unable to create
+        the queue
         """
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
+        self._queue = None
+        self._hookLock = threading.Lock()
+        self._once = {}
+        self._each = {}
+
+        try:
+            self._queue = gridftpwrapper.gridftp_completion_queue_init()
+        except Exception, e:
+            msg = "Unable to create completion queue: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def drain(self, maxEvents = 0, timeout = None):
+        """
+        Return the events recorded so far, in the order they happened.
+
+        The interpreter lock is released while waiting.
+
+        @param maxEvents: the largest number of events to return, or 0
+        for all of the events recorded so far
+        @type maxEvents: integer
+
+        @param timeout: the number of seconds to wait for the first event
+        if none is ready; 0 returns at once and None waits forever
+        @type timeout: float
+
+        @return: the events as (kind, args) tuples, empty if the timeout
+        expired first
+        @rtype: list
+
+        @raise GridFTPClientException: raised if unable to drain
+        the queue
+        """
+        if timeout is None:
+            timeout = -1.0
+
+        try:
+            events = gridftpwrapper.gridftp_completion_queue_drain(self._queue, maxEvents, float(timeout))
+        except Exception, e:
+            msg = "Unable to drain completion queue: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if self._once or self._each:
+            self._run_hooks(events)
+
+        return events
+
+    def _after(self, kind, arg, function):
+        """
+        Call function(args) once, for the next event of a kind drained
+        with the user argument arg, before the event is returned.
+        """
+        self._hookLock.acquire()
+        try:
+            self._once.setdefault((kind, id(arg)), collections.deque()).append((arg, function))
+        finally:
+            self._hookLock.release()
+
+    def _after_each(self, kind, function):
+        """
+        Call function(args) for every event of a kind drained, before
+        the event is returned.
+        """
+        self._hookLock.acquire()
+        try:
+            self._each.setdefault(kind, []).append(function)
+        finally:
+            self._hookLock.release()
+
+    def _run_hooks(self, events):
+        """
+        Run the functions set up with _after and _after_each on a list
+        of drained events.
+        """
+        for kind, args in events:
+            if kind == self.CKSM:
+                key = (kind, id(args[1]))
+            else:
+                key = (kind, id(args[0]))
+
+            functions = list(self._each.get(kind, ()))
+            self._hookLock.acquire()
+            try:
+                pending = self._once.get(key)
+                if pending:
+                    functions.append(pending.popleft()[1])
+                    if not pending:
+                        del self._once[key]
+            finally:
+                self._hookLock.release()
+
+            for function in functions:
+                function(args)
+
+    def poll(self, maxEvents = 0):
+        """
+        Return the events recorded so far without waiting.
+
+        This is the call to make when fileno() polls readable.
+
+        @param maxEvents: the largest number of events to return, or 0
+        for all of the events recorded so far; if events are left over
+        the descriptor stays readable
+        @type maxEvents: integer
+
+        @return: the events as (kind, args) tuples, possibly empty
+        @rtype: list
+
+        @raise GridFTPClientException: raised if unable to drain
+        the queue
+        """
+        return self.drain(maxEvents, 0)
+
+    def fileno(self):
+        """
+        Return the file descriptor that is readable whenever the queue
+        has events waiting. The descriptor belongs to the queue and must
+        not be read or closed by the caller.
+
+        @return: the file descriptor
+        @rtype: integer
+        """
+        return gridftpwrapper.gridftp_completion_queue_fileno(self._queue)
+
+def _optional_marker(marker):
+    """
+    Return the wrapped C pointer of an optional RestartMarker, or None.
+    """
+    if marker is None:
+        return None
+    return marker._marker
+
+def _optional_digest(digest):
+    """
+    Return the wrapped C pointer of an optional StreamDigest, or None.
+    """
+    if digest is None:
+        return None
+    return digest._digest
+
+def _optional_attr(attr):
+    """
+    Return the wrapped C pointer of an optional attribute instance, or
+    None to have the wrapper use the default attributes.
+    """
+    if attr is None:
+        return None
+    return attr._attr
+
+def _call_soon(function, args):
+    """
+    Call function(*args) from a Globus thread, as the wrapper calls the
+    completion callbacks, rather than from the calling thread.
+    """
+    try:
+        gridftpwrapper.gridftp_callback_oneshot(function, tuple(args))
+    except Exception, e:
+        msg = "Unable to register callback: %s" % e
+        ex = GridFTPClientException(msg)
+        raise ex
+
+def _callback_object(callback):
+    """
+    Return the object to hand to the wrapper as a callback, which for a
+    CompletionQueue is the wrapped C queue.
+    """
+    if isinstance(callback, CompletionQueue):
+        return callback._queue
+    return callback
+
+ListingEntry = collections.namedtuple('ListingEntry', 'name size mtime type mode')
+
+class Listing(object):
+    """
+    A listing parsed in C from MLSD or MLST fact lines.
+
+    The entries are kept as columns: the names in one string, and the
+    size, modify time (seconds since the epoch, UTC) and UNIX.mode facts
+    as C longs. Indexing or iterating gives a ListingEntry per entry,
+    decoded from the columns on demand; the sizes, mtimes and modes
+    properties give whole columns as array('l') and types gives one
+    character per entry:
+
+        f   file
+        d   directory
+        c   the listed directory itself (cdir)
+        p   its parent directory (pdir)
+        l   symbolic link
+        o   anything else
+
+    A fact the server did not give is -1.
+
+        listing = client.machine_list_sync(url)
+        total = sum(listing.sizes)
+        dirs = [e.name for e in listing if e.type == 'd']
+    """
+
+    _LONG = struct.calcsize('l')
+
+    def __init__(self, columns):
+        """
+        Constructs an instance from the columns returned by the wrapper.
+
+        @param columns: (n, names, offsets, sizes, mtimes, modes, types)
+        @type columns: tuple
+
+        @rtype: instance
+        @return: an instance of the class
+        """
+        (self._n, self._names, self._offsets, self._sizes, self._mtimes,
+            self._modes, self.types) = columns
+        self._arrays = {}
+
+    def __len__(self):
+        return self._n
+
+    def _long(self, column, i):
+        return struct.unpack_from('l', column, i * self._LONG)[0]
+
+    def name(self, i):
+        """
+        Return the name of an entry.
+
+        @param i: index of the entry
+        @type i: integer
+
+        @rtype: string
+        """
+        if i < 0:
+            i += self._n
+        if i < 0 or i >= self._n:
+            raise IndexError("listing index out of range")
+        start = self._long(self._offsets, i)
+        return self._names[start:self._names.index('\0', start)]
+
+    def __getitem__(self, i):
+        name = self.name(i)
+        if i < 0:
+            i += self._n
+        return ListingEntry(
+            name,
+            self._long(self._sizes, i),
+            self._long(self._mtimes, i),
+            self.types[i],
+            self._long(self._modes, i)
+            )
+
+    def __iter__(self):
+        for i in xrange(self._n):
+            yield self[i]
+
+    def _column(self, key, raw):
+        column = self._arrays.get(key)
+        if column is None:
+            column = array.array('l')
+            column.fromstring(raw)
+            self._arrays[key] = column
+        return column
+
+    @property
+    def names(self):
+        """
+        The names of the entries, as a list of strings.
+        """
+        return self._names.split('\0')[:self._n]
+
+    @property
+    def sizes(self):
+        """
+        The size facts, as an array('l').
+        """
+        return self._column('sizes', self._sizes)
+
+    @property
+    def mtimes(self):
+        """
+        The modify facts in seconds since the epoch, as an array('l').
+        """
+        return self._column('mtimes', self._mtimes)
+
+    @property
+    def modes(self):
+        """
+        The UNIX.mode facts, as an array('l').
+        """
+        return self._column('modes', self._modes)
+
+    @classmethod
+    def parse(cls, data, skipDots = False, blocksize = 0):
+        """
+        Parse MLSD or MLST fact lines already read, for example saved
+        from an earlier listing, as a listing from the server is.
+
+        @param data: the fact lines
+        @type data: string
+
+        @param skipDots: leave out the cdir and pdir entries
+        @type skipDots: boolean
+
+        @param blocksize: feed the parser this many bytes at a time, as
+        the data would arrive from the server, or 0 for all at once
+        @type blocksize: integer
+
+        @return: the listing
+        @rtype: instance of Listing
+        """
+        try:
+            return cls(gridftpwrapper.gridftp_listing_parse(data, int(skipDots), blocksize))
+        except Exception, e:
+            msg = "Unable to parse listing: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+# checksum algorithms GridFTP servers commonly support, cheapest to
+# compute first
+CKSM_ALGORITHMS = ("ADLER32", "CRC32C", "CRC32", "MD5", "SHA1", "SHA256", "SHA512")
+
+# the algorithms tried by FTPClient.cksm_algorithms_sync when the server
+# does not list its own, those file_digests can also compute
+CKSM_PROBE_ALGORITHMS = ("ADLER32", "CRC32C", "MD5")
+
+def choose_cksm_algorithm(supported, accepted = None):
+    """
+    Pick the cheapest checksum algorithm a server supports that is
+    also accepted by the caller, for example as returned by
+    FTPClient.cksm_algorithms_sync for each end of a transfer.
+
+    @param supported: the algorithms the server supports
+    @type supported: sequence of strings
+
+    @param accepted: the algorithms acceptable to the caller, or None
+    for any of them
+    @type accepted: sequence of strings
+
+    @return: the algorithm, taken from supported, or None if the two
+    have none in common. Algorithms not in CKSM_ALGORITHMS come after
+    those that are, in the order given
+    @rtype: string
+    """
+    if accepted is not None:
+        accepted = set([a.upper() for a in accepted])
+
+    def cost(algorithm):
+        try:
+            return CKSM_ALGORITHMS.index(algorithm.upper())
+        except ValueError:
+            return len(CKSM_ALGORITHMS)
+
+    shared = [a for a in supported if accepted is None or a.upper() in accepted]
+    if not shared:
+        return None
+    # sorted() is stable, so unknown algorithms keep their order
+    return sorted(shared, key = cost)[0]
+
+def _cksm_equal(algorithm, digest, cksm):
+    """
+    Return True if two hex checksums of an algorithm are equal, ignoring
+    case and, for the 32 bit sums, the leading zeros some servers leave
+    off. A missing checksum equals nothing.
+    """
+    if not digest or not cksm:
+        return False
+
+    digest = digest.strip().lower()
+    cksm = cksm.strip().lower()
+    if algorithm.upper() not in ("ADLER32", "CRC32", "CRC32C"):
+        return digest == cksm
+
+    try:
+        return int(digest, 16) == int(cksm, 16)
+    except ValueError:
+        return False
+
+def _split_ranges(size, chunkSize):
+    """
+    Return the (offset, length) of each chunk of chunkSize bytes a file
+    of size bytes is cut into, the last one holding what is left.
+    """
+    return [(offset, min(chunkSize, size - offset)) for offset in xrange(0, size, chunkSize)]
+
+def _merge_ranges(ranges):
+    """
+    Return ordered (offset, length) ranges with each run of adjacent
+    ones merged into one.
+    """
+    merged = []
+    for offset, length in ranges:
+        if merged and merged[-1][0] + merged[-1][1] == offset:
+            merged[-1] = (merged[-1][0], merged[-1][1] + length)
+        else:
+            merged.append((offset, length))
+    return merged
+
+def file_digests(ranges, algorithm = "ADLER32", bufsize = 1048576):
+    """
+    Compute the checksums of byte ranges of local files with the
+    wrapper's native kernels, for comparing against the checksums a
+    server reports. The kernels use the vector instructions of the CPU
+    where it has them; MD5 ranges are hashed several at once, one per
+    vector lane, so pass many ranges in one call. The GIL is released
+    while hashing.
+
+    @param ranges: (path, offset, length) for each range, length -1 for
+    the rest of the file
+    @type ranges: sequence of tuples
+
+    @param algorithm: MD5, ADLER32 or CRC32C
+    @type algorithm: string
+
+    @param bufsize: the number of bytes read at a time from each file
+    @type bufsize: integer
+
+    @return: (digest, nbytes, error) for each range in order: the lower
+    case hex digest, or None with error a string if the file could not
+    be read, and the number of bytes summed, fewer than asked for if
+    the file is shorter
+    @rtype: list of tuples
+
+    @raise GridFTPClientException: raised if the algorithm is not
+    supported or a range is malformed
+    """
+    try:
+        return gridftpwrapper.gridftp_file_digests(algorithm,
+            [(path, offset, length) for path, offset, length in ranges], bufsize)
+    except Exception, e:
+        msg = "Unable to compute file digests: %s" % e
+        ex = GridFTPClientException(msg)
+        raise ex
+
+def file_digest(path, algorithm = "ADLER32", offset = 0, length = -1):
+    """
+    Compute the checksum of a local file, or of a range of it, with the
+    wrapper's native kernels; see file_digests.
+
+    @return: the lower case hex digest
+    @rtype: string
+
+    @raise GridFTPClientException: raised if the file cannot be read
+    """
+    digest, nbytes, error = file_digests([(path, offset, length)], algorithm)[0]
+    if error:
+        msg = "Unable to compute digest of %s: %s" % (path, error)
+        ex = GridFTPClientException(msg)
+        raise ex
+    return digest
+
+def cksm_kernels():
+    """
+    Return the checksum kernels picked for this CPU. CPU features named
+    in the comma separated GRIDFTP_CKSM_DISABLE environment variable,
+    any of avx2, ssse3 and sse4.2, are treated as missing, so slower
+    kernels can be checked; it is read once, on the first checksum.
+
+    @return: the kernel name for each of MD5, ADLER32 and CRC32C
+    @rtype: dictionary
+    """
+    return gridftpwrapper.gridftp_cksm_kernels()
+
+class MetadataCache(object):
+    """
+    A thread safe cache of the metadata of remote paths, keyed by URL.
+
+    A client given a cache with set_metadata_cache() answers exists,
+    cksm and mlst requests from it while the facts are fresh, instead of
+    paying a control channel round trip each time. A path found missing
+    is cached as well, for the shorter negativeTtl. The entries for a
+    path are dropped whenever the client makes, deletes, removes, moves,
+    changes the mode of or writes to that path, both when the operation
+    starts and when it completes, and a removed or moved directory drops
+    the entries below it too. The destinations of a TransferQueue over a
+    pool with a cache are dropped the same way.
+
+    One cache may be shared by any number of clients and pools, which is
+    what makes invalidation see every change made in the process; a
+    change made by another process is only seen once the entry expires.
+
+        cache = MetadataCache(ttl = 60, negativeTtl = 5)
+        client.set_metadata_cache(cache)
+        if not client.exists_sync(url):
+            ...
+
+    The facts cached per URL are 'exists', 'stat', the ListingEntry from
+    mlst_sync giving the size and modify time, and one 'cksm' per
+    algorithm and range.
+    """
+
+    def __init__(self, ttl = 60.0, negativeTtl = 10.0, maxEntries = 100000):
+        """
+        Constructs an instance.
+
+        @param ttl: the number of seconds a fact is kept, or 0 to cache
+        nothing but missing paths
+        @type ttl: float
+
+        @param negativeTtl: the number of seconds a missing path is
+        kept, or 0 not to cache missing paths
+        @type negativeTtl: float
+
+        @param maxEntries: the largest number of URLs kept; expired
+        entries are dropped when it is reached, and the whole cache if
+        none has expired
+        @type maxEntries: integer
+
+        @rtype: instance
+        @return: an instance of the class
+        """
+        self.ttl = ttl
+        self.negativeTtl = negativeTtl
+        self.maxEntries = maxEntries
+        self._lock = threading.Lock()
+        self._entries = {}
+        self._hits = 0
+        self._misses = 0
+
+    def get(self, url, fact):
+        """
+        Look a fact about a path up.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param fact: the name of the fact
+        @type fact: string
+
+        @return: a tuple (found, value), found being False if the fact
+        is not cached or has expired
+        @rtype: tuple
+        """
+        key = _metadata_key(url)
+        now = time.time()
+
+        self._lock.acquire()
+        try:
+            facts = self._entries.get(key)
+            if facts and fact in facts:
+                value, expires = facts[fact]
+                if expires > now:
+                    self._hits += 1
+                    return True, value
+                del facts[fact]
+                if not facts:
+                    del self._entries[key]
+            self._misses += 1
+            return False, None
+        finally:
+            self._lock.release()
+
+    def set(self, url, fact, value, negative = False):
+        """
+        Cache a fact about a path.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param fact: the name of the fact
+        @type fact: string
+
+        @param value: the value of the fact
+        @type value: any
+
+        @param negative: the fact records that the path is missing, and
+        is kept for negativeTtl rather than ttl
+        @type negative: boolean
+
+        @return: None
+        @rtype: None
+        """
+        if negative:
+            ttl = self.negativeTtl
+        else:
+            ttl = self.ttl
+        if ttl <= 0:
+            return
+
+        key = _metadata_key(url)
+        now = time.time()
+
+        self._lock.acquire()
+        try:
+            facts = self._entries.get(key)
+            if facts is None:
+                if len(self._entries) >= self.maxEntries:
+                    self._prune(now)
+                facts = self._entries[key] = {}
+            # a path found again is no longer missing, and one found
+            # missing has no other facts
+            if negative:
+                facts.clear()
+            elif fact != 'exists':
+                facts['exists'] = (True, now + ttl)
+            facts[fact] = (value, now + ttl)
+        finally:
+            self._lock.release()
+
+    def _prune(self, now):
+        """
+        Drop the expired entries, or all of them if none has expired.
+        The lock must be held.
+        """
+        for key, facts in self._entries.items():
+            for fact, (value, expires) in facts.items():
+                if expires <= now:
+                    del facts[fact]
+            if not facts:
+                del self._entries[key]
+
+        if len(self._entries) >= self.maxEntries:
+            self._entries.clear()
+
+    def invalidate(self, url, recursive = False):
+        """
+        Drop the facts cached about a path.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param recursive: drop the facts about the paths below it too
+        @type recursive: boolean
+
+        @return: the number of URLs dropped
+        @rtype: integer
+        """
+        key = _metadata_key(url)
+
+        self._lock.acquire()
+        try:
+            n = 0
+            if self._entries.pop(key, None) is not None:
+                n += 1
+            if recursive:
+                prefix = key.rstrip('/') + '/'
+                for other in self._entries.keys():
+                    if other.startswith(prefix):
+                        del self._entries[other]
+                        n += 1
+            return n
+        finally:
+            self._lock.release()
+
+    def clear(self):
+        """
+        Drop every cached fact.
+
+        @return: None
+        @rtype: None
+        """
+        self._lock.acquire()
+        try:
+            self._entries.clear()
+        finally:
+            self._lock.release()
+
+    def stats(self):
+        """
+        Return the number of URLs cached and of lookups answered and
+        missed.
+
+        @return: a dictionary with the entries, hits and misses
+        @rtype: dict
+        """
+        self._lock.acquire()
+        try:
+            return {
+                'entries' : len(self._entries),
+                'hits' : self._hits,
+                'misses' : self._misses
+                }
+        finally:
+            self._lock.release()
+
+def _cksm_fact(offset, length, algorithm):
+    """
+    Return the name a checksum of a range is cached under.
+    """
+    return "cksm:%s:%d:%d" % (algorithm.upper(), offset, length)
+
+def _server_root(url):
+    """
+    Return the URL of the root directory of the server of a URL.
+    """
+    scheme = url.find('://')
+    slash = url.find('/', scheme >= 0 and scheme + 3 or 0)
+    if slash < 0:
+        return url + '/'
+    return url[:slash + 1]
+
+# the port a URL of each scheme names when it gives none
+_DEFAULT_PORTS = {'gsiftp' : '2811', 'ftp' : '21', 'sshftp' : '22'}
+
+def _metadata_key(url):
+    """
+    Return the key a URL is cached under. Like the host keys of a
+    HandlePool the scheme and host are in lower case and the default
+    port is left out, whether given or not; repeated slashes in the path
+    are collapsed and trailing ones left out for any path but the root.
+    """
+    scheme = url.find('://')
+    if scheme < 0:
+        prefix = ''
+        path = url
+    else:
+        start = scheme + 3
+        end = start
+        while end < len(url) and url[end] not in '/?#':
+            end += 1
+
+        # any user information stays as it is
+        at = url.rfind('@', start, end)
+        host = url[max(at + 1, start):end]
+
+        # a literal IPv6 address is enclosed in brackets
+        port = ''
+        colon = host.find(':', max(host.find(']'), 0))
+        if colon >= 0:
+            host, port = host[:colon], host[colon + 1:]
+        name = url[:scheme].lower()
+        if port == _DEFAULT_PORTS.get(name):
+            port = ''
+
+        prefix = name + '://' + url[start:max(at + 1, start)] + host.lower()
+        if port:
+            prefix += ':' + port
+        path = url[end:] or '/'
+
+    while '//' in path:
+        path = path.replace('//', '/')
+    if len(path) > 1:
+        path = path.rstrip('/') or '/'
+    return prefix + path
+
+class FTPClient(object):
+    """
+    A class to wrap the GridFTP client functions
+    """
+
+    # the MetadataCache of the client, if any
+    _cache = None
+
+    def __init__(self, handleAttr):
+        """
+        Constructs an instance. A wrapped pointer to the Globus C type 
+        globus_ftp_client_handle_t is stored in the ._handle attribute.
+
+        @param handleAttr: instance of the HandleAttr class
+        @type handleAttr: instance of HandleAttr class
+
+        @return: an instance of class GridFTPClient
+        @rtype: instance of class GridFTPClient
+
+        @raise GridFTPClientException:  thrown if unable to init the module
+        or open the connection to the server.
+        """
+
+        self._handleAttr = handleAttr
+        self._handle = None
+        self._pool = None
+
+        # create a handle for this client
+        try:
+            self._handle = gridftpwrapper.gridftp_handle_init(self._handleAttr._attr)
+        except Exception, e:
+            msg = "Unable to create a handle: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def destroy(self):
+        """
+        Destroys an instance. The wrapped pointer to the Globus C type is
+        used by globus_free() to free all the memory associated with the C
+        type. A client leased from a HandlePool is released to the pool
+        instead.
+
+        @return: None
+        @rtype: None
+        
+        @raise GridFTPClientException: thrown if unable to destroy the
+        instance
+        """
+
+        # a client leased from a HandlePool goes back to the pool
+        if self._pool:
+            self._pool.release(self)
+            return
+
+        if self._handle:
+            try: 
+                gridftpwrapper.gridftp_handle_destroy(self._handle)
+            except Exception, e:
+                msg = "Unable to destroy client handle: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+
+    def add_plugin(self, plugin):
+        """
+        Add a plugin to the handle associated with this instance.
+
+        @param plugin: an instance of a plugin class, either
+        PerformanceMarkerPlugin or RestartMarkerPlugin
+        @type plugin: instance of PerformanceMarkerPlugin or RestartMarkerPlugin
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: thrown if unable to add the plugin
+        to the handle
+        """
+        if self._handle:
+            try:
+                gridftpwrapper.gridftp_handle_add_plugin(self._handle, plugin._plugin)
+            except Exception, e:
+                msg = "Unable to add plugin: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+
+    def remove_plugin(self, plugin):
+        """
+        Remove a plugin from the handle associated with this instance. The
+        plugin must have already been added using the add_plugin() method.
+
+        @param plugin: an instance of a plugin class, either
+        PerformanceMarkerPlugin or RestartMarkerPlugin
+        @type plugin: instance of PerformanceMarkerPlugin or RestartMarkerPlugin
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: thrown if unable to remove the plugin
+        to the handle
+        """
+        if self._handle:
+            try:
+                gridftpwrapper.gridftp_handle_remove_plugin(self._handle, plugin._plugin)
+            except Exception, e:
+                msg = "Unable to remove plugin: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+
+    def cache_url_state(self, url):
+        """
+        Keep the connection to the server of a URL open between the
+        operations of this client, as set_cache_all does for every URL.
+
+        @param url: a URL on the server whose connection to cache
+        @type url: string
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: thrown if unable to cache the
+        URL state
+        """
+        try:
+            gridftpwrapper.gridftp_handle_cache_url_state(self._handle, url)
+        except Exception, e:
+            msg = "Unable to cache url state: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def flush_url_state(self, url):
+        """
+        Stop caching the connection to the server of a URL, closing it
+        if no operation is using it.
+
+        @param url: a URL on the server whose connection to flush
+        @type url: string
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: thrown if unable to flush the
+        URL state
+        """
+        try:
+            gridftpwrapper.gridftp_handle_flush_url_state(self._handle, url)
+        except Exception, e:
+            msg = "Unable to flush url state: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def set_metadata_cache(self, cache):
+        """
+        Answer exists, cksm and mlst requests from a cache of metadata
+        while it is fresh, and drop the cached facts about the paths this
+        client changes. The same cache may be given to several clients.
+
+        With a cache, exists() and cksm() still call a completeCallback
+        that is a function from a Globus thread when the answer is
+        cached, just without the round trip; a CompletionQueue always
+        gets its answer from the server.
+
+        @param cache: the cache, or None to stop caching
+        @type cache: instance of MetadataCache
+
+        @return: None
+        @rtype: None
+        """
+        self._cache = cache
+
+    def _invalidate(self, url, recursive = False):
+        """
+        Drop the cached facts about a path this client changes. A path
+        removed or moved away, with the paths below it, is also dropped
+        from the directories known to the pool the client is leased
+        from.
+        """
+        if self._cache:
+            self._cache.invalidate(url, recursive)
+        if recursive and self._pool:
+            self._pool.forget_dirs(url)
+
+    def _invalidating(self, completeCallback, kind, arg, urls, recursive = False):
+        """
+        Return the callback to hand to the wrapper for an operation that
+        changes urls, which drops their cached facts again when the
+        operation completes, since an exists or cksm answered while it
+        was in flight may have cached the old state. With urls None the
+        URL dropped is the dst of each event, args[2].
+        """
+        pool = recursive and self._pool or None
+        if not self._cache and not pool:
+            return completeCallback
+
+        cache = self._cache
+        def drop(url):
+            if cache:
+                cache.invalidate(url, recursive)
+            if pool and pool._pool:
+                pool.forget_dirs(url)
+
+        def invalidate(args):
+            if urls is None:
+                drop(args[2])
+                return
+            for url in urls:
+                drop(url)
+
+        if isinstance(completeCallback, CompletionQueue):
+            completeCallback._after(kind, arg, invalidate)
+            return completeCallback
+
+        callback = completeCallback
+        def invalidatingCallback(*args):
+            invalidate(args)
+            callback(*args)
+        return invalidatingCallback
+
+    def third_party_transfer(self, src, dst, completeCallback, arg, 
+                srcOpAttr = None, dstOpAttr = None, restartMarker = None):
+        """
+        Initiate a third party transfer between to servers. This function
+        returns immediately.  When the transfer is completed or if the
+        transfer is aborted, the completeCallback function will be invoked with the
+        final status of the transfer.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param src: the source URL for the transfer
+        @type src: string
+
+        @param dst: the destination URL for the transfer
+        @type dst: string
+
+        @param completeCallback: the function to call when the transfer is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the completion callback 
+        @type arg: any
+
+        @param srcOpAttr: an instance of OperationAttr for the source
+        @type srcOpAttr: instance of OperationAttr
+
+        @param dstOpAttr: an instance of OperationAttr for the destination
+        @type dstOpAttr: instance of OperationAttr
+
+        @param restartMarker: a restart marker recording the data
+        already transferred, for example as kept by a
+        RestartMarkerPlugin during an earlier attempt, or None to
+        transfer the whole file
+        @type restartMarker: instance of RestartMarker
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        third party transfer
+        """
+
+        if not srcOpAttr or not dstOpAttr:
+            msg = "Both a source and destination OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(dst)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.THIRD_PARTY, arg, [dst])
+
+        try:
+            gridftpwrapper.gridftp_third_party_transfer(
+                self._handle,
+                src,
+                srcOpAttr._attr,
+                dst,
+                dstOpAttr._attr,
+                _optional_marker(restartMarker),
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate third party transfer: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+
+
+    def third_party_transfer_pipelined(self, pairs, completeCallback, arg,
+                srcOpAttr = None, dstOpAttr = None):
+        """
+        Initiate third party transfers of a list of files over the one
+        session of this client, with the commands of many transfers in
+        flight at once. The client must have been created from a
+        HandleAttr on which set_pipeline() was called, and only one
+        pipelined batch may be in progress per client.
+
+        Globus reports the batch as a whole, so the completeCallback is
+        called for every pair when the batch completes and must have
+        the form:
+
+        def completeCallback(arg, src, dst, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - src and dst are the URLs of the pair
+            - error is None for success or a string if an error occurred.
+              If the batch failed every pair handed to Globus gets the
+              error, since which of them completed is not known, and the
+              pairs never started get an error saying so
+
+        A CompletionQueue may be given in place of the callback, in which
+        case the event kind is CompletionQueue.PIPELINED.
+
+        @param pairs: the (source URL, destination URL) pairs to transfer
+        @type pairs: sequence of tuples of strings
+
+        @param completeCallback: function to call for each pair
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param srcOpAttr: an instance of OperationAttr for the sources,
+        or None for the default attributes
+        @type srcOpAttr: instance of OperationAttr
+
+        @param dstOpAttr: an instance of OperationAttr for the
+        destinations, or None for the default attributes
+        @type dstOpAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        transfers
+        """
+        pairs = list(pairs)
+        for src, dst in pairs:
+            self._invalidate(dst)
+
+        # each pair gets its own event, which its dst is dropped on
+        if isinstance(completeCallback, CompletionQueue):
+            for pair in pairs:
+                self._invalidating(completeCallback, CompletionQueue.PIPELINED, arg, None)
+        else:
+            completeCallback = self._invalidating(completeCallback, CompletionQueue.PIPELINED, arg, None)
+
+        try:
+            gridftpwrapper.gridftp_third_party_transfer_pipelined(
+                self._handle,
+                pairs,
+                _optional_attr(srcOpAttr),
+                _optional_attr(dstOpAttr),
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate pipelined third party transfer: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def get(self, url, completeCallback, arg, opAttr = None, marker = None, digest = None):
+        """
+        Get a file from an FTP server.
+
+        This function starts a get file transfer from an FTP server. If
+        this function returns without exception then the user may immediately
+        begin calling register_read() to retrieve the data associated with this URL.
+
+        When all of the data associated with this URL is retrieved, and all
+        of the data callbacks have been called, or if the get request is
+        aborted, the completeCallback will be invoked with the final
+        status of the get.
+
+        The completeCallback function must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        or, when a digest is given, completeCallback(arg, handle, error,
+        digest) where digest is the hex digest or None if it failed.
+
+        @param url: the source URL to get
+        @type url: string
+
+        @param completeCallback: function to call when the transfer is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the transfer
+        @type opAttr: instance of OperationAttr
+
+        @param marker: a restart marker recording the data already
+        received, so that only the rest is sent, or None for the whole
+        file; register_read callbacks then see only the missing ranges
+        @type marker: instance of RestartMarker
+
+        @param digest: a digest to finish when the get completes, which
+        must also be given to the register_read calls for the get
+        @type digest: instance of StreamDigest
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initaite the get
+        operation
+
+        """
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        try:
+            gridftpwrapper.gridftp_get(
+                self._handle, 
+                url,
+                opAttr._attr,
+                _optional_marker(marker),
+                _callback_object(completeCallback),
+                arg,
+                _optional_digest(digest)
+                )
+        except Exception, e:
+            msg = "Unable to initiate get: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def partial_get(self, url, offset, end, completeCallback, arg, opAttr = None, digest = None):
+        """
+        Get part of a file from an FTP server.
+
+        This works like get(), but only the bytes from offset up to, but
+        not including, end are transferred. The data is read with
+        register_read() and the offsets given to the data callbacks are
+        offsets into the whole file. Several partial gets of one file
+        on different handles, or from different servers, can run at
+        the same time to fetch it in parallel.
+
+        The completeCallback function must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        or, when a digest is given, completeCallback(arg, handle, error,
+        digest) where digest is the hex digest or None if it failed.
+
+        @param url: the source URL to get
+        @type url: string
+
+        @param offset: the offset of the first byte to get
+        @type offset: integer
+
+        @param end: the offset one past the last byte to get
+        @type end: integer
+
+        @param completeCallback: function to call when the transfer is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the transfer
+        @type opAttr: instance of OperationAttr
+
+        @param digest: a digest of the range, created with start equal to
+        offset, which must also be given to the register_read calls for
+        the get
+        @type digest: instance of StreamDigest
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        partial get operation
+        """
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        try:
+            gridftpwrapper.gridftp_partial_get(
+                self._handle, 
+                url,
+                opAttr._attr,
+                offset,
+                end,
+                _callback_object(completeCallback),
+                arg,
+                _optional_digest(digest)
+                )
+        except Exception, e:
+            msg = "Unable to initiate partial get: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def get_to_file(self, url, dest, completeCallback, arg, opAttr = None,
+                nbuffers = 4, bufsize = 1048576, marker = None, digest = None):
+        """
+        Get a file from an FTP server and write it directly to a local file.
+
+        Unlike get(), no calls to register_read() are needed. The wrapper
+        keeps nbuffers buffers of bufsize bytes registered with Globus and
+        writes each block into the local file at the offset reported by
+        the server, re-registering the buffer itself. None of this involves
+        the Python interpreter, so the transfer is not limited by the
+        speed of Python callbacks. When using parallel data channels
+        nbuffers should be at least the number of channels.
+
+        The completeCallback is called once, when the transfer is complete
+        or aborted, and must have the form:
+
+        def completeCallback(arg, handle, error, nbytes):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred,
+              including an error writing the local file
+            - nbytes is the number of bytes written to the local file
+
+        or, when a digest is given, completeCallback(arg, handle, error,
+        nbytes, digest) where digest is the hex digest of the data
+        written, or None if it failed.
+
+        @param url: the source URL to get
+        @type url: string
+
+        @param dest: the path of the local file, which is created or
+        truncated unless resuming from a marker, or an open file
+        descriptor to write to which is left open
+        @type dest: string or integer
+
+        @param completeCallback: function to call when the transfer is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the transfer
+        @type opAttr: instance of OperationAttr
+
+        @param nbuffers: the number of buffers to keep registered
+        @type nbuffers: integer
+
+        @param bufsize: the size in bytes of each buffer
+        @type bufsize: integer
+
+        @param marker: a restart marker, or None. Each range written to
+        the local file is recorded in the marker as it lands, and only
+        the ranges not yet recorded are asked for. If the get fails,
+        calling get_to_file again with the same marker fetches just the
+        missing data; a dest path is then not truncated. The marker
+        may be saved with str() and restored with RestartMarker(string)
+        @type marker: instance of RestartMarker
+
+        @param digest: a digest of the data as it is written; a resumed
+        get only writes the missing ranges, so its digest fails
+        @type digest: instance of StreamDigest
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the get
+        operation
+
+        """
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        try:
+            gridftpwrapper.gridftp_get_to_file(
+                self._handle,
+                url,
+                opAttr._attr,
+                dest,
+                _optional_marker(marker),
+                nbuffers,
+                bufsize,
+                _callback_object(completeCallback),
+                arg,
+                _optional_digest(digest)
+                )
+        except Exception, e:
+            msg = "Unable to initiate get to file: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def register_read(self, buffer, dataCallback, arg, digest = None):
+        """
+        Register an instance of class Buffer and the function dataCallback
+        to handle a part of the FTP data transfer.
+
+        The instance of class Buffer will be associated with the current get being
+        performed on this client handle and data will be written into the
+        buffer. The user must then empty the buffer and register another
+        instance for the transfer to proceed. Note that if parallel data
+        channels are used multiple buffers should be registered.
+
+        When the instance of class Buffer is fulled the function
+        dataCallback will be called.
+
+        The dataCallback function must have the form:
+
+        def dataCallback(arg, handle, error, buffer, length, offset, eof):
+            - arg is the user argument passed in when this function is called
+            - handle is the wrapped pointer to the client handle
+            - error is None or a string if there is an error
+            - buffer is the buffer from which the data can be read
+            - length is the number of bytes in the buffer
+            - offset is the offset into the file at which the bytes start
+            - eof is true if this is the end of the file
+
+        @param buffer: instance of class Buffer into which the data will be
+        written
+        @type buffer: instance of class Buffer
+
+        @param dataCallback: function to be called when the instance of
+        Buffer is full
+        @type dataCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param digest: the digest given to the get, fed the data before
+        dataCallback is called
+        @type digest: instance of StreamDigest
+
+        @return: None
+        @rtype: None
+
+        @raises GridFTPException: raised if unable to register the buffer
+        and callback for reading
+
+        """
+        try:
+            gridftpwrapper.gridftp_register_read(
+                self._handle,
+                buffer._buffer,
+                buffer.size,
+                _callback_object(dataCallback),
+                arg,
+                _optional_digest(digest)
+                )
+        except Exception, e:
+            msg = "Unable to register read: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def register_read_ring(self, nbuffers, size, dataCallback, arg, copy = False, digest = None):
+        """
+        Register a ring of nbuffers buffers, each of size bytes, for the
+        get being performed on this client handle.
+
+        This replaces calling register_read() again from every data
+        callback. The wrapper allocates the buffers, registers all of them
+        at once and re-registers each buffer itself as soon as dataCallback
+        returns, so with parallel data channels every channel always has a
+        buffer to read into. The buffers are freed by the wrapper once the
+        transfer is over.
+
+        If copy is true the data of each block is copied into a Python
+        string and the buffer is handed back to Globus before dataCallback
+        is called, which keeps the data channels busy even while the
+        callback is slow. If copy is false the callback receives a buffer
+        object pointing at the wrapper's memory, which is only valid until
+        the callback returns.
+
+        The dataCallback function must have the form:
+
+        def dataCallback(arg, handle, error, buffer, length, offset, eof):
+            - arg is the user argument passed in when this function is called
+            - handle is the wrapped pointer to the client handle
+            - error is None or a string if there is an error
+            - buffer is the data, a string in copy mode
+            - length is the number of bytes in the buffer
+            - offset is the offset into the file at which the bytes start
+            - eof is true if this is the end of the file
+
+        @param nbuffers: the number of buffers to keep registered, at least
+        the number of parallel data channels
+        @type nbuffers: integer
+
+        @param size: the size in bytes of each buffer
+        @type size: integer
+
+        @param dataCallback: function to be called for each block of data
+        @type dataCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param copy: copy the data out and re-register before calling
+        dataCallback
+        @type copy: boolean
+
+        @param digest: the digest given to the get, fed each block before
+        the buffer is handed back to Globus
+        @type digest: instance of StreamDigest
+
+        @return: None
+        @rtype: None
+
+        @raises GridFTPException: raised if unable to register the buffers
+
+        """
+        try:
+            gridftpwrapper.gridftp_register_read_ring(
+                self._handle,
+                nbuffers,
+                size,
+                dataCallback,
+                arg,
+                int(bool(copy)),
+                _optional_digest(digest)
+                )
+        except Exception, e:
+            msg = "Unable to register read ring: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def put(self, url, completeCallback, arg, opAttr = None, marker = None):
+        """
+        Put a file to an FTP server.
+
+        This function starts a put file transfer to an FTP server. If
+        this function returns without exception then the user may immediately
+        begin calling register_write() to send the data associated with this URL.
+
+        When all of the data associated with this URL is written, and all
+        of the data callbacks have been called, or if the put request is
+        aborted, the completeCallback will be invoked with the final
+        status of the put.
+
+        The completeCallback function must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the destination URL to put
+        @type url: string
+
+        @param completeCallback: function to call when the transfer is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the transfer
+        @type opAttr: instance of OperationAttr
+
+        @param marker: a restart marker recording the data the server
+        already has, for example as kept by a RestartMarkerPlugin during
+        an earlier attempt, or None to send the whole file
+        @type marker: instance of RestartMarker
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the put
+        operation
+
+        """
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(url)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.PUT, arg, [url])
+
+        try:
+            gridftpwrapper.gridftp_put(
+                self._handle,
+                url,
+                opAttr._attr,
+                _optional_marker(marker),
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate put: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def register_write(self, data, dataCallback, arg, offset = 0, eof = False, length = None):
+        """
+        Register a block of data to be written as part of the put being
+        performed on this client handle.
+
+        The data may be an instance of class Buffer or any object that
+        supports the buffer protocol, for example a bytearray, an mmap,
+        an array.array, a string or a buffer() or memoryview slice of one
+        of those. The memory of the object is handed to Globus directly
+        and is not copied, so the object must not be modified or resized
+        until dataCallback has been called for it. A reference to the
+        object is held until then.
+
+        To send a large file without copying it, map it with mmap and
+        register slices such as buffer(theMap, offset, blockSize) at the
+        matching offsets. When parallel data channels are used several
+        blocks should be registered at once so each channel has data.
+
+        The dataCallback function must have the form:
+
+        def dataCallback(arg, handle, error, data, length, offset, eof):
+            - arg is the user argument passed in when this function is called
+            - handle is the wrapped pointer to the client handle
+            - error is None or a string if there is an error
+            - data is the object that was registered (the wrapped pointer
+              for an instance of Buffer)
+            - length is the number of bytes that were written
+            - offset is the offset into the file at which the bytes start
+            - eof is true if this was the last block of the file
+
+        dataCallback may be None if the caller does not need to know when
+        each block has been sent.
+
+        @param data: the data to write
+        @type data: instance of class Buffer or buffer protocol object
+
+        @param dataCallback: function to be called when Globus is done with
+        the data
+        @type dataCallback: callable or None
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param offset: the offset into the file at which the data is written
+        @type offset: integer
+
+        @param eof: true if this is the last block of the file
+        @type eof: boolean
+
+        @param length: the number of bytes to write, use None to write the
+        whole object (or the whole Buffer)
+        @type length: integer
+
+        @return: None
+        @rtype: None
+
+        @raises GridFTPException: raised if unable to register the data
+        and callback for writing
+
+        """
+        if isinstance(data, Buffer):
+            obj = data._buffer
+            if length is None:
+                length = data.size
+        else:
+            obj = data
+            if length is None:
+                length = -1
+
+        try:
+            gridftpwrapper.gridftp_register_write(
+                self._handle,
+                obj,
+                length,
+                offset,
+                int(bool(eof)),
+                _callback_object(dataCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to register write: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+
+    def cksm(self, url, completeCallback, arg, opAttr = None, offset = None, length = None, algorithm = "MD5"):
+        """
+        Get a file's checksum from an FTP server.
+
+        This function requests the checksum of a file from an FTP server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the operation and the
+        checksum value. 
+
+        The completeCallback must have the form:
+
+        def completeCallback(cksm, arg, handle, error):
+            - cksm is the Python string containing the checksum value
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL for the file to be checksummed
+        @type url: string
+
+        @param completeCallback: the function to be called when the checksum
+        operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @param offset: the offset in bytes into the file at which to begin computing
+        the checkusm, use None to start at the beginning of the file
+        @type offset: integer
+
+        @param length: the length of the file in bytes to use when
+        computing the checksum, use None to checksum the entire file
+        @type length: integer
+
+        @param algorithm: the checksum algorithm, such as ADLER32, MD5
+        or SHA256; see cksm_algorithms_sync for those the server supports
+        @type algorithm: string
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        checksum operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+        if not offset:
+            offset = 0
+        if not length:
+            length = -1
+
+        if self._cache and not isinstance(completeCallback, CompletionQueue):
+            cache = self._cache
+            fact = _cksm_fact(offset, length, algorithm)
+            found, value = cache.get(url, fact)
+            if found:
+                _call_soon(completeCallback, (value, arg, self._handle, None))
+                return
+
+            callback = completeCallback
+            def cachingCallback(cksm, arg, handle, error):
+                if error is None:
+                    cache.set(url, fact, cksm)
+                callback(cksm, arg, handle, error)
+            completeCallback = cachingCallback
+
+        try:
+            gridftpwrapper.gridftp_cksm(self._handle, url, opAttr._attr, offset, length, _callback_object(completeCallback), arg, algorithm)
+        except Exception, e:
+            msg = "Unable to cksm: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def mkdir(self, url, completeCallback, arg, opAttr = None):
+        """
+        Make a directory on a server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL for the directory to be created
+        @type url: string
+
+        @param completeCallback: the function to be called
+        when the mkdir operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        mkdir operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(url)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.MKDIR, arg, [url])
+
+        try:
+            gridftpwrapper.gridftp_mkdir(self._handle, url, opAttr._attr, _callback_object(completeCallback), arg)
+        except Exception, e:
+            msg = "Unable to mkdir: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+    def popen(self, server, cmd, cmd_args, buff_size=1024):
+        """
+        Call 'popen' on server.
+
+        server (string): name of server. Example: 'gsiftp://oregano.phys.uwm.edu'
+        cmd (string): command to issue on server. Example: '/bin/df'
+        cmd_args (list of strings): list of arguments to pass to cmd. Example: ['-i', '/opt']
+
+        return a string, viz. the contents of whatever register_read returns.
+
+        raises GridFTPClientException
+
+        Example use:
+
+          import gridftpClient
+          
+          cmd='/bin/df'
+          cmd_args=['-ih', '/opt']
+          server = "gsiftp://oregano.phys.uwm.edu"
+          h = gridftpClient.HandleAttr()
+          myClient = gridftpClient.FTPClient(h)
+          outstr=myClient.popen(server, cmd, cmd_args)
+          print outstr
+
+        results in the following output:
+
+          Filesystem            Inodes   IUsed   IFree IUse% Mounted on
+          /dev/sdb1                47M    4.4K     47M    1% /opt
+  
+        """
+
+        def transfer_done(arg, handle, error):
+            """
+            complete callback function
+            """
+            theCondition = arg
+            theCondition.acquire()
+            if error:
+                print "Callback: error is %s" % error
+                sys.stdout.flush()
+            else:
+                pass
+            theCondition.notify()
+            theCondition.release()
+            
+        def transfer_read(mydict, handle, error, buff, length, offset, eof):
+            """
+            datacallback function
+            """
+            mydict['buffer_string']+=str(buff)
+            if not eof:
+                self.register_read(mydict['my_buffer'], transfer_read, mydict) 
+
+        try:
+            import threading
+            myCondition = threading.Condition()
+            myCondition.acquire()
+    
+            opAttr = OperationAttr()
+            disk_stack='#'.join(["popen:argv=",cmd]+cmd_args)
+            opAttr.set_disk_stack(disk_stack)
+            buffer = Buffer(buff_size)
+            self.get(server, transfer_done, myCondition, opAttr, None)
+            mydict={'client_handle': self, 'buffer_string': "", 'my_buffer': buffer}
+            self.register_read(buffer, transfer_read, mydict)
+            myCondition.wait()
+        except Exception, e:
+            msg = "problem with popen: %s" %e
+            ex = GridFTPClientException(msg)
+            raise ex
+        return mydict['buffer_string']
+
+
+    def rmdir(self, url, completeCallback, arg, opAttr = None):
+        """
+        Remove a directory on a server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL for the directory to be removed
+        @type url: string
+
+        @param completeCallback: the function to be called
+        when the mkdir operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        mkdir operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(url, True)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.RMDIR, arg, [url], True)
+
+        try:
+            gridftpwrapper.gridftp_rmdir(self._handle, url, opAttr._attr, _callback_object(completeCallback), arg)
+        except Exception, e:
+            msg = "Unable to rmdir: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def delete(self, url, completeCallback, arg, opAttr = None):
+        """
+        Delete a file on a server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL for the file to be deleted
+        @type url: string
+
+        @param completeCallback: the function to be called
+        when the mkdir operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        delete operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(url)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.DELETE, arg, [url])
+
+        try:
+            gridftpwrapper.gridftp_delete(self._handle, url, opAttr._attr, _callback_object(completeCallback), arg)
+        except Exception, e:
+            msg = "Unable to delete: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def move(self, src, dst, completeCallback, arg, opAttr = None):
+        """
+        Move or rename a file on a server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param src: the source URL for the file to be moved
+        @type src: string
+
+        @param dst: the destination URL for the file to be moved
+        @type dst: string
+
+        @param completeCallback: the function to be called
+        when the mkdir operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        delete operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(src, True)
+        self._invalidate(dst, True)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.MOVE, arg, [src, dst], True)
+
+        try:
+            gridftpwrapper.gridftp_move(self._handle, src, dst, opAttr._attr, _callback_object(completeCallback), arg)
+        except Exception, e:
+            msg = "Unable to move: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def chmod(self, url, mode, completeCallback, arg, opAttr = None):
+        """
+        Change the mode of a file on a server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL for the file 
+        @type url: string
+
+        @param mode: the integer file mode, be sure to use 4
+        digits, for example 0644 instead of 644.
+        @type mode: integer
+
+        @param completeCallback: the function to be called
+        when the mkdir operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        delete operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        self._invalidate(url)
+        completeCallback = self._invalidating(completeCallback, CompletionQueue.CHMOD, arg, [url])
+
+        try:
+            gridftpwrapper.gridftp_chmod(self._handle, url, mode, opAttr._attr, _callback_object(completeCallback), arg)
+        except Exception, e:
+            msg = "Unable to chmod: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def verbose_list(self, url, completeCallback, arg, opAttr = None):
+        """
+        Get a file listing from a FTP server.
+
+        This function starts a verbose file listing from an FTP server. If
+        this function returns without exception then the user may immediately
+        begin calling register_read() to retrieve the data associated with this
+        operation.
+
+        When all of the data associated with this URL is retrieved, and all
+        of the data callbacks have been called, or if the verbose list request is
+        aborted, the completeCallback will be invoked with the final
+        status of the get.
+
+        The completeCallback function must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the transfer was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the source URL from which to get the file listing
+        @type url: string
+
+        @param completeCallback: function to call when the listing is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the transfer
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the verbose
+        list operation
+
+        """
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        try:
+            gridftpwrapper.gridftp_verbose_list(
+                self._handle, 
+                url,
+                opAttr._attr,
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate verbose list: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def machine_list(self, url, completeCallback, arg, opAttr = None):
+        """
+        Get a machine readable (MLSD) file listing from a FTP server.
+
+        As with verbose_list() the listing, one fact line per entry, is
+        read with register_read() and the completeCallback is invoked
+        once it has all been read or the operation failed. Use
+        machine_list_sync() to have the listing read and parsed in C.
+
+        The completeCallback function must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the listing was
+              initiated
+            - handle is the wrapped pointer to the client handle
+            - error is None for success or a string if an error occurred
+
+        @param url: the URL of the directory to list
+        @type url: string
+
+        @param completeCallback: function to call when the listing is
+        complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        machine list operation
+        """
+        try:
+            gridftpwrapper.gridftp_machine_list(
+                self._handle,
+                url,
+                _optional_attr(opAttr),
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate machine list: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def exists(self, url, completeCallback, arg, opAttr = None, withCode = False):
+        """
+        Check for the existence of a file or directory on a remote server.
+
+        When the request is completed or aborted, the completeCallback
+        will be invoked with the final status of the
+        operation.
+
+        The completeCallback must have the form:
+
+        def completeCallback(arg, handle, error):
+            - arg is the user argument passed in when the call was
+              initiated
+            - handle is the wrapper pointer to the client handle
+            - error is None for existence or a string if an error occurred
+
+        or, when withCode is true, completeCallback(arg, handle, error,
+        code) where code is the FTP reply code of the error, 550 if the
+        path does not exist, or 0. Only the code tells a missing path
+        from a failure to check.
+
+        @param url: the URL to check for existence
+        @type url: string
+
+        @param completeCallback: the function to be called
+        when the exist operation is complete
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback function
+        @type arg: any
+
+        @param opAttr: an instance of OperationAttr for the source
+        @type opAttr: instance of OperationAttr
+
+        @param withCode: pass the FTP reply code to the callback too
+        @type withCode: boolean
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        exists operation
+        """
+
+        if not opAttr:
+            msg = "An OperationAttr instance must be input"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        passCode = withCode
+        if self._cache and not isinstance(completeCallback, CompletionQueue):
+            cache = self._cache
+            found, value = cache.get(url, 'exists')
+            if found:
+                if value:
+                    args = (arg, self._handle, None, 0)
+                else:
+                    args = (arg, self._handle, "550 %s: no such file or directory (cached)" % url, 550)
+                _call_soon(completeCallback, passCode and args or args[:3])
+                return
+
+            # a missing path is reported by the server with a 550 reply,
+            # which the wrapper passes as the code
+            callback = completeCallback
+            def cachingCallback(arg, handle, error, code):
+                if error is None:
+                    cache.set(url, 'exists', True)
+                elif code == 550:
+                    cache.set(url, 'exists', False, True)
+                if passCode:
+                    callback(arg, handle, error, code)
+                else:
+                    callback(arg, handle, error)
+            completeCallback = cachingCallback
+            withCode = True
+
+        try:
+            gridftpwrapper.gridftp_exists(self._handle, url, opAttr._attr, _callback_object(completeCallback), arg, int(withCode))
+        except Exception, e:
+            msg = "Unable to check existence: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+            
+    def third_party_transfer_sync(self, src, dst, srcOpAttr = None, dstOpAttr = None, restartMarker = None):
+        """
+        Transfer a file between two servers and return once the
+        transfer has completed.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param src: the source URL for the transfer
+        @type src: string
+
+        @param dst: the destination URL for the transfer
+        @type dst: string
+
+        @param srcOpAttr: an instance of OperationAttr for the source,
+        or None for the default attributes
+        @type srcOpAttr: instance of OperationAttr
+
+        @param dstOpAttr: an instance of OperationAttr for the
+        destination, or None for the default attributes
+        @type dstOpAttr: instance of OperationAttr
+
+        @param restartMarker: a restart marker recording the data
+        already transferred, or None to transfer the whole file
+        @type restartMarker: instance of RestartMarker
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_third_party_transfer_sync(self._handle, src, _optional_attr(srcOpAttr), dst, _optional_attr(dstOpAttr), _optional_marker(restartMarker))
+        except Exception, e:
+            msg = "Unable to do third party transfer: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(dst)
+
+    def cksm_sync(self, url, opAttr = None, offset = None, length = None, algorithm = "MD5"):
+        """
+        Get a file's checksum from an FTP server and return it.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the file to be checksummed
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param offset: the offset in bytes into the file at which to begin computing
+        the checksum, use None to start at the beginning of the file
+        @type offset: integer
+
+        @param length: the length of the file in bytes to use when
+        computing the checksum, use None to checksum the entire file
+        @type length: integer
+
+        @param algorithm: the checksum algorithm, such as ADLER32, MD5
+        or SHA256; see cksm_algorithms_sync for those the server supports
+        @type algorithm: string
+
+        @return: the checksum value
+        @rtype: string
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        offset = offset or 0
+        length = length or -1
+
+        if self._cache:
+            found, value = self._cache.get(url, _cksm_fact(offset, length, algorithm))
+            if found:
+                return value
+
+        try:
+            cksm = gridftpwrapper.gridftp_cksm_sync(self._handle, url, _optional_attr(opAttr), offset, length, algorithm)
+        except Exception, e:
+            msg = "Unable to cksm: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if self._cache:
+            self._cache.set(url, _cksm_fact(offset, length, algorithm), cksm)
+        return cksm
+
+    def cksm_algorithms_sync(self, url, candidates = None, opAttr = None):
+        """
+        Find which checksum algorithms the server of a file supports.
+
+        The algorithms are taken from the CKSM line of the server's FEAT
+        reply when it has one, which costs a FEAT round trip and nothing
+        on the file. The client library only sends FEAT when it opens a
+        connection, so with the connection already cached, or a server
+        that does not list algorithms, each candidate is instead tried
+        on the first byte of the file: one CKSM round trip per candidate,
+        whatever the size of the file. With a metadata cache the answer
+        is kept for the server.
+
+            algorithm = choose_cksm_algorithm(client.cksm_algorithms_sync(url))
+
+        @param url: the URL of a non-empty file on the server
+        @type url: string
+
+        @param candidates: the algorithms of interest, or None for all
+        the server lists, or CKSM_PROBE_ALGORITHMS when they are probed
+        @type candidates: sequence of strings
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: the candidates the server supports, in the order given,
+        or with no candidates those the server lists, in its order
+        @rtype: list of strings
+
+        @raise GridFTPClientException: raised if the file could not be
+        checksummed or the server not reached
+        """
+
+        if candidates is not None:
+            candidates = list(candidates)
+
+        root = _server_root(url)
+        fact = "cksm_algorithms:" + ",".join(candidates or [])
+        if self._cache:
+            found, value = self._cache.get(root, fact)
+            if found:
+                return list(value)
+
+        try:
+            listed = gridftpwrapper.gridftp_cksm_feat(self._handle, url, _optional_attr(opAttr))
+            if listed:
+                listed = [a.strip() for a in listed.replace(';', ',').replace(' ', ',').split(',') if a.strip()]
+                if candidates is None:
+                    supported = listed
+                else:
+                    listed = set([a.upper() for a in listed])
+                    supported = [a for a in candidates if a.upper() in listed]
+            else:
+                supported = gridftpwrapper.gridftp_cksm_probe(self._handle, url, _optional_attr(opAttr),
+                    candidates is None and list(CKSM_PROBE_ALGORITHMS) or candidates)
+        except Exception, e:
+            msg = "Unable to probe checksum algorithms: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if self._cache:
+            self._cache.set(root, fact, tuple(supported))
+        return supported
+
+    def exists_sync(self, url, opAttr = None):
+        """
+        Check whether a file or directory exists on a server.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL to check for existence
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: True if the path exists, False if the server
+        reports that it does not
+        @rtype: boolean
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        if self._cache:
+            found, value = self._cache.get(url, 'exists')
+            if found:
+                return value
+
+        try:
+            exists = gridftpwrapper.gridftp_exists_sync(self._handle, url, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to check existence: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if self._cache:
+            self._cache.set(url, 'exists', exists, not exists)
+        return exists
+
+    def machine_list_sync(self, url, opAttr = None, skipDots = True):
+        """
+        List a directory with MLSD and return the parsed listing.
+
+        The listing is read and its fact lines parsed in C with the
+        Python interpreter lock released, so no text is handed to Python
+        and other Python threads keep running.
+
+        @param url: the URL of the directory to list
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param skipDots: leave out the entries for the directory itself
+        and its parent
+        @type skipDots: boolean
+
+        @return: the entries of the directory
+        @rtype: instance of Listing
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            return Listing(gridftpwrapper.gridftp_machine_list_sync(
+                self._handle, url, _optional_attr(opAttr), skipDots and 1 or 0))
+        except Exception, e:
+            msg = "Unable to list directory: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def mlst_sync(self, url, opAttr = None):
+        """
+        Get the facts of a single file or directory with MLST.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the file or directory
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: the facts, with the name being the path the server
+        gives; a directory may have type 'c', as the listed directory,
+        rather than 'd'
+        @rtype: instance of ListingEntry
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed, or the server gave no fact line
+        """
+
+        if self._cache:
+            found, value = self._cache.get(url, 'stat')
+            if found:
+                return value
+
+        try:
+            listing = Listing(gridftpwrapper.gridftp_mlst_sync(
+                self._handle, url, _optional_attr(opAttr)))
+        except Exception, e:
+            msg = "Unable to get facts: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if not len(listing):
+            msg = "Unable to get facts: no fact line for %s" % url
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if self._cache:
+            self._cache.set(url, 'stat', listing[0])
+        return listing[0]
+
+    def mkdir_sync(self, url, opAttr = None):
+        """
+        Make a directory on a server and return once it is done.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_mkdir_sync(self._handle, url, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to mkdir: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(url)
+
+    def rmdir_sync(self, url, opAttr = None):
+        """
+        Remove a directory on a server and return once it is done.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_rmdir_sync(self._handle, url, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to rmdir: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(url, True)
+
+    def delete_sync(self, url, opAttr = None):
+        """
+        Delete a file on a server and return once it is done.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the path
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_delete_sync(self._handle, url, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to delete: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(url)
+
+    def move_sync(self, src, dst, opAttr = None):
+        """
+        Move a file on a server and return once it is done.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param src: the URL of the file to move
+        @type src: string
+
+        @param dst: the URL to move the file to
+        @type dst: string
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_move_sync(self._handle, src, dst, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to move: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(src, True)
+            self._invalidate(dst, True)
+
+    def chmod_sync(self, url, mode, opAttr = None):
+        """
+        Change the mode of a file on a server and return once it is done.
+
+        The operation is waited for in C with the Python interpreter
+        lock released, so other Python threads keep running.
+
+        @param url: the URL of the file
+        @type url: string
+
+        @param mode: the new mode, for example 0644
+        @type mode: integer
+
+        @param opAttr: an instance of OperationAttr, or None for the
+        default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the operation could
+        not be started or failed
+        """
+
+        try:
+            gridftpwrapper.gridftp_chmod_sync(self._handle, url, mode, _optional_attr(opAttr))
+        except Exception, e:
+            msg = "Unable to chmod: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+        finally:
+            self._invalidate(url)
+
+    def abort(self):
+        """
+        Abort the operation currently in progress.
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if unable to initiate the
+        abort operation
+        """
+
+        if self._handle:
+            try:
+                gridftpwrapper.gridftp_abort(self._handle)
+            except Exception, e:
+                msg = "Unable to abort: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+
+        
+# the result of an item of a HandlePool batch that got no handle in time
+HANDLE_ACQUIRE_TIMED_OUT = -2
+
+def batch_error(code):
+    """
+    Return the error an item result of a HandlePool batch stands for.
+
+    @param code: the result of the item
+    @type code: integer
+
+    @return: None for success, or the error
+    @rtype: string
+    """
+    if code == 0:
+        return None
+    if code == HANDLE_ACQUIRE_TIMED_OUT:
+        return "handle acquire timed out"
+    if code < 0:
+        return "server could not be reached or operation not started"
+    return "server refused with reply code %d" % code
+
+class HandlePool(object):
+    """
+    A thread safe pool of client handles kept per host:port.
+
+    Handles are leased for the host:port of a URL and kept when they
+    are released, so their cached control connections are reused by the
+    next lease for the same host instead of paying for a new connection
+    and authentication. The pool takes its own copy of the HandleAttr
+    with set_cache_all turned on, and keeps at most maxPerHost handles,
+    idle or leased, for each host:port.
+
+        client = pool.lease("gsiftp://host/path")
+        try:
+            client.mkdir_sync("gsiftp://host/path/dir")
+        finally:
+            pool.release(client)
+
+    A handle may be released from its own completion callback. Plugins
+    added to a leased client must be removed before it is released.
+
+    The *_many methods run one metadata operation on each of many paths
+    with a bounded window in flight over the pooled handles, and return
+    an array('i') of per path reply codes rather than calling back into
+    Python once per path:
+
+        codes = pool.delete_many(urls, window = 64)
+        failed = [url for url, code in zip(urls, codes) if code != 0]
+
+    While none of its own operations are in flight, a batch waits at
+    most 30 seconds in all for a host at maxPerHost to free a handle;
+    the paths that get no handle after that get -1. A caller should
+    release the clients it has leased for a host before running a
+    batch against it.
+    """
+
+    # the MetadataCache given to leased clients, if any
+    _cache = None
+
+    def __init__(self, handleAttr, maxPerHost = 4):
+        """
+        Constructs an instance. A wrapped pointer to the C pool is
+        stored as the ._pool attribute to the instance.
+
+        @param handleAttr: the attributes the handles are created with
+        @type handleAttr: instance of HandleAttr
+
+        @param maxPerHost: the largest number of handles kept per
+        host:port
+        @type maxPerHost: integer
+
+        @rtype: instance
+        @return: an instance of the class
+
+        @raise GridFTPClientException: raised if unable to create the pool
+        """
+        self._handleAttr = handleAttr
+        self._pool = None
+
+        try:
+            self._pool = gridftpwrapper.gridftp_handle_pool_init(handleAttr._attr, maxPerHost)
+        except Exception, e:
+            msg = "Unable to create handle pool: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def lease(self, url, block = True, timeout = None):
+        """
+        Lease a client for the host:port of a URL. The interpreter lock
+        is released while waiting.
+
+        @param url: a URL on the host the client is leased for
+        @type url: string
+
+        @param block: wait for a handle to be released if the host is
+        at maxPerHost
+        @type block: boolean
+
+        @param timeout: the number of seconds to wait, or None to wait
+        as long as it takes
+        @type timeout: float
+
+        @return: the leased client, or None if no handle was available
+        @rtype: instance of FTPClient
+
+        @raise GridFTPClientException: raised if unable to lease a handle
+        """
+        if timeout is None:
+            timeout = -1.0
+
+        try:
+            handle = gridftpwrapper.gridftp_handle_pool_lease(self._pool, url, int(block), float(timeout))
+        except Exception, e:
+            msg = "Unable to lease handle: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        if handle is None:
+            return None
+
+        client = FTPClient.__new__(FTPClient)
+        client._handleAttr = self._handleAttr
+        client._handle = handle
+        client._pool = self
+        client._cache = self._cache
+        return client
+
+    def release(self, client, discard = False):
+        """
+        Return a leased client to the pool. The client must not be used
+        afterwards.
+
+        @param client: the client returned by lease()
+        @type client: instance of FTPClient
+
+        @param discard: destroy the handle instead of keeping it, for
+        example after an error that may have broken its connection
+        @type discard: boolean
+
+        @return: None
+        @rtype: None
+
+        @raise GridFTPClientException: raised if the client was not
+        leased from this pool or has already been released
+        """
+        # the client lets go of the handle first, so that nothing else
+        # uses it once it is back in the pool
+        handle = client._handle
+        client._handle = None
+        client._pool = None
+        if handle is None:
+            msg = "Unable to release handle: the client has already been released"
             ex = GridFTPClientException(msg)
             raise ex
 
         try:
-            gridftpwrapper.gridftp_get(
-                self._handle, 
-                url,
-                opAttr._attr,
-                None,
-                completeCallback,
-                arg
-                )
+            gridftpwrapper.gridftp_handle_pool_release(self._pool, handle, int(discard))
         except Exception, e:
-            msg = "Unable to initiate get: %s" % e
+            msg = "Unable to release handle: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
-    def register_read(self, buffer, dataCallback, arg):
+    def set_metadata_cache(self, cache):
         """
-        Register an instance of class Buffer and the function dataCallback
-        to handle a part of the FTP data transfer.
+        Give a cache of metadata to the clients leased from now on, see
+        FTPClient.set_metadata_cache, and keep it up to date with the
+        results of the *_many and makedirs methods.
 
-        The instance of class Buffer will be associated with the current get being
-        performed on this client handle and data will be written into the
-        buffer. The user must then empty the buffer and register another
-        instance for the transfer to proceed. Note that if parallel data
-        channels are used multiple buffers should be registered.
+        @param cache: the cache, or None to stop caching
+        @type cache: instance of MetadataCache
 
-        When the instance of class Buffer is fulled the function
-        dataCallback will be called.
+        @return: None
+        @rtype: None
+        """
+        self._cache = cache
 
-        The dataCallback function must have the form:
+    def prewarm(self, urls, completeCallback = None, arg = None, opAttr = None):
+        """
+        Open and authenticate control connections to the servers of a
+        set of URLs in the background, so that the first lease for each
+        host:port does not pay for the handshake.
 
-        def dataCallback(arg, handle, error, buffer, length, offset, eof):
-            - arg is the user argument passed in when this function is called
-            - handle is the wrapped pointer to the client handle
-            - error is None or a string if there is an error
-            - buffer is the buffer from which the data can be read
-            - length is the number of bytes in the buffer
-            - offset is the offset into the file at which the bytes start
-            - eof is true if this is the end of the file
+        For each host:port with no idle handle a handle is leased
+        without waiting and an exists operation is started on the URL.
+        When it completes the handle goes back to the pool with its
+        connection open. A reply from the server, even an error such as
+        a missing file, means the connection is up; a handle that could
+        not reach its server is destroyed.
 
-        @param buffer: instance of class Buffer into which the data will be
-        written
-        @type buffer: instance of class Buffer
+        The completeCallback, if given, is called once per URL started
+        and must have the form:
 
-        @param dataCallback: function to be called when the instance of
-        Buffer is full
-        @type dataCallback: callable
+        def completeCallback(arg, url, error):
+            - arg is the user argument passed in to prewarm
+            - url is the URL that was warmed up
+            - error is None if the connection is open or a string if
+              the server could not be reached
 
-        @param arg: user argument to pass to the callback function
+        A CompletionQueue may be given in place of the callback, in which
+        case the event kind is CompletionQueue.PREWARM.
+
+        @param urls: URLs on the servers to connect to
+        @type urls: sequence of strings
+
+        @param completeCallback: function to call for each URL, or None
+        @type completeCallback: callable
+
+        @param arg: user argument to pass to the callback
         @type arg: any
 
-        @return: None
-        @rtype: None
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
 
-        @raises GridFTPException: raised if unable to register the buffer
-        and callback for reading
+        @return: the number of URLs a connection was started for
+        @rtype: integer
 
+        @raise GridFTPClientException: raised if unable to start
         """
         try:
-            gridftpwrapper.gridftp_register_read(
-                self._handle,
-                buffer._buffer,
-                buffer.size,
-                dataCallback,
+            return gridftpwrapper.gridftp_handle_pool_prewarm(
+                self._pool,
+                list(urls),
+                _optional_attr(opAttr),
+                _callback_object(completeCallback),
                 arg
                 )
         except Exception, e:
-            msg = "Unable to register read: %s" % e
+            msg = "Unable to prewarm handle pool: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
-            
-    def cksm(self, url, completeCallback, arg, opAttr = None, offset = None, length = None):
+    def _metadata_many(self, op, items, mode, window, opAttr, timeout):
+        """
+        Run one metadata operation per item over handles leased from
+        the pool, with at most window operations in flight, and wait
+        for them all.
+
+        @return: per item, 0 for success, the FTP reply code if the
+        server refused, such as 550 for a missing path, -1 if the
+        server could not be reached or the operation not started, or
+        HANDLE_ACQUIRE_TIMED_OUT if no handle was had within timeout
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the items are malformed
+        """
+        items = list(items)
+
+        try:
+            raw = gridftpwrapper.gridftp_handle_pool_metadata_many(
+                self._pool,
+                op,
+                items,
+                _optional_attr(opAttr),
+                mode,
+                window,
+                timeout
+                )
+        except Exception, e:
+            msg = "Unable to run %s on batch: %s" % (op, e)
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        results = array.array('i')
+        results.fromstring(raw)
+
+        if self._cache:
+            self._update_cache(op, items, results)
+        return results
+
+    def _update_cache(self, op, items, results):
+        """
+        Record the results of a batch of metadata operations in the
+        cache: what exists_many found, and the paths changed by the
+        others.
+        """
+        cache = self._cache
+        for item, code in zip(items, results):
+            if op == "exists":
+                if code == 0:
+                    cache.set(item, 'exists', True)
+                elif code == 550:
+                    cache.set(item, 'exists', False, True)
+            elif op == "move":
+                cache.invalidate(item[0], True)
+                cache.invalidate(item[1], True)
+            else:
+                cache.invalidate(item, op == "rmdir")
+
+    def exists_many(self, urls, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Check whether each of a list of paths exists, with up to window
+        checks in flight at once over the handles of the pool.
+
+        @param urls: the URLs to check
+        @type urls: sequence of strings
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 if it exists, 550 if it does not, another
+        FTP reply code if the server refused, or -1 if the server could
+        not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        return self._metadata_many("exists", urls, 0, window, opAttr, timeout)
+
+    def mkdir_many(self, urls, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Make each of a list of directories, with up to window requests
+        in flight at once over the handles of the pool. The parents are
+        not made, so a directory should come after its parent only if
+        the parent already exists.
+
+        @param urls: the URLs of the directories
+        @type urls: sequence of strings
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 for success, the FTP reply code if the
+        server refused or -1 if it could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        return self._metadata_many("mkdir", urls, 0, window, opAttr, timeout)
+
+    def rmdir_many(self, urls, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Remove each of a list of empty directories, with up to window
+        requests in flight at once over the handles of the pool.
+
+        @param urls: the URLs of the directories
+        @type urls: sequence of strings
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 for success, the FTP reply code if the
+        server refused or -1 if it could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        return self._metadata_many("rmdir", urls, 0, window, opAttr, timeout)
+
+    def delete_many(self, urls, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Delete each of a list of files, with up to window requests in
+        flight at once over the handles of the pool.
+
+        @param urls: the URLs of the files
+        @type urls: sequence of strings
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 for success, the FTP reply code if the
+        server refused or -1 if it could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        return self._metadata_many("delete", urls, 0, window, opAttr, timeout)
+
+    def chmod_many(self, urls, mode, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Change the mode of each of a list of paths, with up to window
+        requests in flight at once over the handles of the pool.
+
+        @param urls: the URLs of the paths
+        @type urls: sequence of strings
+
+        @param mode: the mode to set, such as 0644
+        @type mode: integer
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 for success, the FTP reply code if the
+        server refused or -1 if it could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        return self._metadata_many("chmod", urls, mode, window, opAttr, timeout)
+
+    def move_many(self, pairs, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Move each of a list of paths, with up to window requests in
+        flight at once over the handles of the pool. Source and
+        destination of a pair must be on the same server.
+
+        @param pairs: the paths as (src, dst) tuples of URLs
+        @type pairs: sequence of tuples
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per pair, 0 for success, the FTP reply code if the
+        server refused or -1 if it could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the pairs are malformed
+        """
+        return self._metadata_many("move", pairs, 0, window, opAttr, timeout)
+
+    def cksm_many(self, ranges, algorithm = "MD5", window = 16, opAttr = None, timeout = 30.0):
+        """
+        Get the checksums of ranges of files, with up to window requests
+        in flight at once over the handles of the pool. Checksums are not
+        taken from or put in the metadata cache.
+
+        @param ranges: (url, offset, length) for each range, length -1
+        for the rest of the file
+        @type ranges: sequence of tuples
+
+        @param algorithm: the checksum algorithm, one the servers support
+        @type algorithm: string
+
+        @param window: the largest number of requests in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the requests, or
+        None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: (cksm, code) for each range in order: the checksum and
+        0, or None and the FTP reply code if the server refused, or -1
+        if the server could not be reached
+        or HANDLE_ACQUIRE_TIMED_OUT; see batch_error
+        @rtype: list of tuples
+
+        @raise GridFTPClientException: raised if the ranges are
+        malformed or the algorithm unknown
+        """
+        try:
+            return gridftpwrapper.gridftp_handle_pool_cksm_many(
+                self._pool,
+                [(url, offset, length) for url, offset, length in ranges],
+                algorithm,
+                _optional_attr(opAttr),
+                window,
+                timeout
+                )
+        except Exception, e:
+            msg = "Unable to run cksm on batch: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def verify_ranges(self, srcUrl, localPath, chunkSize, algorithm = "MD5",
+                window = 16, localThreads = 4, opAttr = None, timeout = 30.0):
+        """
+        Compare a local copy of a file with the file on the server chunk
+        by chunk, to find the parts of a failed download to fetch again
+        with partial_get rather than the whole file.
+
+        The file is cut into chunks of chunkSize bytes. The server is
+        asked for the checksum of each chunk, up to window at once over
+        the handles of the pool, while the same chunks of the local file
+        are summed by localThreads threads with file_digests. Bytes of
+        the local file past the end of the remote one are not checked.
+
+        @param srcUrl: the URL of the file on the server
+        @type srcUrl: string
+
+        @param localPath: the path of the local copy
+        @type localPath: string
+
+        @param chunkSize: the size in bytes of each chunk compared
+        @type chunkSize: integer
+
+        @param algorithm: MD5, ADLER32 or CRC32C, one the server also
+        supports; see FTPClient.cksm_algorithms_sync
+        @type algorithm: string
+
+        @param window: the largest number of server requests in flight
+        @type window: integer
+
+        @param localThreads: the number of threads summing local chunks
+        @type localThreads: integer
+
+        @param opAttr: an instance of OperationAttr for the requests, or
+        None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait for a handle; see cksm_many
+        @type timeout: float
+
+        @return: a tuple (mismatched, unverified) of lists of the
+        (offset, length) of each run of chunks, in order, with adjacent
+        chunks merged. mismatched holds the chunks that differ, or that
+        the server reports missing with a 550 reply; unverified holds
+        those the server could not be asked about or refused to sum for
+        any other reason, which may or may not match. Both are empty if
+        the copies match
+        @rtype: tuple
+
+        @raise GridFTPClientException: raised if the size of the remote
+        file cannot be found, or the server gave no chunk checksum at
+        all, for example because it cannot checksum ranges
+        """
+        if chunkSize < 1:
+            msg = "Unable to verify ranges: chunkSize must be positive"
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        client = self.lease(srcUrl)
+        try:
+            size = client.mlst_sync(srcUrl, opAttr).size
+        finally:
+            self.release(client)
+        if size < 0:
+            msg = "Unable to verify ranges: no size for %s" % srcUrl
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        chunks = _split_ranges(size, chunkSize)
+        if not chunks:
+            return [], []
+
+        # the local sums run in threads while this one waits for the
+        # server; both wait with the interpreter lock released
+        local = [None] * len(chunks)
+        errors = []
+        nthreads = max(1, min(localThreads, len(chunks)))
+        share = (len(chunks) + nthreads - 1) // nthreads
+
+        def sumChunks(start):
+            try:
+                ranges = [(localPath, offset, length) for offset, length in chunks[start:start + share]]
+                local[start:start + len(ranges)] = file_digests(ranges, algorithm)
+            except Exception, e:
+                errors.append(e)
+
+        threads = [threading.Thread(target = sumChunks, args = (start,))
+                   for start in xrange(0, len(chunks), share)]
+        for thread in threads:
+            thread.start()
+        try:
+            remote = self.cksm_many([(srcUrl, offset, length) for offset, length in chunks],
+                algorithm, window, opAttr, timeout)
+        finally:
+            for thread in threads:
+                thread.join()
+
+        if errors:
+            raise errors[0]
+        if not [cksm for cksm, code in remote if cksm is not None]:
+            msg = "Unable to verify ranges: no chunk checksums from server, reply code %d" % remote[0][1]
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        mismatched = []
+        unverified = []
+        for (offset, length), (cksm, code), (digest, nbytes, error) in zip(chunks, remote, local):
+            if cksm is None and code != 550:
+                unverified.append((offset, length))
+            elif nbytes != length or not _cksm_equal(algorithm, digest, cksm):
+                mismatched.append((offset, length))
+        return _merge_ranges(mismatched), _merge_ranges(unverified)
+
+    def makedirs_many(self, urls, window = 64, opAttr = None, timeout = 30.0):
+        """
+        Make each of a list of directories along with any missing
+        parents, like mkdir -p.
+
+        The trees are made one level at a time, the directories of a
+        level in parallel with up to window requests in flight. The pool
+        remembers the directories it made or found to exist, so they
+        cost no round trip the next time, and a directory another thread
+        is making is waited for rather than made twice. When mkdir is
+        refused, the path only counts as made if its MLST type fact is
+        dir, so a file in the way fails the URLs under it. Directories
+        removed or moved through the pool are forgotten, but one that is
+        removed behind the pool's back is not noticed until
+        forget_dirs() is called.
+
+        @param urls: the URLs of the directories
+        @type urls: sequence of strings
+
+        @param window: the largest number of operations in flight
+        @type window: integer
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait in all for a handle while
+        none of the batch is in flight, after which the items left get
+        HANDLE_ACQUIRE_TIMED_OUT
+        @type timeout: float
+
+        @return: per URL, 0 for success, or the FTP reply code, -1 if
+        the server could not be reached or HANDLE_ACQUIRE_TIMED_OUT, of
+        the first directory on its path that could not be made; see
+        batch_error
+        @rtype: array('i')
+
+        @raise GridFTPClientException: raised if the URLs are malformed
+        """
+        urls = list(urls)
+
+        try:
+            raw = gridftpwrapper.gridftp_handle_pool_makedirs(
+                self._pool,
+                urls,
+                _optional_attr(opAttr),
+                window,
+                timeout
+                )
+        except Exception, e:
+            msg = "Unable to make directories: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+        results = array.array('i')
+        results.fromstring(raw)
+
+        # any parent on the way may have been made as well
+        if self._cache:
+            for url in urls:
+                path = _metadata_key(url)
+                scheme = path.find('://')
+                root = path.find('/', scheme >= 0 and scheme + 3 or 0)
+                while root >= 0 and len(path) > root + 1:
+                    self._cache.invalidate(path)
+                    path = path[:max(path.rfind('/'), root + 1)]
+        return results
+
+    def makedirs(self, url, opAttr = None, timeout = 30.0):
+        """
+        Make a directory along with any missing parents, like mkdir -p,
+        skipping those the pool knows to exist. See makedirs_many.
+
+        @param url: the URL of the directory
+        @type url: string
+
+        @param opAttr: an instance of OperationAttr for the operations,
+        or None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @param timeout: the seconds to wait for a handle; see
+        makedirs_many
+        @type timeout: float
+
+        @return: None
+
+        @raise GridFTPClientException: raised if the directory or one of
+        its parents could not be made
+        """
+        code = self.makedirs_many([url], 1, opAttr, timeout)[0]
+        if code:
+            msg = "Unable to make directory %s: %s" % (url, batch_error(code))
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def forget_dirs(self, url = None):
+        """
+        Forget the directories the pool knows to exist, so that
+        makedirs checks them again. The rmdir_many, delete_many and
+        move_many methods, and the rmdir and move methods of leased
+        clients, already forget the paths they remove or move away.
+
+        @param url: forget only the directory at url and those under
+        it, or None to forget them all
+        @type url: string
+
+        @return: the number of directories forgotten
+        @rtype: integer
+        """
+        try:
+            return gridftpwrapper.gridftp_handle_pool_forget_dirs(self._pool, url)
+        except Exception, e:
+            msg = "Unable to forget directories: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def remember_dirs(self, urls):
+        """
+        Record directories as known to exist, for example those made by
+        another client, so that makedirs skips them. Their parents are
+        not recorded.
+
+        @param urls: the URLs of the directories
+        @type urls: sequence of strings
+
+        @return: the number of directories that were not known before
+        @rtype: integer
+        """
+        try:
+            return gridftpwrapper.gridftp_handle_pool_remember_dirs(self._pool, list(urls))
+        except Exception, e:
+            msg = "Unable to remember directories: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
+
+    def known_dirs(self):
+        """
+        Return the directories the pool knows to exist. The URLs are
+        spelled the way the pool keys them: the scheme and host in lower
+        case, the port always given, and the path without repeated or
+        trailing slashes.
+
+        @return: the URLs of the directories, sorted
+        @rtype: list
+        """
+        return sorted(gridftpwrapper.gridftp_handle_pool_known_dirs(self._pool))
+
+    def walk(self, rootUrl, maxConcurrency = 16, maxDepth = -1, opAttr = None):
+        """
+        Walk the directory tree below a URL, listing directories in
+        parallel over handles from the pool. See TreeWalker.
+
+        @param rootUrl: the URL of the directory to start from
+        @type rootUrl: string
+
+        @param maxConcurrency: the largest number of directories listed
+        at once
+        @type maxConcurrency: integer
+
+        @param maxDepth: the number of levels below rootUrl to list, or
+        -1 for all of them
+        @type maxDepth: integer
+
+        @param opAttr: an instance of OperationAttr for the listings, or
+        None for the default attributes
+        @type opAttr: instance of OperationAttr
+
+        @return: a generator of (dirUrl, listing, error) tuples, listing
+        being an instance of Listing, in the order the listings complete
+        @rtype: generator
+
+        @raise GridFTPClientException: raised if unable to start the walk
+        """
+        walker = TreeWalker(self, [rootUrl], maxConcurrency, maxDepth, opAttr)
+        try:
+            for item in walker:
+                yield item
+        finally:
+            walker.destroy()
+
+    def trim(self):
+        """
+        Destroy the idle handles, closing their cached connections.
+
+        @return: the number of handles destroyed
+        @rtype: integer
+        """
+        return gridftpwrapper.gridftp_handle_pool_trim(self._pool)
+
+    def stats(self):
+        """
+        Return the number of idle and leased handles per host:port.
+
+        @return: a dictionary mapping host:port to a tuple (idle, leased)
+        @rtype: dict
+        """
+        return gridftpwrapper.gridftp_handle_pool_stats(self._pool)
+
+    def destroy(self):
+        """
+        Destroy an instance and its idle handles. Every leased client
+        must have been released first.
+
+        @rtype: None
+        @return: None
+
+        @raise GridFTPClientException: raised if clients are still leased
         """
-        Get a file's checksum from an FTP server.
+        if self._pool:
+            try:
+                gridftpwrapper.gridftp_handle_pool_destroy(self._pool)
+                self._pool = None
+            except Exception, e:
+                msg = "Unable to destroy handle pool: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
 
-        This function requests the checksum of a file from an FTP server.
+class TransferQueue(object):
+    """
+    A queue of third party transfer jobs run natively over a HandlePool.
+
+    Jobs are submitted in batches and started in C as the limits allow:
+    at most maxActive transfers at once, and at most maxPerPair between
+    any one source and destination host:port, so no single server is
+    overloaded. Handles are leased from the pool under the key of the
+    endpoint pair, so transfers between the same endpoints reuse the
+    same cached connections and the maxPerHost of the pool caps each
+    pair as well. The queue must be destroyed before the pool.
+
+    Each job has a priority class from 0, the highest, to PRIORITIES - 1.
+    Waiting jobs of a higher class always start first; within a class
+    the endpoint pairs take turns.
+
+    With set_size_policy() the queue sizes each file before moving it,
+    so that large files are split into chunks moved over several handles
+    at once and small files are pipelined together on one session, and
+    neither holds up the other.
+
+    Completions are reported per job to the completeCallback, which is
+    best given as a CompletionQueue so they can be drained in batches
+    without the Globus threads taking the interpreter lock:
+
+        queue = CompletionQueue()
+        tq = TransferQueue(pool, queue, maxActive = 64, maxPerPair = 4)
+        tq.submit(jobs)
+        while tq.stats()['completed'] < len(jobs):
+            for kind, (arg, src, dst, error) in queue.drain():
+                ...
+
+    A callback function must have the form:
+
+        def completeCallback(arg, src, dst, error):
+            - arg is the argument given with the job, or None
+            - src and dst are the URLs of the job
+            - error is None for success or a string if an error occurred
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the operation and the
-        checksum value. 
+    and the event kind from a CompletionQueue is
+    CompletionQueue.TRANSFER.
+    """
 
-        The completeCallback must have the form:
+    PRIORITIES = gridftpwrapper.TRANSFER_PRIORITIES
 
-        def completeCallback(cksm, arg, handle, error):
-            - cksm is the Python string containing the checksum value
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+    def __init__(self, pool, completeCallback, maxActive = 64, maxPerPair = 4,
+                srcOpAttr = None, dstOpAttr = None):
+        """
+        Constructs an instance. A wrapped pointer to the C queue is
+        stored as the ._queue attribute to the instance.
 
-        @param url: the source URL for the file to be checksummed
-        @type url: string
+        @param pool: the pool to lease handles from
+        @type pool: instance of HandlePool
 
-        @param completeCallback: the function to be called when the checksum
-        operation is complete
-        @type completeCallback: callable
+        @param completeCallback: function to call, or CompletionQueue to
+        record into, for each job
+        @type completeCallback: callable or instance of CompletionQueue
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+        @param maxActive: the largest number of transfers running at once
+        @type maxActive: integer
 
-        @param opAttr: an instance of OperationAttr for the source
-        @type opAttr: instance of OperationAttr
+        @param maxPerPair: the largest number of transfers running at
+        once between one source and destination
+        @type maxPerPair: integer
 
-        @param offset: the offset in bytes into the file at which to begin computing
-        the checkusm, use None to start at the beginning of the file
-        @type offset: integer
+        @param srcOpAttr: an instance of OperationAttr for the sources,
+        or None for the default attributes
+        @type srcOpAttr: instance of OperationAttr
 
-        @param length: the length of the file in bytes to use when
-        computing the checksum, use None to checksum the entire file
-        @type length: integer
+        @param dstOpAttr: an instance of OperationAttr for the
+        destinations, or None for the default attributes
+        @type dstOpAttr: instance of OperationAttr
 
-        @return: None
-        @rtype: None
+        @rtype: instance
+        @return: an instance of the class
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        checksum operation
+        @raise GridFTPClientException: raised if unable to create the queue
         """
-
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
-        if not offset:
-            offset = 0
-        if not length:
-            length = -1
+        self._queue = None
+        self.pool = pool
+
+        # the cached facts of each destination are dropped again when
+        # its job completes, as for FTPClient writes
+        def invalidate(args):
+            if pool._cache:
+                pool._cache.invalidate(args[2])
+
+        if isinstance(completeCallback, CompletionQueue):
+            completeCallback._after_each(CompletionQueue.TRANSFER, invalidate)
+        else:
+            callback = completeCallback
+            def invalidatingCallback(*args):
+                invalidate(args)
+                callback(*args)
+            completeCallback = invalidatingCallback
 
         try:
-            gridftpwrapper.gridftp_cksm(self._handle, url, opAttr._attr, offset, length, completeCallback, arg)
+            self._queue = gridftpwrapper.gridftp_transfer_queue_init(
+                pool._pool,
+                _callback_object(completeCallback),
+                maxActive,
+                maxPerPair,
+                _optional_attr(srcOpAttr),
+                _optional_attr(dstOpAttr)
+                )
         except Exception, e:
-            msg = "Unable to cksm: %s" % e
+            msg = "Unable to create transfer queue: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
-    def mkdir(self, url, completeCallback, arg, opAttr = None):
+    def set_size_policy(self, chunkThreshold = 0, chunkSize = 268435456,
+                smallThreshold = 0, batchSize = 64):
         """
-        Make a directory on a server.
+        Schedule jobs by the size of their source file, which is asked
+        for on the handle each job is given unless it was submitted with
+        the job. Applies to the jobs not yet started.
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
-
-        The completeCallback must have the form:
+        Files of at least chunkThreshold bytes are split into chunks of
+        chunkSize bytes, each moved as a partial transfer, so up to
+        maxPerPair handles work on one file; the job is reported once
+        every chunk is done, with the first error of any of them.
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+        Files under smallThreshold bytes go ahead of the other jobs of
+        their endpoint pair and up to batchSize of them are moved as one
+        pipelined transfer over a single session. The pool must be
+        created from a HandleAttr with set_pipeline() called for the
+        files to be pipelined; without it they are moved one at a time.
 
-        @param url: the source URL for the directory to be created
-        @type url: string
+        @param chunkThreshold: the size from which files are chunked, or
+        0 to chunk none
+        @type chunkThreshold: integer
 
-        @param completeCallback: the function to be called
-        when the mkdir operation is complete
-        @type completeCallback: callable
+        @param chunkSize: the size of each chunk in bytes
+        @type chunkSize: integer
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+        @param smallThreshold: the size under which files are pipelined,
+        or 0 to pipeline none
+        @type smallThreshold: integer
 
-        @param opAttr: an instance of OperationAttr for the source
-        @type opAttr: instance of OperationAttr
+        @param batchSize: the largest number of small files pipelined
+        together
+        @type batchSize: integer
 
         @return: None
-        @rtype: None
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        mkdir operation
+        @raise GridFTPClientException: raised if a parameter is out of
+        range
         """
-
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
-
         try:
-            gridftpwrapper.gridftp_mkdir(self._handle, url, opAttr._attr, completeCallback, arg)
+            gridftpwrapper.gridftp_transfer_queue_set_policy(
+                self._queue,
+                chunkThreshold,
+                chunkSize,
+                smallThreshold,
+                batchSize
+                )
         except Exception, e:
-            msg = "Unable to mkdir: %s" % e
+            msg = "Unable to set size policy: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
-    def popen(self, server, cmd, cmd_args, buff_size=1024):
-        """
-        Call 'popen' on server.
-
-        server (string): name of server. Example: 'gsiftp://oregano.phys.uwm.edu'
-        cmd (string): command to issue on server. Example: '/bin/df'
-        cmd_args (list of strings): list of arguments to pass to cmd. Example: ['-i', '/opt']
-
-        return a string, viz. the contents of whatever register_read returns.
-
-        raises GridFTPClientException
 
-        Example use:
+    def submit(self, jobs):
+        """
+        Add a batch of jobs and start as many as the limits allow.
 
-          import gridftpClient
-          
-          cmd='/bin/df'
-          cmd_args=['-ih', '/opt']
-          server = "gsiftp://oregano.phys.uwm.edu"
-          h = gridftpClient.HandleAttr()
-          myClient = gridftpClient.FTPClient(h)
-          outstr=myClient.popen(server, cmd, cmd_args)
-          print outstr
+        @param jobs: the jobs as (src, dst), (src, dst, priority),
+        (src, dst, priority, arg) or (src, dst, priority, arg, size)
+        tuples; priority defaults to 0 and arg to None. A known size
+        spares the size query of the size policy for the job
+        @type jobs: sequence of tuples
 
-        results in the following output:
+        @return: the number of jobs added
+        @rtype: integer
 
-          Filesystem            Inodes   IUsed   IFree IUse% Mounted on
-          /dev/sdb1                47M    4.4K     47M    1% /opt
-  
+        @raise GridFTPClientException: raised if a job is malformed, in
+        which case none of the batch is added
         """
-
-        def transfer_done(arg, handle, error):
-            """
-            complete callback function
-            """
-            theCondition = arg
-            theCondition.acquire()
-            if error:
-                print "Callback: error is %s" % error
-                sys.stdout.flush()
-            else:
-                pass
-            theCondition.notify()
-            theCondition.release()
-            
-        def transfer_read(mydict, handle, error, buff, length, offset, eof):
-            """
-            datacallback function
-            """
-            mydict['buffer_string']+=str(buff)
-            if not eof:
-                self.register_read(mydict['my_buffer'], transfer_read, mydict) 
-
         try:
-            import threading
-            myCondition = threading.Condition()
-            myCondition.acquire()
-    
-            opAttr = OperationAttr()
-            disk_stack='#'.join(["popen:argv=",cmd]+cmd_args)
-            opAttr.set_disk_stack(disk_stack)
-            buffer = Buffer(buff_size)
-            self.get(server, transfer_done, myCondition, opAttr, None)
-            mydict={'client_handle': self, 'buffer_string': "", 'my_buffer': buffer}
-            self.register_read(buffer, transfer_read, mydict)
-            myCondition.wait()
+            jobs = list(jobs)
+            if self.pool._cache:
+                for job in jobs:
+                    self.pool._cache.invalidate(job[1])
+            return gridftpwrapper.gridftp_transfer_queue_submit(self._queue, jobs)
         except Exception, e:
-            msg = "problem with popen: %s" %e
+            msg = "Unable to submit to transfer queue: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
-        return mydict['buffer_string']
 
+    def stats(self):
+        """
+        Return the progress of the queue.
 
-    def rmdir(self, url, completeCallback, arg, opAttr = None):
+        @return: a dictionary with the number of jobs queued, counting
+        each chunk of a large file, and completed, the number of
+        transfers active, the number of endpoint pairs seen, and the
+        number of chunk and pipelined transfers started
+        @rtype: dict
         """
-        Remove a directory on a server.
+        return gridftpwrapper.gridftp_transfer_queue_stats(self._queue)
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
+    def destroy(self):
+        """
+        Destroy an instance. Jobs not yet started are dropped without
+        being reported; the call waits for the running transfers to
+        complete and be reported.
 
-        The completeCallback must have the form:
+        @return: the number of jobs dropped
+        @rtype: integer
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+        @raise GridFTPClientException: raised if unable to destroy the
+        queue
+        """
+        if self._queue:
+            try:
+                ndropped = gridftpwrapper.gridftp_transfer_queue_destroy(self._queue)
+                self._queue = None
+                return ndropped
+            except Exception, e:
+                msg = "Unable to destroy transfer queue: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+        return 0
 
-        @param url: the source URL for the directory to be removed
-        @type url: string
+class TreeWalker(object):
+    """
+    A walk of the directory trees below a set of URLs, listed natively
+    over a HandlePool.
+
+    The directories are listed in C with MLSD, up to maxConcurrency at
+    once over handles leased from the pool, and the subdirectories each
+    listing turns up are queued to be listed in turn. Each host:port
+    keeps its own stack of directories waiting, so a host goes depth
+    first and the number waiting stays small, while the hosts take turns
+    for the free handles and a slow or saturated server does not hold up
+    the others. Symbolic links are not followed, and the names of
+    subdirectories are percent-encoded in the URLs they are listed by.
+
+    The listings are handed back in batches as they complete, without
+    the Globus threads taking the interpreter lock. The walker stops
+    starting listings while Python falls behind, so memory stays bounded.
+    The walker must be destroyed before the pool.
+
+        walker = TreeWalker(pool, [url], maxConcurrency = 16)
+        try:
+            for dirUrl, listing, error in walker:
+                ...
+        finally:
+            walker.destroy()
+    """
 
-        @param completeCallback: the function to be called
-        when the mkdir operation is complete
-        @type completeCallback: callable
+    def __init__(self, pool, rootUrls, maxConcurrency = 16, maxDepth = -1, opAttr = None):
+        """
+        Constructs an instance and starts the walk. A wrapped pointer to
+        the C walker is stored as the ._walker attribute to the instance.
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+        @param pool: the pool to lease handles from
+        @type pool: instance of HandlePool
 
-        @param opAttr: an instance of OperationAttr for the source
+        @param rootUrls: the URLs of the directories to start from
+        @type rootUrls: sequence of strings
+
+        @param maxConcurrency: the largest number of directories listed
+        at once
+        @type maxConcurrency: integer
+
+        @param maxDepth: the number of levels below the roots to list, or
+        -1 for all of them
+        @type maxDepth: integer
+
+        @param opAttr: an instance of OperationAttr for the listings, or
+        None for the default attributes
         @type opAttr: instance of OperationAttr
 
-        @return: None
-        @rtype: None
+        @rtype: instance
+        @return: an instance of the class
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        mkdir operation
+        @raise GridFTPClientException: raised if unable to create the
+        walker
         """
-
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+        self._walker = None
+        self.pool = pool
 
         try:
-            gridftpwrapper.gridftp_rmdir(self._handle, url, opAttr._attr, completeCallback, arg)
+            self._walker = gridftpwrapper.gridftp_walker_init(
+                pool._pool,
+                list(rootUrls),
+                _optional_attr(opAttr),
+                maxConcurrency,
+                maxDepth
+                )
         except Exception, e:
-            msg = "Unable to rmdir: %s" % e
+            msg = "Unable to create tree walker: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
-    def delete(self, url, completeCallback, arg, opAttr = None):
+    def next_batch(self, maxResults = 64, timeout = None):
         """
-        Delete a file on a server.
+        Take the directory listings that have completed, waiting for
+        one if none has.
+
+        @param maxResults: the largest number of listings to take
+        @type maxResults: integer
+
+        @param timeout: seconds to wait for a listing, or None to wait
+        for as long as the walk goes on
+        @type timeout: float
+
+        @return: a tuple (done, results), done being True once every
+        directory has been listed and taken, and results a list of
+        (dirUrl, listing, error) tuples, listing being an instance of
+        Listing and error None or a string if the directory could not
+        be listed, or some of its subdirectories could not be queued
+        @rtype: tuple
+        """
+        if timeout is None:
+            timeout = -1.0
+        done, results = gridftpwrapper.gridftp_walker_next(self._walker, maxResults, float(timeout))
+        return done, [(url, Listing(columns), error) for url, columns, error in results]
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
+    def __iter__(self):
+        """
+        Iterate over the (dirUrl, listing, error) tuples of the walk
+        as the listings complete.
+        """
+        while True:
+            done, results = self.next_batch()
+            for item in results:
+                yield item
+            if done:
+                return
+
+    def stats(self):
+        """
+        Return the progress of the walk.
 
-        The completeCallback must have the form:
+        @return: a dictionary with the number of directories queued,
+        being listed, listed and not yet taken, and listed in all, the
+        number of entries found, and the number of listings handed back
+        with an error
+        @rtype: dict
+        """
+        return gridftpwrapper.gridftp_walker_stats(self._walker)
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
+    def destroy(self):
+        """
+        Destroy an instance. Directories not yet listed are dropped;
+        the call waits for the running listings to complete.
+
+        @return: the number of directories dropped
+        @rtype: integer
+
+        @raise GridFTPClientException: raised if unable to destroy the
+        walker
+        """
+        if self._walker:
+            try:
+                ndropped = gridftpwrapper.gridftp_walker_destroy(self._walker)
+                self._walker = None
+                return ndropped
+            except Exception, e:
+                msg = "Unable to destroy tree walker: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
+        return 0
+
+class StripedGet(object):
+    """
+    A get of one file over several handles at once.
+
+    The file is split into byte ranges that are fetched with partial
+    gets over streams handles, each with its own control and data
+    connections, and written in place in the local file. Ranges are
+    handed out large at first and smaller towards the end of the file,
+    and when the file has been handed out a stream that runs dry takes
+    over the upper half of what the slowest stream still has to fetch,
+    so a slow stream does not hold up the end of the transfer. Splitting
+    a range once it has started needs the data to arrive in order, so
+    with an OperationAttr in extended block mode the ranges are only
+    balanced by their sizes.
+
+    The whole transfer runs in C without the Python interpreter, like
+    FTPClient.get_to_file(). The instance must be destroyed once the
+    completeCallback has been called.
+    """
+    def __init__(self, handleAttr, url, dest, completeCallback, arg,
+                opAttr = None, streams = 4, nbuffers = 2, bufsize = 1048576,
+                minChunk = 8388608):
+        """
+        Constructs an instance and starts the transfer. A wrapped pointer
+        to the C engine is stored as the ._engine attribute to the
+        instance.
+
+        The completeCallback is called once, when every range has been
+        written or the transfer has failed or been aborted, and must have
+        the form:
+
+        def completeCallback(arg, handle, error, nbytes):
+            - arg is the user argument passed in when the transfer was
               initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+            - handle is None since the transfer used several handles
+            - error is None for success or a string if an error occurred,
+              including an error writing the local file
+            - nbytes is the number of bytes written to the local file
 
-        @param url: the source URL for the file to be deleted
+        A CompletionQueue may be given in place of the callback, in which
+        case the event kind is CompletionQueue.STRIPED_GET.
+
+        @param handleAttr: the attributes every handle is created with
+        @type handleAttr: instance of HandleAttr
+
+        @param url: the source URL to get
         @type url: string
 
-        @param completeCallback: the function to be called
-        when the mkdir operation is complete
+        @param dest: the path of the local file, which is created or
+        truncated, or an open file descriptor to write to which is left
+        open
+        @type dest: string or integer
+
+        @param completeCallback: function to call when the transfer is
+        complete
         @type completeCallback: callable
 
-        @param arg: user argument to pass to the callback function
+        @param arg: user argument to pass to the callback
         @type arg: any
 
-        @param opAttr: an instance of OperationAttr for the source
+        @param opAttr: an instance of OperationAttr used for every range,
+        or None for the default attributes
         @type opAttr: instance of OperationAttr
 
-        @return: None
-        @rtype: None
+        @param streams: the number of handles to fetch ranges over
+        @type streams: integer
+
+        @param nbuffers: the number of buffers each handle keeps
+        registered
+        @type nbuffers: integer
+
+        @param bufsize: the size in bytes of each buffer
+        @type bufsize: integer
+
+        @param minChunk: the smallest range in bytes handed to a handle
+        @type minChunk: integer
+
+        @rtype: instance
+        @return: an instance of the class
+
+        @raise GridFTPClientException: raised if unable to start the
+        transfer
+        """
+        self._engine = None
+
+        try:
+            self._engine = gridftpwrapper.gridftp_striped_get(
+                handleAttr._attr,
+                url,
+                _optional_attr(opAttr),
+                dest,
+                streams,
+                nbuffers,
+                bufsize,
+                minChunk,
+                _callback_object(completeCallback),
+                arg
+                )
+        except Exception, e:
+            msg = "Unable to initiate striped get: %s" % e
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        delete operation
+    def status(self):
         """
+        Return the progress of the transfer.
 
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+        @return: a dictionary with the keys size, the size of the file or
+        0 while it is not yet known, nbytes, the number of bytes written,
+        streams, a list of the bytes written by each handle, and done,
+        True once the completeCallback has been called
+        @rtype: dict
 
+        @raise GridFTPClientException: raised if unable to get the status
+        """
         try:
-            gridftpwrapper.gridftp_delete(self._handle, url, opAttr._attr, completeCallback, arg)
+            return gridftpwrapper.gridftp_striped_get_status(self._engine)
         except Exception, e:
-            msg = "Unable to delete: %s" % e
+            msg = "Unable to get striped get status: %s" % e
             ex = GridFTPClientException(msg)
             raise ex
 
-    def move(self, src, dst, completeCallback, arg, opAttr = None):
+    def abort(self):
         """
-        Move or rename a file on a server.
+        Abort the transfer. The completeCallback is still called, with
+        an error.
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
+        @return: None
+        @rtype: None
 
-        The completeCallback must have the form:
+        @raise GridFTPClientException: raised if unable to abort
+        """
+        if self._engine:
+            try:
+                gridftpwrapper.gridftp_striped_get_abort(self._engine)
+            except Exception, e:
+                msg = "Unable to abort striped get: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+    def destroy(self):
+        """
+        Destroy an instance and its handles. This is only possible once
+        the completeCallback has been called.
 
-        @param src: the source URL for the file to be moved
-        @type src: string
+        @rtype: None
+        @return: None
 
-        @param dst: the destination URL for the file to be moved
-        @type dst: string
+        @raise GridFTPClientException: raised if the transfer is still
+        in progress or unable to free the memory
+        """
+        if self._engine:
+            try:
+                gridftpwrapper.gridftp_striped_get_destroy(self._engine)
+                self._engine = None
+            except Exception, e:
+                msg = "Unable to destroy striped get: %s" % e
+                ex = GridFTPClientException(msg)
+                raise ex
 
-        @param completeCallback: the function to be called
-        when the mkdir operation is complete
-        @type completeCallback: callable
+class Operation(object):
+    """
+    The pending result of an operation started through AsyncFTPClient.
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+    The interface is the subset of the asyncio/trollius Future interface
+    needed to wait for and collect a result, so that an Operation can be
+    used where a future is expected when no event loop was given to the
+    AsyncFTPClient.
+    """
+    def __init__(self):
+        """
+        Constructs an instance.
 
-        @param opAttr: an instance of OperationAttr for the source
-        @type opAttr: instance of OperationAttr
+        @rtype: instance
+        @return: an instance of the class
+        """
+        self._done = False
+        self._result = None
+        self._exception = None
+        self._callbacks = []
 
-        @return: None
-        @rtype: None
+    def done(self):
+        """
+        Return True if the operation has completed.
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        delete operation
+        @rtype: boolean
+        @return: True once a result or exception has been set
         """
+        return self._done
 
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+    def cancelled(self):
+        """
+        Return True if the operation was cancelled, which an Operation
+        never is; it is here for the code that also handles futures.
 
-        try:
-            gridftpwrapper.gridftp_move(self._handle, src, dst, opAttr._attr, completeCallback, arg)
-        except Exception, e:
-            msg = "Unable to move: %s" % e
-            ex = GridFTPClientException(msg)
-            raise ex
+        @rtype: boolean
+        @return: False
+        """
+        return False
 
-    def chmod(self, url, mode, completeCallback, arg, opAttr = None):
+    def result(self):
         """
-        Change the mode of a file on a server.
+        Return the result of the operation.
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
+        @return: the result of the operation
+        @rtype: any
 
-        The completeCallback must have the form:
+        @raise GridFTPClientException: raised if the operation failed or
+        has not completed yet
+        """
+        if not self._done:
+            msg = "Operation has not completed"
+            ex = GridFTPClientException(msg)
+            raise ex
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for success or a string if an error occurred
+        if self._exception:
+            raise self._exception
 
-        @param url: the source URL for the file 
-        @type url: string
+        return self._result
 
-        @param mode: the integer file mode, be sure to use 4
-        digits, for example 0644 instead of 644.
-        @type mode: integer
+    def exception(self):
+        """
+        Return the exception the operation failed with, or None.
 
-        @param completeCallback: the function to be called
-        when the mkdir operation is complete
-        @type completeCallback: callable
+        @rtype: instance of GridFTPClientException
+        @return: the exception, or None on success
+        """
+        return self._exception
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+    def add_done_callback(self, fn):
+        """
+        Arrange for fn(operation) to be called when the operation
+        completes, or at once if it already has.
 
-        @param opAttr: an instance of OperationAttr for the source
-        @type opAttr: instance of OperationAttr
+        @param fn: the function to call
+        @type fn: callable
+        """
+        if self._done:
+            fn(self)
+        else:
+            self._callbacks.append(fn)
 
-        @return: None
-        @rtype: None
+    def set_result(self, result):
+        """
+        Mark the operation completed with a result.
+        """
+        self._result = result
+        self._finish()
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        delete operation
+    def set_exception(self, exception):
         """
+        Mark the operation failed with an exception.
+        """
+        self._exception = exception
+        self._finish()
 
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+    def _finish(self):
+        self._done = True
+        callbacks, self._callbacks = self._callbacks, []
+        for fn in callbacks:
+            fn(self)
 
-        try:
-            gridftpwrapper.gridftp_chmod(self._handle, url, mode, opAttr._attr, completeCallback, arg)
-        except Exception, e:
-            msg = "Unable to chmod: %s" % e
-            ex = GridFTPClientException(msg)
-            raise ex
+class AsyncFTPClient(object):
+    """
+    A client whose methods start operations and return futures instead
+    of taking a callback and an argument.
+
+    Operations are run on a set of FTPClient handles, at most maxHandles
+    of them, each running one operation at a time; further operations
+    wait in order for a free handle. All completions are collected
+    through one CompletionQueue, so the Globus threads never take the
+    Python interpreter lock.
+
+    When an event loop is given (an asyncio or trollius loop, or any
+    loop with add_reader/remove_reader and create_future) the futures
+    are the loop's own, so they can be awaited or yielded from, and the
+    queue's file descriptor is registered with add_reader: a batch of
+    completions costs one wake-up of the loop, not one call_soon_threadsafe
+    per event. Without a loop the futures are Operation instances and
+    completions are processed by calling process(), for example when
+    fileno() polls readable in a select loop, or by wait().
+    """
 
-    def verbose_list(self, url, completeCallback, arg, opAttr = None):
+    def __init__(self, handleAttr, opAttr, maxHandles = 16, loop = None):
         """
-        Get a file listing from a FTP server.
+        Constructs an instance.
 
-        This function starts a verbose file listing from an FTP server. If
-        this function returns without exception then the user may immediately
-        begin calling register_read() to retrieve the data associated with this
-        operation.
+        @param handleAttr: the handle attributes used for every handle
+        @type handleAttr: instance of HandleAttr
 
-        When all of the data associated with this URL is retrieved, and all
-        of the data callbacks have been called, or if the verbose list request is
-        aborted, the completeCallback will be invoked with the final
-        status of the get.
+        @param opAttr: the operation attributes used when a method is
+        not given its own
+        @type opAttr: instance of OperationAttr
 
-        The completeCallback function must have the form:
+        @param maxHandles: the largest number of operations in flight
+        @type maxHandles: integer
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the transfer was
-              initiated
-            - handle is the wrapped pointer to the client handle
-            - error is None for success or a string if an error occurred
+        @param loop: an event loop to deliver completions to, or None
+        @type loop: event loop
 
-        @param url: the source URL from which to get the file listing
-        @type url: string
+        @rtype: instance
+        @return: an instance of the class
 
-        @param completeCallback: function to call when the listing is
-        complete
-        @type completeCallback: callable
+        @raise GridFTPClientException: raised if unable to create the
+        completion queue
+        """
+        self._handleAttr = handleAttr
+        self._opAttr = opAttr
+        self._maxHandles = maxHandles
+        self._loop = loop
 
-        @param arg: user argument to pass to the callback
-        @type arg: any
+        self._queue = CompletionQueue()
+        self._clients = []
+        self._idle = []
+        self._waiting = collections.deque()
+        self._inflight = {}
+        self._nextId = 0
 
-        @param opAttr: an instance of OperationAttr for the transfer
-        @type opAttr: instance of OperationAttr
+        if self._loop:
+            self._loop.add_reader(self._queue.fileno(), self.process)
+
+    def destroy(self):
+        """
+        Destroy the handles of the instance. Operations must not be in
+        flight.
 
         @return: None
         @rtype: None
 
-        @raise GridFTPClientException: raised if unable to initiate the verbose
-        list operation
-
+        @raise GridFTPClientException: raised if operations are in
+        flight or if unable to destroy a handle
         """
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
+        if self._inflight:
+            msg = "Unable to destroy client with operations in flight"
             ex = GridFTPClientException(msg)
             raise ex
 
-        try:
-            gridftpwrapper.gridftp_verbose_list(
-                self._handle, 
-                url,
-                opAttr._attr,
-                completeCallback,
-                arg
-                )
-        except Exception, e:
-            msg = "Unable to initiate verbose list: %s" % e
-            ex = GridFTPClientException(msg)
-            raise ex
+        if self._loop:
+            self._loop.remove_reader(self._queue.fileno())
+            self._loop = None
+
+        clients, self._clients, self._idle = self._clients, [], []
+        for client in clients:
+            client.destroy()
 
-    def exists(self, url, completeCallback, arg, opAttr = None):
+    def fileno(self):
         """
-        Check for the existence of a file or directory on a remote server.
+        Return the file descriptor that is readable whenever completions
+        are waiting to be processed.
 
-        When the request is completed or aborted, the completeCallback
-        will be invoked with the final status of the
-        operation.
+        @return: the file descriptor
+        @rtype: integer
+        """
+        return self._queue.fileno()
 
-        The completeCallback must have the form:
+    def process(self, maxEvents = 0, timeout = 0):
+        """
+        Resolve the futures of the operations that have completed and
+        start waiting operations on the freed handles.
 
-        def completeCallback(arg, handle, error):
-            - arg is the user argument passed in when the call was
-              initiated
-            - handle is the wrapper pointer to the client handle
-            - error is None for existence or a string if an error occurred
+        @param maxEvents: the largest number of completions to process,
+        or 0 for all of them
+        @type maxEvents: integer
 
-        @param url: the URL to check for existence
-        @type url: string
+        @param timeout: the number of seconds to wait for a completion
+        if none is ready, None to wait forever
+        @type timeout: float
 
-        @param completeCallback: the function to be called
-        when the exist operation is complete
-        @type completeCallback: callable
+        @return: the number of completions processed
+        @rtype: integer
+        """
+        events = self._queue.drain(maxEvents, timeout)
 
-        @param arg: user argument to pass to the callback function
-        @type arg: any
+        for kind, args in events:
+            if kind == CompletionQueue.CKSM:
+                opId = args[1]
+            else:
+                opId = args[0]
 
-        @param opAttr: an instance of OperationAttr for the source
-        @type opAttr: instance of OperationAttr
+            client, future, resultFunction = self._inflight.pop(opId)
+            self._idle.append(client)
+
+            # a loop future may have been cancelled while in flight
+            if future.cancelled() or future.done():
+                continue
+
+            try:
+                result = resultFunction(args)
+            except GridFTPClientException, e:
+                future.set_exception(e)
+            else:
+                future.set_result(result)
+
+        self._start_waiting()
+
+        return len(events)
+
+    def wait(self, operations, timeout = None):
+        """
+        Process completions until all of the operations have completed.
+        Only for use without an event loop.
+
+        @param operations: the futures returned by the methods
+        @type operations: list
+
+        @param timeout: the largest number of seconds to wait for each
+        completion, None to wait forever
+        @type timeout: float
 
         @return: None
         @rtype: None
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        exists operation
+        @raise GridFTPClientException: raised if the timeout expires
+        """
+        for operation in operations:
+            while not operation.done():
+                if self.process(0, timeout) == 0 and timeout is not None:
+                    msg = "Timed out waiting for operations"
+                    ex = GridFTPClientException(msg)
+                    raise ex
+
+    def third_party_transfer(self, src, dst, srcOpAttr = None, dstOpAttr = None):
         """
+        Start a third party transfer; the future resolves to None.
+        """
+        return self._submit("third_party_transfer", (src, dst), 
+            {"srcOpAttr" : srcOpAttr or self._opAttr, "dstOpAttr" : dstOpAttr or self._opAttr},
+            _async_none)
 
-        if not opAttr:
-            msg = "An OperationAttr instance must be input"
-            ex = GridFTPClientException(msg)
-            raise ex
+    def get_to_file(self, url, dest, opAttr = None, nbuffers = 4, bufsize = 1048576, marker = None, digest = None):
+        """
+        Start a get into a local file, see FTPClient.get_to_file; the
+        future resolves to the number of bytes written, or to
+        (nbytes, digest) when a StreamDigest is given.
+        """
+        return self._submit("get_to_file", (url, dest),
+            {"opAttr" : opAttr or self._opAttr, "nbuffers" : nbuffers, "bufsize" : bufsize, "marker" : marker,
+             "digest" : digest},
+            digest is None and _async_nbytes or _async_nbytes_digest)
 
-        try:
-            gridftpwrapper.gridftp_exists(self._handle, url, opAttr._attr, completeCallback, arg)
-        except Exception, e:
-            msg = "Unable to check existence: %s" % e
-            ex = GridFTPClientException(msg)
-            raise ex
-            
-    def abort(self):
+    def cksm(self, url, opAttr = None, offset = None, length = None, algorithm = "MD5"):
         """
-        Abort the operation currently in progress.
+        Start a checksum request; the future resolves to the checksum.
+        """
+        return self._submit("cksm", (url,), 
+            {"opAttr" : opAttr or self._opAttr, "offset" : offset, "length" : length, "algorithm" : algorithm},
+            _async_cksm)
 
-        @return: None
-        @rtype: None
+    def exists(self, url, opAttr = None):
+        """
+        Start an existence check; the future resolves to True or False.
+        """
+        return self._submit("exists", (url,), {"opAttr" : opAttr or self._opAttr, "withCode" : True}, _async_exists)
 
-        @raise GridFTPClientException: raised if unable to initiate the
-        abort operation
+    def mkdir(self, url, opAttr = None):
         """
+        Start a mkdir; the future resolves to None.
+        """
+        return self._submit("mkdir", (url,), {"opAttr" : opAttr or self._opAttr}, _async_none)
 
-        if self._handle:
-            try:
-                gridftpwrapper.gridftp_abort(self._handle)
-            except Exception, e:
-                msg = "Unable to abort: %s" % e
-                ex = GridFTPClientException(msg)
-                raise ex
+    def rmdir(self, url, opAttr = None):
+        """
+        Start a rmdir; the future resolves to None.
+        """
+        return self._submit("rmdir", (url,), {"opAttr" : opAttr or self._opAttr}, _async_none)
 
-        
+    def delete(self, url, opAttr = None):
+        """
+        Start a delete; the future resolves to None.
+        """
+        return self._submit("delete", (url,), {"opAttr" : opAttr or self._opAttr}, _async_none)
+
+    def move(self, src, dst, opAttr = None):
+        """
+        Start a move; the future resolves to None.
+        """
+        return self._submit("move", (src, dst), {"opAttr" : opAttr or self._opAttr}, _async_none)
+
+    def chmod(self, url, mode, opAttr = None):
+        """
+        Start a chmod; the future resolves to None.
+        """
+        return self._submit("chmod", (url, mode), {"opAttr" : opAttr or self._opAttr}, _async_none)
+
+    def _new_future(self):
+        if self._loop:
+            return self._loop.create_future()
+        return Operation()
+
+    def _submit(self, method, args, kwargs, resultFunction):
+        future = self._new_future()
+        self._waiting.append((method, args, kwargs, resultFunction, future))
+        self._start_waiting()
+        return future
+
+    def _start_waiting(self):
+        while self._waiting:
+            if not self._idle:
+                if len(self._clients) >= self._maxHandles:
+                    return
+                client = FTPClient(self._handleAttr)
+                self._clients.append(client)
+                self._idle.append(client)
+
+            method, args, kwargs, resultFunction, future = self._waiting.popleft()
+
+            # a loop future cancelled while it waited is not started
+            if future.cancelled():
+                continue
+
+            client = self._idle.pop()
+
+            opId = self._nextId
+            self._nextId += 1
+
+            # the callback and argument go after the positional
+            # arguments, as in every FTPClient method
+            try:
+                getattr(client, method)(*(args + (self._queue, opId)), **kwargs)
+            except GridFTPClientException, e:
+                self._idle.append(client)
+                if not future.cancelled():
+                    future.set_exception(e)
+                continue
+
+            self._inflight[opId] = (client, future, resultFunction)
+
+def _async_error(error):
+    if error:
+        ex = GridFTPClientException(error)
+        raise ex
+
+def _async_none(args):
+    _async_error(args[2])
+    return None
+
+def _async_nbytes(args):
+    _async_error(args[2])
+    return args[3]
+
+def _async_nbytes_digest(args):
+    _async_error(args[2])
+    return (args[3], args[4])
+
+def _async_cksm(args):
+    _async_error(args[3])
+    return args[0]
+
+def _async_exists(args):
+    # a missing file is reported by the server with a 550 reply, which
+    # the wrapper passes as the code
+    if args[2] and args[3] == 550:
+        return False
+    _async_error(args[2])
+    return True
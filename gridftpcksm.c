@@ -0,0 +1,1286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CKSM_X86 1
+#include <immintrin.h>
+#endif
+
+#include "gridftpcksm.h"
+
+// MD5, as specified in RFC 1321
+
+// state of an MD5 computation
+typedef struct
+{
+    uint32_t state[4];
+    uint64_t nbytes;             // number of bytes hashed
+    unsigned char block[64];     // bytes waiting for a full block
+} md5_ctx_t;
+
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+#define MD5_STEP(f, a, b, c, d, x, t, s) \
+    (a) += f((b), (c), (d)) + (x) + (uint32_t) (t); \
+    (a) = (((a) << (s)) | (((a) & 0xffffffff) >> (32 - (s)))); \
+    (a) += (b);
+
+// the 64 steps of the compression function over the words x of a block,
+// shared by the one block and multi-buffer versions
+#define MD5_ROUNDS(a, b, c, d, x) \
+    MD5_STEP(MD5_F, (a), (b), (c), (d), (x)[0], 0xd76aa478, 7) \
+    MD5_STEP(MD5_F, (d), (a), (b), (c), (x)[1], 0xe8c7b756, 12) \
+    MD5_STEP(MD5_F, (c), (d), (a), (b), (x)[2], 0x242070db, 17) \
+    MD5_STEP(MD5_F, (b), (c), (d), (a), (x)[3], 0xc1bdceee, 22) \
+    MD5_STEP(MD5_F, (a), (b), (c), (d), (x)[4], 0xf57c0faf, 7) \
+    MD5_STEP(MD5_F, (d), (a), (b), (c), (x)[5], 0x4787c62a, 12) \
+    MD5_STEP(MD5_F, (c), (d), (a), (b), (x)[6], 0xa8304613, 17) \
+    MD5_STEP(MD5_F, (b), (c), (d), (a), (x)[7], 0xfd469501, 22) \
+    MD5_STEP(MD5_F, (a), (b), (c), (d), (x)[8], 0x698098d8, 7) \
+    MD5_STEP(MD5_F, (d), (a), (b), (c), (x)[9], 0x8b44f7af, 12) \
+    MD5_STEP(MD5_F, (c), (d), (a), (b), (x)[10], 0xffff5bb1, 17) \
+    MD5_STEP(MD5_F, (b), (c), (d), (a), (x)[11], 0x895cd7be, 22) \
+    MD5_STEP(MD5_F, (a), (b), (c), (d), (x)[12], 0x6b901122, 7) \
+    MD5_STEP(MD5_F, (d), (a), (b), (c), (x)[13], 0xfd987193, 12) \
+    MD5_STEP(MD5_F, (c), (d), (a), (b), (x)[14], 0xa679438e, 17) \
+    MD5_STEP(MD5_F, (b), (c), (d), (a), (x)[15], 0x49b40821, 22) \
+    MD5_STEP(MD5_G, (a), (b), (c), (d), (x)[1], 0xf61e2562, 5) \
+    MD5_STEP(MD5_G, (d), (a), (b), (c), (x)[6], 0xc040b340, 9) \
+    MD5_STEP(MD5_G, (c), (d), (a), (b), (x)[11], 0x265e5a51, 14) \
+    MD5_STEP(MD5_G, (b), (c), (d), (a), (x)[0], 0xe9b6c7aa, 20) \
+    MD5_STEP(MD5_G, (a), (b), (c), (d), (x)[5], 0xd62f105d, 5) \
+    MD5_STEP(MD5_G, (d), (a), (b), (c), (x)[10], 0x02441453, 9) \
+    MD5_STEP(MD5_G, (c), (d), (a), (b), (x)[15], 0xd8a1e681, 14) \
+    MD5_STEP(MD5_G, (b), (c), (d), (a), (x)[4], 0xe7d3fbc8, 20) \
+    MD5_STEP(MD5_G, (a), (b), (c), (d), (x)[9], 0x21e1cde6, 5) \
+    MD5_STEP(MD5_G, (d), (a), (b), (c), (x)[14], 0xc33707d6, 9) \
+    MD5_STEP(MD5_G, (c), (d), (a), (b), (x)[3], 0xf4d50d87, 14) \
+    MD5_STEP(MD5_G, (b), (c), (d), (a), (x)[8], 0x455a14ed, 20) \
+    MD5_STEP(MD5_G, (a), (b), (c), (d), (x)[13], 0xa9e3e905, 5) \
+    MD5_STEP(MD5_G, (d), (a), (b), (c), (x)[2], 0xfcefa3f8, 9) \
+    MD5_STEP(MD5_G, (c), (d), (a), (b), (x)[7], 0x676f02d9, 14) \
+    MD5_STEP(MD5_G, (b), (c), (d), (a), (x)[12], 0x8d2a4c8a, 20) \
+    MD5_STEP(MD5_H, (a), (b), (c), (d), (x)[5], 0xfffa3942, 4) \
+    MD5_STEP(MD5_H, (d), (a), (b), (c), (x)[8], 0x8771f681, 11) \
+    MD5_STEP(MD5_H, (c), (d), (a), (b), (x)[11], 0x6d9d6122, 16) \
+    MD5_STEP(MD5_H, (b), (c), (d), (a), (x)[14], 0xfde5380c, 23) \
+    MD5_STEP(MD5_H, (a), (b), (c), (d), (x)[1], 0xa4beea44, 4) \
+    MD5_STEP(MD5_H, (d), (a), (b), (c), (x)[4], 0x4bdecfa9, 11) \
+    MD5_STEP(MD5_H, (c), (d), (a), (b), (x)[7], 0xf6bb4b60, 16) \
+    MD5_STEP(MD5_H, (b), (c), (d), (a), (x)[10], 0xbebfbc70, 23) \
+    MD5_STEP(MD5_H, (a), (b), (c), (d), (x)[13], 0x289b7ec6, 4) \
+    MD5_STEP(MD5_H, (d), (a), (b), (c), (x)[0], 0xeaa127fa, 11) \
+    MD5_STEP(MD5_H, (c), (d), (a), (b), (x)[3], 0xd4ef3085, 16) \
+    MD5_STEP(MD5_H, (b), (c), (d), (a), (x)[6], 0x04881d05, 23) \
+    MD5_STEP(MD5_H, (a), (b), (c), (d), (x)[9], 0xd9d4d039, 4) \
+    MD5_STEP(MD5_H, (d), (a), (b), (c), (x)[12], 0xe6db99e5, 11) \
+    MD5_STEP(MD5_H, (c), (d), (a), (b), (x)[15], 0x1fa27cf8, 16) \
+    MD5_STEP(MD5_H, (b), (c), (d), (a), (x)[2], 0xc4ac5665, 23) \
+    MD5_STEP(MD5_I, (a), (b), (c), (d), (x)[0], 0xf4292244, 6) \
+    MD5_STEP(MD5_I, (d), (a), (b), (c), (x)[7], 0x432aff97, 10) \
+    MD5_STEP(MD5_I, (c), (d), (a), (b), (x)[14], 0xab9423a7, 15) \
+    MD5_STEP(MD5_I, (b), (c), (d), (a), (x)[5], 0xfc93a039, 21) \
+    MD5_STEP(MD5_I, (a), (b), (c), (d), (x)[12], 0x655b59c3, 6) \
+    MD5_STEP(MD5_I, (d), (a), (b), (c), (x)[3], 0x8f0ccc92, 10) \
+    MD5_STEP(MD5_I, (c), (d), (a), (b), (x)[10], 0xffeff47d, 15) \
+    MD5_STEP(MD5_I, (b), (c), (d), (a), (x)[1], 0x85845dd1, 21) \
+    MD5_STEP(MD5_I, (a), (b), (c), (d), (x)[8], 0x6fa87e4f, 6) \
+    MD5_STEP(MD5_I, (d), (a), (b), (c), (x)[15], 0xfe2ce6e0, 10) \
+    MD5_STEP(MD5_I, (c), (d), (a), (b), (x)[6], 0xa3014314, 15) \
+    MD5_STEP(MD5_I, (b), (c), (d), (a), (x)[13], 0x4e0811a1, 21) \
+    MD5_STEP(MD5_I, (a), (b), (c), (d), (x)[4], 0xf7537e82, 6) \
+    MD5_STEP(MD5_I, (d), (a), (b), (c), (x)[11], 0xbd3af235, 10) \
+    MD5_STEP(MD5_I, (c), (d), (a), (b), (x)[2], 0x2ad7d2bb, 15) \
+    MD5_STEP(MD5_I, (b), (c), (d), (a), (x)[9], 0xeb86d391, 21)
+
+// words of a block, which MD5 reads little endian
+static uint32_t md5_word(const unsigned char * p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// run the compression function over nblocks blocks of 64 bytes
+static void md5_blocks(uint32_t state[4], const unsigned char * data, size_t nblocks)
+{
+    uint32_t a, b, c, d;
+    uint32_t x[16];
+    int i;
+
+    while (nblocks--){
+        for (i = 0; i < 16; i++){
+            x[i] = md5_word(data + 4 * i);
+        }
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+
+        MD5_ROUNDS(a, b, c, d, x)
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+
+        data += 64;
+    }
+}
+
+static void md5_init(md5_ctx_t * ctx)
+{
+    ctx -> state[0] = 0x67452301;
+    ctx -> state[1] = 0xefcdab89;
+    ctx -> state[2] = 0x98badcfe;
+    ctx -> state[3] = 0x10325476;
+    ctx -> nbytes = 0;
+}
+
+static void md5_update(md5_ctx_t * ctx, const unsigned char * data, size_t length)
+{
+    size_t used = (size_t) (ctx -> nbytes & 63);
+    size_t n;
+
+    ctx -> nbytes += length;
+
+    // top up a partial block first
+    if (used){
+        n = 64 - used;
+        if (length < n){
+            memcpy(ctx -> block + used, data, length);
+            return;
+        }
+        memcpy(ctx -> block + used, data, n);
+        md5_blocks(ctx -> state, ctx -> block, 1);
+        data += n;
+        length -= n;
+    }
+
+    // whole blocks are hashed straight from the data
+    md5_blocks(ctx -> state, data, length / 64);
+    data += length & ~((size_t) 63);
+    length &= 63;
+
+    memcpy(ctx -> block, data, length);
+}
+
+static void md5_final(md5_ctx_t * ctx, unsigned char digest[16])
+{
+    unsigned char padding[72];
+    uint64_t bits = ctx -> nbytes * 8;
+    size_t used = (size_t) (ctx -> nbytes & 63);
+    size_t n = (used < 56 ? 56 : 120) - used;
+    int i;
+
+    memset(padding, 0, sizeof(padding));
+    padding[0] = 0x80;
+    for (i = 0; i < 8; i++){
+        padding[n + i] = (unsigned char) (bits >> (8 * i));
+    }
+    md5_update(ctx, padding, n + 8);
+
+    for (i = 0; i < 16; i++){
+        digest[i] = (unsigned char) (ctx -> state[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+// write an MD5 digest as lower case hex
+static void md5_hex(const unsigned char digest[16], char hex[STREAM_DIGEST_HEX_MAX])
+{
+    int i;
+
+    for (i = 0; i < 16; i++){
+        sprintf(hex + 2 * i, "%02x", digest[i]);
+    }
+}
+
+// Adler-32, as specified in RFC 1950
+
+#define ADLER32_BASE 65521
+
+// the most bytes that can be summed before the sums must be reduced
+// to stay within 32 bits
+#define ADLER32_NMAX 5552
+
+// portable Adler-32, also used for the tails the vector versions leave
+static uint32_t adler32_generic(uint32_t adler, const unsigned char * data, size_t length)
+{
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    size_t n;
+
+    while (length > 0){
+        n = length < ADLER32_NMAX ? length : ADLER32_NMAX;
+        length -= n;
+        while (n--){
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return (b << 16) | a;
+}
+
+// Adler-32 of two runs of bytes from the sums of each and the length
+// of the second
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, uint64_t length2)
+{
+    uint32_t rem = (uint32_t) (length2 % ADLER32_BASE);
+    uint32_t a1 = adler1 & 0xffff;
+    uint32_t b1 = adler1 >> 16;
+    uint32_t a2 = adler2 & 0xffff;
+    uint32_t b2 = adler2 >> 16;
+    uint64_t a;
+    uint64_t b;
+
+    // the second run restarted its sums at a = 1, b = 0, so a gains
+    // a1 - 1 and b gains rem times the a it started from
+    a = (uint64_t) a1 + a2 + ADLER32_BASE - 1;
+    b = (uint64_t) rem * a1 % ADLER32_BASE + b1 + b2 + ADLER32_BASE - rem;
+
+    return (uint32_t) ((b % ADLER32_BASE) << 16 | (a % ADLER32_BASE));
+}
+
+// CRC32C, the CRC-32 with the Castagnoli polynomial used by iSCSI,
+// reflected
+
+#define CRC32C_POLY 0x82f63b78
+
+// tables for slicing by 8: crc32c_table[k][n] is the CRC of byte n
+// followed by k zero bytes
+static uint32_t crc32c_table[8][256];
+
+static void crc32c_init_table(void)
+{
+    uint32_t crc;
+    int n;
+    int k;
+
+    for (n = 0; n < 256; n++){
+        crc = (uint32_t) n;
+        for (k = 0; k < 8; k++){
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        crc32c_table[0][n] = crc;
+    }
+
+    for (n = 0; n < 256; n++){
+        crc = crc32c_table[0][n];
+        for (k = 1; k < 8; k++){
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[k][n] = crc;
+        }
+    }
+}
+
+// portable CRC32C, slicing by 8
+static uint32_t crc32c_generic(uint32_t crc, const unsigned char * data, size_t length)
+{
+    uint32_t lo;
+    uint32_t hi;
+
+    crc = ~crc;
+
+    while (length > 0 && ((uintptr_t) data & 7)){
+        crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        length--;
+    }
+
+    // eight bytes at a time, read little endian
+    while (length >= 8){
+        lo = crc ^ ((uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+        hi = (uint32_t) data[4] | ((uint32_t) data[5] << 8) | ((uint32_t) data[6] << 16) | ((uint32_t) data[7] << 24);
+        crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff]
+            ^ crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24]
+            ^ crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff]
+            ^ crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+        data += 8;
+        length -= 8;
+    }
+
+    while (length--){
+        crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+// multiply a vector by a matrix over GF(2), each a 32 bit word per row
+static uint32_t gf2_matrix_times(const uint32_t * mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+
+    while (vec){
+        if (vec & 1){
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+
+    return sum;
+}
+
+static void gf2_matrix_square(uint32_t * square, const uint32_t * mat)
+{
+    int n;
+
+    for (n = 0; n < 32; n++){
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// CRC32C of two runs of bytes from the sums of each and the length of
+// the second
+static uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t length2)
+{
+    uint32_t even[32];
+    uint32_t odd[32];
+    uint32_t row;
+    int n;
+
+    if (length2 == 0){
+        return crc1;
+    }
+
+    // the operator for one zero bit, then squared to two and four
+    odd[0] = CRC32C_POLY;
+    row = 1;
+    for (n = 1; n < 32; n++){
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // run crc1 through length2 zero bytes, squaring the operator for
+    // each bit of the length
+    do{
+        gf2_matrix_square(even, odd);
+        if (length2 & 1){
+            crc1 = gf2_matrix_times(even, crc1);
+        }
+        length2 >>= 1;
+        if (length2 == 0){
+            break;
+        }
+
+        gf2_matrix_square(odd, even);
+        if (length2 & 1){
+            crc1 = gf2_matrix_times(odd, crc1);
+        }
+        length2 >>= 1;
+    } while (length2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+// vector kernels, picked at run time for the CPU the module runs on
+//
+// each algorithm has a portable version above. On x86 the Adler-32 sums
+// are taken 16 or 32 bytes at a time with SSSE3 or AVX2, CRC32C uses
+// the SSE4.2 crc32 instruction on three interleaved lanes so its latency
+// is hidden, and MD5 hashes 4 (SSE2) or 8 (AVX2) independent messages
+// at once, one per vector lane, for callers with several files or
+// ranges to hash
+
+// the blocks of the multi-buffer MD5, one message per lane
+typedef uint32_t md5_x4_t __attribute__((vector_size(16)));
+typedef uint32_t md5_x8_t __attribute__((vector_size(32)));
+
+#define MD5_MULTI_LANES_MAX 8
+
+// run the compression function over nblocks blocks of each of the
+// messages at data, one per lane, into the states at state
+#define MD5_BLOCKS_MULTI(vec_t, lanes) \
+    vec_t a, b, c, d; \
+    vec_t aa, bb, cc, dd; \
+    vec_t x[16]; \
+    size_t off; \
+    int i, j; \
+    for (j = 0; j < (lanes); j++){ \
+        a[j] = state[j][0]; \
+        b[j] = state[j][1]; \
+        c[j] = state[j][2]; \
+        d[j] = state[j][3]; \
+    } \
+    for (off = 0; off < nblocks * 64; off += 64){ \
+        for (i = 0; i < 16; i++){ \
+            for (j = 0; j < (lanes); j++){ \
+                x[i][j] = md5_word(data[j] + off + 4 * i); \
+            } \
+        } \
+        aa = a; \
+        bb = b; \
+        cc = c; \
+        dd = d; \
+        MD5_ROUNDS(a, b, c, d, x) \
+        a += aa; \
+        b += bb; \
+        c += cc; \
+        d += dd; \
+    } \
+    for (j = 0; j < (lanes); j++){ \
+        state[j][0] = a[j]; \
+        state[j][1] = b[j]; \
+        state[j][2] = c[j]; \
+        state[j][3] = d[j]; \
+    }
+
+static void md5_blocks_x4(uint32_t * state[], const unsigned char * data[], size_t nblocks)
+{
+    MD5_BLOCKS_MULTI(md5_x4_t, 4)
+}
+
+#ifdef CKSM_X86
+
+__attribute__((target("avx2")))
+static void md5_blocks_x8(uint32_t * state[], const unsigned char * data[], size_t nblocks)
+{
+    MD5_BLOCKS_MULTI(md5_x8_t, 8)
+}
+
+// add up the 32 bit lanes of a vector stored to memory
+static uint64_t cksm_sum_lanes(const uint32_t * lanes, int n)
+{
+    uint64_t sum = 0;
+    int i;
+
+    for (i = 0; i < n; i++){
+        sum += lanes[i];
+    }
+
+    return sum;
+}
+
+// Adler-32 16 bytes at a time: within a block b gains 16 times the a it
+// started from plus the bytes weighted 16 down to 1, taken with a
+// multiply and add, and a gains the bytes, taken with a sum of absolute
+// differences against zero
+__attribute__((target("ssse3")))
+static uint32_t adler32_ssse3(uint32_t adler, const unsigned char * data, size_t length)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i weights = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    uint64_t a = adler & 0xffff;
+    uint64_t b = adler >> 16;
+    uint32_t lanes[4];
+    __m128i va, vb, vp, v;
+    size_t blocks;
+    size_t n;
+
+    while (length >= 16){
+        blocks = length / 16;
+        if (blocks > ADLER32_NMAX / 16){
+            blocks = ADLER32_NMAX / 16;
+        }
+        length -= blocks * 16;
+
+        va = zero;
+        vb = zero;
+        vp = zero;
+        for (n = 0; n < blocks; n++){
+            v = _mm_loadu_si128((const __m128i *) data);
+            vp = _mm_add_epi32(vp, va);
+            va = _mm_add_epi32(va, _mm_sad_epu8(v, zero));
+            vb = _mm_add_epi32(vb, _mm_madd_epi16(_mm_maddubs_epi16(v, weights), ones));
+            data += 16;
+        }
+
+        b += a * blocks * 16;
+        _mm_storeu_si128((__m128i *) lanes, vp);
+        b += 16 * cksm_sum_lanes(lanes, 4);
+        _mm_storeu_si128((__m128i *) lanes, vb);
+        b += cksm_sum_lanes(lanes, 4);
+        _mm_storeu_si128((__m128i *) lanes, va);
+        a += cksm_sum_lanes(lanes, 4);
+
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return adler32_generic((uint32_t) (b << 16 | a), data, length);
+}
+
+// Adler-32 32 bytes at a time, as adler32_ssse3
+__attribute__((target("avx2")))
+static uint32_t adler32_avx2(uint32_t adler, const unsigned char * data, size_t length)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    uint64_t a = adler & 0xffff;
+    uint64_t b = adler >> 16;
+    uint32_t lanes[8];
+    __m256i va, vb, vp, v;
+    size_t blocks;
+    size_t n;
+
+    while (length >= 32){
+        blocks = length / 32;
+        if (blocks > ADLER32_NMAX / 32){
+            blocks = ADLER32_NMAX / 32;
+        }
+        length -= blocks * 32;
+
+        va = zero;
+        vb = zero;
+        vp = zero;
+        for (n = 0; n < blocks; n++){
+            v = _mm256_loadu_si256((const __m256i *) data);
+            vp = _mm256_add_epi32(vp, va);
+            va = _mm256_add_epi32(va, _mm256_sad_epu8(v, zero));
+            vb = _mm256_add_epi32(vb, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+            data += 32;
+        }
+
+        b += a * blocks * 32;
+        _mm256_storeu_si256((__m256i *) lanes, vp);
+        b += 32 * cksm_sum_lanes(lanes, 8);
+        _mm256_storeu_si256((__m256i *) lanes, vb);
+        b += cksm_sum_lanes(lanes, 8);
+        _mm256_storeu_si256((__m256i *) lanes, va);
+        a += cksm_sum_lanes(lanes, 8);
+
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return adler32_generic((uint32_t) (b << 16 | a), data, length);
+}
+
+// bytes of each of the three lanes CRC32C is computed on at once
+#define CRC32C_LANE 4096
+
+// the operator that runs a CRC register through CRC32C_LANE zero bytes,
+// used to join the lanes
+static uint32_t crc32c_lane_shift[32];
+
+// CRC32C with the crc32 instruction; the instruction has a latency of
+// three cycles, so three runs of CRC32C_LANE bytes are summed side by
+// side, the second and third from zero, and then shifted into place
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char * data, size_t length)
+{
+    uint64_t crc0 = (uint32_t) ~crc;
+    uint64_t crc1;
+    uint64_t crc2;
+    uint64_t word;
+    size_t i;
+
+    while (length > 0 && ((uintptr_t) data & 7)){
+        crc0 = _mm_crc32_u8((uint32_t) crc0, *data++);
+        length--;
+    }
+
+    while (length >= 3 * CRC32C_LANE){
+        crc1 = 0;
+        crc2 = 0;
+        for (i = 0; i < CRC32C_LANE; i += 8){
+            crc0 = _mm_crc32_u64(crc0, *(const uint64_t *) (data + i));
+            crc1 = _mm_crc32_u64(crc1, *(const uint64_t *) (data + CRC32C_LANE + i));
+            crc2 = _mm_crc32_u64(crc2, *(const uint64_t *) (data + 2 * CRC32C_LANE + i));
+        }
+        crc0 = gf2_matrix_times(crc32c_lane_shift, (uint32_t) crc0) ^ (uint32_t) crc1;
+        crc0 = gf2_matrix_times(crc32c_lane_shift, (uint32_t) crc0) ^ (uint32_t) crc2;
+        data += 3 * CRC32C_LANE;
+        length -= 3 * CRC32C_LANE;
+    }
+
+    while (length >= 8){
+        memcpy(&word, data, 8);
+        crc0 = _mm_crc32_u64(crc0, word);
+        data += 8;
+        length -= 8;
+    }
+
+    while (length--){
+        crc0 = _mm_crc32_u8((uint32_t) crc0, *data++);
+    }
+
+    return ~(uint32_t) crc0;
+}
+
+#endif
+
+// the kernels picked for this CPU
+static uint32_t (* adler32_kernel)(uint32_t, const unsigned char *, size_t) = adler32_generic;
+static uint32_t (* crc32c_kernel)(uint32_t, const unsigned char *, size_t) = crc32c_generic;
+static void (* md5_multi_kernel)(uint32_t * [], const unsigned char * [], size_t) = md5_blocks_x4;
+static int md5_multi_lanes = 4;
+static const char * adler32_kernel_name = "generic";
+static const char * crc32c_kernel_name = "slicing-by-8";
+static const char * md5_kernel_name = "multi-buffer x4";
+static pthread_once_t cksm_once = PTHREAD_ONCE_INIT;
+
+#ifdef CKSM_X86
+// whether the comma separated list in GRIDFTP_CKSM_DISABLE names a CPU
+// feature, so its kernels are passed over as if the CPU lacked it; this
+// lets each kernel be checked on a machine that would pick a faster one
+static int cksm_disabled(const char * feature)
+{
+    const char * list = getenv("GRIDFTP_CKSM_DISABLE");
+    size_t length = strlen(feature);
+    const char * p;
+
+    for (p = list; p != NULL && *p != '\0'; p += strcspn(p, ",")){
+        p += strspn(p, ",");
+        if (strncasecmp(p, feature, length) == 0 && (p[length] == ',' || p[length] == '\0')){
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+static void cksm_dispatch_init(void)
+{
+#ifdef CKSM_X86
+    int n;
+#endif
+
+    crc32c_init_table();
+
+#ifdef CKSM_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && !cksm_disabled("avx2")){
+        adler32_kernel = adler32_avx2;
+        adler32_kernel_name = "avx2";
+        md5_multi_kernel = md5_blocks_x8;
+        md5_multi_lanes = 8;
+        md5_kernel_name = "multi-buffer x8 avx2";
+    } else if (__builtin_cpu_supports("ssse3") && !cksm_disabled("ssse3")){
+        adler32_kernel = adler32_ssse3;
+        adler32_kernel_name = "ssse3";
+    }
+
+    if (__builtin_cpu_supports("sse4.2") && !cksm_disabled("sse4.2")){
+        for (n = 0; n < 32; n++){
+            crc32c_lane_shift[n] = crc32c_combine((uint32_t) 1 << n, 0, CRC32C_LANE);
+        }
+        crc32c_kernel = crc32c_sse42;
+        crc32c_kernel_name = "sse4.2";
+    }
+#endif
+}
+
+// Adler-32 and CRC32C of data following the bytes summed to adler or
+// crc, 1 and 0 respectively for no bytes
+static uint32_t adler32_update(uint32_t adler, const unsigned char * data, size_t length)
+{
+    pthread_once(&cksm_once, cksm_dispatch_init);
+    return adler32_kernel(adler, data, length);
+}
+
+static uint32_t crc32c_update(uint32_t crc, const unsigned char * data, size_t length)
+{
+    pthread_once(&cksm_once, cksm_dispatch_init);
+    return crc32c_kernel(crc, data, length);
+}
+
+// MD5 of several messages at once: the same length of data is hashed
+// into each of the n contexts, several contexts per instruction where
+// the CPU allows. Contexts part way through a block are hashed one at
+// a time
+static void md5_update_many(md5_ctx_t ** ctx, const unsigned char ** data, size_t length, int n)
+{
+    uint32_t * state[MD5_MULTI_LANES_MAX];
+    const unsigned char * lane_data[MD5_MULTI_LANES_MAX];
+    uint32_t spare[MD5_MULTI_LANES_MAX][4];
+    size_t nblocks = length / 64;
+    int lanes;
+    int i, j, k;
+
+    pthread_once(&cksm_once, cksm_dispatch_init);
+    lanes = md5_multi_lanes;
+
+    // a context part way through a block would need its own top up,
+    // so the lanes would no longer line up
+    for (i = 0; i < n; i++){
+        if (ctx[i] -> nbytes & 63){
+            break;
+        }
+    }
+    if (i < n || n < 2 || nblocks == 0){
+        for (i = 0; i < n; i++){
+            md5_update(ctx[i], data[i], length);
+        }
+        return;
+    }
+
+    for (i = 0; i < n; i += lanes){
+        k = n - i < lanes ? n - i : lanes;
+        if (k == 1){
+            md5_blocks(ctx[i] -> state, data[i], nblocks);
+        } else{
+            // lanes left over in the last group hash a copy of the last
+            // message into spare states
+            for (j = 0; j < lanes; j++){
+                if (j < k){
+                    state[j] = ctx[i + j] -> state;
+                    lane_data[j] = data[i + j];
+                } else{
+                    memcpy(spare[j], ctx[i + k - 1] -> state, sizeof(spare[j]));
+                    state[j] = spare[j];
+                    lane_data[j] = data[i + k - 1];
+                }
+            }
+            md5_multi_kernel(state, lane_data, nblocks);
+        }
+        for (j = 0; j < k; j++){
+            ctx[i + j] -> nbytes += nblocks * 64;
+        }
+    }
+
+    // the rest of a block is kept by each context
+    for (i = 0; i < n; i++){
+        md5_update(ctx[i], data[i] + nblocks * 64, length - nblocks * 64);
+    }
+}
+
+const char * cksm_kernel_name(int algorithm)
+{
+    pthread_once(&cksm_once, cksm_dispatch_init);
+
+    switch (algorithm){
+    case STREAM_DIGEST_MD5:
+        return md5_kernel_name;
+    case STREAM_DIGEST_ADLER32:
+        return adler32_kernel_name;
+    case STREAM_DIGEST_CRC32C:
+        return crc32c_kernel_name;
+    }
+
+    return NULL;
+}
+
+// local file digests
+
+// read up to length bytes at offset, stopping early only at the end of
+// the file
+//
+// returns the number of bytes read or -1 with errno set
+static ssize_t file_digest_read(int fd, unsigned char * buffer, size_t length, long long offset)
+{
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < length){
+        n = pread(fd, buffer + done, length - done, (off_t) (offset + done));
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0){
+            break;
+        }
+        done += (size_t) n;
+    }
+
+    return (ssize_t) done;
+}
+
+// the number of bytes of a range still to read, capped at bufsize
+static size_t file_digest_want(file_digest_t * file, size_t bufsize)
+{
+    long long left;
+
+    if (file -> length < 0){
+        return bufsize;
+    }
+
+    left = file -> length - file -> nbytes;
+    return left < (long long) bufsize ? (size_t) left : bufsize;
+}
+
+// hash up to MD5_MULTI_LANES_MAX ranges together with the multi-buffer
+// MD5; each round reads a buffer from every range still going, and
+// those that filled their buffer are hashed side by side
+static void file_digests_md5(file_digest_t * files, int nfiles, size_t bufsize)
+{
+    md5_ctx_t ctx[MD5_MULTI_LANES_MAX];
+    md5_ctx_t * full_ctx[MD5_MULTI_LANES_MAX];
+    const unsigned char * full_data[MD5_MULTI_LANES_MAX];
+    unsigned char * buffers[MD5_MULTI_LANES_MAX];
+    int fds[MD5_MULTI_LANES_MAX];
+    int active[MD5_MULTI_LANES_MAX];
+    unsigned char md5[16];
+    size_t want;
+    ssize_t got;
+    int nactive = 0;
+    int nfull;
+    int i;
+
+    for (i = 0; i < nfiles; i++){
+        md5_init(&ctx[i]);
+        buffers[i] = NULL;
+        active[i] = 0;
+        fds[i] = open(files[i].path, O_RDONLY);
+        if (fds[i] < 0){
+            files[i].error = errno;
+            continue;
+        }
+        buffers[i] = (unsigned char *) malloc(bufsize);
+        if (buffers[i] == NULL){
+            files[i].error = ENOMEM;
+            continue;
+        }
+        active[i] = 1;
+        nactive++;
+    }
+
+    while (nactive > 0){
+        nfull = 0;
+        for (i = 0; i < nfiles; i++){
+            if (!active[i]){
+                continue;
+            }
+
+            want = file_digest_want(&files[i], bufsize);
+            got = want ? file_digest_read(fds[i], buffers[i], want, files[i].offset + files[i].nbytes) : 0;
+            if (got < 0){
+                files[i].error = errno;
+                active[i] = 0;
+                nactive--;
+                continue;
+            }
+            files[i].nbytes += got;
+
+            if ((size_t) got == bufsize){
+                full_ctx[nfull] = &ctx[i];
+                full_data[nfull] = buffers[i];
+                nfull++;
+            } else{
+                // a short read is the end of the range or the file
+                md5_update(&ctx[i], buffers[i], (size_t) got);
+                active[i] = 0;
+                nactive--;
+            }
+        }
+
+        if (nfull > 0){
+            md5_update_many(full_ctx, full_data, bufsize, nfull);
+        }
+    }
+
+    for (i = 0; i < nfiles; i++){
+        if (fds[i] >= 0){
+            close(fds[i]);
+        }
+        free(buffers[i]);
+        if (files[i].error == 0){
+            md5_final(&ctx[i], md5);
+            md5_hex(md5, files[i].hex);
+        }
+    }
+}
+
+// hash one range with Adler-32 or CRC32C
+static void file_digest_sum(int algorithm, file_digest_t * file, unsigned char * buffer, size_t bufsize)
+{
+    uint32_t value = algorithm == STREAM_DIGEST_ADLER32 ? 1 : 0;
+    size_t want;
+    ssize_t got;
+    int fd;
+
+    fd = open(file -> path, O_RDONLY);
+    if (fd < 0){
+        file -> error = errno;
+        return;
+    }
+
+    while ((want = file_digest_want(file, bufsize)) > 0){
+        got = file_digest_read(fd, buffer, want, file -> offset + file -> nbytes);
+        if (got < 0){
+            file -> error = errno;
+            break;
+        }
+        if (algorithm == STREAM_DIGEST_ADLER32){
+            value = adler32_update(value, buffer, (size_t) got);
+        } else{
+            value = crc32c_update(value, buffer, (size_t) got);
+        }
+        file -> nbytes += got;
+        if ((size_t) got < want){
+            break;
+        }
+    }
+
+    close(fd);
+
+    if (file -> error == 0){
+        sprintf(file -> hex, "%08x", (unsigned int) value);
+    }
+}
+
+void cksm_file_digests(int algorithm, file_digest_t * files, int nfiles, size_t bufsize)
+{
+    unsigned char * buffer;
+    int group;
+    int i;
+
+    pthread_once(&cksm_once, cksm_dispatch_init);
+
+    // whole MD5 blocks per buffer keep the multi-buffer lanes lined up
+    bufsize = (bufsize + 63) & ~((size_t) 63);
+    if (bufsize == 0){
+        bufsize = 64;
+    }
+
+    for (i = 0; i < nfiles; i++){
+        files[i].hex[0] = '\0';
+        files[i].nbytes = 0;
+        files[i].error = 0;
+    }
+
+    if (algorithm == STREAM_DIGEST_MD5){
+        for (i = 0; i < nfiles; i += md5_multi_lanes){
+            group = nfiles - i < md5_multi_lanes ? nfiles - i : md5_multi_lanes;
+            file_digests_md5(files + i, group, bufsize);
+        }
+        return;
+    }
+
+    buffer = (unsigned char *) malloc(bufsize);
+    for (i = 0; i < nfiles; i++){
+        if (buffer == NULL){
+            files[i].error = ENOMEM;
+        } else{
+            file_digest_sum(algorithm, &files[i], buffer, bufsize);
+        }
+    }
+    free(buffer);
+}
+
+// stream digests
+
+// used to store a run of bytes of a stream digest that cannot be
+// hashed yet: for MD5 a copy of a block that arrived ahead of the
+// bytes before it, and for the other algorithms the checksum of a run
+// of contiguous blocks
+typedef struct stream_segment_s
+{
+    struct stream_segment_s * next;  // next run, at a higher offset
+    long long offset;
+    long long length;
+    uint32_t value;                  // checksum of the run, unless MD5
+    unsigned char * data;            // copy of the run for MD5
+} stream_segment_t;
+
+struct stream_digest_s
+{
+    pthread_mutex_t mutex;       // protects the fields below
+    int refs;
+    int algorithm;               // one of the STREAM_DIGEST_ values
+    long long start;             // offset of the first byte summed
+    long long next;              // offset of the next byte MD5 must hash
+    md5_ctx_t md5;
+    stream_segment_t * segments; // runs not yet folded in, by offset
+    size_t pending;              // bytes of data held for MD5
+    size_t max_pending;          // most bytes of data held for MD5
+    long long nbytes;            // bytes fed
+    int finished;
+    const char * reason;         // why the digest failed, NULL if it did not
+    char hex[STREAM_DIGEST_HEX_MAX];
+};
+
+int stream_digest_algorithm(const char * name)
+{
+    if (strcasecmp(name, "MD5") == 0){
+        return STREAM_DIGEST_MD5;
+    }
+    if (strcasecmp(name, "ADLER32") == 0){
+        return STREAM_DIGEST_ADLER32;
+    }
+    if (strcasecmp(name, "CRC32C") == 0){
+        return STREAM_DIGEST_CRC32C;
+    }
+
+    return -1;
+}
+
+stream_digest_t * stream_digest_new(int algorithm, long long start, size_t max_pending)
+{
+    stream_digest_t * digest;
+
+    digest = (stream_digest_t *) malloc(sizeof(stream_digest_t));
+    if (digest == NULL){
+        return NULL;
+    }
+
+    memset(digest, 0, sizeof(stream_digest_t));
+    pthread_mutex_init(&(digest -> mutex), NULL);
+    digest -> refs = 1;
+    digest -> algorithm = algorithm;
+    digest -> start = start;
+    digest -> next = start;
+    digest -> max_pending = max_pending;
+    md5_init(&(digest -> md5));
+
+    return digest;
+}
+
+// free the runs of a digest; the mutex must be held
+static void stream_digest_clear(stream_digest_t * digest)
+{
+    stream_segment_t * segment;
+
+    while (digest -> segments){
+        segment = digest -> segments;
+        digest -> segments = segment -> next;
+        free(segment -> data);
+        free(segment);
+    }
+    digest -> pending = 0;
+}
+
+void stream_digest_retain(stream_digest_t * digest)
+{
+    pthread_mutex_lock(&(digest -> mutex));
+    digest -> refs++;
+    pthread_mutex_unlock(&(digest -> mutex));
+}
+
+void stream_digest_release(stream_digest_t * digest)
+{
+    int refs;
+
+    pthread_mutex_lock(&(digest -> mutex));
+    refs = --(digest -> refs);
+    pthread_mutex_unlock(&(digest -> mutex));
+
+    if (refs == 0){
+        stream_digest_clear(digest);
+        pthread_mutex_destroy(&(digest -> mutex));
+        free(digest);
+    }
+}
+
+// fail a digest and drop what it holds; the mutex must be held
+static void stream_digest_fail_locked(stream_digest_t * digest, const char * reason)
+{
+    if (digest -> reason == NULL){
+        digest -> reason = reason;
+    }
+    stream_digest_clear(digest);
+}
+
+// fold a block into an MD5 digest; the mutex must be held
+static void stream_digest_update_md5(stream_digest_t * digest, long long offset, const unsigned char * data, size_t length)
+{
+    stream_segment_t ** link;
+    stream_segment_t * segment;
+
+    if (offset < digest -> next){
+        stream_digest_fail_locked(digest, "overlapping data");
+        return;
+    }
+
+    // a block ahead of the bytes still missing is held until they come
+    if (offset > digest -> next){
+        if (digest -> pending + length > digest -> max_pending){
+            stream_digest_fail_locked(digest, "data too far out of order");
+            return;
+        }
+
+        segment = (stream_segment_t *) malloc(sizeof(stream_segment_t));
+        if (segment){
+            segment -> data = (unsigned char *) malloc(length);
+        }
+        if (segment == NULL || segment -> data == NULL){
+            free(segment);
+            stream_digest_fail_locked(digest, "out of memory");
+            return;
+        }
+        memcpy(segment -> data, data, length);
+        segment -> offset = offset;
+        segment -> length = (long long) length;
+
+        for (link = &(digest -> segments); *link && (*link) -> offset < offset; link = &((*link) -> next)){
+        }
+        segment -> next = *link;
+        *link = segment;
+        digest -> pending += length;
+        return;
+    }
+
+    md5_update(&(digest -> md5), data, length);
+    digest -> next += (long long) length;
+
+    // then any held blocks it makes contiguous
+    while ((segment = digest -> segments) && segment -> offset <= digest -> next){
+        if (segment -> offset < digest -> next){
+            stream_digest_fail_locked(digest, "overlapping data");
+            return;
+        }
+        md5_update(&(digest -> md5), segment -> data, (size_t) segment -> length);
+        digest -> next += segment -> length;
+        digest -> pending -= (size_t) segment -> length;
+        digest -> segments = segment -> next;
+        free(segment -> data);
+        free(segment);
+    }
+}
+
+// fold the checksum of a block into an Adler-32 or CRC32C digest,
+// merging it with the runs it touches; the mutex must be held
+static void stream_digest_update_combined(stream_digest_t * digest, long long offset, uint32_t value, long long length)
+{
+    stream_segment_t ** link;
+    stream_segment_t * prev = NULL;
+    stream_segment_t * segment;
+    stream_segment_t * next;
+
+    for (link = &(digest -> segments); *link && (*link) -> offset < offset; link = &((*link) -> next)){
+        prev = *link;
+    }
+    next = *link;
+
+    if (offset < digest -> start || (prev && prev -> offset + prev -> length > offset) || (next && offset + length > next -> offset)){
+        stream_digest_fail_locked(digest, "overlapping data");
+        return;
+    }
+
+    if (prev && prev -> offset + prev -> length == offset){
+        segment = prev;
+        segment -> value = digest -> algorithm == STREAM_DIGEST_ADLER32 ?
+            adler32_combine(segment -> value, value, (uint64_t) length) :
+            crc32c_combine(segment -> value, value, (uint64_t) length);
+        segment -> length += length;
+    } else{
+        segment = (stream_segment_t *) malloc(sizeof(stream_segment_t));
+        if (segment == NULL){
+            stream_digest_fail_locked(digest, "out of memory");
+            return;
+        }
+        segment -> offset = offset;
+        segment -> length = length;
+        segment -> value = value;
+        segment -> data = NULL;
+        segment -> next = next;
+        *link = segment;
+    }
+
+    if (next && segment -> offset + segment -> length == next -> offset){
+        segment -> value = digest -> algorithm == STREAM_DIGEST_ADLER32 ?
+            adler32_combine(segment -> value, next -> value, (uint64_t) next -> length) :
+            crc32c_combine(segment -> value, next -> value, (uint64_t) next -> length);
+        segment -> length += next -> length;
+        segment -> next = next -> next;
+        free(next);
+    }
+}
+
+void stream_digest_update(stream_digest_t * digest, long long offset, const unsigned char * data, size_t length)
+{
+    uint32_t value = 0;
+
+    if (length == 0){
+        return;
+    }
+
+    // the checksum of a block for the combinable algorithms is taken
+    // before the lock, so parallel streams sum their blocks at once
+    if (digest -> algorithm == STREAM_DIGEST_ADLER32){
+        value = adler32_update(1, data, length);
+    } else if (digest -> algorithm == STREAM_DIGEST_CRC32C){
+        value = crc32c_update(0, data, length);
+    }
+
+    pthread_mutex_lock(&(digest -> mutex));
+
+    if (!(digest -> finished) && digest -> reason == NULL){
+        digest -> nbytes += (long long) length;
+        if (digest -> algorithm == STREAM_DIGEST_MD5){
+            stream_digest_update_md5(digest, offset, data, length);
+        } else{
+            stream_digest_update_combined(digest, offset, value, (long long) length);
+        }
+    }
+
+    pthread_mutex_unlock(&(digest -> mutex));
+}
+
+void stream_digest_fail(stream_digest_t * digest, const char * reason)
+{
+    pthread_mutex_lock(&(digest -> mutex));
+    if (!(digest -> finished)){
+        stream_digest_fail_locked(digest, reason);
+    }
+    pthread_mutex_unlock(&(digest -> mutex));
+}
+
+void stream_digest_finish(stream_digest_t * digest)
+{
+    unsigned char md5[16];
+    stream_segment_t * segment;
+    uint32_t value;
+
+    pthread_mutex_lock(&(digest -> mutex));
+
+    if (!(digest -> finished) && digest -> reason == NULL){
+        segment = digest -> segments;
+
+        if (digest -> algorithm == STREAM_DIGEST_MD5){
+            if (segment){
+                stream_digest_fail_locked(digest, "data missing");
+            } else{
+                md5_final(&(digest -> md5), md5);
+                md5_hex(md5, digest -> hex);
+            }
+        } else if (segment && (segment -> offset != digest -> start || segment -> next)){
+            stream_digest_fail_locked(digest, "data missing");
+        } else{
+            // no run at all is an empty file
+            if (segment){
+                value = segment -> value;
+            } else{
+                value = digest -> algorithm == STREAM_DIGEST_ADLER32 ? 1 : 0;
+            }
+            sprintf(digest -> hex, "%08x", (unsigned int) value);
+            stream_digest_clear(digest);
+        }
+    }
+    digest -> finished = 1;
+
+    pthread_mutex_unlock(&(digest -> mutex));
+}
+
+int stream_digest_result(stream_digest_t * digest, char hex[STREAM_DIGEST_HEX_MAX], long long * nbytes, const char ** reason)
+{
+    int rc;
+
+    pthread_mutex_lock(&(digest -> mutex));
+
+    *nbytes = digest -> nbytes;
+    *reason = digest -> reason;
+    if (digest -> reason){
+        rc = -1;
+    } else if (digest -> finished){
+        memcpy(hex, digest -> hex, STREAM_DIGEST_HEX_MAX);
+        rc = 1;
+    } else{
+        rc = 0;
+    }
+
+    pthread_mutex_unlock(&(digest -> mutex));
+
+    return rc;
+}
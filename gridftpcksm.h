@@ -0,0 +1,83 @@
+#ifndef GRIDFTPCKSM_H
+#define GRIDFTPCKSM_H
+
+// checksums computed by the wrapper on the data of a transfer as it
+// arrives, to compare against the checksum the server reports for
+// the file without reading the file a second time. Nothing here
+// refers to Python or Globus
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the algorithms a stream digest can compute
+enum
+{
+    STREAM_DIGEST_MD5 = 0,
+    STREAM_DIGEST_ADLER32,
+    STREAM_DIGEST_CRC32C
+};
+
+// size of the buffer for the hex digest of any stream digest algorithm,
+// terminator included
+#define STREAM_DIGEST_HEX_MAX 33
+
+// name of the kernel picked at run time for a STREAM_DIGEST_ algorithm
+// on this CPU, or NULL for an unknown algorithm
+const char * cksm_kernel_name(int algorithm);
+
+// used to ask for the digest of a byte range of a local file
+typedef struct
+{
+    const char * path;
+    long long offset;            // offset of the first byte summed
+    long long length;            // bytes summed, -1 for the rest of the file
+    char hex[STREAM_DIGEST_HEX_MAX]; // lower case hex digest, empty on error
+    long long nbytes;            // bytes summed, fewer than length if the file is shorter
+    int error;                   // errno of a failure to read the file, 0 if none
+} file_digest_t;
+
+// compute the digests of the ranges of local files in files, reading
+// bufsize bytes at a time; MD5 ranges are hashed several at once
+void cksm_file_digests(int algorithm, file_digest_t * files, int nfiles, size_t bufsize);
+
+typedef struct stream_digest_s stream_digest_t;
+
+// return the STREAM_DIGEST_ value for an algorithm name, ignoring case,
+// or -1 if it is not supported
+int stream_digest_algorithm(const char * name);
+
+// create a stream digest of the bytes of a file from start on, with a
+// reference held by the caller
+//
+// blocks may be fed in any order. Adler-32 and CRC32C are computed per
+// block and combined as the gaps between blocks fill; MD5 must see the
+// bytes in order, so a block that arrives early is copied and held,
+// and the digest fails if more than max_pending bytes are held at once.
+// Returns NULL if out of memory
+stream_digest_t * stream_digest_new(int algorithm, long long start, size_t max_pending);
+
+// take and drop a reference; the digest is freed with the last one.
+// Both may be called from any thread
+void stream_digest_retain(stream_digest_t * digest);
+void stream_digest_release(stream_digest_t * digest);
+
+// feed a block of the file at offset; ignored once the digest has
+// failed or finished
+void stream_digest_update(stream_digest_t * digest, long long offset, const unsigned char * data, size_t length);
+
+// give up on a digest, for example because its transfer failed; the
+// first reason given is kept
+void stream_digest_fail(stream_digest_t * digest, const char * reason);
+
+// compute the digest once every block has been fed; it fails if the
+// bytes fed do not run without a gap from start
+void stream_digest_finish(stream_digest_t * digest);
+
+// get the outcome of a digest
+//
+// returns 1 with the lower case hex digest copied to hex, 0 if it is
+// not finished yet, or -1 with *reason set if it failed. *nbytes is set
+// to the number of bytes fed in every case
+int stream_digest_result(stream_digest_t * digest, char hex[STREAM_DIGEST_HEX_MAX], long long * nbytes, const char ** reason);
+
+#endif
@@ -1,6 +1,14 @@
 #include "Python.h"
 #include <unistd.h>
 #include <ctype.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 #include "globus_common.h"
 #include "globus_ftp_client.h"
@@ -11,6 +19,8 @@
 
 #include "globus_ftp_control.h"
 
+#include "gridftpcksm.h"
+
 
 // Some notes about threads
 // 
@@ -131,6 +141,196 @@ static void child()
 //
 //
 
+// the buffer pool hands out page aligned buffers in a fixed set of
+// size classes and keeps freed buffers on a per class free list so
+// that busy transfers do not go back to the allocator (and pay for
+// zeroing multi-MB blocks) for every buffer. Classes are spaced two
+// per octave (1, 1.5, 2, 3, 4, 6, ... pages) so rounding up wastes at
+// most a third of a buffer
+#define BUFFER_POOL_NCLASSES 64
+
+// buffers this large or larger are mapped with mmap, which is page
+// aligned, already zeroed, and may be backed by huge pages
+#define BUFFER_POOL_MMAP_THRESHOLD (1024 * 1024)
+#define BUFFER_POOL_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+// an idle buffer on a free list, stored in the buffer itself
+typedef struct buffer_pool_idle_s
+{
+    struct buffer_pool_idle_s * next;
+} buffer_pool_idle_t;
+
+// one size class of the buffer pool
+typedef struct
+{
+    globus_size_t size;          // size in bytes of every buffer in the class
+    buffer_pool_idle_t * idle;   // free list of idle buffers
+    unsigned long nidle;         // number of buffers on the free list
+    unsigned long nused;         // number of buffers handed out
+    unsigned long hits;          // allocations served from the free list
+    unsigned long misses;        // allocations that needed new memory
+    unsigned long hugemisses;    // misses that were given huge page memory
+} buffer_pool_class_t;
+
+// the process wide buffer pool
+typedef struct
+{
+    globus_mutex_t mutex;        // protects everything in the pool
+    int initialized;
+    globus_size_t page_size;
+    int use_hugepages;           // try MAP_HUGETLB for large classes
+    unsigned long max_idle;      // maximum idle buffers kept per class
+    int nclasses;
+    buffer_pool_class_t classes[BUFFER_POOL_NCLASSES];
+} buffer_pool_t;
+
+static buffer_pool_t buffer_pool;
+
+// kinds of completion records, exported to Python so that events
+// drained from a completion queue can be dispatched
+enum
+{
+    COMPLETION_THIRD_PARTY = 1,
+    COMPLETION_CKSM,
+    COMPLETION_MKDIR,
+    COMPLETION_RMDIR,
+    COMPLETION_DELETE,
+    COMPLETION_MOVE,
+    COMPLETION_CHMOD,
+    COMPLETION_GET,
+    COMPLETION_GET_DATA,
+    COMPLETION_PUT,
+    COMPLETION_PUT_DATA,
+    COMPLETION_GET_TO_FILE,
+    COMPLETION_EXISTS,
+    COMPLETION_PERF_BEGIN,
+    COMPLETION_PERF_MARKER,
+    COMPLETION_PERF_COMPLETE,
+    COMPLETION_STRIPED_GET,
+    COMPLETION_PREWARM,
+    COMPLETION_PIPELINED,
+    COMPLETION_TRANSFER
+};
+
+// a completion recorded by a Globus callback thread for later delivery
+// to Python. Records are built without the GIL so they hold only C data
+// and the references the callback bucket already owned; the Python
+// argument tuple is built when the record is drained
+typedef struct completion_record_s
+{
+    struct completion_record_s * next;
+    struct completion_queue_s * queue;  // queue the record is delivered through
+    int kind;                           // one of the COMPLETION_ values
+    int owned;                          // true if the record owns a reference to pyarg and the queue object;
+                                        // perf plugin records hold a count on their callback bucket instead
+    PyObject * pyarg;                   // Python argument to pass back
+    globus_ftp_client_handle_t * handle;
+    char * error;                       // error chain text, NULL on success
+    char * text[2];                     // kind specific strings (checksum, urls)
+    globus_byte_t * buffer;             // data buffer for data callbacks
+    globus_off_t values[5];             // kind specific numbers
+    void * owner;                       // kind specific state released when drained
+} completion_record_t;
+
+// a completion queue lets callbacks skip taking the GIL altogether.
+// Globus threads push records onto a lock free LIFO with a compare and
+// swap; the consumer, always holding the GIL, takes the whole list with
+// one exchange and reverses it, so events come out in the order they
+// were pushed and many events are delivered per GIL acquisition
+//
+// so that an event loop can wait on the queue alongside its other file
+// descriptors the queue also owns an eventfd (a pipe where there is no
+// eventfd), which is readable whenever records are waiting. It is
+// written at most once between drains, not once per record
+typedef struct completion_queue_s
+{
+    completion_record_t * head;         // lock free list of pushed records, newest first
+    completion_record_t * pending;      // records taken but not yet drained, oldest first
+    completion_record_t * pending_tail;
+    int waiting;                        // number of threads blocked in a drain
+    globus_mutex_t mutex;               // used only to block and wake waiting threads
+    globus_cond_t cond;
+    int notify_fd[2];                   // read and write ends of the eventfd or pipe made readable when records are ready
+    int signaled;                       // true if notify_fd has been written and not yet cleared
+} completion_queue_t;
+
+// tag stored as the description of a completion queue Python object so
+// that callbacks can recognize a queue passed in place of a function
+static char completion_queue_tag[] = "gridftpwrapper completion queue";
+
+// used to wait in C, without the Python GIL, for the completion of an
+// operation started by one of the _sync functions. The bucket lives on
+// the stack of the waiting function, so nothing here refers to Python
+typedef struct
+{
+    globus_mutex_t mutex;
+    globus_cond_t cond;
+    globus_bool_t done;    // true once the complete callback has run
+    char * error;          // error chain text, NULL on success
+    int error_code;        // FTP reply code carried by the error, 0 if none
+} sync_bucket_t;
+
+// size of the buffer a listing is read into by the _sync listing
+// functions
+#define LISTING_READ_BUFFER 65536
+
+// used to store a listing parsed from MLSD or MLST fact lines, a column
+// per fact so Python can read the entries without a text line, or an
+// object, per entry
+typedef struct
+{
+    char * names;          // names of the entries, each followed by a NUL
+    long names_len;
+    long names_size;       // allocated length of names
+    long * offsets;        // offset of the name of each entry in names
+    long * sizes;          // size fact, -1 if not given
+    long * mtimes;         // modify fact in seconds since the epoch, -1 if not given
+    long * modes;          // UNIX.mode fact, -1 if not given
+    char * types;          // type fact: f file, d dir, c cdir, p pdir, l link, o other
+    long n;                // number of entries
+    long size;             // allocated number of entries
+    char * line;           // start of a line cut off at the end of the last buffer
+    long line_len;
+    long line_size;        // allocated length of line
+    globus_bool_t skip_dots; // leave out the cdir and pdir entries
+    globus_bool_t failed;  // true if out of memory
+} listing_t;
+
+// used to read and parse a machine list for gridftp_machine_list_sync
+typedef struct
+{
+    sync_bucket_t bucket;  // completion of the operation
+    listing_t listing;     // the entries parsed so far
+    globus_byte_t buffer[LISTING_READ_BUFFER];
+} listing_read_t;
+
+// used to store a restart marker shared between Python and the
+// transfers that update it. The mutex protects the marker while a get
+// into a local file records the ranges written, or a restart marker
+// plugin records the markers sent by the server. It is freed by the
+// destructor of its Python object, which those transfers hold
+typedef struct
+{
+    globus_ftp_client_restart_marker_t marker;
+    globus_mutex_t mutex;
+} restart_marker_t;
+
+// used to store the state of a restart marker plugin, which keeps a
+// restart marker up to date with the markers sent by the server
+typedef struct
+{
+    restart_marker_t * marker; // the marker to keep up to date
+    PyObject * pymarker;       // Python object for the marker, held while the plugin exists
+} restart_marker_plugin_bucket_t;
+
+// tag stored as the description of a restart marker Python object so
+// that it can be told apart from other wrapped pointers
+static char restart_marker_tag[] = "gridftpwrapper restart marker";
+
+// tag stored as the description of a stream digest Python object so
+// that it can be told apart from other wrapped pointers
+static char stream_digest_tag[] = "gridftpwrapper stream digest";
+
 // used to store pointers to the Python objects that should
 // be used during a callback for completion of third party transfer
 typedef struct
@@ -145,10 +345,40 @@ typedef struct
 {
     PyObject * pyfunction; // Python object for the Python function to call as callback
     PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
-    char cksm[32];         // the checksum value
+    char * cksm;           // the checksum value, sized by cksm_digest_size
 
 } cksm_callback_bucket_t;
 
+// used to describe a checksum algorithm by the size of its digest.
+// Globus copies the digest from the server reply as hex, with no
+// bound, so the buffer must hold two characters per byte and a
+// terminator
+typedef struct
+{
+    const char * name;     // name as given to CKSM
+    int digest_bytes;      // size of the binary digest
+} cksm_algorithm_t;
+
+static const cksm_algorithm_t cksm_algorithms[] = {
+    {"ADLER32", 4},
+    {"CRC32", 4},
+    {"CRC32C", 4},
+    {"MD5", 16},
+    {"SHA1", 20},
+    {"SHA-1", 20},
+    {"SHA256", 32},
+    {"SHA-256", 32},
+    {"SHA512", 64},
+    {"SHA-512", 64},
+    {NULL, 0}
+};
+
+// size of the digest buffer for an algorithm not in cksm_algorithms
+#define CKSM_UNKNOWN_DIGEST 512
+
+// longest name of a checksum algorithm accepted
+#define CKSM_ALGORITHM_MAX 32
+
 // used to store pointers to the Python objects that should
 // be used during a callback for a mkdir operation
 typedef struct
@@ -190,29 +420,487 @@ typedef struct
 } chmod_callback_bucket_t;
 
 // used to store pointers to the Python objects that should
-// be used during a callback for completion of a get operation
+// be used during a callback for completion of a get, or of a list
+// operation whose data is read the same way
 typedef struct
 {
     PyObject * pyfunction; // Python object for the Python function to call as callback
     PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
+    stream_digest_t * digest; // digest finished when the get completes, NULL if none
 } get_complete_callback_bucket_t;
 
 // used to store pointers to the Python objects that should
-// be used during a callback for completion of a verbose list operation
+// be used during a data callback for a get or put operation
 typedef struct
 {
     PyObject * pyfunction; // Python object for the Python function to call as callback
     PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
-} verbose_list_complete_callback_bucket_t;
+    PyObject * pybuffer;   // Python object for the Python buffer 
+    stream_digest_t * digest; // digest the data is fed to, NULL if none
+} get_data_callback_bucket_t;
 
 // used to store pointers to the Python objects that should
-// be used during a data callback for a get or put operation
+// be used during a callback for completion of a put operation
 typedef struct
 {
     PyObject * pyfunction; // Python object for the Python function to call as callback
     PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
-    PyObject * pybuffer;   // Python object for the Python buffer 
-} get_data_callback_bucket_t;
+} put_complete_callback_bucket_t;
+
+// used to store pointers to the Python objects that should
+// be used during a data callback for a put operation
+//
+// the memory handed to Globus belongs to the Python object pybuffer,
+// so a reference (and, for new style buffers, the buffer view) is
+// held until Globus is done with the memory and the callback has run
+typedef struct
+{
+    PyObject * pyfunction; // Python object for the Python function to call as callback
+    PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
+    PyObject * pybuffer;   // Python object that owns the memory being written
+    Py_buffer view;        // buffer view held while Globus uses the memory
+    int has_view;          // true if view must be released
+    globus_byte_t * copy;  // copy of the data for old style buffers, or NULL
+} put_data_callback_bucket_t;
+
+// used to store the state of a get operation whose data is written
+// directly to a local file by the wrapper. The data callbacks run
+// entirely in C, without the Python GIL, and re-register their buffers
+// themselves; Python is only called once, when the get completes
+typedef struct
+{
+    PyObject * pyfunction;   // Python object for the Python function to call at completion
+    PyObject * pyarg;        // Python object for the Python argument to pass in to the callback
+    int fd;                  // file descriptor the data is written to
+    int close_fd;            // true if the wrapper opened fd and must close it
+    int nbuffers;            // number of buffers kept registered with Globus
+    globus_size_t bufsize;   // size of each buffer
+    globus_byte_t ** buffers;
+    buffer_pool_class_t * bufclass; // buffer pool class the buffers come from
+    globus_mutex_t mutex;    // protects the fields below
+    int outstanding;         // number of buffers not yet retired
+    globus_bool_t done;      // true once eof or an error has been seen
+    globus_bool_t complete;  // true once Globus has called the completion callback
+    globus_ftp_client_handle_t * handle; // handle the get runs on
+    char * error;            // error chain of the get, NULL if none
+    int write_errno;         // errno of a failed local write, 0 if none
+    globus_off_t nbytes;     // number of bytes written to the file
+    restart_marker_t * marker; // marker the written ranges are recorded in, NULL if none
+    PyObject * pymarker;     // Python object for the marker
+    stream_digest_t * digest; // digest of the data written, NULL if none
+} get_sink_t;
+
+// used to store the state of a ring of buffers that the wrapper keeps
+// registered for a get operation. Each buffer is re-registered by the
+// wrapper as soon as the Python data callback returns, or before the
+// callback is called when the data is copied out for Python
+typedef struct
+{
+    PyObject * pyfunction;   // Python object for the Python function to call as data callback
+    PyObject * pyarg;        // Python object for the Python argument to pass in to the callback
+    int copy;                // true if the data is copied into a string for Python
+    stream_digest_t * digest; // digest the data is fed to, NULL if none
+    int nbuffers;            // number of buffers in the ring
+    globus_size_t bufsize;   // size of each buffer
+    globus_byte_t ** buffers;
+    buffer_pool_class_t * bufclass; // buffer pool class the buffers come from
+    globus_mutex_t mutex;    // protects the fields below
+    int outstanding;         // buffers registered, plus one while the registering thread uses the ring
+    globus_bool_t done;      // true once eof or an error has been seen
+} read_ring_t;
+
+struct striped_get_s;
+
+// used to store the state of one stream of a striped get. Each stream
+// owns its own handle, and so its own control and data connections,
+// and moves from one byte range of the file to the next until the
+// engine has none left to hand out
+typedef struct
+{
+    struct striped_get_s * engine;
+    globus_ftp_client_handle_t handle;
+    globus_byte_t ** buffers;  // buffers kept registered for the current range
+    globus_bool_t busy;        // true while a range is being transferred
+    globus_off_t start;        // first byte of the current range
+    globus_off_t end;          // end of the current range, lowered when part of it is stolen
+    globus_off_t position;     // end of the highest block received for the current range, counted once its write is reserved
+    globus_off_t range_bytes;  // bytes written for the current range
+    globus_bool_t clipped;     // true if the range was shortened after it was started
+    globus_bool_t aborting;    // true once the get of a clipped range has been aborted
+    globus_off_t nbytes;       // bytes written by this stream over all of its ranges
+} striped_stream_t;
+
+// used to store the state of a striped get, which splits one file into
+// byte ranges and fetches them over several handles at once, writing
+// each block in place in the destination file. Ranges are handed out
+// with guided self-scheduling, large at first and smaller towards the
+// end of the file, and once none are left a stream that runs dry takes
+// over the upper half of what the slowest stream still has to fetch
+typedef struct striped_get_s
+{
+    PyObject * pyfunction;     // Python object for the Python function to call at completion
+    PyObject * pyarg;          // Python object for the Python argument to pass in to the callback
+    char * url;                // URL of the file being fetched
+    globus_ftp_client_operationattr_t attr; // operation attributes used for every range
+    globus_bool_t steal;       // true if ranges may be split, which needs in order data
+    int fd;                    // file descriptor the data is written to
+    int close_fd;              // true if the wrapper opened fd and must close it
+    int nstreams;              // number of streams, each with its own handle
+    striped_stream_t * streams;
+    int nbuffers;              // number of buffers registered per stream
+    globus_size_t bufsize;     // size of each buffer
+    buffer_pool_class_t * bufclass; // buffer pool class the buffers come from
+    globus_off_t minchunk;     // smallest range handed out
+    globus_mutex_t mutex;      // protects the fields below and those of the streams
+    globus_off_t size;         // size of the file, once known
+    globus_off_t cursor;       // first byte not yet handed out as a range
+    int nactive;               // number of streams that have not run out of work
+    globus_bool_t failed;      // true once a range failed or the get was aborted
+    char * error;              // description of the first failure
+    globus_off_t nbytes;       // bytes written to the file
+    globus_bool_t done;        // true once the completion has been reported
+} striped_get_t;
+
+// used as the description of Python objects wrapping a striped get
+static char striped_get_tag[] = "gridftpwrapper striped get";
+
+struct handle_pool_s;
+struct handle_pool_host_s;
+
+// number of hash buckets a handle pool looks directories up in
+#define DIR_CACHE_NBUCKETS 4096
+
+// used to store a directory a handle pool knows to exist, or that one
+// call of gridftp_handle_pool_makedirs is creating
+typedef struct dir_cache_entry_s
+{
+    struct dir_cache_entry_s * next; // next directory in the same hash bucket
+    char * url;                      // normalized URL of the directory
+    globus_bool_t creating;          // true while it is being created
+} dir_cache_entry_t;
+
+// used to store a handle kept by a handle pool. The handle comes first
+// so that the pointer handed to Python as the handle is also the entry
+typedef struct handle_pool_entry_s
+{
+    globus_ftp_client_handle_t handle;
+    struct handle_pool_s * pool;        // pool the handle belongs to
+    struct handle_pool_host_s * host;   // host the handle is kept for
+    struct handle_pool_entry_s * next;  // next idle handle of the host
+    globus_bool_t leased;               // true while leased out, protected by the pool mutex
+} handle_pool_entry_t;
+
+// used to store the handles a handle pool keeps for one host:port
+typedef struct handle_pool_host_s
+{
+    struct handle_pool_host_s * next;
+    char * key;                // host:port the handles are kept for
+    handle_pool_entry_t * idle; // idle handles, most recently used first
+    int nidle;                 // number of idle handles
+    int nleased;               // number of handles leased out
+} handle_pool_host_t;
+
+// used to store the state of a pool of handles that are leased out per
+// host:port and kept when they come back, so the control connections
+// they cache are reused by the next lease for the same host. The
+// handles are created from the pool's own copy of the handle
+// attributes, with caching of every URL turned on
+typedef struct handle_pool_s
+{
+    globus_ftp_client_handleattr_t attr; // attributes every handle is created with
+    int max_per_host;          // largest number of handles, idle or leased, per host
+    globus_mutex_t mutex;      // protects the fields below
+    globus_cond_t cond;        // signalled when a handle comes back
+    handle_pool_host_t * hosts;
+    int waiting;               // number of threads waiting for a handle
+    globus_mutex_t dirs_mutex; // protects the directory cache
+    globus_cond_t dirs_cond;   // signalled when a directory is done being created
+    dir_cache_entry_t ** dirs; // directories known to exist, by hash, allocated on first use
+    long ndirs;                // number of directories cached
+} handle_pool_t;
+
+// used as the description of Python objects wrapping a handle pool
+// and the handles leased from it
+static char handle_pool_tag[] = "gridftpwrapper handle pool";
+static char handle_pool_handle_tag[] = "gridftpwrapper pooled handle";
+
+// used to store the state of the operation that warms up a handle
+// leased by gridftp_handle_pool_prewarm
+typedef struct
+{
+    PyObject * pyfunction;        // Python object for the Python function to call as callback
+    PyObject * pyarg;             // Python object for the Python argument to pass in to the callback
+    handle_pool_entry_t * entry;  // the leased handle
+    char * url;                   // the URL being warmed up
+} prewarm_callback_bucket_t;
+
+// metadata operations gridftp_handle_pool_metadata_many can run
+enum {
+    METADATA_EXISTS,
+    METADATA_MKDIR,
+    METADATA_RMDIR,
+    METADATA_DELETE,
+    METADATA_CHMOD,
+    METADATA_MOVE,
+    METADATA_CKSM,
+    METADATA_ISDIR            // MLST, succeeding only for a directory
+};
+
+// used to store the checksum requests of a metadata batch, a range of
+// a file per URL
+typedef struct
+{
+    const char * algorithm;   // checksum algorithm of every request
+    long long * offsets;      // per URL, offset of the range
+    long long * lengths;      // per URL, length of the range, -1 for the rest of the file
+    char ** cksms;            // per URL, buffer of cksm_digest_size(algorithm) bytes the checksum is written to
+} metadata_cksm_t;
+
+// used to store the state of a batch of metadata operations run over
+// handles leased from a handle pool with a bounded number in flight
+typedef struct
+{
+    handle_pool_t * pool;     // handle pool the operations lease their handles from
+    globus_ftp_client_operationattr_t * attr; // operation attributes, or NULL
+    int op;                   // the metadata operation the batch runs
+    int * results;            // per URL: 0 for success, the FTP reply code of a refusal, -1 or -2
+    int active;               // number of operations in flight
+    double timeout;           // seconds to wait for a handle in all with none of its own in flight
+    double starved;           // seconds spent waiting for a handle with none of its own in flight
+    globus_mutex_t mutex;     // protects active
+    globus_cond_t cond;       // signalled when an operation completes
+} metadata_batch_t;
+
+// seconds a metadata batch waits for a handle at a time, and in all
+// unless the caller gives another timeout, while none of its own
+// operations are in flight to give one back, for example because the
+// caller holds every lease for the host
+#define METADATA_ACQUIRE_SLICE 1.0
+#define METADATA_ACQUIRE_TIMEOUT 30.0
+
+// the result of an item of a metadata batch that got no handle in time
+#define METADATA_ACQUIRE_TIMED_OUT -2
+
+// used to store the state of one operation of a metadata batch
+typedef struct
+{
+    metadata_batch_t * batch;     // batch the operation belongs to
+    handle_pool_entry_t * entry;  // the leased handle
+    int index;                    // index of the URL in the batch
+    globus_byte_t * facts;        // fact line of an MLST, NULL if none
+    globus_size_t facts_length;   // length of the fact line
+} metadata_slot_t;
+
+// used to store a URL given to gridftp_handle_pool_makedirs while its
+// directories are made one level at a time
+typedef struct
+{
+    char * url;     // the URL with its path normalized
+    int index;      // index of the URL in the call
+    int end;        // end in url of the directory of the level being made
+} makedirs_leaf_t;
+
+// number of directory listings a tree walker keeps ready for Python
+// per listing it may run at once before it stops starting more
+#define WALKER_READY_PER_ACTIVE 4
+
+// used to store a directory waiting to be listed by a tree walker
+typedef struct walker_dir_s
+{
+    struct walker_dir_s * next;  // next directory of the same host
+    char * url;                  // URL of the directory
+    int depth;                   // depth below the root it was found under
+} walker_dir_t;
+
+// used to store the directories a tree walker has yet to list on one
+// host:port. They are kept as a stack, so the walk goes depth first and
+// the number waiting stays small, while the hosts take turns
+typedef struct walker_host_s
+{
+    struct walker_host_s * next;
+    char * key;                  // host:port, also the handle pool key
+    walker_dir_t * dirs;         // directories to list, last found first
+    unsigned long blocked_pass;  // scheduling pass in which the pool had no handle for the host
+} walker_host_t;
+
+// used to store a listed directory until Python takes it
+typedef struct walker_result_s
+{
+    struct walker_result_s * next;
+    char * url;                  // URL of the directory
+    char * error;                // error text, NULL on success
+    listing_t listing;           // its entries
+} walker_result_t;
+
+struct walker_s;
+
+// used to store the state of one directory listing of a tree walker.
+// The read state comes first so the data callback of the _sync
+// listing can be shared
+typedef struct
+{
+    listing_read_t read;         // buffer and parsed entries
+    struct walker_s * walker;    // walker the listing belongs to
+    handle_pool_entry_t * entry; // handle leased for the listing
+    walker_dir_t * dir;          // the directory being listed
+} walker_op_t;
+
+// used to store the state of a tree walker, which lists the directories
+// below a set of roots over handles leased from a handle pool, up to
+// max_active at once, and keeps each listing until Python takes it
+typedef struct walker_s
+{
+    PyObject * poolObj;        // Python object for the handle pool
+    handle_pool_t * pool;      // handle pool the listings lease their handles from
+    globus_ftp_client_operationattr_t attr; // operation attributes, if has_attr
+    globus_bool_t has_attr;
+    int max_active;            // largest number of listings running at once
+    int max_depth;             // depth below the roots not to go past, negative for none
+    globus_mutex_t mutex;      // protects the fields below
+    globus_cond_t cond;        // signalled when a listing completes or a callback finishes
+    walker_host_t * hosts;
+    walker_host_t * cursor;    // host to be served next
+    long queued;               // number of directories waiting
+    int active;                // number of listings running
+    walker_result_t * ready;   // listings waiting for Python, oldest first
+    walker_result_t * ready_tail;
+    long nready;
+    long ndirs;                // number of directories listed
+    long nentries;             // number of entries found
+    long nerrors;              // number of listings that failed or left subdirectories out
+    unsigned long pass;        // number of scheduling passes made
+    int pending;               // number of oneshot callbacks registered and not yet run
+    globus_bool_t retry_pending; // true while a retry callback is registered
+    globus_bool_t closed;      // true once the walker is being destroyed
+} walker_t;
+
+// used as the description of Python objects wrapping a tree walker
+static char walker_tag[] = "gridftpwrapper tree walker";
+
+// number of priority classes of a transfer queue, 0 being the highest
+#define TRANSFER_QUEUE_NPRIORITIES 4
+
+// number of hash buckets a transfer queue looks its endpoint pairs up in
+#define TRANSFER_QUEUE_NBUCKETS 4096
+
+// microseconds a transfer queue waits before trying again to start jobs
+// that could not get a handle while none of its transfers are running
+#define TRANSFER_QUEUE_RETRY_USEC 50000
+
+struct transfer_queue_s;
+struct transfer_pair_s;
+
+// used to store a job of a transfer queue
+typedef struct transfer_job_s
+{
+    struct transfer_job_s * next;    // next job of the same pair and priority
+    struct transfer_pair_s * pair;   // endpoint pair of the job
+    struct transfer_queue_s * queue; // queue the job belongs to
+    char * src;                      // source URL
+    char * dst;                      // destination URL
+    PyObject * pyarg;                // Python object for the Python argument to pass in to the callback
+    int priority;                    // priority class
+    handle_pool_entry_t * entry;     // handle leased for the transfer, once started
+    globus_off_t size;               // size of the source file, -1 if not known
+    globus_bool_t sized;             // true once the size has been asked for, or was given
+    globus_off_t offset;             // start of the range of a chunk
+    globus_off_t end;                // end of the range of a chunk
+    struct transfer_job_s * parent;  // job a chunk is part of, NULL if not a chunk
+    int nchunks;                     // number of chunks of the job not yet reported
+    char * error;                    // first error reported for a chunk of the job
+} transfer_job_t;
+
+// used to store the jobs of a transfer queue between one source and
+// one destination host:port, queued per priority class
+typedef struct transfer_pair_s
+{
+    struct transfer_pair_s * hnext;  // next pair in the same hash bucket
+    char * key;                      // source and destination host:port, also the handle pool key
+    transfer_job_t * head[TRANSFER_QUEUE_NPRIORITIES];
+    transfer_job_t * tail[TRANSFER_QUEUE_NPRIORITIES];
+    transfer_job_t * small_head[TRANSFER_QUEUE_NPRIORITIES]; // small files, to be pipelined together
+    transfer_job_t * small_tail[TRANSFER_QUEUE_NPRIORITIES];
+    int active;                      // number of transfers running
+    unsigned long blocked_pass;      // scheduling pass in which the pool had no handle for the pair
+} transfer_pair_t;
+
+// used to store the state of a transfer queue, which runs third party
+// transfers of queued jobs over handles leased from a handle pool, with
+// at most max_active transfers at once and at most max_per_pair between
+// any one pair of endpoints. Jobs of a higher priority class always go
+// first; within a class the pairs take turns, so one busy pair does not
+// hold up the others
+//
+// With a size policy set, the size of each source is asked for on the
+// handle the job is given. Files of at least chunk_threshold bytes are
+// then split into chunks of chunk_size bytes, queued as partial
+// transfers which run over as many handles as the limits allow, and
+// files under small_threshold bytes are queued apart and started up to
+// batch_max at a time as one pipelined transfer on a single session
+typedef struct transfer_queue_s
+{
+    PyObject * pyfunction;     // Python object for the Python function, or completion queue, to report jobs to
+    PyObject * poolObj;        // Python object for the handle pool
+    handle_pool_t * pool;      // handle pool the transfers lease their handles from
+    globus_ftp_client_operationattr_t src_attr; // source operation attributes, if has_src_attr
+    globus_ftp_client_operationattr_t dst_attr; // destination operation attributes, if has_dst_attr
+    globus_bool_t has_src_attr;
+    globus_bool_t has_dst_attr;
+    int max_active;            // largest number of transfers running at once
+    int max_per_pair;          // largest number of transfers running at once per pair
+    globus_mutex_t mutex;      // protects the fields below and those of the pairs
+    globus_bool_t sizing;      // true if a size policy is set
+    globus_off_t chunk_threshold; // smallest file split into chunks, 0 for none
+    globus_off_t chunk_size;   // bytes per chunk
+    globus_off_t small_threshold; // files under this many bytes are pipelined, 0 for none
+    int batch_max;             // largest number of small files per pipelined transfer
+    long chunks;               // number of chunk transfers started
+    long batches;              // number of pipelined transfers of small files started
+    globus_cond_t cond;        // signalled when a transfer or callback finishes
+    transfer_pair_t * buckets[TRANSFER_QUEUE_NBUCKETS];
+    transfer_pair_t ** pairs;  // every pair, in the order they take turns
+    int npairs;
+    int pairs_size;            // allocated length of pairs
+    int cursor[TRANSFER_QUEUE_NPRIORITIES]; // pair to be served next per class
+    long queued_per_priority[TRANSFER_QUEUE_NPRIORITIES];
+    long queued;               // number of jobs waiting
+    int active;                // number of transfers running
+    long completed;            // number of jobs reported
+    unsigned long pass;        // number of scheduling passes made
+    int pending;               // number of oneshot callbacks registered and not yet run
+    globus_bool_t retry_pending; // true while a retry callback is registered
+    globus_bool_t closed;      // true once the queue is being destroyed
+} transfer_queue_t;
+
+// used as the description of Python objects wrapping a transfer queue
+static char transfer_queue_tag[] = "gridftpwrapper transfer queue";
+
+// used to store the state of a pipelined third party transfer of a
+// list of (source, destination) pairs over one handle. Globus asks for
+// the pairs after the first through the pipeline callback of the handle
+// attributes, which only identifies the batch by its handle
+typedef struct pipeline_batch_s
+{
+    struct pipeline_batch_s * next;      // next batch in the registry
+    globus_ftp_client_handle_t * handle; // handle the pairs go over
+    PyObject * pyfunction;  // Python object for the Python function to call for each pair
+    PyObject * pyarg;       // Python object for the Python argument to pass in to the callback
+    int npairs;             // number of pairs
+    char ** src;            // source URLs
+    char ** dst;            // destination URLs
+    int issued;             // number of pairs handed to Globus so far
+    transfer_job_t * jobs;  // jobs of a transfer queue the pairs belong to, NULL if from Python
+} pipeline_batch_t;
+
+// used to find the batch in progress on a handle from the pipeline
+// callback
+typedef struct
+{
+    globus_mutex_t mutex;     // protects the list of batches
+    pipeline_batch_t * batches;
+} pipeline_registry_t;
+
+static pipeline_registry_t pipeline_registry;
 
 // used to store pointers to the Python objects that should
 // be used during a performance marker callback 
@@ -222,6 +910,7 @@ typedef struct
     PyObject * markercb;    // Python object for the Python function to call when perf marker is received
     PyObject * completecb;  // Python object for the Python function to call at completion of a transfer
     PyObject * userarg;     // Python object for the user arg passed in and then passed to the callback Python functions
+    int refs;               // one for the plugin, plus one per queue record not yet drained
 } perf_plugin_callback_bucket_t;
 
 // used to store pointers to the Python objects that should
@@ -230,8 +919,17 @@ typedef struct
 {
     PyObject * pyfunction; // Python object for the Python function to call as callback
     PyObject * pyarg;      // Python object for the Python argument to pass in to the callback
+    int with_code;         // true if the FTP reply code is passed to the callback too
 } exists_callback_bucket_t;
 
+// used to store a Python call that gridftp_callback_oneshot makes from
+// a Globus thread
+typedef struct
+{
+    PyObject * pyfunction; // Python object for the Python function to call
+    PyObject * pyargs;     // Python tuple of the arguments to call it with
+} oneshot_callback_bucket_t;
+
 
 //
 // This section of the code is for auxiliary functions
@@ -240,438 +938,1071 @@ typedef struct
 // to the Python code.
 //
 
-// callback for the completion of third party transfers
-static void third_party_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// set up the size classes of the buffer pool
+static void buffer_pool_init()
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
-
-    third_party_callback_bucket_t  * callbackBucket;
-
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    callbackBucket = (third_party_callback_bucket_t *) user_data;
+    int i;
+    long page;
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    if (buffer_pool.initialized){
+        return;
+    }
 
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    page = sysconf(_SC_PAGESIZE);
+    if (page <= 0){
+        page = 4096;
+    }
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    globus_mutex_init(&(buffer_pool.mutex), NULL);
+    buffer_pool.page_size = (globus_size_t) page;
+    buffer_pool.use_hugepages = 0;
+    buffer_pool.max_idle = 16;
+
+    // 1, 1.5, 2, 3, 4, 6, 8, ... pages, stopping before overflow
+    buffer_pool.nclasses = 0;
+    for (i = 0; i < BUFFER_POOL_NCLASSES; i++){
+        globus_size_t size;
+
+        if (i == 0){
+            size = page;
+        } else if (i % 2){
+            size = ((globus_size_t) page << ((i + 1) / 2)) / 4 * 3;
+        } else {
+            size = (globus_size_t) page << (i / 2);
+        }
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+        if (i > 0 && size <= buffer_pool.classes[i - 1].size){
+            break;
+        }
 
-    // create an error object to pass back into Python
-    if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+        memset(&(buffer_pool.classes[i]), 0, sizeof(buffer_pool_class_t));
+        buffer_pool.classes[i].size = size;
+        buffer_pool.nclasses++;
     }
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
-
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+    buffer_pool.initialized = 1;
+}
 
-    if (result == NULL) {
+// find the smallest size class that holds size bytes, or NULL if the
+// request is larger than every class
+static buffer_pool_class_t * buffer_pool_class_for(globus_size_t size)
+{
+    int i;
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+    for (i = 0; i < buffer_pool.nclasses; i++){
+        if (buffer_pool.classes[i].size >= size){
+            return &(buffer_pool.classes[i]);
+        }
     }
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
+    return NULL;
+}
 
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+// get fresh memory for a buffer of the given class; the pool mutex
+// must not be held
+static globus_byte_t * buffer_pool_map(buffer_pool_class_t * bufclass, int use_hugepages, int * hugepage, int * zeroed)
+{
+    void * ptr = NULL;
+
+    *hugepage = 0;
+    *zeroed = 0;
+
+    if (bufclass -> size >= BUFFER_POOL_MMAP_THRESHOLD){
+
+#ifdef MAP_HUGETLB
+        if (use_hugepages && (bufclass -> size % BUFFER_POOL_HUGEPAGE_SIZE) == 0){
+            ptr = mmap(NULL, bufclass -> size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED){
+                *hugepage = 1;
+                *zeroed = 1;
+                return (globus_byte_t *) ptr;
+            }
+        }
+#endif
 
+        ptr = mmap(NULL, bufclass -> size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED){
+            return NULL;
+        }
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+#ifdef MADV_HUGEPAGE
+        // fall back to transparent huge pages where the kernel has them
+        if (use_hugepages){
+            madvise(ptr, bufclass -> size, MADV_HUGEPAGE);
+        }
+#endif
+        *zeroed = 1;
+        return (globus_byte_t *) ptr;
+    }
 
-    return;
+    if (posix_memalign(&ptr, buffer_pool.page_size, bufclass -> size) != 0){
+        return NULL;
+    }
+
+    return (globus_byte_t *) ptr;
 }
 
-// callback for the completion of checksum operations
-static void cksm_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// give the memory of a buffer back to the system; the pool mutex must
+// not be held
+static void buffer_pool_unmap(buffer_pool_class_t * bufclass, globus_byte_t * buffer)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
-
+    if (bufclass -> size >= BUFFER_POOL_MMAP_THRESHOLD){
+        munmap((void *) buffer, bufclass -> size);
+    } else {
+        free(buffer);
+    }
+}
 
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    cksm_callback_bucket_t * callbackBucket = (cksm_callback_bucket_t *) user_data;
+// allocate a buffer of at least size bytes from the pool, zeroing it
+// if asked to; the class the buffer belongs to is returned in *classp
+// and must be passed back to buffer_pool_free
+//
+// this does not touch the Python interpreter and may be called
+// without the GIL
+static globus_byte_t * buffer_pool_alloc(globus_size_t size, int zero, buffer_pool_class_t ** classp)
+{
+    buffer_pool_class_t * bufclass;
+    globus_byte_t * buffer = NULL;
+    int use_hugepages;
+    int hugepage = 0;
+    int zeroed = 0;
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    bufclass = buffer_pool_class_for(size);
+    *classp = bufclass;
+    if (bufclass == NULL){
+        return NULL;
+    }
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    globus_mutex_lock(&(buffer_pool.mutex));
+    if (bufclass -> idle){
+        buffer = (globus_byte_t *) bufclass -> idle;
+        bufclass -> idle = bufclass -> idle -> next;
+        bufclass -> nidle--;
+        bufclass -> hits++;
+    } else {
+        bufclass -> misses++;
+    }
+    use_hugepages = buffer_pool.use_hugepages;
+    globus_mutex_unlock(&(buffer_pool.mutex));
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+    if (buffer == NULL){
+        buffer = buffer_pool_map(bufclass, use_hugepages, &hugepage, &zeroed);
+        if (buffer == NULL){
+            return NULL;
+        }
+    }
 
-    // create an error object to pass back into Python
-    if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+    globus_mutex_lock(&(buffer_pool.mutex));
+    bufclass -> nused++;
+    if (hugepage){
+        bufclass -> hugemisses++;
     }
+    globus_mutex_unlock(&(buffer_pool.mutex));
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(sOOO)", callbackBucket -> cksm, arg, handleObj, errorObject);
+    if (zero && !zeroed){
+        memset(buffer, 0, bufclass -> size);
+    }
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+    return buffer;
+}
 
-    if (result == NULL) {
+// return a buffer to the pool; the memory is kept for reuse unless
+// the class already has max_idle buffers waiting
+static void buffer_pool_free(buffer_pool_class_t * bufclass, globus_byte_t * buffer)
+{
+    globus_bool_t release = GLOBUS_FALSE;
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+    if (buffer == NULL){
+        return;
     }
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
-
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+    globus_mutex_lock(&(buffer_pool.mutex));
+    bufclass -> nused--;
+    if (bufclass -> nidle < buffer_pool.max_idle){
+        ((buffer_pool_idle_t *) buffer) -> next = bufclass -> idle;
+        bufclass -> idle = (buffer_pool_idle_t *) buffer;
+        bufclass -> nidle++;
+    } else {
+        release = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&(buffer_pool.mutex));
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    if (release){
+        buffer_pool_unmap(bufclass, buffer);
+    }
+}
 
-    return;
+// release every idle buffer in the pool back to the system
+static void buffer_pool_trim()
+{
+    int i;
+    buffer_pool_idle_t * idle;
+    buffer_pool_idle_t * next;
+
+    for (i = 0; i < buffer_pool.nclasses; i++){
+        buffer_pool_class_t * bufclass = &(buffer_pool.classes[i]);
+
+        globus_mutex_lock(&(buffer_pool.mutex));
+        idle = bufclass -> idle;
+        bufclass -> idle = NULL;
+        bufclass -> nidle = 0;
+        globus_mutex_unlock(&(buffer_pool.mutex));
+
+        while (idle){
+            next = idle -> next;
+            buffer_pool_unmap(bufclass, (globus_byte_t *) idle);
+            idle = next;
+        }
+    }
 }
 
-// callback for the completion of mkdir operation
-static void mkdir_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// return the completion queue behind a Python object passed in place of
+// a callback function, or NULL if the object is not a queue
+//
+// only immutable fields of an object the caller holds a reference to
+// are read, so this is safe to call without the GIL
+static completion_queue_t * completion_queue_from_object(PyObject * obj)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
+    if (obj && PyCObject_Check(obj) && PyCObject_GetDesc(obj) == (void *) completion_queue_tag){
+        return (completion_queue_t *) PyCObject_AsVoidPtr(obj);
+    }
 
+    return NULL;
+}
 
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    mkdir_callback_bucket_t * callbackBucket = (mkdir_callback_bucket_t *) user_data;
+// if the Python object given as a callback is a completion queue,
+// create a record for delivery through that queue, copying the error
+// chain so the record can outlive the Globus error object
+//
+// returns NULL if the object is not a queue, or if the memory cannot
+// be allocated, in which case the caller calls Python directly
+static completion_record_t * completion_queue_record(
+        PyObject * pyfunction,
+        int kind,
+        PyObject * pyarg,
+        int owned,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error)
+{
+    completion_queue_t * queue;
+    completion_record_t * record;
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    queue = completion_queue_from_object(pyfunction);
+    if (queue == NULL){
+        return NULL;
+    }
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    record = (completion_record_t *) globus_malloc(sizeof(completion_record_t));
+    if (record == NULL){
+        return NULL;
+    }
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+    memset(record, 0, sizeof(completion_record_t));
+    record -> queue = queue;
+    record -> kind = kind;
+    record -> owned = owned;
+    record -> pyarg = pyarg;
+    record -> handle = handle;
 
-    // create an error object to pass back into Python
     if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+        record -> error = globus_error_print_chain(error);
     }
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    return record;
+}
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+// make the notification descriptor of a completion queue readable
+static void completion_queue_notify(completion_queue_t * queue)
+{
+    uint64_t one = 1;
+    ssize_t rc;
 
-    if (result == NULL) {
+    do {
+        rc = write(queue -> notify_fd[1], &one, queue -> notify_fd[0] == queue -> notify_fd[1] ? sizeof(one) : 1);
+    } while (rc < 0 && errno == EINTR);
+}
 
-        // something went wrong so print to stderr
-        PyErr_Print();
-    }
+// make the notification descriptor of a completion queue unreadable
+// again; the descriptor is non-blocking so this stops once it is empty
+static void completion_queue_clear(completion_queue_t * queue)
+{
+    char scratch[64];
+    ssize_t rc;
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
+    do {
+        rc = read(queue -> notify_fd[0], scratch, sizeof(scratch));
+    } while (rc > 0 || (rc < 0 && errno == EINTR));
+}
 
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+// push a record onto a completion queue from any thread, waking a
+// thread blocked in a drain if there is one
+static void completion_queue_push(completion_record_t * record)
+{
+    completion_queue_t * queue = record -> queue;
+    completion_record_t * head;
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    head = __atomic_load_n(&(queue -> head), __ATOMIC_RELAXED);
+    do {
+        record -> next = head;
+    } while (!__atomic_compare_exchange_n(&(queue -> head), &head, record, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
 
-    return;
+    // make the notification descriptor readable unless it already is
+    if (__atomic_exchange_n(&(queue -> signaled), 1, __ATOMIC_SEQ_CST) == 0){
+        completion_queue_notify(queue);
+    }
+
+    // the waiting count is read after the push and written by the
+    // consumer before it re-checks the list, both sequentially
+    // consistent, so either we see the waiter or it sees the record
+    if (__atomic_load_n(&(queue -> waiting), __ATOMIC_SEQ_CST)){
+        globus_mutex_lock(&(queue -> mutex));
+        globus_cond_broadcast(&(queue -> cond));
+        globus_mutex_unlock(&(queue -> mutex));
+    }
 }
 
-// callback for the completion of rmdir operation
-static void rmdir_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// move everything pushed so far onto the pending list in push order;
+// the GIL must be held, which makes the GIL the consumer lock
+static void completion_queue_collect(completion_queue_t * queue)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
-
-
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    rmdir_callback_bucket_t * callbackBucket = (rmdir_callback_bucket_t *) user_data;
+    completion_record_t * record;
+    completion_record_t * reversed = NULL;
+    completion_record_t * tail = NULL;
+    completion_record_t * next;
+
+    // clear the notification before taking the records, so that a
+    // record pushed after the exchange below sets it again
+    if (__atomic_load_n(&(queue -> signaled), __ATOMIC_SEQ_CST)){
+        completion_queue_clear(queue);
+        __atomic_store_n(&(queue -> signaled), 0, __ATOMIC_SEQ_CST);
+    }
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    record = __atomic_exchange_n(&(queue -> head), NULL, __ATOMIC_SEQ_CST);
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    while (record){
+        next = record -> next;
+        record -> next = reversed;
+        if (reversed == NULL){
+            tail = record;
+        }
+        reversed = record;
+        record = next;
+    }
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+    if (reversed == NULL){
+        return;
+    }
 
-    // create an error object to pass back into Python
-    if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    if (queue -> pending_tail){
+        queue -> pending_tail -> next = reversed;
     } else{
-        errorObject = Py_BuildValue("s", NULL);
+        queue -> pending = reversed;
     }
+    queue -> pending_tail = tail;
+}
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+// drop a count on a perf plugin callback bucket, releasing its Python
+// references and freeing it with the last one; the GIL must be held
+static void perf_plugin_bucket_release(perf_plugin_callback_bucket_t * callbackBucket)
+{
+    if (__atomic_sub_fetch(&(callbackBucket -> refs), 1, __ATOMIC_SEQ_CST)){
+        return;
+    }
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+    Py_XDECREF(callbackBucket -> begincb);
+    Py_XDECREF(callbackBucket -> markercb);
+    Py_XDECREF(callbackBucket -> completecb);
+    Py_XDECREF(callbackBucket -> userarg);
+    globus_free(callbackBucket);
+}
 
-    if (result == NULL) {
+// convert a drained record into a (kind, args) tuple, where args are the
+// arguments the equivalent callback function would have been called
+// with, and free the record; the GIL must be held
+static PyObject * completion_record_to_python(completion_record_t * record, PyObject * queueObj)
+{
+    PyObject * handleObj;
+    PyObject * errorObject;
+    PyObject * bufferObj;
+    PyObject * arglist = NULL;
+    PyObject * event;
+    put_data_callback_bucket_t * putBucket;
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+    // operations that span several handles report no handle
+    if (record -> handle){
+        handleObj = PyCObject_FromVoidPtr((void *) record -> handle, NULL);
+    } else{
+        handleObj = Py_None;
+        Py_INCREF(handleObj);
     }
+    errorObject = Py_BuildValue("s", record -> error);
+
+    switch (record -> kind){
+    case COMPLETION_CKSM:
+        arglist = Py_BuildValue("(sOOO)", record -> text[0], record -> pyarg, handleObj, errorObject);
+        break;
+    case COMPLETION_GET_DATA:
+        bufferObj = PyBuffer_FromReadWriteMemory((void *) record -> buffer, (Py_ssize_t) record -> values[0]);
+        arglist = Py_BuildValue("(OOOOlli)", record -> pyarg, handleObj, errorObject, bufferObj,
+            (long) record -> values[0], (long) record -> values[1], (int) record -> values[2]);
+        Py_XDECREF(bufferObj);
+        break;
+    case COMPLETION_PUT_DATA:
+        putBucket = (put_data_callback_bucket_t *) record -> owner;
+        arglist = Py_BuildValue("(OOOOlli)", record -> pyarg, handleObj, errorObject, putBucket -> pybuffer,
+            (long) record -> values[0], (long) record -> values[1], (int) record -> values[2]);
+
+        // Globus is done with the memory so let go of the Python object
+        if (putBucket -> has_view){
+            PyBuffer_Release(&(putBucket -> view));
+        }
+        Py_XDECREF(putBucket -> pybuffer);
+        free(putBucket);
+        break;
+    case COMPLETION_GET:
+        if (record -> values[0]){
+            arglist = Py_BuildValue("(OOOz)", record -> pyarg, handleObj, errorObject, record -> text[0]);
+        } else{
+            arglist = Py_BuildValue("(OOO)", record -> pyarg, handleObj, errorObject);
+        }
+        break;
+    case COMPLETION_GET_TO_FILE:
+    case COMPLETION_STRIPED_GET:
+        if (record -> values[1]){
+            arglist = Py_BuildValue("(OOOLz)", record -> pyarg, handleObj, errorObject, (PY_LONG_LONG) record -> values[0], record -> text[0]);
+        } else{
+            arglist = Py_BuildValue("(OOOL)", record -> pyarg, handleObj, errorObject, (PY_LONG_LONG) record -> values[0]);
+        }
 
-    // take care of reference handling
+        // the restart marker the sink recorded into
+        Py_XDECREF((PyObject *) record -> owner);
+        break;
+    case COMPLETION_EXISTS:
+        if (record -> values[1]){
+            arglist = Py_BuildValue("(OOOi)", record -> pyarg, handleObj, errorObject, (int) record -> values[0]);
+        } else{
+            arglist = Py_BuildValue("(OOO)", record -> pyarg, handleObj, errorObject);
+        }
+        break;
+    case COMPLETION_PREWARM:
+        arglist = Py_BuildValue("(OsO)", record -> pyarg, record -> text[0], errorObject);
+        break;
+    case COMPLETION_PIPELINED:
+    case COMPLETION_TRANSFER:
+        arglist = Py_BuildValue("(OssO)", record -> pyarg, record -> text[0], record -> text[1], errorObject);
+        break;
+    case COMPLETION_PERF_BEGIN:
+        arglist = Py_BuildValue("(OOssi)", record -> pyarg, handleObj, record -> text[0], record -> text[1], (int) record -> values[0]);
+        break;
+    case COMPLETION_PERF_MARKER:
+        arglist = Py_BuildValue("(OOlbiil)", record -> pyarg, handleObj,
+            (long) record -> values[0], (char) record -> values[1],
+            (int) record -> values[2], (int) record -> values[3], (long) record -> values[4]);
+        break;
+    case COMPLETION_PERF_COMPLETE:
+        arglist = Py_BuildValue("(OOi)", record -> pyarg, handleObj, (int) record -> values[0]);
+        break;
+    default:
+        arglist = Py_BuildValue("(OOO)", record -> pyarg, handleObj, errorObject);
+        break;
+    }
+
+    event = Py_BuildValue("(iO)", record -> kind, arglist);
+
+    // take care of reference handling, including the references the
+    // callback bucket handed over to the record
     Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
     Py_XDECREF(errorObject);
+    Py_XDECREF(arglist);
+    if (record -> owned){
+        Py_XDECREF(record -> pyarg);
+        Py_DECREF(queueObj);
+    }
+    if (record -> kind == COMPLETION_PERF_BEGIN || record -> kind == COMPLETION_PERF_MARKER || record -> kind == COMPLETION_PERF_COMPLETE){
+        perf_plugin_bucket_release((perf_plugin_callback_bucket_t *) record -> owner);
+    }
 
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+    globus_libc_free(record -> error);
+    globus_libc_free(record -> text[0]);
+    globus_libc_free(record -> text[1]);
+    globus_libc_free(record);
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    return event;
+}
 
-    return;
+// destructor for the Python object wrapping a completion queue, called
+// once the last reference is gone; every undrained record owns a
+// reference to the queue object, or for the perf plugin records a count
+// on the callback bucket that holds one, so none can be left by then
+static void completion_queue_free(void * ptr, void * desc)
+{
+    completion_queue_t * queue = (completion_queue_t *) ptr;
+
+    close(queue -> notify_fd[0]);
+    if (queue -> notify_fd[1] != queue -> notify_fd[0]){
+        close(queue -> notify_fd[1]);
+    }
+    globus_mutex_destroy(&(queue -> mutex));
+    globus_cond_destroy(&(queue -> cond));
+    globus_libc_free(queue);
 }
 
-// callback for the completion of delete operation
-static void delete_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// return the FTP reply code carried by an error or by one of the errors
+// in its chain of causes, or 0 if there is none
+static int gridftp_error_ftp_code(globus_object_t * error)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
+    while (error){
+        if (globus_object_type_match(globus_object_get_type(error), GLOBUS_ERROR_TYPE_FTP)){
+            return globus_error_ftp_error_get_code(error);
+        }
+        error = globus_error_get_cause(error);
+    }
 
+    return 0;
+}
 
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    delete_callback_bucket_t * callbackBucket = (delete_callback_bucket_t *) user_data;
+// return the FTP reply code of an error as gridftp_error_ftp_code does,
+// but 550 for the missing path error that exists raises without a reply
+static int gridftp_error_reply_code(globus_object_t * error)
+{
+    int code = gridftp_error_ftp_code(error);
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    if (code <= 0 && error && globus_error_match(error, GLOBUS_FTP_CLIENT_MODULE, GLOBUS_FTP_CLIENT_ERROR_NO_SUCH_FILE)){
+        return 550;
+    }
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    return code;
+}
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+// prepare a sync bucket for an operation
+static void sync_bucket_init(sync_bucket_t * bucket)
+{
+    memset(bucket, 0, sizeof(sync_bucket_t));
+    globus_mutex_init(&(bucket -> mutex), GLOBUS_NULL);
+    globus_cond_init(&(bucket -> cond), GLOBUS_NULL);
+}
+
+// callback for the completion of operations started by the _sync
+// functions; records the outcome and wakes the waiting thread
+static void sync_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    sync_bucket_t * bucket = (sync_bucket_t *) user_data;
+
+    globus_mutex_lock(&(bucket -> mutex));
 
-    // create an error object to pass back into Python
     if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+        bucket -> error = globus_error_print_chain(error);
+        bucket -> error_code = gridftp_error_reply_code(error);
     }
+    bucket -> done = GLOBUS_TRUE;
+    globus_cond_signal(&(bucket -> cond));
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    globus_mutex_unlock(&(bucket -> mutex));
+}
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+// wait for the operation of a sync bucket to complete; must be called
+// without the GIL
+static void sync_bucket_wait(sync_bucket_t * bucket)
+{
+    globus_mutex_lock(&(bucket -> mutex));
+    while (!bucket -> done){
+        globus_cond_wait(&(bucket -> cond), &(bucket -> mutex));
+    }
+    globus_mutex_unlock(&(bucket -> mutex));
+}
 
-    if (result == NULL) {
+// release a sync bucket and turn the outcome of its operation into a
+// Python exception if it failed
+//
+// returns 0 on success, 1 if the operation failed with the FTP reply
+// code ignore_code (if non zero) and -1 with an exception set otherwise
+static int sync_bucket_finish(sync_bucket_t * bucket, globus_result_t gridftp_result, const char * operation, int ignore_code)
+{
+    char msg[2048] = "";
+    int rc = 0;
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+    if (gridftp_result != GLOBUS_SUCCESS){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: rc = %d: unable to start %s operation", gridftp_result, operation);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        rc = -1;
+    } else if (bucket -> error){
+        if (ignore_code && bucket -> error_code == ignore_code){
+            rc = 1;
+        } else{
+            snprintf(msg, sizeof(msg), "gridftpwrapper: %s operation failed: %s", operation, bucket -> error);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            rc = -1;
+        }
     }
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
-
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+    globus_libc_free(bucket -> error);
+    globus_mutex_destroy(&(bucket -> mutex));
+    globus_cond_destroy(&(bucket -> cond));
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    return rc;
+}
 
-    return;
+// prepare a listing
+static void listing_init(listing_t * listing, globus_bool_t skip_dots)
+{
+    memset(listing, 0, sizeof(listing_t));
+    listing -> skip_dots = skip_dots;
 }
 
-// callback for the completion of move operation
-static void move_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// free what a listing holds
+static void listing_free(listing_t * listing)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
+    globus_libc_free(listing -> names);
+    globus_libc_free(listing -> offsets);
+    globus_libc_free(listing -> sizes);
+    globus_libc_free(listing -> mtimes);
+    globus_libc_free(listing -> modes);
+    globus_libc_free(listing -> types);
+    globus_libc_free(listing -> line);
+    memset(listing, 0, sizeof(listing_t));
+}
 
+// resize a column of a listing to bytes; returns 0 or -1 if out of
+// memory, leaving the column as it was
+static int listing_realloc(void ** p, size_t bytes)
+{
+    void * q;
 
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    move_callback_bucket_t * callbackBucket = (move_callback_bucket_t *) user_data;
+    q = globus_libc_realloc(*p, bytes);
+    if (q == NULL){
+        return -1;
+    }
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    *p = q;
+    return 0;
+}
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+// grow a character buffer of a listing to at least need bytes,
+// doubling it; returns 0 or -1 if out of memory
+static int listing_grow(char ** p, long * allocated, long need)
+{
+    long n = *allocated ? *allocated : 4096;
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+    while (n < need){
+        n *= 2;
+    }
 
-    // create an error object to pass back into Python
-    if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+    if (listing_realloc((void **) p, n) != 0){
+        return -1;
     }
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    *allocated = n;
+    return 0;
+}
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+// turn a UTC time into seconds since the epoch, for the modify fact
+static long listing_timegm(int year, int month, int day, int hour, int minute, int second)
+{
+    long days;
+    int era;
+    int yoe;
+    int doy;
+
+    // days from the civil calendar date, counting from 0000-03-01
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    days = (long) era * 146097 + (long) yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+
+    return ((days * 24 + hour) * 60 + minute) * 60 + second;
+}
 
-    if (result == NULL) {
+// parse the vlen characters of a fact value as a number in base into
+// *number; returns 0, or -1 leaving *number alone if they are not all
+// digits of the base or there are too many to be a long
+static int listing_number(const char * value, long vlen, int base, long * number)
+{
+    char digits[24];
+    char * stop;
+    long n;
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+    if (vlen <= 0 || vlen >= (long) sizeof(digits)){
+        return -1;
     }
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
-
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+    // the value is not terminated, so strtol gets a copy that is
+    memcpy(digits, value, vlen);
+    digits[vlen] = '\0';
+    if (digits[0] < '0' || digits[0] > '9'){
+        return -1;
+    }
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    errno = 0;
+    n = strtol(digits, &stop, base);
+    if (stop != digits + vlen || errno == ERANGE){
+        return -1;
+    }
 
-    return;
+    *number = n;
+    return 0;
 }
 
-// callback for the completion of chmod operation
-static void chmod_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// parse one fact line, "fact=value;...; name", into a listing; lines
+// that are not fact lines are passed over, as are facts whose values
+// are malformed
+static void listing_parse_line(listing_t * listing, const char * line, long len)
 {
-    PyObject * func;
-    PyObject * arglist; 
-    PyObject * result; 
-    PyObject * arg;
-    PyObject * handleObj;
-    PyObject * errorObject;
+    const char * p = line;
+    const char * end = line + len;
+    const char * fact;
+    const char * value;
+    const char * next;
+    long flen;
+    long vlen;
+    long size = -1;
+    long mtime = -1;
+    long mode = -1;
+    char type = 'o';
+    int tm[6];
+    long n;
+    int i;
+    int k;
+
+    while (end > p && (end[-1] == '\r' || end[-1] == '\n')){
+        end--;
+    }
+    while (p < end && *p == ' '){
+        p++;
+    }
 
+    // the facts run up to the space before the name
+    while (p < end && *p != ' '){
+        fact = p;
+        while (p < end && *p != ';' && *p != ' '){
+            p++;
+        }
+        next = p < end && *p == ';' ? p + 1 : p;
+
+        value = memchr(fact, '=', p - fact);
+        if (value){
+            flen = value - fact;
+            value++;
+            vlen = p - value;
+
+            if (flen == 4 && strncasecmp(fact, "size", 4) == 0){
+                listing_number(value, vlen, 10, &size);
+            } else if (flen == 6 && strncasecmp(fact, "modify", 6) == 0){
+
+                // YYYYMMDDHHMMSS, then at most a fraction of a second
+                for (k = 0; k < vlen && k < 14 && value[k] >= '0' && value[k] <= '9'; k++){
+                }
+                if (k == 14 && (vlen == 14 || value[14] == '.')){
+                    for (i = 0, k = 0; i < 6; i++){
+                        tm[i] = 0;
+                        for (; k < (i == 0 ? 4 : 4 + 2 * i); k++){
+                            tm[i] = tm[i] * 10 + (value[k] - '0');
+                        }
+                    }
+                    if (tm[1] >= 1 && tm[1] <= 12 && tm[2] >= 1 && tm[2] <= 31 && tm[3] <= 23 && tm[4] <= 59 && tm[5] <= 60){
+                        mtime = listing_timegm(tm[0], tm[1], tm[2], tm[3], tm[4], tm[5]);
+                    }
+                }
+            } else if (flen == 9 && strncasecmp(fact, "UNIX.mode", 9) == 0){
+                listing_number(value, vlen, 8, &mode);
+            } else if (flen == 4 && strncasecmp(fact, "type", 4) == 0){
+                if (vlen == 4 && strncasecmp(value, "file", 4) == 0){
+                    type = 'f';
+                } else if (vlen == 3 && strncasecmp(value, "dir", 3) == 0){
+                    type = 'd';
+                } else if (vlen == 4 && strncasecmp(value, "cdir", 4) == 0){
+                    type = 'c';
+                } else if (vlen == 4 && strncasecmp(value, "pdir", 4) == 0){
+                    type = 'p';
+                } else if (vlen >= 13 && strncasecmp(value, "OS.unix=slink", 13) == 0){
+                    type = 'l';
+                }
+            }
+        }
 
-    // cast the user_data that the GridFTP libraries are passing in to the
-    // callback structure where we previously stored the Python function and
-    // arguments to call
-    chmod_callback_bucket_t * callbackBucket = (chmod_callback_bucket_t *) user_data;
+        p = next;
+    }
 
-    // we need to obtain the Python GIL before this thread can manipulate any Python object
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    // a fact line has a space and then the name
+    if (p >= end || *p != ' ' || p + 1 >= end){
+        return;
+    }
+    p++;
 
-    // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> pyfunction;
-    arg = callbackBucket -> pyarg;
+    if (listing -> skip_dots && (type == 'c' || type == 'p')){
+        return;
+    }
 
-    // create a handle object to pass back into Python
-    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+    if (listing -> n == listing -> size){
+        n = listing -> size ? listing -> size * 2 : 1024;
+        if (listing_realloc((void **) &(listing -> offsets), n * sizeof(long)) != 0
+                || listing_realloc((void **) &(listing -> sizes), n * sizeof(long)) != 0
+                || listing_realloc((void **) &(listing -> mtimes), n * sizeof(long)) != 0
+                || listing_realloc((void **) &(listing -> modes), n * sizeof(long)) != 0
+                || listing_realloc((void **) &(listing -> types), n) != 0){
+            listing -> failed = GLOBUS_TRUE;
+            return;
+        }
+        listing -> size = n;
+    }
 
-    // create an error object to pass back into Python
-    if (error){
-        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
-    } else{
-        errorObject = Py_BuildValue("s", NULL);
+    if (listing -> names_len + (end - p) + 1 > listing -> names_size){
+        if (listing_grow(&(listing -> names), &(listing -> names_size), listing -> names_len + (end - p) + 1) != 0){
+            listing -> failed = GLOBUS_TRUE;
+            return;
+        }
     }
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    listing -> offsets[listing -> n] = listing -> names_len;
+    memcpy(listing -> names + listing -> names_len, p, end - p);
+    listing -> names_len += end - p;
+    listing -> names[listing -> names_len++] = '\0';
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+    listing -> sizes[listing -> n] = size;
+    listing -> mtimes[listing -> n] = mtime;
+    listing -> modes[listing -> n] = mode;
+    listing -> types[listing -> n] = type;
+    listing -> n++;
+}
 
-    if (result == NULL) {
+// parse a buffer of listing data into a listing, keeping a line cut off
+// at its end for the next buffer
+static void listing_feed(listing_t * listing, const globus_byte_t * buffer, long length)
+{
+    const char * p = (const char *) buffer;
+    const char * end = p + length;
+    const char * nl;
+
+    while (p < end && !(listing -> failed)){
+        nl = memchr(p, '\n', end - p);
+        if (nl == NULL){
+
+            // room is kept for the terminator listing_finish adds
+            if (listing -> line_len + (end - p) + 1 > listing -> line_size){
+                if (listing_grow(&(listing -> line), &(listing -> line_size), listing -> line_len + (end - p) + 1) != 0){
+                    listing -> failed = GLOBUS_TRUE;
+                    return;
+                }
+            }
+            memcpy(listing -> line + listing -> line_len, p, end - p);
+            listing -> line_len += end - p;
+            return;
+        }
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+        if (listing -> line_len){
+            if (listing -> line_len + (nl - p) > listing -> line_size){
+                if (listing_grow(&(listing -> line), &(listing -> line_size), listing -> line_len + (nl - p)) != 0){
+                    listing -> failed = GLOBUS_TRUE;
+                    return;
+                }
+            }
+            memcpy(listing -> line + listing -> line_len, p, nl - p);
+            listing_parse_line(listing, listing -> line, listing -> line_len + (nl - p));
+            listing -> line_len = 0;
+        } else{
+            listing_parse_line(listing, p, nl - p);
+        }
+
+        p = nl + 1;
     }
+}
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
+// parse the line left over once the listing data has all been fed,
+// terminated so that nothing reading it can run past its end
+static void listing_finish(listing_t * listing)
+{
+    if (listing -> line_len && !(listing -> failed)){
+        listing -> line[listing -> line_len] = '\0';
+        listing_parse_line(listing, listing -> line, listing -> line_len);
+        listing -> line_len = 0;
+    }
+}
 
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+// return the columns of a listing as a tuple (n, names, offsets, sizes,
+// mtimes, modes, types) of strings, the number columns holding C longs
+// to be read into an array('l') and types a character per entry
+static PyObject * listing_to_python(listing_t * listing)
+{
+    // an empty listing has no columns allocated
+    if (listing -> n == 0){
+        return Py_BuildValue("(lssssss)", 0L, "", "", "", "", "", "");
+    }
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    return Py_BuildValue("(ls#s#s#s#s#s#)",
+        listing -> n,
+        listing -> names, (int) listing -> names_len,
+        (char *) listing -> offsets, (int) (listing -> n * sizeof(long)),
+        (char *) listing -> sizes, (int) (listing -> n * sizeof(long)),
+        (char *) listing -> mtimes, (int) (listing -> n * sizeof(long)),
+        (char *) listing -> modes, (int) (listing -> n * sizeof(long)),
+        listing -> types, (int) listing -> n);
+}
+
+// data callback for gridftp_machine_list_sync; parses each buffer and
+// reads the next into the same buffer until the end of the listing
+static void listing_read_callback(
+        void * user_data,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof)
+{
+    listing_read_t * read = (listing_read_t *) user_data;
+
+    if (error == NULL){
+        listing_feed(&(read -> listing), buffer, (long) length);
+    }
+
+    if (error || eof){
+        return;
+    }
+
+    if (globus_ftp_client_register_read(
+            handle,
+            read -> buffer,
+            LISTING_READ_BUFFER,
+            listing_read_callback,
+            user_data
+            ) != GLOBUS_SUCCESS){
+        globus_ftp_client_abort(handle);
+    }
+}
+
+// return the pointer wrapped by a Python object, or NULL for None
+static void * gridftp_optional_ptr(PyObject * obj)
+{
+    if (obj == Py_None){
+        return NULL;
+    }
+
+    return PyCObject_AsVoidPtr(obj);
+}
+
+// set *abstime to timeout seconds from now, for globus_cond_timedwait
+static void gridftp_abstime_after(double timeout, globus_abstime_t * abstime)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    abstime -> tv_sec = now.tv_sec + (time_t) timeout;
+    abstime -> tv_nsec = now.tv_usec * 1000 + (long) ((timeout - (double) (time_t) timeout) * 1e9);
+    if (abstime -> tv_nsec >= 1000000000){
+        abstime -> tv_sec += 1;
+        abstime -> tv_nsec -= 1000000000;
+    }
+}
+
+// get the restart marker behind a Python object, which may be None
+//
+// returns 0 with *markerp set (to NULL for None) or -1 with a Python
+// exception set if the object is not a restart marker
+static int gridftp_restart_marker_from_object(PyObject * obj, restart_marker_t ** markerp)
+{
+    *markerp = NULL;
+
+    if (obj == NULL || obj == Py_None){
+        return 0;
+    }
+
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) restart_marker_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a restart marker");
+        return -1;
+    }
+
+    *markerp = (restart_marker_t *) PyCObject_AsVoidPtr(obj);
+    return 0;
+}
+
+// get the stream digest behind a Python object, which may be None
+//
+// returns 0 with *digestp set (to NULL for None) or -1 with a Python
+// exception set if the object is not a stream digest
+static int gridftp_stream_digest_from_object(PyObject * obj, stream_digest_t ** digestp)
+{
+    *digestp = NULL;
+
+    if (obj == NULL || obj == Py_None){
+        return 0;
+    }
+
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) stream_digest_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a stream digest");
+        return -1;
+    }
+
+    *digestp = (stream_digest_t *) PyCObject_AsVoidPtr(obj);
+    return 0;
+}
+
+// finish the stream digest of a get that has completed, failing it if
+// the get did not succeed, and drop the reference the get held
+//
+// returns the hex digest, to be freed with globus_libc_free, or NULL if
+// the digest failed; the reason is kept in the digest for Python
+static char * gridftp_stream_digest_close(stream_digest_t * digest, globus_bool_t failed)
+{
+    char hex[STREAM_DIGEST_HEX_MAX];
+    long long nbytes;
+    const char * reason;
+    char * result = NULL;
 
+    if (failed){
+        stream_digest_fail(digest, "transfer failed");
+    }
+    stream_digest_finish(digest);
+
+    if (stream_digest_result(digest, hex, &nbytes, &reason) == 1){
+        result = globus_libc_strdup(hex);
+    }
+    stream_digest_release(digest);
+
+    return result;
+}
+
+// callback for the restart marker plugin called when a transfer starts;
+// the restart point given to the operation is left as it is
+static globus_bool_t restart_marker_plugin_begin_cb(
+    void * user_arg,
+    globus_ftp_client_handle_t * handle,
+    const char * source_url,
+    const char * dest_url,
+    globus_ftp_client_restart_marker_t * restart_marker)
+{
+    return GLOBUS_FALSE;
+}
+
+// callback for the restart marker plugin called each time the server
+// sends a restart marker; the marker replaces the one kept by the plugin
+// since each marker covers all of the data received so far
+static void restart_marker_plugin_marker_cb(
+    void * user_arg,
+    globus_ftp_client_handle_t * handle,
+    globus_ftp_client_restart_marker_t * restart_marker)
+{
+    restart_marker_plugin_bucket_t * bucket = (restart_marker_plugin_bucket_t *) user_arg;
+
+    globus_mutex_lock(&(bucket -> marker -> mutex));
+    globus_ftp_client_restart_marker_destroy(&(bucket -> marker -> marker));
+    globus_ftp_client_restart_marker_copy(&(bucket -> marker -> marker), restart_marker);
+    globus_mutex_unlock(&(bucket -> marker -> mutex));
+}
+
+// callback for the restart marker plugin called when a transfer ends
+static void restart_marker_plugin_complete_cb(
+    void * user_arg,
+    globus_ftp_client_handle_t * handle,
+    globus_object_t * error,
+    const char * error_url)
+{
     return;
 }
 
-// callback for the completion of get operations
-static void get_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// callback for the completion of third party transfers
+static void third_party_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
@@ -679,14 +2010,26 @@ static void get_complete_callback(void * user_data, globus_ftp_client_handle_t *
     PyObject * arg;
     PyObject * handleObj;
     PyObject * errorObject;
+    completion_record_t * record;
 
+    third_party_callback_bucket_t  * callbackBucket;
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    get_complete_callback_bucket_t * callbackBucket = (get_complete_callback_bucket_t *) user_data;
+    callbackBucket = (third_party_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_THIRD_PARTY, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
 
@@ -725,21 +2068,51 @@ static void get_complete_callback(void * user_data, globus_ftp_client_handle_t *
     // release the Python GIL from this thread
     PyGILState_Release(gstate);
 
+
     // free the space the callback bucket was holding
     free(callbackBucket);
 
     return;
 }
 
-// callback for the data read of get operations
-static void get_data_callback(
-        void * user_data, 
-        globus_ftp_client_handle_t * handle, 
-        globus_object_t * error,
-        globus_byte_t * buffer,
-        globus_size_t length,
-        globus_off_t offset,
-        globus_bool_t eof) 
+// return the size of the buffer needed for the hex digest of a
+// checksum algorithm, terminator included
+static size_t cksm_digest_size(const char * algorithm)
+{
+    const cksm_algorithm_t * a;
+
+    for (a = cksm_algorithms; a -> name; a++){
+        if (strcasecmp(a -> name, algorithm) == 0){
+            return 2 * a -> digest_bytes + 1;
+        }
+    }
+
+    return CKSM_UNKNOWN_DIGEST;
+}
+
+// check that a checksum algorithm name is a single word of letters,
+// digits, dashes and underscores, since it goes into the command line
+// as is; sets a Python exception and returns -1 if not
+static int cksm_algorithm_check(const char * algorithm)
+{
+    const char * c;
+
+    for (c = algorithm; *c; c++){
+        if (!isalnum((unsigned char) *c) && *c != '-' && *c != '_'){
+            break;
+        }
+    }
+
+    if (*c || c == algorithm || c - algorithm > CKSM_ALGORITHM_MAX){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: invalid checksum algorithm");
+        return -1;
+    }
+
+    return 0;
+}
+
+// callback for the completion of checksum operations
+static void cksm_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
@@ -747,24 +2120,32 @@ static void get_data_callback(
     PyObject * arg;
     PyObject * handleObj;
     PyObject * errorObject;
-    PyObject * bufferObj;
+    completion_record_t * record;
 
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    get_data_callback_bucket_t * callbackBucket = (get_data_callback_bucket_t *) user_data;
+    cksm_callback_bucket_t * callbackBucket = (cksm_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_CKSM, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        record -> text[0] = globus_libc_strdup(callbackBucket -> cksm);
+        completion_queue_push(record);
+        free(callbackBucket -> cksm);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
 
     // pick off the function and argument pointers we want to pass back into Python
-    // as well as the buffer object
     func = callbackBucket -> pyfunction;
     arg = callbackBucket -> pyarg;
-    bufferObj= PyBuffer_FromReadWriteMemory((void*) buffer, length * sizeof(globus_byte_t));
-
 
     // create a handle object to pass back into Python
     handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
@@ -777,7 +2158,7 @@ static void get_data_callback(
     }
 
     // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOOOlli)", arg, handleObj, errorObject, bufferObj, (long) length, (long) offset, (int) eof);
+    arglist = Py_BuildValue("(sOOO)", callbackBucket -> cksm, arg, handleObj, errorObject);
 
     // now call the Python callback function
     result = PyEval_CallObject(func, arglist);
@@ -790,7 +2171,6 @@ static void get_data_callback(
 
     // take care of reference handling
     Py_DECREF(handleObj);
-    Py_DECREF(bufferObj);
     Py_DECREF(arglist);
     Py_XDECREF(result);
     Py_XDECREF(errorObject);
@@ -799,44 +2179,58 @@ static void get_data_callback(
     PyGILState_Release(gstate);
 
     // free the space the callback bucket was holding
+    free(callbackBucket -> cksm);
     free(callbackBucket);
 
     return;
 }
 
-// callback for performance marker plugin that is called
-// when a transfer starts
-static void perf_plugin_begin_cb(
-    void * user_specific,
-    globus_ftp_client_handle_t * handle,
-    const char * source_url,
-    const char * dest_url,
-    globus_bool_t restart)
+// callback for the completion of mkdir operation
+static void mkdir_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
     PyObject * result; 
     PyObject * arg;
     PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+    mkdir_callback_bucket_t * callbackBucket = (mkdir_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_MKDIR, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
 
     // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> begincb;
-    arg = callbackBucket -> userarg;
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
 
     // create a handle object to pass back into Python
     handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
 
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
     // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOssi)", arg, handleObj, source_url, dest_url, (int) restart);
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
 
     // now call the Python callback function
     result = PyEval_CallObject(func, arglist);
@@ -851,51 +2245,63 @@ static void perf_plugin_begin_cb(
     Py_DECREF(handleObj);
     Py_DECREF(arglist);
     Py_XDECREF(result);
+    Py_XDECREF(errorObject);
 
     // release the Python GIL from this thread
     PyGILState_Release(gstate);
 
-    return;
+    // free the space the callback bucket was holding
+    free(callbackBucket);
 
+    return;
 }
 
-// callback for performance marker plugin that is called
-// each time a performance marker is received
-static void perf_plugin_marker_cb(
-    void * user_specific,
-    globus_ftp_client_handle_t * handle,
-    long time_stamp_int,
-    char time_stamp_tenth,
-    int stripe_ndx,
-    int num_stripes,
-    globus_off_t nbytes)
+// callback for the completion of rmdir operation
+static void rmdir_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
     PyObject * result; 
     PyObject * arg;
     PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+    rmdir_callback_bucket_t * callbackBucket = (rmdir_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_RMDIR, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
 
     // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> markercb;
-    arg = callbackBucket -> userarg;
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
 
     // create a handle object to pass back into Python
     handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
 
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
     // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOlbiil)", 
-        arg, handleObj, time_stamp_int, time_stamp_tenth, 
-        stripe_ndx, num_stripes, (long) nbytes);
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
 
     // now call the Python callback function
     result = PyEval_CallObject(func, arglist);
@@ -910,45 +2316,63 @@ static void perf_plugin_marker_cb(
     Py_DECREF(handleObj);
     Py_DECREF(arglist);
     Py_XDECREF(result);
+    Py_XDECREF(errorObject);
 
     // release the Python GIL from this thread
     PyGILState_Release(gstate);
 
-    return;
+    // free the space the callback bucket was holding
+    free(callbackBucket);
 
+    return;
 }
 
-// callback for performance marker plugin that is called
-// when a transfer completes
-static void perf_plugin_complete_cb(
-    void * user_specific,
-    globus_ftp_client_handle_t * handle,
-    globus_bool_t success)
+// callback for the completion of delete operation
+static void delete_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
     PyObject * result; 
     PyObject * arg;
     PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+    delete_callback_bucket_t * callbackBucket = (delete_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_DELETE, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
 
     // pick off the function and argument pointers we want to pass back into Python
-    func = callbackBucket -> completecb;
-    arg = callbackBucket -> userarg;
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
 
     // create a handle object to pass back into Python
     handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
 
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
     // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOi)", arg, handleObj, (int) success );
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
 
     // now call the Python callback function
     result = PyEval_CallObject(func, arglist);
@@ -963,15 +2387,19 @@ static void perf_plugin_complete_cb(
     Py_DECREF(handleObj);
     Py_DECREF(arglist);
     Py_XDECREF(result);
+    Py_XDECREF(errorObject);
 
     // release the Python GIL from this thread
     PyGILState_Release(gstate);
 
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
     return;
 }
 
-// callback for the completion of exists operation
-static void exists_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+// callback for the completion of move operation
+static void move_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
 {
     PyObject * func;
     PyObject * arglist; 
@@ -979,12 +2407,22 @@ static void exists_complete_callback(void * user_data, globus_ftp_client_handle_
     PyObject * arg;
     PyObject * handleObj;
     PyObject * errorObject;
+    completion_record_t * record;
 
 
     // cast the user_data that the GridFTP libraries are passing in to the
     // callback structure where we previously stored the Python function and
     // arguments to call
-    exists_callback_bucket_t * callbackBucket = (exists_callback_bucket_t *) user_data;
+    move_callback_bucket_t * callbackBucket = (move_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_MOVE, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
 
     // we need to obtain the Python GIL before this thread can manipulate any Python object
     PyGILState_STATE gstate;
@@ -1004,944 +2442,9640 @@ static void exists_complete_callback(void * user_data, globus_ftp_client_handle_
         errorObject = Py_BuildValue("s", NULL);
     }
 
-    // prepare the arg list to pass into the Python callback function
-    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// callback for the completion of chmod operation
+static void chmod_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    chmod_callback_bucket_t * callbackBucket = (chmod_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_CHMOD, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// callback for the completion of get operations
+static void get_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    get_complete_callback_bucket_t * callbackBucket = (get_complete_callback_bucket_t *) user_data;
+    char * digest = NULL;
+
+    // every data callback has returned, so the digest has seen all of
+    // the data it is going to
+    if (callbackBucket -> digest){
+        digest = gridftp_stream_digest_close(callbackBucket -> digest, error != NULL);
+    }
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_GET, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        record -> values[0] = callbackBucket -> digest != NULL;
+        record -> text[0] = digest;
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function,
+    // with the digest last if the get was computing one
+    if (callbackBucket -> digest){
+        arglist = Py_BuildValue("(OOOz)", arg, handleObj, errorObject, digest);
+    } else{
+        arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    }
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    globus_libc_free(digest);
+    free(callbackBucket);
+
+    return;
+}
+
+// callback for the data read of get operations
+static void get_data_callback(
+        void * user_data, 
+        globus_ftp_client_handle_t * handle, 
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof) 
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+    PyObject * bufferObj;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    get_data_callback_bucket_t * callbackBucket = (get_data_callback_bucket_t *) user_data;
+
+    // the digest is fed before Python sees the buffer, which Python may
+    // reuse as soon as it has it
+    if (callbackBucket -> digest){
+        if (!error && length > 0){
+            stream_digest_update(callbackBucket -> digest, (long long) offset, buffer, (size_t) length);
+        }
+        stream_digest_release(callbackBucket -> digest);
+    }
+
+    // hand the data to a completion queue, without taking the GIL, if a
+    // queue was given in place of a callback function; the buffer stays
+    // valid until the caller registers it again after draining
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_GET_DATA, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        record -> buffer = buffer;
+        record -> values[0] = (globus_off_t) length;
+        record -> values[1] = offset;
+        record -> values[2] = (globus_off_t) eof;
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    // as well as the buffer object
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+    bufferObj= PyBuffer_FromReadWriteMemory((void*) buffer, length * sizeof(globus_byte_t));
+
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOOOlli)", arg, handleObj, errorObject, bufferObj, (long) length, (long) offset, (int) eof);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(bufferObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// callback for the completion of put operations
+static void put_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    put_complete_callback_bucket_t * callbackBucket = (put_complete_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_PUT, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+    Py_XDECREF(func);
+    Py_XDECREF(arg);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// callback for the data write of put operations
+//
+// Globus is finished with the memory when this is called, so this
+// is where the buffer view and the reference to the Python object
+// that owns the memory are released
+static void put_data_callback(
+        void * user_data,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    put_data_callback_bucket_t * callbackBucket = (put_data_callback_bucket_t *) user_data;
+
+    // hand the event to a completion queue, without taking the GIL, if a
+    // queue was given in place of a callback function; the bucket goes
+    // with the record since the buffer view must be released with the
+    // GIL held when the record is drained
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_PUT_DATA, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        record -> owner = (void *) callbackBucket;
+        record -> values[0] = (globus_off_t) length;
+        record -> values[1] = offset;
+        record -> values[2] = (globus_off_t) eof;
+        completion_queue_push(record);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    // a callback of None means the caller does not want to be told
+    // about each block, only that the memory may be reused
+    if (func != Py_None){
+
+        // create a handle object to pass back into Python
+        handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+        // create an error object to pass back into Python
+        if (error){
+            errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+        } else{
+            errorObject = Py_BuildValue("s", NULL);
+        }
+
+        // prepare the arg list to pass into the Python callback function,
+        // handing back the object that was written from
+        arglist = Py_BuildValue("(OOOOlli)", arg, handleObj, errorObject, callbackBucket -> pybuffer, (long) length, (long) offset, (int) eof);
+
+        // now call the Python callback function
+        result = PyEval_CallObject(func, arglist);
+
+        if (result == NULL) {
+
+            // something went wrong so print to stderr
+            PyErr_Print();
+        }
+
+        // take care of reference handling
+        Py_DECREF(handleObj);
+        Py_DECREF(arglist);
+        Py_XDECREF(result);
+        Py_XDECREF(errorObject);
+    }
+
+    // Globus no longer needs the memory so let go of the Python object
+    if (callbackBucket -> has_view){
+        PyBuffer_Release(&(callbackBucket -> view));
+    }
+    globus_libc_free(callbackBucket -> copy);
+    Py_XDECREF(callbackBucket -> pybuffer);
+    Py_XDECREF(func);
+    Py_XDECREF(arg);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// obtain a pointer to and the length of the memory behind a Python
+// object so that it can be handed to Globus for writing
+//
+// the object may be a wrapped pointer from gridftp_create_buffer, in
+// which case the length is not known and -1 is returned for it, or
+// any object supporting the buffer protocol (bytearray, mmap, array,
+// string, buffer, memoryview). If a new style buffer view is obtained
+// *has_view is set and the caller must PyBuffer_Release the view when
+// done with the memory. The old style interface, which is what mmap
+// and array objects provide, holds nothing that keeps the memory in
+// place, so for those the data is copied and *copy is set to memory
+// the caller must free
+//
+// returns 0 on success and -1 with a Python exception set on failure
+static int gridftp_object_as_memory(
+        PyObject * obj,
+        Py_buffer * view,
+        int * has_view,
+        globus_byte_t ** copy,
+        globus_byte_t ** buffer,
+        Py_ssize_t * length)
+{
+    const void * ptr = NULL;
+    Py_ssize_t len = 0;
+
+    *has_view = 0;
+    *copy = NULL;
+
+    if (PyCObject_Check(obj)){
+        *buffer = (globus_byte_t *) PyCObject_AsVoidPtr(obj);
+        *length = -1;
+        return 0;
+    }
+
+    if (PyObject_CheckBuffer(obj)){
+        if (PyObject_GetBuffer(obj, view, PyBUF_SIMPLE) != 0){
+            return -1;
+        }
+        *has_view = 1;
+        *buffer = (globus_byte_t *) view -> buf;
+        *length = view -> len;
+        return 0;
+    }
+
+    if (PyObject_AsReadBuffer(obj, &ptr, &len) != 0){
+        return -1;
+    }
+
+    *copy = (globus_byte_t *) globus_malloc(len > 0 ? len : 1);
+    if (*copy == NULL){
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(*copy, ptr, len);
+
+    *buffer = *copy;
+    *length = len;
+    return 0;
+}
+
+// write a block of data to a file descriptor at the given offset,
+// retrying short writes
+//
+// returns 0 on success or the errno of the failed write
+static int gridftp_pwrite_all(int fd, globus_byte_t * buffer, globus_size_t length, globus_off_t offset)
+{
+    ssize_t written;
+
+    while (length > 0){
+        written = pwrite(fd, buffer, length, (off_t) offset);
+        if (written < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return errno;
+        }
+        buffer += written;
+        length -= written;
+        offset += written;
+    }
+
+    return 0;
+}
+
+static void get_sink_finish(get_sink_t * sink);
+
+// callback for the data read of a get sink
+//
+// this runs on a Globus thread and never touches the Python
+// interpreter: the block is written at its offset and the buffer
+// is handed straight back to Globus for the next block
+static void get_sink_data_callback(
+        void * user_data,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof)
+{
+    get_sink_t * sink = (get_sink_t *) user_data;
+    globus_bool_t reregister;
+    globus_bool_t abort_transfer = GLOBUS_FALSE;
+    globus_bool_t finished = GLOBUS_FALSE;
+    globus_result_t gridftp_result;
+    int rc = 0;
+
+    if (!error && length > 0){
+        rc = gridftp_pwrite_all(sink -> fd, buffer, length, offset);
+
+        // record the range as on disk so that a retry with the marker
+        // only asks the server for what is still missing
+        if (rc == 0 && sink -> marker){
+            globus_mutex_lock(&(sink -> marker -> mutex));
+            globus_ftp_client_restart_marker_insert_range(&(sink -> marker -> marker), offset, offset + (globus_off_t) length);
+            globus_mutex_unlock(&(sink -> marker -> mutex));
+        }
+
+        // sum only what reached the file
+        if (rc == 0 && sink -> digest){
+            stream_digest_update(sink -> digest, (long long) offset, buffer, (size_t) length);
+        }
+    }
+
+    globus_mutex_lock(&(sink -> mutex));
+
+    if (rc == 0){
+        sink -> nbytes += length;
+    } else if (sink -> write_errno == 0){
+        // first local failure, stop the transfer
+        sink -> write_errno = rc;
+        abort_transfer = GLOBUS_TRUE;
+    }
+
+    if (eof || error || rc != 0){
+        sink -> done = GLOBUS_TRUE;
+    }
+
+    reregister = !(sink -> done);
+    if (!reregister){
+        sink -> outstanding--;
+        finished = (sink -> complete && sink -> outstanding == 0);
+    }
+
+    globus_mutex_unlock(&(sink -> mutex));
+
+    if (abort_transfer){
+        globus_ftp_client_abort(handle);
+    }
+
+    if (reregister){
+        gridftp_result = globus_ftp_client_register_read(
+                            handle,
+                            buffer,
+                            sink -> bufsize,
+                            get_sink_data_callback,
+                            (void *) sink
+                            );
+
+        if (gridftp_result != GLOBUS_SUCCESS){
+            globus_mutex_lock(&(sink -> mutex));
+            sink -> outstanding--;
+            finished = (sink -> complete && sink -> outstanding == 0);
+            globus_mutex_unlock(&(sink -> mutex));
+        }
+    }
+
+    if (finished){
+        get_sink_finish(sink);
+    }
+
+    return;
+}
+
+// callback for the completion of a get sink
+//
+// a get that fails early can complete while get_to_file is still
+// registering buffers, so the sink is only finished here if every
+// buffer has already been retired; otherwise the last one to be
+// retired finishes it
+static void get_sink_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    get_sink_t * sink = (get_sink_t *) user_data;
+    globus_bool_t finished;
+
+    globus_mutex_lock(&(sink -> mutex));
+    if (error){
+        sink -> error = globus_error_print_chain(error);
+    }
+    sink -> complete = GLOBUS_TRUE;
+    finished = (sink -> outstanding == 0);
+    globus_mutex_unlock(&(sink -> mutex));
+
+    if (finished){
+        get_sink_finish(sink);
+    }
+}
+
+// release a get sink whose buffers have all been retired and call
+// Python, or a completion queue, with the outcome of the get
+static void get_sink_finish(get_sink_t * sink)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+    globus_ftp_client_handle_t * handle = sink -> handle;
+    char msg[2048] = "";
+    char * digest = NULL;
+    int i;
+
+    // release the local resources before calling into Python so the
+    // file is complete on disk when the callback runs
+    if (sink -> close_fd){
+        if (close(sink -> fd) != 0 && sink -> write_errno == 0){
+            sink -> write_errno = errno;
+        }
+    }
+
+    for (i = 0; i < sink -> nbuffers; i++){
+        buffer_pool_free(sink -> bufclass, sink -> buffers[i]);
+    }
+    globus_libc_free(sink -> buffers);
+
+    if (sink -> digest){
+        digest = gridftp_stream_digest_close(sink -> digest, sink -> error != NULL || sink -> write_errno != 0);
+    }
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(sink -> pyfunction, COMPLETION_GET_TO_FILE, sink -> pyarg, 1, handle, NULL);
+    if (record){
+        if (sink -> write_errno){
+            snprintf(msg, sizeof(msg), "gridftpwrapper: unable to write local file: %s", strerror(sink -> write_errno));
+            record -> error = globus_libc_strdup(msg);
+        } else{
+            record -> error = sink -> error;
+            sink -> error = NULL;
+        }
+        record -> values[0] = sink -> nbytes;
+        record -> values[1] = sink -> digest != NULL;
+        record -> text[0] = digest;
+        record -> owner = (void *) sink -> pymarker;
+        completion_queue_push(record);
+        globus_libc_free(sink -> error);
+        globus_mutex_destroy(&(sink -> mutex));
+        free(sink);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = sink -> pyfunction;
+    arg = sink -> pyarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python, a local write
+    // failure takes precedence since it is the reason for the abort
+    if (sink -> write_errno){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: unable to write local file: %s", strerror(sink -> write_errno));
+        errorObject = Py_BuildValue("s", msg);
+    } else{
+        errorObject = Py_BuildValue("s", sink -> error);
+    }
+
+    // prepare the arg list to pass into the Python callback function,
+    // with the digest last if the get was computing one
+    if (sink -> digest){
+        arglist = Py_BuildValue("(OOOLz)", arg, handleObj, errorObject, (PY_LONG_LONG) sink -> nbytes, digest);
+    } else{
+        arglist = Py_BuildValue("(OOOL)", arg, handleObj, errorObject, (PY_LONG_LONG) sink -> nbytes);
+    }
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+    Py_XDECREF(func);
+    Py_XDECREF(arg);
+    Py_XDECREF(sink -> pymarker);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the sink was holding
+    globus_libc_free(digest);
+    globus_libc_free(sink -> error);
+    globus_mutex_destroy(&(sink -> mutex));
+    free(sink);
+
+    return;
+}
+
+// release the memory held by a read ring; the GIL must be held
+static void read_ring_free(read_ring_t * ring)
+{
+    int i;
+
+    for (i = 0; i < ring -> nbuffers; i++){
+        buffer_pool_free(ring -> bufclass, ring -> buffers[i]);
+    }
+    globus_libc_free(ring -> buffers);
+
+    if (ring -> digest){
+        stream_digest_release(ring -> digest);
+    }
+
+    Py_XDECREF(ring -> pyfunction);
+    Py_XDECREF(ring -> pyarg);
+
+    globus_mutex_destroy(&(ring -> mutex));
+    free(ring);
+}
+
+// hand a buffer of a read ring back to Globus, retiring it if that fails
+//
+// returns true if the buffer was registered
+static globus_bool_t read_ring_register(read_ring_t * ring, globus_ftp_client_handle_t * handle, globus_byte_t * buffer);
+
+// callback for the data read of a buffer in a read ring
+static void read_ring_data_callback(
+        void * user_data,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    PyObject * bufferObj;
+
+    read_ring_t * ring = (read_ring_t *) user_data;
+    globus_bool_t reregister;
+    globus_bool_t registered = GLOBUS_FALSE;
+    globus_bool_t finished = GLOBUS_FALSE;
+
+    // decide now whether this buffer goes back to Globus, so that in
+    // copy mode it can be re-registered before Python sees the data
+    globus_mutex_lock(&(ring -> mutex));
+    if (eof || error){
+        ring -> done = GLOBUS_TRUE;
+    }
+    reregister = !(ring -> done);
+    globus_mutex_unlock(&(ring -> mutex));
+
+    // feed the digest while the buffer still holds this data, before
+    // it can go back to Globus
+    if (ring -> digest && !error && length > 0){
+        stream_digest_update(ring -> digest, (long long) offset, buffer, (size_t) length);
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = ring -> pyfunction;
+    arg = ring -> pyarg;
+
+    if (ring -> copy){
+
+        // copy the data out so the buffer can go straight back to Globus
+        bufferObj = PyString_FromStringAndSize((char *) buffer, (Py_ssize_t) length);
+
+        if (reregister){
+            Py_BEGIN_ALLOW_THREADS
+            registered = read_ring_register(ring, handle, buffer);
+            Py_END_ALLOW_THREADS
+            reregister = GLOBUS_FALSE;
+        }
+    } else {
+        bufferObj = PyBuffer_FromReadWriteMemory((void *) buffer, length * sizeof(globus_byte_t));
+    }
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOOOlli)", arg, handleObj, errorObject, bufferObj, (long) length, (long) offset, (int) eof);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_XDECREF(bufferObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // the Python callback is done with the data, so the buffer can be reused
+    if (reregister){
+        Py_BEGIN_ALLOW_THREADS
+        registered = read_ring_register(ring, handle, buffer);
+        Py_END_ALLOW_THREADS
+    }
+
+    // once every buffer has been retired the ring is no longer needed
+    if (!registered){
+        globus_mutex_lock(&(ring -> mutex));
+        ring -> outstanding--;
+        finished = (ring -> outstanding == 0);
+        globus_mutex_unlock(&(ring -> mutex));
+    }
+
+    if (finished){
+        read_ring_free(ring);
+    }
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    return;
+}
+
+static globus_bool_t read_ring_register(read_ring_t * ring, globus_ftp_client_handle_t * handle, globus_byte_t * buffer)
+{
+    globus_result_t gridftp_result;
+
+    gridftp_result = globus_ftp_client_register_read(
+                        handle,
+                        buffer,
+                        ring -> bufsize,
+                        read_ring_data_callback,
+                        (void *) ring
+                        );
+
+    return (gridftp_result == GLOBUS_SUCCESS);
+}
+
+// get the striped get behind a Python object
+//
+// returns the engine or NULL with a Python exception set if the object
+// is not a striped get
+static striped_get_t * striped_get_from_object(PyObject * obj)
+{
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) striped_get_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a striped get");
+        return NULL;
+    }
+
+    return (striped_get_t *) PyCObject_AsVoidPtr(obj);
+}
+
+// release the memory held by a striped get, including the handles of
+// the first nhandles streams and whatever buffers are still allocated
+static void striped_get_free(striped_get_t * engine, int nhandles)
+{
+    int i, j;
+
+    for (i = 0; i < nhandles; i++){
+        globus_ftp_client_handle_destroy(&(engine -> streams[i].handle));
+    }
+
+    for (i = 0; i < engine -> nstreams; i++){
+        if (engine -> streams[i].buffers == NULL){
+            continue;
+        }
+        for (j = 0; j < engine -> nbuffers; j++){
+            buffer_pool_free(engine -> bufclass, engine -> streams[i].buffers[j]);
+        }
+        globus_libc_free(engine -> streams[i].buffers);
+    }
+
+    globus_ftp_client_operationattr_destroy(&(engine -> attr));
+    globus_mutex_destroy(&(engine -> mutex));
+    globus_libc_free(engine -> streams);
+    globus_libc_free(engine -> url);
+    globus_libc_free(engine -> error);
+    globus_libc_free(engine);
+}
+
+// mark a striped get as failed, keeping the description of the first
+// failure; the engine mutex must be held
+//
+// returns GLOBUS_TRUE if this is the first failure, in which case the
+// caller must abort the other streams once the mutex is released
+static globus_bool_t striped_get_fail(striped_get_t * engine, const char * msg)
+{
+    if (engine -> failed){
+        return GLOBUS_FALSE;
+    }
+
+    engine -> failed = GLOBUS_TRUE;
+    engine -> error = globus_libc_strdup(msg);
+    return GLOBUS_TRUE;
+}
+
+// abort the operation in progress on every busy stream of a striped get
+static void striped_get_abort_streams(striped_get_t * engine)
+{
+    globus_bool_t busy;
+    int i;
+
+    for (i = 0; i < engine -> nstreams; i++){
+        globus_mutex_lock(&(engine -> mutex));
+        busy = engine -> streams[i].busy;
+        globus_mutex_unlock(&(engine -> mutex));
+
+        if (busy){
+            globus_ftp_client_abort(&(engine -> streams[i].handle));
+        }
+    }
+}
+
+// hand the next byte range of a striped get to a stream; the engine
+// mutex must be held
+//
+// ranges are cut from the part of the file not yet handed out, each
+// one a share of what is left so that the streams finish close
+// together. Once the whole file has been handed out the upper half of
+// the largest remainder of a busy stream is split off instead, which
+// is only possible when the data arrives in order
+//
+// returns GLOBUS_TRUE if the stream has a new range
+static globus_bool_t striped_get_next_range(striped_get_t * engine, striped_stream_t * stream)
+{
+    striped_stream_t * victim = NULL;
+    globus_off_t remaining;
+    globus_off_t chunk;
+    globus_off_t best = 0;
+    globus_off_t split;
+    int i;
+
+    if (engine -> failed){
+        return GLOBUS_FALSE;
+    }
+
+    if (engine -> cursor < engine -> size){
+        remaining = engine -> size - engine -> cursor;
+        chunk = remaining / (2 * engine -> nstreams);
+        if (chunk < engine -> minchunk){
+            chunk = engine -> minchunk;
+        }
+        if (chunk > remaining){
+            chunk = remaining;
+        }
+        stream -> start = engine -> cursor;
+        stream -> end = engine -> cursor + chunk;
+        engine -> cursor += chunk;
+    } else {
+        if (!(engine -> steal)){
+            return GLOBUS_FALSE;
+        }
+
+        for (i = 0; i < engine -> nstreams; i++){
+            if (!(engine -> streams[i].busy) || engine -> streams[i].aborting){
+                continue;
+            }
+            remaining = engine -> streams[i].end - engine -> streams[i].position;
+            if (remaining > best){
+                best = remaining;
+                victim = &(engine -> streams[i]);
+            }
+        }
+
+        // both halves must be worth a range of their own
+        if (victim == NULL || best < 2 * engine -> minchunk){
+            return GLOBUS_FALSE;
+        }
+
+        split = victim -> position + best / 2;
+        stream -> start = split;
+        stream -> end = victim -> end;
+        victim -> end = split;
+        victim -> clipped = GLOBUS_TRUE;
+    }
+
+    stream -> busy = GLOBUS_TRUE;
+    stream -> position = stream -> start;
+    stream -> range_bytes = 0;
+    stream -> clipped = GLOBUS_FALSE;
+    stream -> aborting = GLOBUS_FALSE;
+
+    return GLOBUS_TRUE;
+}
+
+// report the completion of a striped get, once every stream has run out
+// of work, and release the file and buffers; the handles are kept until
+// the engine is destroyed from Python
+//
+// this is never called from a callback of one of the engine handles,
+// so the engine may be destroyed from the Python callback
+static void striped_get_finish(striped_get_t * engine)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+    globus_off_t nbytes;
+    char msg[2048] = "";
+    int i, j;
+
+    if (engine -> close_fd){
+        if (close(engine -> fd) != 0 && !(engine -> failed)){
+            snprintf(msg, sizeof(msg), "gridftpwrapper: unable to write local file: %s", strerror(errno));
+            striped_get_fail(engine, msg);
+        }
+    }
+
+    for (i = 0; i < engine -> nstreams; i++){
+        for (j = 0; j < engine -> nbuffers; j++){
+            buffer_pool_free(engine -> bufclass, engine -> streams[i].buffers[j]);
+            engine -> streams[i].buffers[j] = NULL;
+        }
+    }
+
+    // take what is reported before the engine is marked as done, since
+    // from then on it may be destroyed by another thread
+    func = engine -> pyfunction;
+    arg = engine -> pyarg;
+    nbytes = engine -> nbytes;
+    if (engine -> error){
+        snprintf(msg, sizeof(msg), "%s", engine -> error);
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+    engine -> pyfunction = NULL;
+    engine -> pyarg = NULL;
+    engine -> done = GLOBUS_TRUE;
+    globus_mutex_unlock(&(engine -> mutex));
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(func, COMPLETION_STRIPED_GET, arg, 1, NULL, NULL);
+    if (record){
+        if (msg[0]){
+            record -> error = globus_libc_strdup(msg);
+        }
+        record -> values[0] = nbytes;
+        completion_queue_push(record);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // create an error object to pass back into Python
+    errorObject = Py_BuildValue("s", msg[0] ? msg : NULL);
+
+    // prepare the arg list to pass into the Python callback function;
+    // the ranges went over several handles so none is passed back
+    arglist = Py_BuildValue("(OOOL)", arg, Py_None, errorObject, (PY_LONG_LONG) nbytes);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+    Py_XDECREF(func);
+    Py_XDECREF(arg);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    return;
+}
+
+// callback for the data read of a stream of a striped get
+//
+// this runs on a Globus thread and never touches the Python
+// interpreter: the part of the block inside the range of the stream
+// is written in place and the buffer is handed straight back to
+// Globus for the next block
+static void striped_stream_data_callback(
+        void * user_data,
+        globus_ftp_client_handle_t * handle,
+        globus_object_t * error,
+        globus_byte_t * buffer,
+        globus_size_t length,
+        globus_off_t offset,
+        globus_bool_t eof)
+{
+    striped_stream_t * stream = (striped_stream_t *) user_data;
+    striped_get_t * engine = stream -> engine;
+    globus_size_t wlen = 0;
+    globus_bool_t reregister;
+    globus_bool_t abort_transfer = GLOBUS_FALSE;
+    globus_bool_t abort_all = GLOBUS_FALSE;
+    char msg[2048] = "";
+    int rc = 0;
+
+    // data past the end of a clipped range belongs to the stream that
+    // took over the upper part of it and is not written here. The
+    // position moves past the block before it is written, so a stream
+    // that steals part of the range meanwhile splits it above the bytes
+    // being written rather than taking them over
+    globus_mutex_lock(&(engine -> mutex));
+    if (!error && length > 0 && offset < stream -> end){
+        wlen = length;
+        if (offset + (globus_off_t) length > stream -> end){
+            wlen = (globus_size_t) (stream -> end - offset);
+        }
+    }
+    if (!error && offset + (globus_off_t) length > stream -> position){
+        stream -> position = offset + (globus_off_t) length;
+    }
+    globus_mutex_unlock(&(engine -> mutex));
+
+    if (wlen > 0){
+        rc = gridftp_pwrite_all(engine -> fd, buffer, wlen, offset);
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+
+    if (rc == 0){
+        stream -> range_bytes += wlen;
+        stream -> nbytes += wlen;
+        engine -> nbytes += wlen;
+    } else {
+        snprintf(msg, sizeof(msg), "gridftpwrapper: unable to write local file: %s", strerror(rc));
+        abort_all = striped_get_fail(engine, msg);
+    }
+
+    // a clipped range is complete once its new end has been reached and
+    // the rest of the get is not needed
+    if (stream -> clipped && stream -> position >= stream -> end && !(stream -> aborting)){
+        stream -> aborting = GLOBUS_TRUE;
+        abort_transfer = GLOBUS_TRUE;
+    }
+
+    reregister = !(eof || error || engine -> failed || stream -> aborting);
+
+    globus_mutex_unlock(&(engine -> mutex));
+
+    if (abort_all){
+        striped_get_abort_streams(engine);
+    } else if (abort_transfer){
+        globus_ftp_client_abort(handle);
+    }
+
+    // a buffer that cannot go back is simply retired; the range then
+    // ends short and the completion callback reports it
+    if (reregister){
+        globus_ftp_client_register_read(
+                            handle,
+                            buffer,
+                            engine -> bufsize,
+                            striped_stream_data_callback,
+                            (void *) stream
+                            );
+    }
+
+    return;
+}
+
+static void striped_stream_schedule(striped_stream_t * stream);
+
+// callback for the completion of the partial get of a range
+//
+// a clipped range that was aborted once all of its data had arrived
+// counts as a success; the next range is started from a oneshot
+// callback rather than from within the callback of the handle
+static void striped_stream_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    striped_stream_t * stream = (striped_stream_t *) user_data;
+    striped_get_t * engine = stream -> engine;
+    globus_bool_t abort_all = GLOBUS_FALSE;
+    char * text = NULL;
+    char msg[2048] = "";
+
+    if (error){
+        text = globus_error_print_chain(error);
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+
+    stream -> busy = GLOBUS_FALSE;
+    if (stream -> range_bytes < stream -> end - stream -> start && !(engine -> failed)){
+        if (text){
+            snprintf(msg, sizeof(msg), "%s", text);
+        } else{
+            snprintf(msg, sizeof(msg), "gridftpwrapper: server sent %lld of %lld bytes of range starting at %lld",
+                (long long) stream -> range_bytes, (long long) (stream -> end - stream -> start), (long long) stream -> start);
+        }
+        abort_all = striped_get_fail(engine, msg);
+    }
+
+    globus_mutex_unlock(&(engine -> mutex));
+
+    globus_libc_free(text);
+
+    if (abort_all){
+        striped_get_abort_streams(engine);
+    }
+
+    striped_stream_schedule(stream);
+
+    return;
+}
+
+// start the next range of a stream of a striped get, or retire the
+// stream if there is none; the last stream to retire reports the
+// completion of the get
+static void striped_stream_next(void * user_arg)
+{
+    striped_stream_t * stream = (striped_stream_t *) user_arg;
+    striped_get_t * engine = stream -> engine;
+    globus_bool_t started;
+    globus_bool_t last = GLOBUS_FALSE;
+    globus_bool_t abort_all = GLOBUS_FALSE;
+    globus_off_t start;
+    globus_off_t end;
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+    int i;
+
+    globus_mutex_lock(&(engine -> mutex));
+    started = striped_get_next_range(engine, stream);
+    if (!started){
+        engine -> nactive--;
+        last = (engine -> nactive == 0);
+    }
+    start = stream -> start;
+    end = stream -> end;
+    globus_mutex_unlock(&(engine -> mutex));
+
+    if (!started){
+        if (last){
+            striped_get_finish(engine);
+        }
+        return;
+    }
+
+    gridftp_result = globus_ftp_client_partial_get(
+                        &(stream -> handle),
+                        engine -> url,
+                        &(engine -> attr),
+                        NULL,
+                        start,
+                        end,
+                        striped_stream_complete_callback,
+                        (void *) stream
+                        );
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: rc = %d: unable to start get of range starting at %lld", gridftp_result, (long long) start);
+
+        globus_mutex_lock(&(engine -> mutex));
+        stream -> busy = GLOBUS_FALSE;
+        abort_all = striped_get_fail(engine, msg);
+        globus_mutex_unlock(&(engine -> mutex));
+
+        if (abort_all){
+            striped_get_abort_streams(engine);
+        }
+
+        // the get has failed so this only retires the stream
+        striped_stream_next(stream);
+        return;
+    }
+
+    for (i = 0; i < engine -> nbuffers; i++){
+        if (globus_ftp_client_register_read(
+                    &(stream -> handle),
+                    stream -> buffers[i],
+                    engine -> bufsize,
+                    striped_stream_data_callback,
+                    (void *) stream
+                    ) != GLOBUS_SUCCESS){
+
+            // with no buffer registered the range cannot make progress,
+            // so stop it; the failure is reported by the completion
+            // callback
+            if (i == 0){
+                globus_ftp_client_abort(&(stream -> handle));
+            }
+            break;
+        }
+    }
+
+    return;
+}
+
+// arrange for the next range of a stream to be started from a Globus
+// callback thread
+static void striped_stream_schedule(striped_stream_t * stream)
+{
+    if (globus_callback_register_oneshot(NULL, NULL, striped_stream_next, (void *) stream) != GLOBUS_SUCCESS){
+        striped_stream_next(stream);
+    }
+}
+
+// callback for the size request that opens a striped get
+//
+// the destination is set to the size of the file, so the ranges can be
+// written in place in any order, and the streams are started; on
+// failure, or for an empty file, only the first stream is scheduled so
+// that the completion is still reported from outside this callback
+static void striped_get_size_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    striped_get_t * engine = (striped_get_t *) user_data;
+    char * text = NULL;
+    char msg[2048] = "";
+    int nscheduled;
+    int i;
+
+    if (error){
+        text = globus_error_print_chain(error);
+        snprintf(msg, sizeof(msg), "%s", text ? text : "gridftpwrapper: unable to get size");
+        globus_libc_free(text);
+    } else if (ftruncate(engine -> fd, (off_t) engine -> size) != 0){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: unable to size local file: %s", strerror(errno));
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+    engine -> streams[0].busy = GLOBUS_FALSE;
+    if (msg[0]){
+        striped_get_fail(engine, msg);
+    }
+    nscheduled = (engine -> failed || engine -> size == 0) ? 1 : engine -> nstreams;
+    engine -> nactive = nscheduled;
+    globus_mutex_unlock(&(engine -> mutex));
+
+    for (i = 0; i < nscheduled; i++){
+        striped_stream_schedule(&(engine -> streams[i]));
+    }
+
+    return;
+}
+
+// get the handle pool behind a Python object
+//
+// returns the pool or NULL with a Python exception set if the object
+// is not a handle pool
+static handle_pool_t * handle_pool_from_object(PyObject * obj)
+{
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) handle_pool_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a handle pool");
+        return NULL;
+    }
+
+    return (handle_pool_t *) PyCObject_AsVoidPtr(obj);
+}
+
+// write the host:port key a URL is pooled under, with the host in lower
+// case and the default port of the scheme filled in when none is given
+static void handle_pool_key(const char * url, char * key, size_t size)
+{
+    const char * host;
+    const char * end;
+    const char * port = NULL;
+    const char * p;
+    int hostlen;
+    int portlen = 0;
+    int default_port = 0;
+    char * k;
+
+    p = strstr(url, "://");
+    if (p == NULL){
+        snprintf(key, size, "%s", url);
+        return;
+    }
+
+    if (strncasecmp(url, "gsiftp:", 7) == 0){
+        default_port = 2811;
+    } else if (strncasecmp(url, "ftp:", 4) == 0){
+        default_port = 21;
+    } else if (strncasecmp(url, "sshftp:", 7) == 0){
+        default_port = 22;
+    }
+
+    // skip any user information in front of the host
+    host = p + 3;
+    end = host + strcspn(host, "/?#");
+    for (p = host; p < end; p++){
+        if (*p == '@'){
+            host = p + 1;
+        }
+    }
+
+    // a literal IPv6 address is enclosed in brackets
+    p = host;
+    if (*host == '['){
+        p = memchr(host, ']', end - host);
+        if (p == NULL){
+            p = host;
+        }
+    }
+    p = memchr(p, ':', end - p);
+    if (p){
+        hostlen = (int) (p - host);
+        port = p + 1;
+        portlen = (int) (end - port);
+    } else{
+        hostlen = (int) (end - host);
+    }
+
+    if (portlen > 0){
+        snprintf(key, size, "%.*s:%.*s", hostlen, host, portlen, port);
+    } else{
+        snprintf(key, size, "%.*s:%d", hostlen, host, default_port);
+    }
+
+    for (k = key; *k && k < key + hostlen; k++){
+        *k = tolower((unsigned char) *k);
+    }
+}
+
+// find the entry of a handle pool for a host:port, adding it if there
+// is none; the pool mutex must be held
+//
+// returns NULL if out of memory
+static handle_pool_host_t * handle_pool_host_for(handle_pool_t * pool, const char * key)
+{
+    handle_pool_host_t * host;
+
+    for (host = pool -> hosts; host; host = host -> next){
+        if (strcmp(host -> key, key) == 0){
+            return host;
+        }
+    }
+
+    host = (handle_pool_host_t *) globus_malloc(sizeof(handle_pool_host_t));
+    if (host == NULL){
+        return NULL;
+    }
+
+    memset(host, 0, sizeof(handle_pool_host_t));
+    host -> key = globus_libc_strdup(key);
+    if (host -> key == NULL){
+        globus_libc_free(host);
+        return NULL;
+    }
+    host -> next = pool -> hosts;
+    pool -> hosts = host;
+
+    return host;
+}
+
+// destroy a handle discarded by a handle pool, from a oneshot callback
+// so that a handle may be discarded from within its own callbacks
+static void handle_pool_discard_callback(void * user_arg)
+{
+    handle_pool_entry_t * entry = (handle_pool_entry_t *) user_arg;
+
+    globus_ftp_client_handle_destroy(&(entry -> handle));
+    globus_libc_free(entry);
+}
+
+// lease a handle from a handle pool for a host:port key, without the
+// GIL; see gridftp_handle_pool_lease
+//
+// returns 0 with *entryp set, to NULL if no handle was available, or -1
+// with *resultp set to the result of a failed handle initialization,
+// or to GLOBUS_SUCCESS if out of memory
+static int handle_pool_acquire(
+        handle_pool_t * pool,
+        const char * key,
+        int block,
+        double timeout,
+        handle_pool_entry_t ** entryp,
+        globus_result_t * resultp)
+{
+    handle_pool_host_t * host;
+    handle_pool_entry_t * entry = NULL;
+    globus_bool_t create = GLOBUS_FALSE;
+    globus_abstime_t abstime;
+    int rc = 0;
+
+    *entryp = NULL;
+    *resultp = GLOBUS_SUCCESS;
+
+    if (timeout > 0.0){
+        gridftp_abstime_after(timeout, &abstime);
+    }
+
+    globus_mutex_lock(&(pool -> mutex));
+
+    host = handle_pool_host_for(pool, key);
+    while (host){
+        if (host -> idle){
+            entry = host -> idle;
+            host -> idle = entry -> next;
+            host -> nidle--;
+            host -> nleased++;
+            entry -> leased = GLOBUS_TRUE;
+            break;
+        }
+
+        // the slot is taken now and the handle created outside the lock
+        if (host -> nidle + host -> nleased < pool -> max_per_host){
+            host -> nleased++;
+            create = GLOBUS_TRUE;
+            break;
+        }
+
+        if (!block || timeout == 0.0 || rc == ETIMEDOUT){
+            break;
+        }
+
+        pool -> waiting++;
+        if (timeout < 0.0){
+            globus_cond_wait(&(pool -> cond), &(pool -> mutex));
+        } else{
+            rc = globus_cond_timedwait(&(pool -> cond), &(pool -> mutex), &abstime);
+        }
+        pool -> waiting--;
+    }
+
+    globus_mutex_unlock(&(pool -> mutex));
+
+    if (host == NULL){
+        return -1;
+    }
+
+    if (create){
+        entry = (handle_pool_entry_t *) globus_malloc(sizeof(handle_pool_entry_t));
+        if (entry == NULL){
+
+            // give the slot back
+            globus_mutex_lock(&(pool -> mutex));
+            host -> nleased--;
+            globus_cond_broadcast(&(pool -> cond));
+            globus_mutex_unlock(&(pool -> mutex));
+            return -1;
+        }
+        memset(entry, 0, sizeof(handle_pool_entry_t));
+        entry -> pool = pool;
+        entry -> host = host;
+        entry -> leased = GLOBUS_TRUE;
+
+        *resultp = globus_ftp_client_handle_init(&(entry -> handle), &(pool -> attr));
+        if (*resultp != GLOBUS_SUCCESS){
+            globus_libc_free(entry);
+
+            // give the slot back
+            globus_mutex_lock(&(pool -> mutex));
+            host -> nleased--;
+            globus_cond_broadcast(&(pool -> cond));
+            globus_mutex_unlock(&(pool -> mutex));
+            return -1;
+        }
+    }
+
+    *entryp = entry;
+    return 0;
+}
+
+// return a leased handle to its handle pool, keeping it as the first
+// idle handle of its host or, if discard is true, destroying it
+//
+// returns 0, or -1 without touching the pool if the handle is not
+// leased out, for instance because it has already been returned
+static int handle_pool_put(handle_pool_entry_t * entry, int discard)
+{
+    handle_pool_t * pool = entry -> pool;
+
+    globus_mutex_lock(&(pool -> mutex));
+    if (!entry -> leased){
+        globus_mutex_unlock(&(pool -> mutex));
+        return -1;
+    }
+    entry -> leased = GLOBUS_FALSE;
+    entry -> host -> nleased--;
+    if (!discard){
+        entry -> next = entry -> host -> idle;
+        entry -> host -> idle = entry;
+        entry -> host -> nidle++;
+    }
+    globus_cond_broadcast(&(pool -> cond));
+    globus_mutex_unlock(&(pool -> mutex));
+
+    if (discard){
+        if (globus_callback_register_oneshot(NULL, NULL, handle_pool_discard_callback, (void *) entry) != GLOBUS_SUCCESS){
+            handle_pool_discard_callback((void *) entry);
+        }
+    }
+
+    return 0;
+}
+
+// destroy the idle handles of every host of a handle pool and return
+// how many were destroyed; the pool mutex must not be held
+static int handle_pool_trim(handle_pool_t * pool)
+{
+    handle_pool_host_t * host;
+    handle_pool_entry_t * idle = NULL;
+    handle_pool_entry_t * entry;
+    int n = 0;
+
+    globus_mutex_lock(&(pool -> mutex));
+    for (host = pool -> hosts; host; host = host -> next){
+        while (host -> idle){
+            entry = host -> idle;
+            host -> idle = entry -> next;
+            entry -> next = idle;
+            idle = entry;
+        }
+        host -> nidle = 0;
+    }
+
+    // a waiter for a host at its cap may now create a handle
+    globus_cond_broadcast(&(pool -> cond));
+    globus_mutex_unlock(&(pool -> mutex));
+
+    while (idle){
+        entry = idle;
+        idle = entry -> next;
+        globus_ftp_client_handle_destroy(&(entry -> handle));
+        globus_libc_free(entry);
+        n++;
+    }
+
+    return n;
+}
+
+// callback for the exists operation that warms up a pooled handle
+//
+// the handle goes back to its pool before the callback into Python, so
+// a lease made from the callback finds it; it is discarded if the
+// server could not be reached
+static void prewarm_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * arg;
+    PyObject * errorObject;
+    completion_record_t * record;
+    globus_bool_t connected;
+
+    prewarm_callback_bucket_t * callbackBucket = (prewarm_callback_bucket_t *) user_data;
+
+    // a reply from the server, even a failure, means the control
+    // connection was opened and authenticated
+    connected = (error == NULL || gridftp_error_ftp_code(error) > 0);
+    handle_pool_put(callbackBucket -> entry, !connected);
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_PREWARM, callbackBucket -> pyarg, 1, NULL, connected ? NULL : error);
+    if (record){
+        record -> text[0] = callbackBucket -> url;
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    if (func != Py_None){
+
+        // create an error object to pass back into Python
+        if (!connected){
+            errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+        } else{
+            errorObject = Py_BuildValue("s", NULL);
+        }
+
+        // prepare the arg list to pass into the Python callback function
+        arglist = Py_BuildValue("(OsO)", arg, callbackBucket -> url, errorObject);
+
+        // now call the Python callback function
+        result = PyEval_CallObject(func, arglist);
+
+        if (result == NULL) {
+
+            // something went wrong so print to stderr
+            PyErr_Print();
+        }
+
+        // take care of reference handling
+        Py_DECREF(arglist);
+        Py_XDECREF(result);
+        Py_XDECREF(errorObject);
+    }
+
+    Py_XDECREF(func);
+    Py_XDECREF(arg);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    globus_libc_free(callbackBucket -> url);
+    free(callbackBucket);
+
+    return;
+}
+
+// free a pipelined batch; the GIL must be held
+static void pipeline_batch_free(pipeline_batch_t * batch)
+{
+    int i;
+
+    for (i = 0; i < batch -> npairs; i++){
+        globus_libc_free(batch -> src[i]);
+        globus_libc_free(batch -> dst[i]);
+    }
+    globus_libc_free(batch -> src);
+    globus_libc_free(batch -> dst);
+    Py_XDECREF(batch -> pyfunction);
+    Py_XDECREF(batch -> pyarg);
+    globus_libc_free(batch);
+}
+
+// remove a batch from the pipeline registry
+static void pipeline_registry_remove(pipeline_batch_t * batch)
+{
+    pipeline_batch_t ** p;
+
+    globus_mutex_lock(&(pipeline_registry.mutex));
+    for (p = &(pipeline_registry.batches); *p; p = &((*p) -> next)){
+        if (*p == batch){
+            *p = batch -> next;
+            break;
+        }
+    }
+    globus_mutex_unlock(&(pipeline_registry.mutex));
+}
+
+// pipeline callback set on handle attributes by
+// gridftp_handleattr_set_pipeline
+//
+// Globus calls this whenever it can send the commands of another
+// transfer on the session of a handle; the next pair of the batch in
+// progress on the handle is handed out, or NULL once there are none
+static void pipeline_callback(
+        globus_ftp_client_handle_t * handle,
+        char ** source_url,
+        char ** dest_url,
+        void * user_arg)
+{
+    pipeline_batch_t * batch;
+
+    *source_url = NULL;
+    *dest_url = NULL;
+
+    globus_mutex_lock(&(pipeline_registry.mutex));
+    for (batch = pipeline_registry.batches; batch; batch = batch -> next){
+        if (batch -> handle == handle){
+            break;
+        }
+    }
+    if (batch && batch -> issued < batch -> npairs){
+        *source_url = batch -> src[batch -> issued];
+        *dest_url = batch -> dst[batch -> issued];
+        batch -> issued++;
+    }
+    globus_mutex_unlock(&(pipeline_registry.mutex));
+}
+
+// report the jobs of a pipelined transfer of small files started by a
+// transfer queue and free the batch
+static void transfer_queue_batch_complete(pipeline_batch_t * batch, globus_object_t * error);
+
+// callback for the completion of a pipelined third party transfer
+//
+// Globus reports once for the whole batch, so each pair is reported
+// from here: all succeeded if there is no error; otherwise the pairs
+// handed to Globus get the error, since which of them completed is not
+// known, and the rest were never started
+static void pipeline_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * errorObject;
+    PyObject * notStartedObject;
+    completion_record_t * record;
+
+    pipeline_batch_t * batch = (pipeline_batch_t * ) user_data;
+    const char * not_started = "gridftpwrapper: transfer not started, an earlier transfer of the pipeline failed";
+    char * text = NULL;
+    int i;
+
+    pipeline_registry_remove(batch);
+
+    // batches of a transfer queue are reported per job by the queue
+    if (batch -> jobs){
+        transfer_queue_batch_complete(batch, error);
+        return;
+    }
+
+    if (error){
+        text = globus_error_print_chain(error);
+    }
+
+    // hand a completion per pair to a completion queue, without taking
+    // the GIL, if a queue was given in place of a callback function;
+    // only the last record owns the references of the batch, so the
+    // argument stays alive until every record has been drained
+    if (completion_queue_from_object(batch -> pyfunction)){
+        for (i = 0; i < batch -> npairs; i++){
+            record = completion_queue_record(batch -> pyfunction, COMPLETION_PIPELINED, batch -> pyarg, i == batch -> npairs - 1, handle, NULL);
+            if (record == NULL){
+                continue;
+            }
+            if (error){
+                record -> error = globus_libc_strdup(i < batch -> issued ? text : not_started);
+            }
+            record -> text[0] = batch -> src[i];
+            record -> text[1] = batch -> dst[i];
+            batch -> src[i] = NULL;
+            batch -> dst[i] = NULL;
+            completion_queue_push(record);
+        }
+
+        // the records took the URLs and the references of the batch
+        for (i = 0; i < batch -> npairs; i++){
+            globus_libc_free(batch -> src[i]);
+            globus_libc_free(batch -> dst[i]);
+        }
+        globus_libc_free(batch -> src);
+        globus_libc_free(batch -> dst);
+        globus_libc_free(batch);
+        globus_libc_free(text);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    if (batch -> pyfunction != Py_None){
+
+        // create the error objects to pass back into Python
+        errorObject = Py_BuildValue("s", text);
+        notStartedObject = Py_BuildValue("s", error ? not_started : NULL);
+
+        for (i = 0; i < batch -> npairs; i++){
+
+            // prepare the arg list to pass into the Python callback function
+            arglist = Py_BuildValue("(OssO)", batch -> pyarg, batch -> src[i], batch -> dst[i],
+                i < batch -> issued ? errorObject : notStartedObject);
+
+            // now call the Python callback function
+            result = PyEval_CallObject(batch -> pyfunction, arglist);
+
+            if (result == NULL) {
+
+                // something went wrong so print to stderr
+                PyErr_Print();
+            }
+
+            // take care of reference handling
+            Py_DECREF(arglist);
+            Py_XDECREF(result);
+        }
+
+        Py_XDECREF(errorObject);
+        Py_XDECREF(notStartedObject);
+    }
+
+    // free the space the batch was holding
+    pipeline_batch_free(batch);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    globus_libc_free(text);
+
+    return;
+}
+
+// callback for the completion of an operation of a metadata batch
+//
+// the outcome goes into the result vector of the batch and the handle
+// back to the pool, discarded if its server could not be reached. A
+// missing path is reported by exists without a reply code, so it is
+// given the code of the server refusal, 550
+static void metadata_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    metadata_slot_t * slot = (metadata_slot_t *) user_data;
+    metadata_batch_t * batch = slot -> batch;
+    listing_t listing;
+    int code = 0;
+
+    if (error){
+        code = gridftp_error_reply_code(error);
+        if (code <= 0){
+            code = -1;
+        }
+    }
+
+    // a path that is there but is not a directory is refused as if the
+    // server had answered 550
+    if (batch -> op == METADATA_ISDIR){
+        if (code == 0){
+            listing_init(&listing, GLOBUS_FALSE);
+            if (slot -> facts){
+                listing_feed(&listing, slot -> facts, (long) slot -> facts_length);
+                listing_finish(&listing);
+            }
+            if (listing.failed){
+                code = -1;
+            } else if (listing.n != 1 || listing.types[0] != 'd'){
+                code = 550;
+            }
+            listing_free(&listing);
+        }
+        globus_libc_free(slot -> facts);
+        slot -> facts = NULL;
+    }
+
+    handle_pool_put(slot -> entry, code < 0);
+
+    globus_mutex_lock(&(batch -> mutex));
+    batch -> results[slot -> index] = code;
+    batch -> active--;
+    globus_cond_signal(&(batch -> cond));
+    globus_mutex_unlock(&(batch -> mutex));
+}
+
+// lease a handle for a metadata batch
+//
+// waiting is unbounded while the batch has operations of its own in
+// flight, which give their handles back; otherwise the batch waits at
+// most its timeout in seconds in all, after which *entryp is left NULL
+// at once
+//
+// returns 0, or -1 if a handle could not be created
+static int metadata_acquire(metadata_batch_t * batch, const char * key, handle_pool_entry_t ** entryp, globus_result_t * resultp)
+{
+    int active;
+    int rc;
+
+    for (;;){
+        rc = handle_pool_acquire(batch -> pool, key, batch -> starved < batch -> timeout, METADATA_ACQUIRE_SLICE, entryp, resultp);
+        if (rc != 0 || *entryp || batch -> starved >= batch -> timeout){
+            return rc;
+        }
+
+        // the one operation counted as in flight is the one being started
+        globus_mutex_lock(&(batch -> mutex));
+        active = batch -> active;
+        globus_mutex_unlock(&(batch -> mutex));
+
+        if (active <= 1){
+            batch -> starved += METADATA_ACQUIRE_SLICE;
+        }
+    }
+}
+
+static long dir_cache_forget_url(handle_pool_t * pool, const char * url);
+
+// run one metadata operation on each of n URLs over handles leased
+// from a handle pool, with at most window in flight, and wait for them
+// all; no lock may be held and the GIL must not be held
+//
+// dst is only used for moves and cksm only for checksums. results
+// gets, per URL, 0 for success, the FTP reply code of a refusal, -1
+// if the server could not be reached or the operation not started, or
+// METADATA_ACQUIRE_TIMED_OUT if no handle was had within timeout
+// seconds. The pool forgets the directories removed, deleted or moved away, and
+// those under them, whatever the outcome
+static void metadata_run(
+        handle_pool_t * pool,
+        globus_ftp_client_operationattr_t * attr,
+        int op,
+        char ** src,
+        char ** dst,
+        int mode,
+        metadata_cksm_t * cksm,
+        int n,
+        int window,
+        double timeout,
+        int * results)
+{
+    metadata_batch_t batch;
+    metadata_slot_t * slots;
+    globus_result_t gridftp_result;
+    char key[1024];
+    int rc;
+    int i;
+
+    memset(&batch, 0, sizeof(metadata_batch_t));
+    batch.pool = pool;
+    batch.attr = attr;
+    batch.op = op;
+    batch.results = results;
+    batch.timeout = timeout;
+
+    slots = (metadata_slot_t *) globus_malloc(sizeof(metadata_slot_t) * (n ? n : 1));
+    if (slots == NULL){
+        for (i = 0; i < n; i++){
+            results[i] = -1;
+        }
+        return;
+    }
+
+    globus_mutex_init(&(batch.mutex), NULL);
+    globus_cond_init(&(batch.cond), NULL);
+
+    for (i = 0; i < n; i++){
+        results[i] = -1;
+
+        // keep the window, then lease, waiting for the pool if the host
+        // has no handle free; handles come back from the callbacks
+        globus_mutex_lock(&(batch.mutex));
+        while (batch.active >= window){
+            globus_cond_wait(&(batch.cond), &(batch.mutex));
+        }
+        batch.active++;
+        globus_mutex_unlock(&(batch.mutex));
+
+        slots[i].batch = &batch;
+        slots[i].index = i;
+        slots[i].facts = NULL;
+        slots[i].facts_length = 0;
+
+        handle_pool_key(src[i], key, sizeof(key));
+        rc = metadata_acquire(&batch, key, &(slots[i].entry), &gridftp_result);
+        if (rc == 0 && slots[i].entry){
+            switch (op){
+            case METADATA_EXISTS:
+                gridftp_result = globus_ftp_client_exists(&(slots[i].entry -> handle), src[i], attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_MKDIR:
+                gridftp_result = globus_ftp_client_mkdir(&(slots[i].entry -> handle), src[i], attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_RMDIR:
+                gridftp_result = globus_ftp_client_rmdir(&(slots[i].entry -> handle), src[i], attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_DELETE:
+                gridftp_result = globus_ftp_client_delete(&(slots[i].entry -> handle), src[i], attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_CHMOD:
+                gridftp_result = globus_ftp_client_chmod(&(slots[i].entry -> handle), src[i], mode, attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_CKSM:
+                gridftp_result = globus_ftp_client_cksm(&(slots[i].entry -> handle), src[i], attr, cksm -> cksms[i],
+                    (globus_off_t) cksm -> offsets[i], (globus_off_t) cksm -> lengths[i], cksm -> algorithm,
+                    metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            case METADATA_ISDIR:
+                gridftp_result = globus_ftp_client_mlst(&(slots[i].entry -> handle), src[i], attr, &(slots[i].facts), &(slots[i].facts_length),
+                    metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            default:
+                gridftp_result = globus_ftp_client_move(&(slots[i].entry -> handle), src[i], dst[i], attr, metadata_complete_callback, (void *) &(slots[i]));
+                break;
+            }
+
+            if (gridftp_result == GLOBUS_SUCCESS){
+                continue;
+            }
+
+            handle_pool_put(slots[i].entry, 0);
+        } else if (rc == 0){
+            results[i] = METADATA_ACQUIRE_TIMED_OUT;
+        }
+
+        // not started, the result stays -1 unless no handle was had
+        globus_mutex_lock(&(batch.mutex));
+        batch.active--;
+        globus_mutex_unlock(&(batch.mutex));
+    }
+
+    globus_mutex_lock(&(batch.mutex));
+    while (batch.active > 0){
+        globus_cond_wait(&(batch.cond), &(batch.mutex));
+    }
+    globus_mutex_unlock(&(batch.mutex));
+
+    if (op == METADATA_RMDIR || op == METADATA_DELETE || op == METADATA_MOVE){
+        for (i = 0; i < n; i++){
+            dir_cache_forget_url(pool, src[i]);
+        }
+    }
+
+    globus_cond_destroy(&(batch.cond));
+    globus_mutex_destroy(&(batch.mutex));
+    globus_libc_free(slots);
+}
+
+// copy a URL with the repeated and trailing slashes of its path taken
+// out and its scheme, host and port written as handle_pool_key writes
+// them, so that each directory has one spelling in the directory cache
+//
+// returns the copy, or NULL if out of memory, with *path set to the
+// offset of its path, or to its length if it has none
+static char * dir_cache_normalize(const char * url, int * path)
+{
+    const char * p;
+    const char * host;
+    const char * end;
+    char key[1024];
+    char * norm;
+    int i;
+
+    handle_pool_key(url, key, sizeof(key));
+
+    norm = (char *) globus_malloc(strlen(url) + strlen(key) + 1);
+    if (norm == NULL){
+        return NULL;
+    }
+
+    p = strstr(url, "://");
+    if (p == NULL){
+        p = strchr(url, '/');
+        i = p ? (int) (p - url) : (int) strlen(url);
+        memcpy(norm, url, i);
+        p = url + i;
+    } else{
+
+        // the scheme in lower case, any user information as it is, then
+        // the host:port key
+        for (i = 0; url + i < p; i++){
+            norm[i] = tolower((unsigned char) url[i]);
+        }
+        memcpy(norm + i, "://", 3);
+        i += 3;
+        host = p + 3;
+        end = host + strcspn(host, "/?#");
+        for (p = end; p > host && p[-1] != '@'; p--){
+        }
+        memcpy(norm + i, host, p - host);
+        i += (int) (p - host);
+        strcpy(norm + i, key);
+        i += (int) strlen(key);
+        p = end;
+    }
+
+    *path = i;
+    for (; *p; p++){
+        if (*p == '/' && i > *path && norm[i - 1] == '/'){
+            continue;
+        }
+        norm[i++] = *p;
+    }
+    while (i > *path && norm[i - 1] == '/'){
+        i--;
+    }
+    norm[i] = '\0';
+
+    return norm;
+}
+
+// find a directory, given by the first len characters of url, in the
+// directory cache of a handle pool; the directory mutex must be held
+//
+// returns the entry or NULL, with *bucket set to where it belongs
+static dir_cache_entry_t * dir_cache_find(handle_pool_t * pool, const char * url, int len, unsigned long * bucket)
+{
+    dir_cache_entry_t * entry;
+    unsigned long hash = 5381;
+    int i;
+
+    for (i = 0; i < len; i++){
+        hash = hash * 33 + (unsigned char) url[i];
+    }
+    *bucket = hash % DIR_CACHE_NBUCKETS;
+
+    if (pool -> dirs == NULL){
+        return NULL;
+    }
+
+    for (entry = pool -> dirs[*bucket]; entry; entry = entry -> next){
+        if (strncmp(entry -> url, url, len) == 0 && entry -> url[len] == '\0'){
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// add a directory, given by the first len characters of url, to the
+// directory cache of a handle pool as being created; the directory
+// mutex must be held
+//
+// returns the entry, or NULL if out of memory
+static dir_cache_entry_t * dir_cache_add(handle_pool_t * pool, const char * url, int len, unsigned long bucket)
+{
+    dir_cache_entry_t * entry;
+
+    if (pool -> dirs == NULL){
+        pool -> dirs = (dir_cache_entry_t **) globus_malloc(sizeof(dir_cache_entry_t *) * DIR_CACHE_NBUCKETS);
+        if (pool -> dirs == NULL){
+            return NULL;
+        }
+        memset(pool -> dirs, 0, sizeof(dir_cache_entry_t *) * DIR_CACHE_NBUCKETS);
+    }
+
+    entry = (dir_cache_entry_t *) globus_malloc(sizeof(dir_cache_entry_t));
+    if (entry == NULL){
+        return NULL;
+    }
+    entry -> url = (char *) globus_malloc(len + 1);
+    if (entry -> url == NULL){
+        globus_libc_free(entry);
+        return NULL;
+    }
+    memcpy(entry -> url, url, len);
+    entry -> url[len] = '\0';
+    entry -> creating = GLOBUS_TRUE;
+    entry -> next = pool -> dirs[bucket];
+    pool -> dirs[bucket] = entry;
+    pool -> ndirs++;
+
+    return entry;
+}
+
+// take a directory out of the directory cache of a handle pool and free
+// it; the directory mutex must be held
+static void dir_cache_remove(handle_pool_t * pool, dir_cache_entry_t * entry)
+{
+    dir_cache_entry_t ** p;
+    unsigned long bucket;
+
+    dir_cache_find(pool, entry -> url, (int) strlen(entry -> url), &bucket);
+    for (p = &(pool -> dirs[bucket]); *p; p = &((*p) -> next)){
+        if (*p == entry){
+            *p = entry -> next;
+            break;
+        }
+    }
+    pool -> ndirs--;
+    globus_libc_free(entry -> url);
+    globus_libc_free(entry);
+}
+
+// forget a directory a handle pool knows to exist and every directory
+// under it, given by the first len characters of a normalized URL, or
+// every directory if url is NULL, leaving those being created; the
+// directory mutex must be held
+//
+// returns the number forgotten
+static long dir_cache_forget(handle_pool_t * pool, const char * url, int len)
+{
+    dir_cache_entry_t ** p;
+    dir_cache_entry_t * entry;
+    long n = 0;
+    int i;
+
+    if (pool -> dirs == NULL || pool -> ndirs == 0){
+        return 0;
+    }
+
+    for (i = 0; i < DIR_CACHE_NBUCKETS; i++){
+        p = &(pool -> dirs[i]);
+        while (*p){
+            entry = *p;
+            if (entry -> creating || (url && (strncmp(entry -> url, url, len) != 0 ||
+                    (entry -> url[len] != '\0' && entry -> url[len] != '/')))){
+                p = &(entry -> next);
+                continue;
+            }
+            *p = entry -> next;
+            globus_libc_free(entry -> url);
+            globus_libc_free(entry);
+            pool -> ndirs--;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+// forget the directory at a URL and every directory under it, taking
+// the directory mutex
+//
+// returns the number forgotten, or -1 if out of memory
+static long dir_cache_forget_url(handle_pool_t * pool, const char * url)
+{
+    char * norm;
+    int path;
+    long n;
+
+    norm = dir_cache_normalize(url, &path);
+    if (norm == NULL){
+        return -1;
+    }
+
+    globus_mutex_lock(&(pool -> dirs_mutex));
+    n = dir_cache_forget(pool, norm, (int) strlen(norm));
+    globus_mutex_unlock(&(pool -> dirs_mutex));
+
+    globus_libc_free(norm);
+
+    return n;
+}
+
+// order the URLs given to gridftp_handle_pool_makedirs so that those
+// under any one directory are next to each other, by sorting the end
+// of a string first and '/' before any other character
+static int makedirs_leaf_compare(const void * a, const void * b)
+{
+    const unsigned char * x = (const unsigned char *) ((const makedirs_leaf_t *) a) -> url;
+    const unsigned char * y = (const unsigned char *) ((const makedirs_leaf_t *) b) -> url;
+    int cx;
+    int cy;
+
+    for (;; x++, y++){
+        cx = *x == '/' ? 1 : (*x ? *x + 1 : 0);
+        cy = *y == '/' ? 1 : (*y ? *y + 1 : 0);
+        if (cx != cy){
+            return cx - cy;
+        }
+        if (cx == 0){
+            return 0;
+        }
+    }
+}
+
+// create the directories of sorted URLs and all their parents over
+// handles leased from a handle pool, one level of the trees at a time
+// with the directories of a level made in parallel, up to window at
+// once; the GIL must not be held
+//
+// directories the pool knows to exist are skipped, and one that another
+// call is creating is waited for rather than made twice. A mkdir that
+// the server refuses is followed by an exists, since the directory may
+// have been made by someone else. results gets, per URL, 0 for success
+// or the code of the first directory on its path that failed; timeout
+// is passed on to metadata_run
+static void makedirs_run(
+        handle_pool_t * pool,
+        globus_ftp_client_operationattr_t * attr,
+        makedirs_leaf_t * leaves,
+        int n,
+        int window,
+        double timeout,
+        int * results)
+{
+    makedirs_leaf_t * leaf;
+    dir_cache_entry_t * entry;
+    dir_cache_entry_t ** entries;
+    unsigned long bucket;
+    char ** urls;
+    int * start;
+    int * stop;
+    int * state;
+    int * codes;
+    int * rcodes;
+    int * dirs;
+    int ndirs;
+    int nurls;
+    int prev;
+    int more;
+    int u;
+    int j;
+    int k;
+    char * q;
+
+    entries = (dir_cache_entry_t **) globus_malloc(sizeof(dir_cache_entry_t *) * (n ? n : 1));
+    urls = (char **) globus_malloc(sizeof(char *) * (n ? n : 1));
+    start = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    stop = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    state = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    codes = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    rcodes = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    dirs = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+
+    if (!entries || !urls || !start || !stop || !state || !codes || !rcodes || !dirs){
+        for (k = 0; k < n; k++){
+            results[leaves[k].index] = -1;
+        }
+        n = 0;
+    }
+
+    while (n > 0){
+
+        // take every URL not failed and not done down one level; those
+        // under the same directory are next to each other in leaves
+        ndirs = 0;
+        prev = -1;
+        for (k = 0; k < n; k++){
+            leaf = &(leaves[k]);
+            if (results[leaf -> index] != 0 || leaf -> url[leaf -> end] == '\0'){
+                continue;
+            }
+
+            q = strchr(leaf -> url + leaf -> end + 1, '/');
+            leaf -> end = q ? (int) (q - leaf -> url) : (int) strlen(leaf -> url);
+
+            if (prev >= 0 && leaves[prev].end == leaf -> end && strncmp(leaves[prev].url, leaf -> url, leaf -> end) == 0){
+                stop[ndirs - 1] = k + 1;
+            } else{
+                start[ndirs] = k;
+                stop[ndirs] = k + 1;
+                ndirs++;
+            }
+            prev = k;
+        }
+
+        if (ndirs == 0){
+            break;
+        }
+
+        // state per directory: 0 to be made by this call, 1 exists, 2
+        // being made by another call, 3 failed with codes[u]
+        globus_mutex_lock(&(pool -> dirs_mutex));
+        for (u = 0; u < ndirs; u++){
+            leaf = &(leaves[start[u]]);
+            entry = dir_cache_find(pool, leaf -> url, leaf -> end, &bucket);
+            if (entry){
+                state[u] = entry -> creating ? 2 : 1;
+                continue;
+            }
+            entries[u] = dir_cache_add(pool, leaf -> url, leaf -> end, bucket);
+            state[u] = entries[u] ? 0 : 3;
+            codes[u] = -1;
+        }
+        globus_mutex_unlock(&(pool -> dirs_mutex));
+
+        more = 1;
+        while (more){
+            nurls = 0;
+            for (u = 0; u < ndirs; u++){
+                if (state[u] == 0){
+                    urls[nurls] = entries[u] -> url;
+                    dirs[nurls] = u;
+                    nurls++;
+                }
+            }
+
+            if (nurls > 0){
+                metadata_run(pool, attr, METADATA_MKDIR, urls, NULL, 0, NULL, nurls, window, timeout, rcodes);
+
+                // a refused mkdir may be for a directory that exists, but
+                // only a path whose MLST type fact is dir is taken as one
+                j = 0;
+                for (k = 0; k < nurls; k++){
+                    codes[dirs[k]] = rcodes[k];
+                    if (rcodes[k] > 0){
+                        urls[j] = urls[k];
+                        dirs[j] = dirs[k];
+                        j++;
+                    }
+                }
+                if (j > 0){
+                    metadata_run(pool, attr, METADATA_ISDIR, urls, NULL, 0, NULL, j, window, timeout, rcodes);
+                    for (k = 0; k < j; k++){
+                        if (rcodes[k] == 0){
+                            codes[dirs[k]] = 0;
+                        }
+                    }
+                }
+
+                globus_mutex_lock(&(pool -> dirs_mutex));
+                for (u = 0; u < ndirs; u++){
+                    if (state[u] != 0){
+                        continue;
+                    }
+                    if (codes[u] == 0){
+                        entries[u] -> creating = GLOBUS_FALSE;
+                        state[u] = 1;
+                    } else{
+                        dir_cache_remove(pool, entries[u]);
+                        state[u] = 3;
+                    }
+                }
+                globus_cond_broadcast(&(pool -> dirs_cond));
+                globus_mutex_unlock(&(pool -> dirs_mutex));
+            }
+
+            // wait for the directories other calls are making, and take
+            // on again those they could not make
+            more = 0;
+            globus_mutex_lock(&(pool -> dirs_mutex));
+            for (u = 0; u < ndirs; u++){
+                if (state[u] != 2){
+                    continue;
+                }
+                leaf = &(leaves[start[u]]);
+                while ((entry = dir_cache_find(pool, leaf -> url, leaf -> end, &bucket)) && entry -> creating){
+                    globus_cond_wait(&(pool -> dirs_cond), &(pool -> dirs_mutex));
+                }
+                if (entry){
+                    state[u] = 1;
+                    continue;
+                }
+                entries[u] = dir_cache_add(pool, leaf -> url, leaf -> end, bucket);
+                state[u] = entries[u] ? 0 : 3;
+                codes[u] = -1;
+                more |= (entries[u] != NULL);
+            }
+            globus_mutex_unlock(&(pool -> dirs_mutex));
+        }
+
+        // fail the URLs under a directory that could not be made
+        for (u = 0; u < ndirs; u++){
+            if (state[u] != 3){
+                continue;
+            }
+            for (k = start[u]; k < stop[u]; k++){
+                results[leaves[k].index] = codes[u] ? codes[u] : -1;
+            }
+        }
+    }
+
+    globus_libc_free(entries);
+    globus_libc_free(urls);
+    globus_libc_free(start);
+    globus_libc_free(stop);
+    globus_libc_free(state);
+    globus_libc_free(codes);
+    globus_libc_free(rcodes);
+    globus_libc_free(dirs);
+}
+
+// get the tree walker behind a Python object
+//
+// returns the walker or NULL with a Python exception set if the object
+// is not a tree walker
+static walker_t * walker_from_object(PyObject * obj)
+{
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) walker_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a tree walker");
+        return NULL;
+    }
+
+    return (walker_t *) PyCObject_AsVoidPtr(obj);
+}
+
+// add a directory for a tree walker to list, taking over the URL; the
+// walker mutex must be held
+//
+// returns 0 or -1 if out of memory, in which case the URL is freed
+static int walker_push(walker_t * walker, char * url, int depth)
+{
+    walker_host_t * host;
+    walker_dir_t * dir;
+    char key[1024];
+
+    handle_pool_key(url, key, sizeof(key));
+    for (host = walker -> hosts; host; host = host -> next){
+        if (strcmp(host -> key, key) == 0){
+            break;
+        }
+    }
+
+    if (host == NULL){
+        host = (walker_host_t *) globus_malloc(sizeof(walker_host_t));
+        if (host == NULL){
+            globus_libc_free(url);
+            return -1;
+        }
+        memset(host, 0, sizeof(walker_host_t));
+        host -> key = globus_libc_strdup(key);
+        host -> next = walker -> hosts;
+        walker -> hosts = host;
+    }
+
+    dir = (walker_dir_t *) globus_malloc(sizeof(walker_dir_t));
+    if (dir == NULL){
+        globus_libc_free(url);
+        return -1;
+    }
+    dir -> url = url;
+    dir -> depth = depth;
+    dir -> next = host -> dirs;
+    host -> dirs = dir;
+    walker -> queued++;
+
+    return 0;
+}
+
+// take the next directory a tree walker can list off its host and
+// lease a handle for it; the walker mutex must be held
+//
+// the hosts are served in turn starting after the one served last, and
+// a host for which the pool has no handle is passed over. If the handle
+// cannot be created the listing is returned with no handle, to be
+// failed. Returns NULL if no listing can be started
+static walker_op_t * walker_pick(walker_t * walker)
+{
+    walker_host_t * start;
+    walker_host_t * host;
+    walker_op_t * op;
+    handle_pool_entry_t * entry;
+    globus_result_t gridftp_result;
+    int rc;
+
+    if (walker -> closed || walker -> hosts == NULL || walker -> active >= walker -> max_active
+            || walker -> nready >= (long) walker -> max_active * WALKER_READY_PER_ACTIVE){
+        return NULL;
+    }
+
+    start = walker -> cursor ? walker -> cursor : walker -> hosts;
+    host = start;
+    do{
+        if (host -> dirs && host -> blocked_pass != walker -> pass){
+            rc = handle_pool_acquire(walker -> pool, host -> key, 0, 0.0, &entry, &gridftp_result);
+            if (rc == 0 && entry == NULL){
+                host -> blocked_pass = walker -> pass;
+            } else{
+                op = (walker_op_t *) globus_malloc(sizeof(walker_op_t));
+                if (op == NULL){
+                    if (entry){
+                        handle_pool_put(entry, 0);
+                    }
+                    return NULL;
+                }
+                memset(op, 0, sizeof(walker_op_t));
+                listing_init(&(op -> read.listing), GLOBUS_TRUE);
+                op -> walker = walker;
+                op -> entry = entry;
+                op -> dir = host -> dirs;
+                host -> dirs = op -> dir -> next;
+                walker -> queued--;
+                walker -> active++;
+                walker -> cursor = host -> next;
+                return op;
+            }
+        }
+        host = host -> next ? host -> next : walker -> hosts;
+    } while (host != start);
+
+    return NULL;
+}
+
+// callback that starts more listings of a tree walker after one of
+// them completed, outside of the callbacks of the handle
+static void walker_schedule_callback(void * user_arg);
+
+// hand the listing of a directory of a tree walker over to Python and
+// queue its subdirectories, then free the listing state; no lock may
+// be held
+//
+// error is the error text of the listing, or NULL for success. If
+// reschedule is true more listings are started from a oneshot callback
+// build the URL of a subdirectory found by a tree walker, with the
+// name percent-encoded so that a space, %, # or ? in it is taken as
+// part of the path
+//
+// returns the URL, or NULL if out of memory
+static char * walker_child_url(const char * parent, const char * name)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t len = strlen(parent);
+    const unsigned char * p;
+    char * url;
+    char * q;
+
+    url = (char *) globus_malloc(len + 3 * strlen(name) + 2);
+    if (url == NULL){
+        return NULL;
+    }
+
+    memcpy(url, parent, len);
+    q = url + len;
+    if (len == 0 || parent[len - 1] != '/'){
+        *q++ = '/';
+    }
+
+    // only the unreserved characters of RFC 3986 are left as they are
+    for (p = (const unsigned char *) name; *p; p++){
+        if (isalnum(*p) || *p == '-' || *p == '.' || *p == '_' || *p == '~'){
+            *q++ = (char) *p;
+        } else{
+            *q++ = '%';
+            *q++ = hex[*p >> 4];
+            *q++ = hex[*p & 15];
+        }
+    }
+    *q = '\0';
+
+    return url;
+}
+
+static void walker_finish(walker_t * walker, walker_op_t * op, const char * error, globus_bool_t reschedule)
+{
+    walker_result_t * result;
+    listing_t * listing = &(op -> read.listing);
+    char * url;
+    char * name;
+    long dropped = 0;
+    long i;
+
+    result = (walker_result_t *) globus_malloc(sizeof(walker_result_t));
+    if (result){
+        memset(result, 0, sizeof(walker_result_t));
+        result -> url = op -> dir -> url;
+        result -> error = error ? globus_libc_strdup(error) : NULL;
+        memcpy(&(result -> listing), listing, sizeof(listing_t));
+    } else{
+        globus_libc_free(op -> dir -> url);
+        listing_free(listing);
+    }
+
+    globus_mutex_lock(&(walker -> mutex));
+
+    // the subdirectories are listed next, unless too deep; symbolic
+    // links are not followed
+    if (result && error == NULL && !(walker -> closed)
+            && (walker -> max_depth < 0 || op -> dir -> depth < walker -> max_depth)){
+        for (i = 0; i < result -> listing.n; i++){
+            if (result -> listing.types[i] != 'd'){
+                continue;
+            }
+            name = result -> listing.names + result -> listing.offsets[i];
+            url = walker_child_url(result -> url, name);
+            if (url == NULL || walker_push(walker, url, op -> dir -> depth + 1) != 0){
+                dropped++;
+            }
+        }
+
+        // the listing is still handed over, but with an error saying
+        // that part of the tree below it is missing
+        if (dropped){
+            result -> error = globus_libc_strdup("gridftpwrapper: unable to allocate subdirectory URLs, their trees are not listed");
+        }
+    }
+
+    if (result == NULL || result -> error || dropped){
+        walker -> nerrors++;
+    }
+
+    if (result){
+        if (walker -> ready_tail){
+            walker -> ready_tail -> next = result;
+        } else{
+            walker -> ready = result;
+        }
+        walker -> ready_tail = result;
+        walker -> nready++;
+        walker -> nentries += result -> listing.n;
+    }
+    walker -> ndirs++;
+    walker -> active--;
+    if (reschedule){
+        walker -> pending++;
+    }
+    globus_cond_broadcast(&(walker -> cond));
+    globus_mutex_unlock(&(walker -> mutex));
+
+    globus_libc_free(op -> dir);
+    globus_libc_free(op);
+
+    if (reschedule && globus_callback_register_oneshot(NULL, NULL, walker_schedule_callback, (void *) walker) != GLOBUS_SUCCESS){
+        walker_schedule_callback((void *) walker);
+    }
+}
+
+// callback for the completion of a directory listing started by a tree
+// walker
+//
+// the handle goes back to the pool, discarded if its server could not
+// be reached, and the listing is handed over
+static void walker_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    walker_op_t * op = (walker_op_t *) user_data;
+    char * text = NULL;
+
+    if (error){
+        text = globus_error_print_chain(error);
+    }
+
+    handle_pool_put(op -> entry, error && gridftp_error_ftp_code(error) == 0);
+    listing_finish(&(op -> read.listing));
+
+    if (error){
+        walker_finish(op -> walker, op, text ? text : "gridftpwrapper: machine list failed", GLOBUS_TRUE);
+    } else if (op -> read.listing.failed){
+        walker_finish(op -> walker, op, "gridftpwrapper: unable to allocate listing", GLOBUS_TRUE);
+    } else{
+        walker_finish(op -> walker, op, NULL, GLOBUS_TRUE);
+    }
+    globus_libc_free(text);
+
+    return;
+}
+
+// callback that tries again to start the listings of a tree walker
+// after the handle pool had no handle for any of them
+static void walker_retry_callback(void * user_arg);
+
+// start as many listings of a tree walker as its limits allow; no lock
+// may be held
+static void walker_schedule(walker_t * walker)
+{
+    walker_op_t * op;
+    globus_bool_t retry = GLOBUS_FALSE;
+    globus_result_t gridftp_result;
+    globus_reltime_t delay;
+    char msg[2048] = "";
+
+    globus_mutex_lock(&(walker -> mutex));
+    walker -> pass++;
+    globus_mutex_unlock(&(walker -> mutex));
+
+    while (1){
+        globus_mutex_lock(&(walker -> mutex));
+
+        op = walker_pick(walker);
+
+        // with nothing running no completion will come to start the
+        // directories left, unless Python has yet to take the listings
+        if (op == NULL){
+            if (!(walker -> closed) && walker -> active == 0 && walker -> queued > 0 && !(walker -> retry_pending)
+                    && walker -> nready < (long) walker -> max_active * WALKER_READY_PER_ACTIVE){
+                walker -> retry_pending = GLOBUS_TRUE;
+                walker -> pending++;
+                retry = GLOBUS_TRUE;
+            }
+            globus_mutex_unlock(&(walker -> mutex));
+            break;
+        }
+
+        globus_mutex_unlock(&(walker -> mutex));
+
+        if (op -> entry){
+            gridftp_result = globus_ftp_client_machine_list(
+                                &(op -> entry -> handle),
+                                op -> dir -> url,
+                                walker -> has_attr ? &(walker -> attr) : NULL,
+                                walker_complete_callback,
+                                (void *) op
+                                );
+
+            if (gridftp_result == GLOBUS_SUCCESS){
+                if (globus_ftp_client_register_read(
+                        &(op -> entry -> handle),
+                        op -> read.buffer,
+                        LISTING_READ_BUFFER,
+                        listing_read_callback,
+                        (void *) &(op -> read)
+                        ) != GLOBUS_SUCCESS){
+                    globus_ftp_client_abort(&(op -> entry -> handle));
+                }
+                continue;
+            }
+
+            handle_pool_put(op -> entry, 0);
+            sprintf(msg, "gridftpwrapper: rc = %d: unable to start machine list", gridftp_result);
+        } else{
+            sprintf(msg, "gridftpwrapper: unable to initialize handle");
+        }
+
+        walker_finish(walker, op, msg, GLOBUS_FALSE);
+    }
+
+    if (retry){
+        GlobusTimeReltimeSet(delay, 0, TRANSFER_QUEUE_RETRY_USEC);
+        if (globus_callback_register_oneshot(NULL, &delay, walker_retry_callback, (void *) walker) != GLOBUS_SUCCESS){
+            globus_mutex_lock(&(walker -> mutex));
+            walker -> retry_pending = GLOBUS_FALSE;
+            walker -> pending--;
+            globus_cond_broadcast(&(walker -> cond));
+            globus_mutex_unlock(&(walker -> mutex));
+        }
+    }
+}
+
+static void walker_schedule_callback(void * user_arg)
+{
+    walker_t * walker = (walker_t *) user_arg;
+
+    walker_schedule(walker);
+
+    globus_mutex_lock(&(walker -> mutex));
+    walker -> pending--;
+    globus_cond_broadcast(&(walker -> cond));
+    globus_mutex_unlock(&(walker -> mutex));
+}
+
+static void walker_retry_callback(void * user_arg)
+{
+    walker_t * walker = (walker_t *) user_arg;
+
+    globus_mutex_lock(&(walker -> mutex));
+    walker -> retry_pending = GLOBUS_FALSE;
+    globus_mutex_unlock(&(walker -> mutex));
+
+    walker_schedule_callback(user_arg);
+}
+
+// get the transfer queue behind a Python object
+//
+// returns the queue or NULL with a Python exception set if the object
+// is not a transfer queue
+static transfer_queue_t * transfer_queue_from_object(PyObject * obj)
+{
+    if (!PyCObject_Check(obj) || PyCObject_GetDesc(obj) != (void *) transfer_queue_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a transfer queue");
+        return NULL;
+    }
+
+    return (transfer_queue_t *) PyCObject_AsVoidPtr(obj);
+}
+
+// find the pair of a transfer queue for a key, adding it if there is
+// none; the queue mutex must be held
+//
+// returns NULL if out of memory
+static transfer_pair_t * transfer_queue_pair_for(transfer_queue_t * tq, const char * key)
+{
+    transfer_pair_t * pair;
+    transfer_pair_t ** pairs;
+    unsigned long hash = 5381;
+    const char * k;
+
+    for (k = key; *k; k++){
+        hash = hash * 33 + (unsigned char) *k;
+    }
+    hash %= TRANSFER_QUEUE_NBUCKETS;
+
+    for (pair = tq -> buckets[hash]; pair; pair = pair -> hnext){
+        if (strcmp(pair -> key, key) == 0){
+            return pair;
+        }
+    }
+
+    if (tq -> npairs == tq -> pairs_size){
+        pairs = (transfer_pair_t **) globus_libc_realloc(tq -> pairs, sizeof(transfer_pair_t *) * (tq -> pairs_size ? tq -> pairs_size * 2 : 64));
+        if (pairs == NULL){
+            return NULL;
+        }
+        tq -> pairs = pairs;
+        tq -> pairs_size = tq -> pairs_size ? tq -> pairs_size * 2 : 64;
+    }
+
+    pair = (transfer_pair_t *) globus_malloc(sizeof(transfer_pair_t));
+    if (pair == NULL){
+        return NULL;
+    }
+
+    memset(pair, 0, sizeof(transfer_pair_t));
+    pair -> key = globus_libc_strdup(key);
+    pair -> hnext = tq -> buckets[hash];
+    tq -> buckets[hash] = pair;
+    tq -> pairs[tq -> npairs++] = pair;
+
+    return pair;
+}
+
+// report the completion of a job of a transfer queue, with error NULL
+// for success, and free the job; no lock may be held
+//
+// a chunk is not reported itself: its job is, with the first error of
+// its chunks, once the last of them is done
+static void transfer_queue_report(transfer_job_t * job, const char * error)
+{
+    PyObject * func;
+    PyObject * arglist;
+    PyObject * result;
+    PyObject * errorObject;
+    completion_record_t * record;
+    transfer_queue_t * tq = job -> queue;
+    transfer_job_t * parent = job -> parent;
+    char * chunk_error = NULL;
+    globus_bool_t last = GLOBUS_TRUE;
+
+    globus_mutex_lock(&(tq -> mutex));
+    if (parent){
+        if (error && parent -> error == NULL){
+            parent -> error = globus_libc_strdup(error);
+        }
+        last = (--(parent -> nchunks) == 0);
+    }
+    if (last){
+        tq -> completed++;
+    }
+    globus_mutex_unlock(&(tq -> mutex));
+
+    if (parent){
+        globus_libc_free(job);
+        if (!last){
+            return;
+        }
+        job = parent;
+        chunk_error = parent -> error;
+        error = chunk_error;
+    }
+
+    func = tq -> pyfunction;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function; the
+    // record takes the references the job holds
+    record = completion_queue_record(func, COMPLETION_TRANSFER, job -> pyarg, 1, NULL, NULL);
+    if (record){
+        record -> error = error ? globus_libc_strdup(error) : NULL;
+        record -> text[0] = job -> src;
+        record -> text[1] = job -> dst;
+        completion_queue_push(record);
+        globus_libc_free(job);
+        globus_libc_free(chunk_error);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // create an error object to pass back into Python
+    errorObject = Py_BuildValue("s", error);
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OssO)", job -> pyarg, job -> src, job -> dst, errorObject);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling, each job holds a reference to
+    // the callback function
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+    Py_XDECREF(func);
+    Py_XDECREF(job -> pyarg);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    globus_libc_free(job -> src);
+    globus_libc_free(job -> dst);
+    globus_libc_free(job);
+    globus_libc_free(chunk_error);
+}
+
+// queue a job of a transfer queue, or the chunks it is split into, at
+// the head or the tail of its pair as its size calls for; the queue
+// mutex must be held
+//
+// a file is only chunked or set apart as small once its size is known,
+// and if chunks cannot be allocated the file is queued whole
+static void transfer_queue_enqueue(transfer_queue_t * tq, transfer_job_t * job, globus_bool_t at_head)
+{
+    transfer_pair_t * pair = job -> pair;
+    transfer_job_t * first = job;
+    transfer_job_t * last = job;
+    transfer_job_t * chunk;
+    transfer_job_t ** head = &(pair -> head[job -> priority]);
+    transfer_job_t ** tail = &(pair -> tail[job -> priority]);
+    globus_off_t offset;
+    long n = 1;
+
+    if (tq -> chunk_threshold > 0 && job -> size >= tq -> chunk_threshold && job -> size > tq -> chunk_size){
+        first = NULL;
+        last = NULL;
+        n = 0;
+        for (offset = 0; offset < job -> size; offset += tq -> chunk_size){
+            chunk = (transfer_job_t *) globus_malloc(sizeof(transfer_job_t));
+            if (chunk == NULL){
+                break;
+            }
+            memset(chunk, 0, sizeof(transfer_job_t));
+            chunk -> pair = pair;
+            chunk -> queue = tq;
+            chunk -> src = job -> src;
+            chunk -> dst = job -> dst;
+            chunk -> priority = job -> priority;
+            chunk -> size = job -> size;
+            chunk -> sized = GLOBUS_TRUE;
+            chunk -> offset = offset;
+            chunk -> end = offset + tq -> chunk_size < job -> size ? offset + tq -> chunk_size : job -> size;
+            chunk -> parent = job;
+            if (last){
+                last -> next = chunk;
+            } else{
+                first = chunk;
+            }
+            last = chunk;
+            n++;
+        }
+
+        if (offset < job -> size){
+            while (first){
+                chunk = first;
+                first = chunk -> next;
+                globus_libc_free(chunk);
+            }
+            first = job;
+            last = job;
+            n = 1;
+        } else{
+            job -> nchunks = (int) n;
+        }
+    } else if (job -> size >= 0 && job -> size < tq -> small_threshold){
+        head = &(pair -> small_head[job -> priority]);
+        tail = &(pair -> small_tail[job -> priority]);
+    }
+
+    if (at_head){
+        last -> next = *head;
+        *head = first;
+        if (*tail == NULL){
+            *tail = last;
+        }
+    } else{
+        last -> next = NULL;
+        if (*tail){
+            (*tail) -> next = first;
+        } else{
+            *head = first;
+        }
+        *tail = last;
+    }
+
+    tq -> queued_per_priority[job -> priority] += n;
+    tq -> queued += n;
+}
+
+// take the jobs queued on a pair of a transfer queue off it, for the
+// queue to drop them; the queue mutex must be held
+//
+// chunks are freed, and their job is only dropped along with the last
+// of them, since any chunk still running reports it
+static void transfer_queue_drop_pair(transfer_queue_t * tq, transfer_pair_t * pair, transfer_job_t ** dropped)
+{
+    transfer_job_t ** lists[2];
+    transfer_job_t * job;
+    transfer_job_t * parent;
+    int prio;
+    int l;
+
+    for (prio = 0; prio < TRANSFER_QUEUE_NPRIORITIES; prio++){
+        lists[0] = &(pair -> head[prio]);
+        lists[1] = &(pair -> small_head[prio]);
+        for (l = 0; l < 2; l++){
+            while (*(lists[l])){
+                job = *(lists[l]);
+                *(lists[l]) = job -> next;
+                parent = job -> parent;
+                if (parent){
+                    globus_libc_free(job);
+                    if (parent -> error == NULL){
+                        parent -> error = globus_libc_strdup("gridftpwrapper: transfer queue destroyed before every chunk was transferred");
+                    }
+                    if (--(parent -> nchunks) > 0){
+                        continue;
+                    }
+                    job = parent;
+                }
+                job -> next = *dropped;
+                *dropped = job;
+            }
+        }
+        pair -> tail[prio] = NULL;
+        pair -> small_tail[prio] = NULL;
+    }
+}
+
+// take the next job to start off a transfer queue and lease a handle
+// for it; the queue mutex must be held
+//
+// classes are served in priority order and, within a class, the pairs
+// in turn starting after the one served last. A pair at its limit, or
+// for which the pool has no handle, is passed over. If the handle
+// cannot be created the job is returned with no handle, to be failed.
+// Within a pair small files go first, so they are not held up behind
+// a large one, and up to batch_max of them are taken at once, linked
+// through next, to be pipelined. Returns NULL if no job can be started
+static transfer_job_t * transfer_queue_pick(transfer_queue_t * tq)
+{
+    transfer_pair_t * pair;
+    transfer_job_t * job;
+    transfer_job_t * last;
+    handle_pool_entry_t * entry;
+    globus_result_t gridftp_result;
+    int prio;
+    int idx;
+    int k;
+    int n;
+    int rc;
+
+    for (prio = 0; prio < TRANSFER_QUEUE_NPRIORITIES; prio++){
+        if (tq -> queued_per_priority[prio] == 0){
+            continue;
+        }
+
+        for (k = 0; k < tq -> npairs; k++){
+            idx = (tq -> cursor[prio] + k) % tq -> npairs;
+            pair = tq -> pairs[idx];
+            job = pair -> small_head[prio] ? pair -> small_head[prio] : pair -> head[prio];
+            if (job == NULL || pair -> active >= tq -> max_per_pair || pair -> blocked_pass == tq -> pass){
+                continue;
+            }
+
+            rc = handle_pool_acquire(tq -> pool, pair -> key, 0, 0.0, &entry, &gridftp_result);
+            if (rc == 0 && entry == NULL){
+                pair -> blocked_pass = tq -> pass;
+                continue;
+            }
+
+            n = 1;
+            if (job == pair -> small_head[prio]){
+                for (last = job; n < tq -> batch_max && last -> next; last = last -> next){
+                    n++;
+                }
+                pair -> small_head[prio] = last -> next;
+                if (pair -> small_head[prio] == NULL){
+                    pair -> small_tail[prio] = NULL;
+                }
+                last -> next = NULL;
+            } else{
+                pair -> head[prio] = job -> next;
+                if (pair -> head[prio] == NULL){
+                    pair -> tail[prio] = NULL;
+                }
+                job -> next = NULL;
+            }
+            job -> entry = entry;
+            tq -> queued_per_priority[prio] -= n;
+            tq -> queued -= n;
+            pair -> active++;
+            tq -> active++;
+            tq -> cursor[prio] = (idx + 1) % tq -> npairs;
+
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void transfer_queue_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error);
+
+static void transfer_queue_size_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error);
+
+// start the operation for a job of a transfer queue on the handle it
+// was given: a size query if the size policy still needs its size, a
+// pipelined transfer for a run of small files, a partial transfer for
+// a chunk, or else a transfer of the whole file; no lock may be held
+//
+// returns the result of Globus, with what set to the operation tried
+static globus_result_t transfer_queue_start(transfer_queue_t * tq, transfer_job_t * job, const char ** what)
+{
+    pipeline_batch_t * batch;
+    transfer_job_t * j;
+    globus_result_t gridftp_result;
+    globus_bool_t sizing;
+    int n;
+
+    globus_mutex_lock(&(tq -> mutex));
+    sizing = tq -> sizing;
+    globus_mutex_unlock(&(tq -> mutex));
+
+    if (sizing && !(job -> sized)){
+        *what = "size query";
+        job -> sized = GLOBUS_TRUE;
+        return globus_ftp_client_size(
+                    &(job -> entry -> handle),
+                    job -> src,
+                    tq -> has_src_attr ? &(tq -> src_attr) : NULL,
+                    &(job -> size),
+                    transfer_queue_size_callback,
+                    (void *) job
+                    );
+    }
+
+    if (job -> next){
+        *what = "pipelined third party transfer";
+
+        for (n = 0, j = job; j; j = j -> next){
+            n++;
+        }
+
+        // the batch points at the URLs of the jobs, which stay put
+        // until the jobs are reported
+        batch = (pipeline_batch_t *) globus_malloc(sizeof(pipeline_batch_t));
+        if (batch == NULL){
+            return GLOBUS_FAILURE;
+        }
+        memset(batch, 0, sizeof(pipeline_batch_t));
+        batch -> handle = &(job -> entry -> handle);
+        batch -> src = (char **) globus_malloc(sizeof(char *) * n);
+        batch -> dst = (char **) globus_malloc(sizeof(char *) * n);
+        if (batch -> src == NULL || batch -> dst == NULL){
+            globus_libc_free(batch -> src);
+            globus_libc_free(batch -> dst);
+            globus_libc_free(batch);
+            return GLOBUS_FAILURE;
+        }
+        for (n = 0, j = job; j; j = j -> next, n++){
+            batch -> src[n] = j -> src;
+            batch -> dst[n] = j -> dst;
+        }
+        batch -> npairs = n;
+        batch -> jobs = job;
+        batch -> issued = 1;
+
+        // the handle is leased from the pool, so no other batch can be
+        // in progress on it
+        globus_mutex_lock(&(pipeline_registry.mutex));
+        batch -> next = pipeline_registry.batches;
+        pipeline_registry.batches = batch;
+        globus_mutex_unlock(&(pipeline_registry.mutex));
+
+        gridftp_result = globus_ftp_client_third_party_transfer(
+                            batch -> handle,
+                            job -> src,
+                            tq -> has_src_attr ? &(tq -> src_attr) : NULL,
+                            job -> dst,
+                            tq -> has_dst_attr ? &(tq -> dst_attr) : NULL,
+                            NULL,
+                            pipeline_complete_callback,
+                            (void *) batch
+                            );
+
+        if (gridftp_result != GLOBUS_SUCCESS){
+            pipeline_registry_remove(batch);
+            globus_libc_free(batch -> src);
+            globus_libc_free(batch -> dst);
+            globus_libc_free(batch);
+            return gridftp_result;
+        }
+
+        globus_mutex_lock(&(tq -> mutex));
+        tq -> batches++;
+        globus_mutex_unlock(&(tq -> mutex));
+
+        return GLOBUS_SUCCESS;
+    }
+
+    if (job -> parent){
+        *what = "partial third party transfer";
+        gridftp_result = globus_ftp_client_partial_third_party_transfer(
+                            &(job -> entry -> handle),
+                            job -> src,
+                            tq -> has_src_attr ? &(tq -> src_attr) : NULL,
+                            job -> dst,
+                            tq -> has_dst_attr ? &(tq -> dst_attr) : NULL,
+                            NULL,
+                            job -> offset,
+                            job -> end,
+                            transfer_queue_complete_callback,
+                            (void *) job
+                            );
+
+        if (gridftp_result == GLOBUS_SUCCESS){
+            globus_mutex_lock(&(tq -> mutex));
+            tq -> chunks++;
+            globus_mutex_unlock(&(tq -> mutex));
+        }
+
+        return gridftp_result;
+    }
+
+    *what = "third party transfer";
+    return globus_ftp_client_third_party_transfer(
+                &(job -> entry -> handle),
+                job -> src,
+                tq -> has_src_attr ? &(tq -> src_attr) : NULL,
+                job -> dst,
+                tq -> has_dst_attr ? &(tq -> dst_attr) : NULL,
+                NULL,
+                transfer_queue_complete_callback,
+                (void *) job
+                );
+}
+
+// callback that tries again to start the jobs of a transfer queue after
+// the handle pool had no handle for any of them
+static void transfer_queue_retry_callback(void * user_arg);
+
+// start as many jobs of a transfer queue as the limits allow; no lock
+// may be held
+static void transfer_queue_schedule(transfer_queue_t * tq)
+{
+    transfer_job_t * job;
+    transfer_job_t * next;
+    transfer_pair_t * pair;
+    globus_bool_t retry = GLOBUS_FALSE;
+    globus_result_t gridftp_result;
+    globus_reltime_t delay;
+    const char * what = "third party transfer";
+    char msg[2048] = "";
+
+    globus_mutex_lock(&(tq -> mutex));
+    tq -> pass++;
+    globus_mutex_unlock(&(tq -> mutex));
+
+    while (1){
+        globus_mutex_lock(&(tq -> mutex));
+
+        job = NULL;
+        if (!(tq -> closed) && tq -> active < tq -> max_active){
+            job = transfer_queue_pick(tq);
+        }
+
+        // with nothing running no completion will come to start the
+        // jobs left, so make sure something does
+        if (job == NULL){
+            if (!(tq -> closed) && tq -> active == 0 && tq -> queued > 0 && !(tq -> retry_pending)){
+                tq -> retry_pending = GLOBUS_TRUE;
+                tq -> pending++;
+                retry = GLOBUS_TRUE;
+            }
+            globus_mutex_unlock(&(tq -> mutex));
+            break;
+        }
+
+        globus_mutex_unlock(&(tq -> mutex));
+
+        pair = job -> pair;
+        if (job -> entry){
+            gridftp_result = transfer_queue_start(tq, job, &what);
+
+            if (gridftp_result == GLOBUS_SUCCESS){
+                continue;
+            }
+
+            handle_pool_put(job -> entry, 0);
+            sprintf(msg, "gridftpwrapper: rc = %d: unable to start %s", gridftp_result, what);
+        } else{
+            sprintf(msg, "gridftpwrapper: unable to initialize handle");
+        }
+
+        // a run of small files fails as a whole
+        while (job){
+            next = job -> next;
+            transfer_queue_report(job, msg);
+            job = next;
+        }
+
+        globus_mutex_lock(&(tq -> mutex));
+        pair -> active--;
+        tq -> active--;
+        globus_cond_broadcast(&(tq -> cond));
+        globus_mutex_unlock(&(tq -> mutex));
+    }
+
+    if (retry){
+        GlobusTimeReltimeSet(delay, 0, TRANSFER_QUEUE_RETRY_USEC);
+        if (globus_callback_register_oneshot(NULL, &delay, transfer_queue_retry_callback, (void *) tq) != GLOBUS_SUCCESS){
+            globus_mutex_lock(&(tq -> mutex));
+            tq -> retry_pending = GLOBUS_FALSE;
+            tq -> pending--;
+            globus_cond_broadcast(&(tq -> cond));
+            globus_mutex_unlock(&(tq -> mutex));
+        }
+    }
+}
+
+// callback that starts more jobs of a transfer queue after one of its
+// transfers completed, outside of the callbacks of the handle
+static void transfer_queue_schedule_callback(void * user_arg)
+{
+    transfer_queue_t * tq = (transfer_queue_t *) user_arg;
+
+    transfer_queue_schedule(tq);
+
+    globus_mutex_lock(&(tq -> mutex));
+    tq -> pending--;
+    globus_cond_broadcast(&(tq -> cond));
+    globus_mutex_unlock(&(tq -> mutex));
+}
+
+static void transfer_queue_retry_callback(void * user_arg)
+{
+    transfer_queue_t * tq = (transfer_queue_t *) user_arg;
+
+    globus_mutex_lock(&(tq -> mutex));
+    tq -> retry_pending = GLOBUS_FALSE;
+    globus_mutex_unlock(&(tq -> mutex));
+
+    transfer_queue_schedule_callback(user_arg);
+}
+
+// callback for the completion of a transfer started by a transfer queue
+//
+// the handle goes back to the pool, discarded if its server could not
+// be reached, the job is reported and the next jobs are started from a
+// oneshot callback
+static void transfer_queue_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    transfer_job_t * job = (transfer_job_t *) user_data;
+    transfer_queue_t * tq = job -> queue;
+    transfer_pair_t * pair = job -> pair;
+    char * text = NULL;
+
+    if (error){
+        text = globus_error_print_chain(error);
+    }
+
+    handle_pool_put(job -> entry, error && gridftp_error_ftp_code(error) == 0);
+    transfer_queue_report(job, error ? (text ? text : "gridftpwrapper: transfer failed") : NULL);
+    globus_libc_free(text);
+
+    globus_mutex_lock(&(tq -> mutex));
+    pair -> active--;
+    tq -> active--;
+    tq -> pending++;
+    globus_cond_broadcast(&(tq -> cond));
+    globus_mutex_unlock(&(tq -> mutex));
+
+    if (globus_callback_register_oneshot(NULL, NULL, transfer_queue_schedule_callback, (void *) tq) != GLOBUS_SUCCESS){
+        transfer_queue_schedule_callback((void *) tq);
+    }
+
+    return;
+}
+
+// callback for the completion of a size query started by a transfer
+// queue under its size policy
+//
+// the handle goes back to the pool and the job is queued again at the
+// head of its pair, whole, in chunks or with the small files as its
+// size calls for. If the size could not be had the file is transferred
+// whole, and a server that cannot be reached fails it then
+static void transfer_queue_size_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error)
+{
+    transfer_job_t * job = (transfer_job_t *) user_data;
+    transfer_queue_t * tq = job -> queue;
+    transfer_pair_t * pair = job -> pair;
+
+    handle_pool_put(job -> entry, error && gridftp_error_ftp_code(error) == 0);
+    job -> entry = NULL;
+    if (error){
+        job -> size = -1;
+    }
+
+    globus_mutex_lock(&(tq -> mutex));
+    transfer_queue_enqueue(tq, job, GLOBUS_TRUE);
+    pair -> active--;
+    tq -> active--;
+    tq -> pending++;
+    globus_cond_broadcast(&(tq -> cond));
+    globus_mutex_unlock(&(tq -> mutex));
+
+    if (globus_callback_register_oneshot(NULL, NULL, transfer_queue_schedule_callback, (void *) tq) != GLOBUS_SUCCESS){
+        transfer_queue_schedule_callback((void *) tq);
+    }
+
+    return;
+}
+
+static void transfer_queue_batch_complete(pipeline_batch_t * batch, globus_object_t * error)
+{
+    transfer_job_t * job = batch -> jobs;
+    transfer_queue_t * tq = job -> queue;
+    transfer_pair_t * pair = job -> pair;
+    transfer_job_t * requeue = NULL;
+    transfer_job_t * next;
+    int issued = batch -> issued;
+    char * text = NULL;
+    int i;
+
+    if (error){
+        text = globus_error_print_chain(error);
+    }
+
+    handle_pool_put(job -> entry, error && gridftp_error_ftp_code(error) == 0);
+
+    globus_libc_free(batch -> src);
+    globus_libc_free(batch -> dst);
+    globus_libc_free(batch);
+
+    // the files handed to Globus are reported, all with the error if
+    // there is one since which of them completed is not known; the rest
+    // were never started, as when the handle attributes of the pool do
+    // not pipeline, and are queued again
+    for (i = 0; job; i++, job = next){
+        next = job -> next;
+        job -> next = NULL;
+        job -> entry = NULL;
+        if (i < issued){
+            transfer_queue_report(job, error ? (text ? text : "gridftpwrapper: transfer failed") : NULL);
+        } else{
+            if (requeue == NULL){
+                requeue = job;
+            }
+            job -> next = next;
+        }
+    }
+    globus_libc_free(text);
+
+    globus_mutex_lock(&(tq -> mutex));
+    for (job = requeue; job; job = next){
+        next = job -> next;
+        job -> next = NULL;
+        transfer_queue_enqueue(tq, job, GLOBUS_FALSE);
+    }
+    pair -> active--;
+    tq -> active--;
+    tq -> pending++;
+    globus_cond_broadcast(&(tq -> cond));
+    globus_mutex_unlock(&(tq -> mutex));
+
+    if (globus_callback_register_oneshot(NULL, NULL, transfer_queue_schedule_callback, (void *) tq) != GLOBUS_SUCCESS){
+        transfer_queue_schedule_callback((void *) tq);
+    }
+}
+
+// callback for performance marker plugin that is called
+// when a transfer starts
+static void perf_plugin_begin_cb(
+    void * user_specific,
+    globus_ftp_client_handle_t * handle,
+    const char * source_url,
+    const char * dest_url,
+    globus_bool_t restart)
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    completion_record_t * record;
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+
+    // hand the event to a completion queue, without taking the GIL, if a
+    // queue was given in place of a callback function; the record keeps
+    // the callback bucket, and with it the queue and argument, until drained
+    record = completion_queue_record(callbackBucket -> begincb, COMPLETION_PERF_BEGIN, callbackBucket -> userarg, 0, handle, NULL);
+    if (record){
+        __atomic_add_fetch(&(callbackBucket -> refs), 1, __ATOMIC_SEQ_CST);
+        record -> owner = (void *) callbackBucket;
+        record -> text[0] = source_url ? globus_libc_strdup(source_url) : NULL;
+        record -> text[1] = dest_url ? globus_libc_strdup(dest_url) : NULL;
+        record -> values[0] = (globus_off_t) restart;
+        completion_queue_push(record);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> begincb;
+    arg = callbackBucket -> userarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOssi)", arg, handleObj, source_url, dest_url, (int) restart);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    return;
+
+}
+
+// callback for performance marker plugin that is called
+// each time a performance marker is received
+static void perf_plugin_marker_cb(
+    void * user_specific,
+    globus_ftp_client_handle_t * handle,
+    long time_stamp_int,
+    char time_stamp_tenth,
+    int stripe_ndx,
+    int num_stripes,
+    globus_off_t nbytes)
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    completion_record_t * record;
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+
+    // hand the event to a completion queue, without taking the GIL, if a
+    // queue was given in place of a callback function; the record keeps
+    // the callback bucket, and with it the queue and argument, until drained
+    record = completion_queue_record(callbackBucket -> markercb, COMPLETION_PERF_MARKER, callbackBucket -> userarg, 0, handle, NULL);
+    if (record){
+        __atomic_add_fetch(&(callbackBucket -> refs), 1, __ATOMIC_SEQ_CST);
+        record -> owner = (void *) callbackBucket;
+        record -> values[0] = (globus_off_t) time_stamp_int;
+        record -> values[1] = (globus_off_t) time_stamp_tenth;
+        record -> values[2] = (globus_off_t) stripe_ndx;
+        record -> values[3] = (globus_off_t) num_stripes;
+        record -> values[4] = nbytes;
+        completion_queue_push(record);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> markercb;
+    arg = callbackBucket -> userarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOlbiil)", 
+        arg, handleObj, time_stamp_int, time_stamp_tenth, 
+        stripe_ndx, num_stripes, (long) nbytes);
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    return;
+
+}
+
+// callback for performance marker plugin that is called
+// when a transfer completes
+static void perf_plugin_complete_cb(
+    void * user_specific,
+    globus_ftp_client_handle_t * handle,
+    globus_bool_t success)
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    completion_record_t * record;
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    perf_plugin_callback_bucket_t * callbackBucket = (perf_plugin_callback_bucket_t *) user_specific;
+
+    // hand the event to a completion queue, without taking the GIL, if a
+    // queue was given in place of a callback function; the record keeps
+    // the callback bucket, and with it the queue and argument, until drained
+    record = completion_queue_record(callbackBucket -> completecb, COMPLETION_PERF_COMPLETE, callbackBucket -> userarg, 0, handle, NULL);
+    if (record){
+        __atomic_add_fetch(&(callbackBucket -> refs), 1, __ATOMIC_SEQ_CST);
+        record -> owner = (void *) callbackBucket;
+        record -> values[0] = (globus_off_t) success;
+        completion_queue_push(record);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> completecb;
+    arg = callbackBucket -> userarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // prepare the arg list to pass into the Python callback function
+    arglist = Py_BuildValue("(OOi)", arg, handleObj, (int) success );
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    return;
+}
+
+// callback for the completion of exists operation
+static void exists_complete_callback(void * user_data, globus_ftp_client_handle_t * handle, globus_object_t * error) 
+{
+    PyObject * func;
+    PyObject * arglist; 
+    PyObject * result; 
+    PyObject * arg;
+    PyObject * handleObj;
+    PyObject * errorObject;
+    completion_record_t * record;
+
+
+    // cast the user_data that the GridFTP libraries are passing in to the
+    // callback structure where we previously stored the Python function and
+    // arguments to call
+    exists_callback_bucket_t * callbackBucket = (exists_callback_bucket_t *) user_data;
+
+    // hand the completion to a completion queue, without taking the
+    // GIL, if a queue was given in place of a callback function
+    record = completion_queue_record(callbackBucket -> pyfunction, COMPLETION_EXISTS, callbackBucket -> pyarg, 1, handle, error);
+    if (record){
+        record -> values[0] = error ? gridftp_error_reply_code(error) : 0;
+        record -> values[1] = callbackBucket -> with_code;
+        completion_queue_push(record);
+        free(callbackBucket);
+        return;
+    }
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    // pick off the function and argument pointers we want to pass back into Python
+    func = callbackBucket -> pyfunction;
+    arg = callbackBucket -> pyarg;
+
+    // create a handle object to pass back into Python
+    handleObj = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    // create an error object to pass back into Python
+    if (error){
+        errorObject = Py_BuildValue("s", globus_error_print_chain(error));
+    } else{
+        errorObject = Py_BuildValue("s", NULL);
+    }
+
+    // prepare the arg list to pass into the Python callback function,
+    // with the FTP reply code of the error, or 0, last if asked for
+    if (callbackBucket -> with_code){
+        arglist = Py_BuildValue("(OOOi)", arg, handleObj, errorObject, error ? gridftp_error_reply_code(error) : 0);
+    } else{
+        arglist = Py_BuildValue("(OOO)", arg, handleObj, errorObject);
+    }
+
+    // now call the Python callback function
+    result = PyEval_CallObject(func, arglist);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    // take care of reference handling
+    Py_DECREF(handleObj);
+    Py_DECREF(arglist);
+    Py_XDECREF(result);
+    Py_XDECREF(errorObject);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    // free the space the callback bucket was holding
+    free(callbackBucket);
+
+    return;
+}
+
+// callback registered by gridftp_callback_oneshot
+static void oneshot_callback(void * user_arg)
+{
+    PyObject * result;
+
+    oneshot_callback_bucket_t * callbackBucket = (oneshot_callback_bucket_t *) user_arg;
+
+    // we need to obtain the Python GIL before this thread can manipulate any Python object
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    result = PyEval_CallObject(callbackBucket -> pyfunction, callbackBucket -> pyargs);
+
+    if (result == NULL) {
+
+        // something went wrong so print to stderr
+        PyErr_Print();
+    }
+
+    Py_XDECREF(result);
+    Py_DECREF(callbackBucket -> pyfunction);
+    Py_DECREF(callbackBucket -> pyargs);
+
+    // release the Python GIL from this thread
+    PyGILState_Release(gstate);
+
+    free(callbackBucket);
+}
+
+
+
+//
+// This section of the code is for functions called 
+// by the Python module.
+//
+//
+//
+//
+//
+
+
+// activate the Globus modules
+PyObject * gridftp_modules_activate(PyObject * self, PyObject * args)
+{
+    int           i;
+    int           rc;
+
+    // this is new with Globus 5.2.x
+    Py_BEGIN_ALLOW_THREADS
+	globus_thread_set_model("pthread");
+    Py_END_ALLOW_THREADS
+	
+
+
+    for (i = 0; i < NMODS; i++){
+    
+        Py_BEGIN_ALLOW_THREADS
+
+        rc = globus_module_activate(modules[i]);
+
+        Py_END_ALLOW_THREADS
+
+        if (rc != GLOBUS_SUCCESS) {
+	  PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to activate Globus module");
+        }
+    }
+
+    // one of the globus modules changes the signal handling behavior.
+    // http://jira.globus.org/browse/GT-360
+    // The next line ensures that any forked subprocesses still catch
+    // SIGTERM, SIGHUP, SIGINT. Without this line, these signals are
+    // not passed along and forked processes will miss these messages.
+    Py_BEGIN_ALLOW_THREADS
+      pthread_atfork(&prepare, &parent, &child);
+    Py_END_ALLOW_THREADS
+
+
+    Py_RETURN_NONE;
+}
+
+// deactivate the Globus modules
+PyObject * gridftp_modules_deactivate(PyObject * self, PyObject * args)
+{
+    int   i;
+
+    for (i = NMODS - 1; i >= 0; i--){
+
+        Py_BEGIN_ALLOW_THREADS
+
+        globus_module_deactivate(modules[i]);
+
+        Py_END_ALLOW_THREADS
+
+    }
+    
+    Py_RETURN_NONE;
+}
+
+// create a buffer for storing data from a get or put operation
+// and return a wrapped pointer to the buffer
+//
+// the buffer comes from the buffer pool; the size class it belongs to
+// is stored as the description of the wrapped pointer so that
+// gridftp_destroy_buffer can return it to the right free list. Zeroing
+// the buffer is optional since Globus overwrites it anyway
+PyObject * gridftp_create_buffer(PyObject * self, PyObject * args)
+{
+
+    globus_byte_t * buffer = NULL;
+    buffer_pool_class_t * bufclass = NULL;
+    unsigned long size;
+    int zero = 1;
+    char msg[2048] = "";
+
+    PyObject * bufferObj;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "k|i", &size, &zero)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    // allocate the memory
+    Py_BEGIN_ALLOW_THREADS
+
+    buffer = buffer_pool_alloc((globus_size_t) size, zero, &bufclass);
+
+    Py_END_ALLOW_THREADS
+
+    if (buffer == NULL) {
+        sprintf(msg, "gridftpwrapper: unable to create buffer");
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // wrap pointer to buffer and return
+    bufferObj = PyCObject_FromVoidPtrAndDesc((void *) buffer, (void *) bufclass, NULL);
+
+    return bufferObj;
+}
+
+// destroy a buffer previously created
+PyObject * gridftp_destroy_buffer(PyObject * self, PyObject * args)
+{
+
+    globus_byte_t * buffer = NULL;
+    buffer_pool_class_t * bufclass = NULL;
+    PyObject * bufferObj;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &bufferObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
+    bufclass = (buffer_pool_class_t *) PyCObject_GetDesc(bufferObj);
+
+    // return the memory to the pool, or free it if it did not come
+    // from the pool
+    Py_BEGIN_ALLOW_THREADS
+
+    if (bufclass){
+        buffer_pool_free(bufclass, buffer);
+    } else {
+        globus_libc_free(buffer);
+    }
+
+    Py_END_ALLOW_THREADS
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// set the options of the buffer pool
+PyObject * gridftp_buffer_pool_configure(PyObject * self, PyObject * args)
+{
+    int use_hugepages = 0;
+    unsigned long max_idle = 0;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "ik", &use_hugepages, &max_idle)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    globus_mutex_lock(&(buffer_pool.mutex));
+    buffer_pool.use_hugepages = use_hugepages;
+    buffer_pool.max_idle = max_idle;
+    globus_mutex_unlock(&(buffer_pool.mutex));
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// release all idle buffers held by the buffer pool
+PyObject * gridftp_buffer_pool_trim(PyObject * self, PyObject * args)
+{
+    Py_BEGIN_ALLOW_THREADS
+
+    buffer_pool_trim();
+
+    Py_END_ALLOW_THREADS
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// return the statistics of the buffer pool as a list of dictionaries,
+// one for each size class that has been used
+PyObject * gridftp_buffer_pool_stats(PyObject * self, PyObject * args)
+{
+    PyObject * statsList;
+    PyObject * classDict;
+    buffer_pool_class_t snapshot[BUFFER_POOL_NCLASSES];
+    int i;
+
+    globus_mutex_lock(&(buffer_pool.mutex));
+    memcpy(snapshot, buffer_pool.classes, sizeof(buffer_pool_class_t) * buffer_pool.nclasses);
+    globus_mutex_unlock(&(buffer_pool.mutex));
+
+    statsList = PyList_New(0);
+
+    for (i = 0; i < buffer_pool.nclasses; i++){
+        if (snapshot[i].hits == 0 && snapshot[i].misses == 0){
+            continue;
+        }
+
+        classDict = Py_BuildValue("{s:k,s:k,s:k,s:k,s:k,s:k}",
+            "size", (unsigned long) snapshot[i].size,
+            "used", snapshot[i].nused,
+            "idle", snapshot[i].nidle,
+            "hits", snapshot[i].hits,
+            "misses", snapshot[i].misses,
+            "hugepage_misses", snapshot[i].hugemisses);
+        PyList_Append(statsList, classDict);
+        Py_DECREF(classDict);
+    }
+
+    return statsList;
+}
+
+// return a Python string representation of the data in a buffer
+PyObject * gridftp_buffer_to_string(PyObject * self, PyObject * args)
+{
+
+    globus_byte_t * buffer = NULL;
+    unsigned long size;
+    PyObject * bufferObj;
+    PyObject * pyString;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Ok", &bufferObj, &size)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
+
+    // free the memory
+    Py_BEGIN_ALLOW_THREADS
+
+    pyString = PyString_FromStringAndSize((char*) buffer, size);
+
+    Py_END_ALLOW_THREADS
+
+    return pyString; 
+}
+
+// initialize a handle attribute and return a wrapped pointer
+// to it
+PyObject * gridftp_handleattr_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t  * handle_attr = NULL;
+    globus_result_t gridftp_result;
+    PyObject * handleAttr = NULL;
+    char msg[2048] = "";
+
+    handle_attr = (globus_ftp_client_handleattr_t *) globus_malloc(sizeof(globus_ftp_client_handleattr_t));
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handleattr_init(handle_attr);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle attribute", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+
+    // wrap pointer to handle attribute and return
+    handleAttr = PyCObject_FromVoidPtr((void *) handle_attr, NULL);
+
+    return handleAttr;
+}
+
+// initialize a handle and return a wrapper pointer to it
+PyObject * gridftp_handle_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handle = NULL;
+    globus_ftp_client_handleattr_t * handle_attr = NULL;
+    PyObject * handleAttr = NULL;
+    PyObject * handleObject = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &handleAttr)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle attr object");
+        return NULL;
+    }
+ 
+    if PyCObject_Check(handleAttr){
+        handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+    } else {
+        sprintf(msg, "gridftpwrapper: unable to obtain pointer to handle_attr");
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    handle = (globus_ftp_client_handle_t *) globus_malloc(sizeof(globus_ftp_client_handle_t));
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handle_init(handle, handle_attr);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+
+    // wrap pointer to handle and return
+    handleObject = PyCObject_FromVoidPtr((void *) handle, NULL);
+
+    return handleObject;
+
+}
+
+// destroy a previously created handle attribute
+PyObject * gridftp_handleattr_destroy(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t * handle_attr = NULL;
+    PyObject * handleAttr = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &handleAttr)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle attr object");
+        return NULL;
+    }
+ 
+    handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handleattr_destroy(handle_attr);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy handle attr", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the 'cache all' setting on a handle attribute
+PyObject * gridftp_handleattr_set_cache_all(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t * handle_attr = NULL;
+    PyObject * handleAttr = NULL;
+    int cache_all;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &handleAttr, &cache_all)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to arguments");
+        return NULL;
+    }
+ 
+    handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handleattr_set_cache_all(handle_attr, (globus_bool_t) cache_all);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set cache all boolean", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// turn on command pipelining for handles created from a handle attr
+//
+// up to outstanding transfers may have their commands sent ahead on
+// one session; the pairs after the first come from the wrapper's
+// pipeline callback, which serves the batch started with
+// gridftp_third_party_transfer_pipelined on the handle
+PyObject * gridftp_handleattr_set_pipeline(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t * handle_attr = NULL;
+    PyObject * handleAttr = NULL;
+    int outstanding;
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &handleAttr, &outstanding)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (outstanding < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: outstanding must be positive");
+        return NULL;
+    }
+
+    handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handleattr_set_pipeline(handle_attr, (globus_size_t) outstanding, pipeline_callback, NULL);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set pipeline", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// destroy a previously created handle
+PyObject * gridftp_handle_destroy(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handle = NULL;
+    PyObject * handleObject = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &handleObject)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle object");
+        return NULL;
+    }
+ 
+    handle = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObject);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handle_destroy(handle);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy handle", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// mark the connection to the server of a URL to be cached by a handle,
+// so that it is kept open between operations
+PyObject * gridftp_handle_cache_url_state(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handle = NULL;
+    PyObject * handleObject = NULL;
+    char * url = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Os", &handleObject, &url)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    handle = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObject);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handle_cache_url_state(handle, url);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to cache url state", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// stop caching the connection to the server of a URL on a handle,
+// closing it if it is idle
+PyObject * gridftp_handle_flush_url_state(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handle = NULL;
+    PyObject * handleObject = NULL;
+    char * url = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Os", &handleObject, &url)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    handle = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObject);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_handle_flush_url_state(handle, url);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to flush url state", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// initialize an operation attribute and return a wrapped pointer
+// to it
+PyObject * gridftp_operationattr_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t  * operation_attr = NULL;
+    globus_result_t gridftp_result;
+    PyObject * opAttr = NULL;
+    char msg[2048] = "";
+
+    operation_attr = (globus_ftp_client_operationattr_t *) globus_malloc(sizeof(globus_ftp_client_operationattr_t));
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_operationattr_init(operation_attr);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize operation attribute", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // wrap pointer to operation attribute and return
+    opAttr = PyCObject_FromVoidPtr((void *) operation_attr, NULL);
+
+    return opAttr;
+}
+
+// destroy a previously created operation attribute
+PyObject * gridftp_operationattr_destroy(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t * operation_attr = NULL;
+    PyObject * opAttr = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &opAttr)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse operation attr object");
+        return NULL;
+    }
+ 
+    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_operationattr_destroy(operation_attr);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy operation attr", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the mode on an operation attribute
+PyObject * gridftp_operationattr_set_mode(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t * operation_attr = NULL;
+    PyObject * opAttr = NULL;
+    int mode = -1;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &opAttr, &mode)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_operationattr_set_mode(operation_attr, (globus_ftp_control_mode_t) mode);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set mode", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the parallelism for an operation attribute
+PyObject * gridftp_operationattr_set_parallelism(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t * operation_attr = NULL;
+    globus_ftp_control_parallelism_t * parallelism = NULL;
+    PyObject * opAttr = NULL;
+    PyObject * parallelObj = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OO", &opAttr, &parallelObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
+    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelObj);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_operationattr_set_parallelism(operation_attr, parallelism);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set parallelism", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+
+
+// FIXME
+PyObject * gridftp_operationattr_set_disk_stack(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t * operation_attr = NULL;
+    PyObject * opAttr = NULL;
+    char * driver_list="";
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Os", &opAttr, &driver_list)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
+
+    Py_BEGIN_ALLOW_THREADS
+    gridftp_result = globus_ftp_client_operationattr_set_disk_stack(operation_attr, driver_list);
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set_disk_stack", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+
+// set the tcp buffer for an operation attribute
+PyObject * gridftp_operationattr_set_tcp_buffer(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_operationattr_t * operation_attr = NULL;
+    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
+    PyObject * opAttr = NULL;
+    PyObject * tcpbufferObj = NULL;
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OO", &opAttr, &tcpbufferObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
+    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_operationattr_set_tcp_buffer(operation_attr, tcpbuffer);
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to set tcpbuffer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// initialize a parallelism type and return a wrapper pointer to it
+PyObject * gridftp_parallelism_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_parallelism_t  * parallelism = NULL;
+    PyObject * parallelismObj = NULL;
+    char msg[2048] = "";
+
+    parallelism = (globus_ftp_control_parallelism_t *) globus_malloc(sizeof(globus_ftp_control_parallelism_t));
+
+    if (parallelism == NULL){
+        sprintf(msg, "gridftpwrapper: unable to initialize parallelism");
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // wrap pointer to parallelism_t and return
+    parallelismObj = PyCObject_FromVoidPtr((void *) parallelism, NULL);
+
+    return parallelismObj;
+}
+
+// destroy a previously created parallelism type
+PyObject * gridftp_parallelism_destroy(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_parallelism_t * parallelism = NULL;
+    PyObject * parallelismObj = NULL;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &parallelismObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
+
+    free(parallelism);
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the mode on a parallelism type
+PyObject * gridftp_parallelism_set_mode(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_parallelism_t * parallelism = NULL;
+    PyObject * parallelismObj = NULL;
+    int mode = -1;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &parallelismObj, &mode)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
+    parallelism -> mode = mode;
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the size on a parallelism type
+PyObject * gridftp_parallelism_set_size(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_parallelism_t * parallelism = NULL;
+    PyObject * parallelismObj = NULL;
+    int size = -1;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &parallelismObj, &size)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
+    parallelism -> fixed.size = size;
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// initialize a tcpbuffer type and return a wrapped pointer to it
+PyObject * gridftp_tcpbuffer_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_tcpbuffer_t  * tcpbuffer = NULL;
+    PyObject * tcpbufferObj = NULL;
+    char msg[2048] = "";
+
+    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) globus_malloc(sizeof(globus_ftp_control_tcpbuffer_t));
+
+    if (tcpbuffer == NULL){
+        sprintf(msg, "gridftpwrapper: unable to initialize tcpbuffer");
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // wrap pointer to tcpbuffer_t and return
+    tcpbufferObj = PyCObject_FromVoidPtr((void *) tcpbuffer, NULL);
+
+    return tcpbufferObj;
+}
+
+// destroy a previously created tcpbuffer type
+PyObject * gridftp_tcpbuffer_destroy(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
+    PyObject * tcpbufferObj = NULL;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &tcpbufferObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+
+    free(tcpbuffer);
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the mode for a tcpbuffer type
+PyObject * gridftp_tcpbuffer_set_mode(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
+    PyObject * tcpbufferObj = NULL;
+    int mode = -1;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &tcpbufferObj, &mode)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+    tcpbuffer -> mode = mode;
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// set the size for a tcpbuffer type
+PyObject * gridftp_tcpbuffer_set_size(PyObject *self, PyObject *args)
+{
+    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
+    PyObject * tcpbufferObj = NULL;
+    int size = -1;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &tcpbufferObj, &size)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+    tcpbuffer -> fixed.size = size;
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// initialize a third party transfer
+PyObject * gridftp_third_party_transfer(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * src_operation_attrp = NULL;
+    char * dst = NULL;
+    globus_ftp_client_operationattr_t * dst_operation_attrp = NULL;
+    restart_marker_t * restart_markerp = NULL;
+
+    PyObject * handleObj;
+    PyObject * srcOpAttrObj;
+    PyObject * dstOpAttrObj;
+    PyObject * restartMarkerObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    third_party_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOsOOOO", 
+            &handleObj, 
+            &src, 
+            &srcOpAttrObj,
+            &dst,
+            &dstOpAttrObj,
+            &restartMarkerObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    src_operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(srcOpAttrObj);
+    dst_operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(dstOpAttrObj);
+    if (gridftp_restart_marker_from_object(restartMarkerObj, &restart_markerp) != 0){
+        return NULL;
+    }
+
+    // create a third party callback struct to hold the callback information
+    callbackBucket = (third_party_callback_bucket_t *) globus_malloc(sizeof(third_party_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the third party transfer 
+
+    Py_BEGIN_ALLOW_THREADS
+
+    // Globus copies the restart marker when the transfer starts
+    if (restart_markerp){
+        globus_mutex_lock(&(restart_markerp -> mutex));
+    }
+
+    gridftp_result = globus_ftp_client_third_party_transfer(
+                        handlep,
+                        src,
+                        src_operation_attrp,
+                        dst,
+                        dst_operation_attrp,
+                        restart_markerp ? &(restart_markerp -> marker) : NULL,
+                        third_party_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    if (restart_markerp){
+        globus_mutex_unlock(&(restart_markerp -> mutex));
+    }
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start third party transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+    
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a pipelined third party transfer of a list of (source,
+// destination) pairs over one handle, which must have been created from
+// handle attributes with pipelining turned on
+//
+// the first pair starts the transfer and Globus asks for the others
+// through the pipeline callback, so the commands of many transfers are
+// in flight on the session at once. The Python callback is called once
+// per pair, with (arg, src, dst, error), when the whole batch completes
+PyObject * gridftp_third_party_transfer_pipelined(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    globus_ftp_client_operationattr_t * src_operation_attrp = NULL;
+    globus_ftp_client_operationattr_t * dst_operation_attrp = NULL;
+    pipeline_batch_t * batch;
+    pipeline_batch_t * other;
+    char * src;
+    char * dst;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    PyObject * handleObj;
+    PyObject * pairsObj;
+    PyObject * pairsSeq;
+    PyObject * srcOpAttrObj;
+    PyObject * dstOpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOOOOO",
+            &handleObj,
+            &pairsObj,
+            &srcOpAttrObj,
+            &dstOpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    src_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(srcOpAttrObj);
+    dst_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(dstOpAttrObj);
+
+    pairsSeq = PySequence_Fast(pairsObj, "gridftpwrapper: pairs must be a sequence");
+    if (pairsSeq == NULL){
+        return NULL;
+    }
+
+    n = PySequence_Fast_GET_SIZE(pairsSeq);
+    if (n < 1){
+        Py_DECREF(pairsSeq);
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: no pairs to transfer");
+        return NULL;
+    }
+
+    // the batch keeps its own copy of the URLs, which Globus uses until
+    // the batch completes
+    batch = (pipeline_batch_t *) globus_malloc(sizeof(pipeline_batch_t));
+    memset(batch, 0, sizeof(pipeline_batch_t));
+    batch -> handle = handlep;
+    batch -> src = (char **) globus_malloc(sizeof(char *) * n);
+    batch -> dst = (char **) globus_malloc(sizeof(char *) * n);
+    memset(batch -> src, 0, sizeof(char *) * n);
+    memset(batch -> dst, 0, sizeof(char *) * n);
+    batch -> npairs = (int) n;
+
+    for (i = 0; i < n; i++){
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pairsSeq, i), "ss", &src, &dst)){
+            Py_DECREF(pairsSeq);
+            pipeline_batch_free(batch);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each pair must be a (src, dst) tuple of strings");
+            return NULL;
+        }
+        batch -> src[i] = globus_libc_strdup(src);
+        batch -> dst[i] = globus_libc_strdup(dst);
+    }
+
+    Py_DECREF(pairsSeq);
+
+    batch -> pyfunction = completeCallbackFunctionObj;
+    batch -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(batch -> pyfunction);
+    Py_XINCREF(batch -> pyarg);
+
+    // the first pair is given to Globus here
+    batch -> issued = 1;
+
+    // register the batch so the pipeline callback can find it, unless
+    // the handle already has one in progress
+    globus_mutex_lock(&(pipeline_registry.mutex));
+    for (other = pipeline_registry.batches; other; other = other -> next){
+        if (other -> handle == handlep){
+            break;
+        }
+    }
+    if (other == NULL){
+        batch -> next = pipeline_registry.batches;
+        pipeline_registry.batches = batch;
+    }
+    globus_mutex_unlock(&(pipeline_registry.mutex));
+
+    if (other){
+        pipeline_batch_free(batch);
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: handle already has a pipelined transfer in progress");
+        return NULL;
+    }
+
+    // kick off the third party transfer
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_third_party_transfer(
+                        handlep,
+                        batch -> src[0],
+                        src_operation_attrp,
+                        batch -> dst[0],
+                        dst_operation_attrp,
+                        NULL,
+                        pipeline_complete_callback,
+                        (void *) batch
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        pipeline_registry_remove(batch);
+        pipeline_batch_free(batch);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start pipelined third party transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// compute the checksum of a file with an algorithm, MD5 if none is
+// given
+// note that it is returned in a callback
+PyObject * gridftp_cksm(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    PY_LONG_LONG offset = -1;
+    PY_LONG_LONG length = -1;
+    char * algorithm = "MD5";
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    cksm_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments, the range as 64 bit values so offsets past
+    // 2GB can be checksummed
+    if (!PyArg_ParseTuple(args, "OsOLLOO|s", 
+            &handleObj, 
+            &url, 
+            &OpAttrObj,
+            &offset,
+            &length,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj,
+            &algorithm
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (cksm_algorithm_check(algorithm) < 0){
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a cksm callback struct to hold the callback information,
+    // with room for the digest of the algorithm; it stays empty if the
+    // operation fails
+    callbackBucket = (cksm_callback_bucket_t *) globus_malloc(sizeof(cksm_callback_bucket_t));
+    callbackBucket -> cksm = (char *) globus_malloc(cksm_digest_size(algorithm));
+    if (callbackBucket -> cksm == NULL){
+        globus_libc_free(callbackBucket);
+        return PyErr_NoMemory();
+    }
+    callbackBucket -> cksm[0] = '\0';
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the checksum operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_cksm(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        callbackBucket -> cksm,
+                        (globus_off_t) offset,
+                        (globus_off_t ) length,
+                        algorithm,
+                        cksm_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        Py_XDECREF(callbackBucket -> pyfunction);
+        Py_XDECREF(callbackBucket -> pyarg);
+        globus_libc_free(callbackBucket -> cksm);
+        globus_libc_free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start checksum operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// make a directory
+// the status is returned in a callback
+PyObject * gridftp_mkdir(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    mkdir_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOO", 
+            &handleObj, 
+            &url, 
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a mkdir callback struct to hold the callback information
+    callbackBucket = (mkdir_callback_bucket_t *) globus_malloc(sizeof(mkdir_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the checksum operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_mkdir(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        mkdir_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start mkdir operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// remove a directory
+// the status is returned in a callback
+PyObject * gridftp_rmdir(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    rmdir_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOO", 
+            &handleObj, 
+            &url, 
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a rmdir callback struct to hold the callback information
+    callbackBucket = (rmdir_callback_bucket_t *) globus_malloc(sizeof(rmdir_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the checksum operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_rmdir(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        rmdir_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start rmdir operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// delete a file
+// the status is returned in a callback
+PyObject * gridftp_delete(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    delete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOO", 
+            &handleObj, 
+            &url, 
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a delete callback struct to hold the callback information
+    callbackBucket = (delete_callback_bucket_t *) globus_malloc(sizeof(delete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the checksum operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_delete(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        delete_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start delete operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// move (that is, rename) a file
+// the status is returned in a callback
+PyObject * gridftp_move(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    char * dst = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    move_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OssOOO", 
+            &handleObj, 
+            &src, 
+            &dst,
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a move callback struct to hold the callback information
+    callbackBucket = (move_callback_bucket_t *) globus_malloc(sizeof(move_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the checksum operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_move(
+                        handlep,
+                        src,
+                        dst,
+                        operation_attrp,
+                        move_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start move operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// chmod a file
+// the status is returned in a callback
+PyObject * gridftp_chmod(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    int mode = 0;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    chmod_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsiOOO", 
+            &handleObj, 
+            &url, 
+            &mode,
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create a chmod callback struct to hold the callback information
+    callbackBucket = (chmod_callback_bucket_t *) globus_malloc(sizeof(chmod_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the chmod operation
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_chmod(
+                        handlep,
+                        url,
+                        mode,
+                        operation_attrp,
+                        chmod_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start chmod operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a gridftp get operation
+PyObject * gridftp_get(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    restart_marker_t * restart_markerp = NULL;
+    stream_digest_t * digestp = NULL;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * restartMarkerObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+    PyObject * digestObj = NULL;
+
+    get_complete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOOO|O", 
+            &handleObj, 
+            &src, 
+            &opAttrObj,
+            &restartMarkerObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj,
+            &digestObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
+    if (gridftp_restart_marker_from_object(restartMarkerObj, &restart_markerp) != 0){
+        return NULL;
+    }
+    if (gridftp_stream_digest_from_object(digestObj, &digestp) != 0){
+        return NULL;
+    }
+
+    // create a get callback struct to hold the callback information
+    callbackBucket = (get_complete_callback_bucket_t *) globus_malloc(sizeof(get_complete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+    callbackBucket -> digest = digestp;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+    if (digestp){
+        stream_digest_retain(digestp);
+    }
+
+    // kick off the get transfer 
+
+    Py_BEGIN_ALLOW_THREADS
+
+    // Globus copies the restart marker when the transfer starts
+    if (restart_markerp){
+        globus_mutex_lock(&(restart_markerp -> mutex));
+    }
+
+    gridftp_result = globus_ftp_client_get(
+                        handlep,
+                        src,
+                        operation_attrp,
+                        restart_markerp ? &(restart_markerp -> marker) : NULL,
+                        get_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    if (restart_markerp){
+        globus_mutex_unlock(&(restart_markerp -> mutex));
+    }
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        if (digestp){
+            stream_digest_release(digestp);
+        }
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start get transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// get part of a file, the bytes from offset up to but not including end
+//
+// as with gridftp_get the data is read with gridftp_register_read, and
+// the offsets given to the data callbacks are offsets into the file
+PyObject * gridftp_partial_get(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    PY_LONG_LONG offset;
+    PY_LONG_LONG end;
+    stream_digest_t * digestp = NULL;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+    PyObject * digestObj = NULL;
+
+    get_complete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOLLOO|O", 
+            &handleObj, 
+            &src, 
+            &opAttrObj,
+            &offset,
+            &end,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj,
+            &digestObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (offset < 0 || end < offset){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: invalid range for partial get");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
+    if (gridftp_stream_digest_from_object(digestObj, &digestp) != 0){
+        return NULL;
+    }
+
+    // create a get callback struct to hold the callback information
+    callbackBucket = (get_complete_callback_bucket_t *) globus_malloc(sizeof(get_complete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+    callbackBucket -> digest = digestp;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+    if (digestp){
+        stream_digest_retain(digestp);
+    }
+
+    // kick off the partial get transfer 
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_partial_get(
+                        handlep,
+                        src,
+                        operation_attrp,
+                        NULL,
+                        (globus_off_t) offset,
+                        (globus_off_t) end,
+                        get_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        Py_XDECREF(callbackBucket -> pyfunction);
+        Py_XDECREF(callbackBucket -> pyarg);
+        if (digestp){
+            stream_digest_release(digestp);
+        }
+        free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start partial get transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a gridftp verbose list operation
+PyObject * gridftp_verbose_list(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    get_complete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOO", 
+            &handleObj, 
+            &url, 
+            &opAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
+
+    // create a verbose list callback struct to hold the callback information
+    callbackBucket = (get_complete_callback_bucket_t *) globus_malloc(sizeof(get_complete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+    callbackBucket -> digest = NULL;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the verbose list operation 
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_verbose_list(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        get_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start verbose list operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a gridftp machine list (MLSD) operation
+//
+// as with gridftp_verbose_list the data, fact lines, is read with
+// gridftp_register_read
+PyObject * gridftp_machine_list(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    get_complete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOO", 
+            &handleObj, 
+            &url, 
+            &opAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+
+    // create a callback struct to hold the callback information
+    callbackBucket = (get_complete_callback_bucket_t *) globus_malloc(sizeof(get_complete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+    callbackBucket -> digest = NULL;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the machine list operation 
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_machine_list(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        get_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        Py_XDECREF(callbackBucket -> pyfunction);
+        Py_XDECREF(callbackBucket -> pyarg);
+        free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start machine list operation", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// register the data callback function for a get operation
+PyObject * gridftp_register_read(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    globus_byte_t * buffer = NULL;
+    unsigned long buffer_length = 0;
+    stream_digest_t * digestp = NULL;
+
+    PyObject * handleObj;
+    PyObject * bufferObj;
+    PyObject * dataCallbackFunctionObj;
+    PyObject * dataCallbackArgObj;
+    PyObject * digestObj = NULL;
+
+    get_data_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOkOO|O", 
+            &handleObj, 
+            &bufferObj, 
+            &buffer_length,
+            &dataCallbackFunctionObj,
+            &dataCallbackArgObj,
+            &digestObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
+    if (gridftp_stream_digest_from_object(digestObj, &digestp) != 0){
+        return NULL;
+    }
+
+    // create a data callback struct to hold the callback information
+    callbackBucket = (get_data_callback_bucket_t *) globus_malloc(sizeof(get_data_callback_bucket_t));
+    callbackBucket -> pyfunction = dataCallbackFunctionObj;
+    callbackBucket -> pyarg = dataCallbackArgObj;
+    callbackBucket -> pybuffer = bufferObj;
+    callbackBucket -> digest = digestp;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+    Py_XINCREF(callbackBucket -> pybuffer);
+    if (digestp){
+        stream_digest_retain(digestp);
+    }
+
+    // register the read
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_register_read(
+                        handlep,
+                        buffer,
+                        (globus_size_t) buffer_length,
+                        get_data_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        if (digestp){
+            stream_digest_release(digestp);
+        }
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to register read", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a gridftp put operation
+PyObject * gridftp_put(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * dst = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    restart_marker_t * restart_markerp = NULL;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * restartMarkerObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    put_complete_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOOO",
+            &handleObj,
+            &dst,
+            &opAttrObj,
+            &restartMarkerObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
+    if (gridftp_restart_marker_from_object(restartMarkerObj, &restart_markerp) != 0){
+        return NULL;
+    }
+
+    // create a put callback struct to hold the callback information
+    callbackBucket = (put_complete_callback_bucket_t *) globus_malloc(sizeof(put_complete_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the put transfer
+
+    Py_BEGIN_ALLOW_THREADS
+
+    // Globus copies the restart marker when the transfer starts
+    if (restart_markerp){
+        globus_mutex_lock(&(restart_markerp -> mutex));
+    }
+
+    gridftp_result = globus_ftp_client_put(
+                        handlep,
+                        dst,
+                        operation_attrp,
+                        restart_markerp ? &(restart_markerp -> marker) : NULL,
+                        put_complete_callback,
+                        (void *) callbackBucket
+                        );
+
+    if (restart_markerp){
+        globus_mutex_unlock(&(restart_markerp -> mutex));
+    }
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        Py_XDECREF(callbackBucket -> pyfunction);
+        Py_XDECREF(callbackBucket -> pyarg);
+        free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start put transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// register a block of data to be written for a put operation
+//
+// the data may be a wrapped pointer from gridftp_create_buffer or any
+// Python object supporting the buffer protocol; in the latter case the
+// memory of the object is handed to Globus directly, without a copy,
+// and the object is kept alive until the data callback has been called
+PyObject * gridftp_register_write(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    globus_byte_t * buffer = NULL;
+    Py_ssize_t object_length = 0;
+    PY_LONG_LONG buffer_length = -1;
+    PY_LONG_LONG offset = 0;
+    int eof = 0;
+
+    PyObject * handleObj;
+    PyObject * bufferObj;
+    PyObject * dataCallbackFunctionObj;
+    PyObject * dataCallbackArgObj;
+
+    put_data_callback_bucket_t * callbackBucket = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOLLiOO",
+            &handleObj,
+            &bufferObj,
+            &buffer_length,
+            &offset,
+            &eof,
+            &dataCallbackFunctionObj,
+            &dataCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+
+    // create a data callback struct to hold the callback information
+    callbackBucket = (put_data_callback_bucket_t *) globus_malloc(sizeof(put_data_callback_bucket_t));
+
+    if (callbackBucket == NULL){
+        return PyErr_NoMemory();
+    }
+
+    if (gridftp_object_as_memory(bufferObj, &(callbackBucket -> view), &(callbackBucket -> has_view), &(callbackBucket -> copy), &buffer, &object_length) != 0){
+        free(callbackBucket);
+        if (!PyErr_Occurred()){
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: data object does not support the buffer protocol");
+        }
+        return NULL;
+    }
+
+    // a negative length means write the whole object, which is only
+    // known for buffer protocol objects
+    if (buffer_length < 0){
+        buffer_length = object_length;
+    }
+    if (buffer_length < 0 || (object_length >= 0 && buffer_length > object_length)){
+        if (callbackBucket -> has_view){
+            PyBuffer_Release(&(callbackBucket -> view));
+        }
+        globus_libc_free(callbackBucket -> copy);
+        free(callbackBucket);
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: invalid length for register write");
+        return NULL;
+    }
+
+    callbackBucket -> pyfunction = dataCallbackFunctionObj;
+    callbackBucket -> pyarg = dataCallbackArgObj;
+    callbackBucket -> pybuffer = bufferObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+    Py_XINCREF(callbackBucket -> pybuffer);
+
+    // register the write
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_register_write(
+                        handlep,
+                        buffer,
+                        (globus_size_t) buffer_length,
+                        (globus_off_t) offset,
+                        (globus_bool_t) eof,
+                        put_data_callback,
+                        (void *) callbackBucket
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        if (callbackBucket -> has_view){
+            PyBuffer_Release(&(callbackBucket -> view));
+        }
+        globus_libc_free(callbackBucket -> copy);
+        Py_XDECREF(callbackBucket -> pyfunction);
+        Py_XDECREF(callbackBucket -> pyarg);
+        Py_XDECREF(callbackBucket -> pybuffer);
+        free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to register write", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a gridftp get operation whose data is written directly to
+// a local file by the wrapper
+//
+// nbuffers buffers of bufsize bytes are kept registered with Globus;
+// each block is written with pwrite at the offset Globus reports, so
+// out of order blocks from parallel streams land in the right place.
+// The Python callback is called once, when the get completes
+PyObject * gridftp_get_to_file(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    restart_marker_t * restart_markerp = NULL;
+    stream_digest_t * digestp = NULL;
+    int nbuffers = 0;
+    unsigned long bufsize = 0;
+    int i;
+
+    PyObject * handleObj;
+    PyObject * opAttrObj;
+    PyObject * destObj;
+    PyObject * restartMarkerObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+    PyObject * digestObj = NULL;
+
+    get_sink_t * sink = NULL;
+    globus_bool_t finished = GLOBUS_FALSE;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOOikOO|O",
+            &handleObj,
+            &src,
+            &opAttrObj,
+            &destObj,
+            &restartMarkerObj,
+            &nbuffers,
+            &bufsize,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj,
+            &digestObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (nbuffers < 1 || bufsize < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: nbuffers and bufsize must be positive");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
+    if (gridftp_restart_marker_from_object(restartMarkerObj, &restart_markerp) != 0){
+        return NULL;
+    }
+    if (gridftp_stream_digest_from_object(digestObj, &digestp) != 0){
+        return NULL;
+    }
+
+    // create the sink that holds the state of the transfer
+    sink = (get_sink_t *) globus_malloc(sizeof(get_sink_t));
+    memset(sink, 0, sizeof(get_sink_t));
+    sink -> nbuffers = nbuffers;
+    sink -> bufsize = (globus_size_t) bufsize;
+
+    // the destination is either an open file descriptor owned by the
+    // caller or a path that the wrapper opens and closes; when resuming
+    // from a restart marker the data already on disk is kept
+    if (PyInt_Check(destObj) || PyLong_Check(destObj)){
+        sink -> fd = (int) PyInt_AsLong(destObj);
+        sink -> close_fd = 0;
+    } else if (PyString_Check(destObj)){
+        Py_BEGIN_ALLOW_THREADS
+        sink -> fd = open(PyString_AsString(destObj), O_WRONLY | O_CREAT | (restart_markerp ? 0 : O_TRUNC), 0644);
+        Py_END_ALLOW_THREADS
+        if (sink -> fd < 0){
+            snprintf(msg, sizeof(msg), "gridftpwrapper: unable to open %s: %s", PyString_AsString(destObj), strerror(errno));
+            free(sink);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            return NULL;
+        }
+        sink -> close_fd = 1;
+    } else {
+        free(sink);
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: destination must be a path or a file descriptor");
+        return NULL;
+    }
+
+    // allocate the buffers the data is read into
+    sink -> buffers = (globus_byte_t **) globus_malloc(sizeof(globus_byte_t *) * nbuffers);
+    memset(sink -> buffers, 0, sizeof(globus_byte_t *) * nbuffers);
+    for (i = 0; i < nbuffers; i++){
+        sink -> buffers[i] = buffer_pool_alloc((globus_size_t) bufsize, 0, &(sink -> bufclass));
+        if (sink -> buffers[i] == NULL){
+            for (i = 0; i < nbuffers; i++){
+                buffer_pool_free(sink -> bufclass, sink -> buffers[i]);
+            }
+            globus_libc_free(sink -> buffers);
+            if (sink -> close_fd){
+                close(sink -> fd);
+            }
+            free(sink);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to create buffer");
+            return NULL;
+        }
+    }
+
+    globus_mutex_init(&(sink -> mutex), NULL);
+
+    sink -> pyfunction = completeCallbackFunctionObj;
+    sink -> pyarg = completeCallbackArgObj;
+    sink -> handle = handlep;
+
+    // count every buffer as outstanding before the get starts so that
+    // a get that completes early cannot finish the sink while the
+    // buffers are still being registered
+    sink -> outstanding = nbuffers;
+
+    // the ranges written are recorded in the restart marker, so the same
+    // marker both resumes this get and makes a retry of it resumable
+    sink -> marker = restart_markerp;
+    sink -> pymarker = restart_markerp ? restartMarkerObj : NULL;
+
+    // the blocks are summed as they are written
+    sink -> digest = digestp;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(sink -> pyfunction);
+    Py_XINCREF(sink -> pyarg);
+    Py_XINCREF(sink -> pymarker);
+    if (digestp){
+        stream_digest_retain(digestp);
+    }
+
+    // kick off the get transfer and hand all of the buffers to Globus
+
+    Py_BEGIN_ALLOW_THREADS
+
+    // Globus copies the restart marker when the transfer starts
+    if (restart_markerp){
+        globus_mutex_lock(&(restart_markerp -> mutex));
+    }
+
+    gridftp_result = globus_ftp_client_get(
+                        handlep,
+                        src,
+                        operation_attrp,
+                        restart_markerp ? &(restart_markerp -> marker) : NULL,
+                        get_sink_complete_callback,
+                        (void *) sink
+                        );
+
+    if (restart_markerp){
+        globus_mutex_unlock(&(restart_markerp -> mutex));
+    }
+
+    if (gridftp_result == GLOBUS_SUCCESS){
+        for (i = 0; i < nbuffers; i++){
+            if (globus_ftp_client_register_read(
+                        handlep,
+                        sink -> buffers[i],
+                        sink -> bufsize,
+                        get_sink_data_callback,
+                        (void *) sink
+                        ) != GLOBUS_SUCCESS){
+                break;
+            }
+        }
+
+        // with no buffer registered the transfer cannot make progress,
+        // so stop it; the failure is reported by the completion callback
+        if (i == 0){
+            globus_ftp_client_abort(handlep);
+        }
+
+        // the buffers that could not be registered are retired here,
+        // and if the get has already completed the sink is finished
+        globus_mutex_lock(&(sink -> mutex));
+        sink -> outstanding -= (nbuffers - i);
+        finished = (sink -> complete && sink -> outstanding == 0);
+        globus_mutex_unlock(&(sink -> mutex));
+
+        if (finished){
+            get_sink_finish(sink);
+        }
+    }
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        for (i = 0; i < nbuffers; i++){
+            buffer_pool_free(sink -> bufclass, sink -> buffers[i]);
+        }
+        globus_libc_free(sink -> buffers);
+        if (sink -> close_fd){
+            close(sink -> fd);
+        }
+        Py_XDECREF(sink -> pyfunction);
+        Py_XDECREF(sink -> pyarg);
+        Py_XDECREF(sink -> pymarker);
+        if (digestp){
+            stream_digest_release(digestp);
+        }
+        globus_mutex_destroy(&(sink -> mutex));
+        free(sink);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start get transfer", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// register a ring of buffers for the get operation currently in
+// progress on a handle
+//
+// the wrapper allocates nbuffers buffers of bufsize bytes, registers
+// all of them, and re-registers each one itself after the Python data
+// callback returns (or, in copy mode, as soon as the data has been
+// copied into a Python string), so every data channel always has a
+// buffer to read into. The buffers are freed after the last one has
+// been returned by Globus
+PyObject * gridftp_register_read_ring(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handle_t * handlep = NULL;
+    int nbuffers = 0;
+    unsigned long bufsize = 0;
+    int copy = 0;
+    int i;
+    int registered = 0;
+    stream_digest_t * digestp = NULL;
+
+    PyObject * handleObj;
+    PyObject * dataCallbackFunctionObj;
+    PyObject * dataCallbackArgObj;
+    PyObject * digestObj = NULL;
+
+    read_ring_t * ring = NULL;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OikOOi|O",
+            &handleObj,
+            &nbuffers,
+            &bufsize,
+            &dataCallbackFunctionObj,
+            &dataCallbackArgObj,
+            &copy,
+            &digestObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (nbuffers < 1 || bufsize < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: nbuffers and bufsize must be positive");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    if (gridftp_stream_digest_from_object(digestObj, &digestp) != 0){
+        return NULL;
+    }
+
+    // create the ring and its buffers, the ring holding a reference to
+    // the digest until it is freed
+    ring = (read_ring_t *) globus_malloc(sizeof(read_ring_t));
+    memset(ring, 0, sizeof(read_ring_t));
+    ring -> copy = copy;
+    ring -> digest = digestp;
+    if (digestp){
+        stream_digest_retain(digestp);
+    }
+    ring -> nbuffers = nbuffers;
+    ring -> bufsize = (globus_size_t) bufsize;
+    ring -> buffers = (globus_byte_t **) globus_malloc(sizeof(globus_byte_t *) * nbuffers);
+    memset(ring -> buffers, 0, sizeof(globus_byte_t *) * nbuffers);
+    globus_mutex_init(&(ring -> mutex), NULL);
+
+    for (i = 0; i < nbuffers; i++){
+        ring -> buffers[i] = buffer_pool_alloc((globus_size_t) bufsize, 0, &(ring -> bufclass));
+        if (ring -> buffers[i] == NULL){
+            read_ring_free(ring);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to create buffer");
+            return NULL;
+        }
+    }
+
+    ring -> pyfunction = dataCallbackFunctionObj;
+    ring -> pyarg = dataCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(ring -> pyfunction);
+    Py_XINCREF(ring -> pyarg);
+
+    // count every buffer as outstanding before the first registration,
+    // plus a reference for this thread, so that the callbacks cannot
+    // retire the ring before this thread is done with it
+    ring -> outstanding = nbuffers + 1;
+
+    // register all of the buffers
+
+    Py_BEGIN_ALLOW_THREADS
+
+    for (i = 0; i < nbuffers; i++){
+        if (!read_ring_register(ring, handlep, ring -> buffers[i])){
+            break;
+        }
+    }
+
+    Py_END_ALLOW_THREADS
+
+    registered = i;
+
+    // the buffers that could not be registered are retired here along
+    // with the reference of this thread; whoever brings the count to 0
+    // frees the ring
+    globus_mutex_lock(&(ring -> mutex));
+    ring -> outstanding -= (nbuffers - registered) + 1;
+    i = ring -> outstanding;
+    globus_mutex_unlock(&(ring -> mutex));
+
+    if (i == 0){
+        read_ring_free(ring);
+    }
+
+    if (registered == 0){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to register read");
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
+}
+
+// start a striped get, which fetches one file over several handles at
+// once and writes it directly to a local file
+//
+// nstreams handles are created from the handle attributes, each with
+// nbuffers buffers of bufsize bytes, and the file is split into byte
+// ranges of at least minchunk bytes that the handles fetch with
+// partial gets. The Python callback is called once, with None in place
+// of a handle, after every range has been written or the get has failed.
+// The returned engine must be destroyed once the callback has been called
+PyObject * gridftp_striped_get(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t * handle_attrp = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    globus_ftp_control_mode_t mode = GLOBUS_FTP_CONTROL_MODE_NONE;
+    int nstreams = 0;
+    int nbuffers = 0;
+    unsigned long bufsize = 0;
+    PY_LONG_LONG minchunk = 0;
+    int nhandles = 0;
+    int i, j;
+
+    PyObject * handleAttrObj;
+    PyObject * opAttrObj;
+    PyObject * destObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    striped_get_t * engine = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOiikLOO",
+            &handleAttrObj,
+            &src,
+            &opAttrObj,
+            &destObj,
+            &nstreams,
+            &nbuffers,
+            &bufsize,
+            &minchunk,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (nstreams < 1 || nbuffers < 1 || bufsize < 1 || minchunk < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: nstreams, nbuffers, bufsize and minchunk must be positive");
+        return NULL;
+    }
+
+    // get the bare pointers from the python objects
+    handle_attrp = (globus_ftp_client_handleattr_t *) gridftp_optional_ptr(handleAttrObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+
+    // create the engine that holds the state of the transfer
+    engine = (striped_get_t *) globus_malloc(sizeof(striped_get_t));
+    memset(engine, 0, sizeof(striped_get_t));
+    engine -> nbuffers = nbuffers;
+    engine -> bufsize = (globus_size_t) bufsize;
+    engine -> minchunk = (globus_off_t) minchunk;
+    engine -> url = globus_libc_strdup(src);
+    globus_mutex_init(&(engine -> mutex), NULL);
+
+    // every range is fetched with the same attributes, so the engine
+    // keeps its own copy rather than depending on the Python object
+    if (operation_attrp){
+        gridftp_result = globus_ftp_client_operationattr_copy(&(engine -> attr), operation_attrp);
+    } else{
+        gridftp_result = globus_ftp_client_operationattr_init(&(engine -> attr));
+    }
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        globus_mutex_destroy(&(engine -> mutex));
+        globus_libc_free(engine -> url);
+        free(engine);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to copy operation attributes", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // in extended block mode blocks arrive out of order, so there is no
+    // point below which a range is known to be complete and it cannot
+    // be split once started
+    globus_ftp_client_operationattr_get_mode(&(engine -> attr), &mode);
+    engine -> steal = (mode != GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+
+    // allocate the streams and their buffers
+    engine -> nstreams = nstreams;
+    engine -> streams = (striped_stream_t *) globus_malloc(sizeof(striped_stream_t) * nstreams);
+    memset(engine -> streams, 0, sizeof(striped_stream_t) * nstreams);
+    for (i = 0; i < nstreams; i++){
+        engine -> streams[i].engine = engine;
+        engine -> streams[i].buffers = (globus_byte_t **) globus_malloc(sizeof(globus_byte_t *) * nbuffers);
+        memset(engine -> streams[i].buffers, 0, sizeof(globus_byte_t *) * nbuffers);
+        for (j = 0; j < nbuffers; j++){
+            engine -> streams[i].buffers[j] = buffer_pool_alloc((globus_size_t) bufsize, 0, &(engine -> bufclass));
+            if (engine -> streams[i].buffers[j] == NULL){
+                striped_get_free(engine, 0);
+                PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to create buffer");
+                return NULL;
+            }
+        }
+    }
+
+    // each stream gets its own handle, and so its own control and
+    // data connections
+    for (nhandles = 0; nhandles < nstreams; nhandles++){
+        gridftp_result = globus_ftp_client_handle_init(&(engine -> streams[nhandles].handle), handle_attrp);
+        if (gridftp_result != GLOBUS_SUCCESS){
+            striped_get_free(engine, nhandles);
+            sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle", gridftp_result);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            return NULL;
+        }
+    }
+
+    // the destination is either an open file descriptor owned by the
+    // caller or a path that the wrapper opens and closes
+    if (PyInt_Check(destObj) || PyLong_Check(destObj)){
+        engine -> fd = (int) PyInt_AsLong(destObj);
+        engine -> close_fd = 0;
+    } else if (PyString_Check(destObj)){
+        Py_BEGIN_ALLOW_THREADS
+        engine -> fd = open(PyString_AsString(destObj), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        Py_END_ALLOW_THREADS
+        if (engine -> fd < 0){
+            snprintf(msg, sizeof(msg), "gridftpwrapper: unable to open %s: %s", PyString_AsString(destObj), strerror(errno));
+            striped_get_free(engine, nhandles);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            return NULL;
+        }
+        engine -> close_fd = 1;
+    } else {
+        striped_get_free(engine, nhandles);
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: destination must be a path or a file descriptor");
+        return NULL;
+    }
+
+    engine -> pyfunction = completeCallbackFunctionObj;
+    engine -> pyarg = completeCallbackArgObj;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(engine -> pyfunction);
+    Py_XINCREF(engine -> pyarg);
+
+    // the ranges cannot be cut before the size of the file is known, so
+    // the first handle asks for it and its callback starts the streams
+    engine -> streams[0].busy = GLOBUS_TRUE;
+
+    Py_BEGIN_ALLOW_THREADS
+
+    gridftp_result = globus_ftp_client_size(
+                        &(engine -> streams[0].handle),
+                        engine -> url,
+                        &(engine -> attr),
+                        &(engine -> size),
+                        striped_get_size_callback,
+                        (void *) engine
+                        );
+
+    Py_END_ALLOW_THREADS
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        if (engine -> close_fd){
+            close(engine -> fd);
+        }
+        Py_XDECREF(engine -> pyfunction);
+        Py_XDECREF(engine -> pyarg);
+        striped_get_free(engine, nhandles);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start size request", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    return PyCObject_FromVoidPtrAndDesc((void *) engine, (void *) striped_get_tag, NULL);
+}
+
+// return the progress of a striped get as a dictionary holding the size
+// of the file, the bytes written so far in total and per stream, and
+// whether the completion has been reported
+PyObject * gridftp_striped_get_status(PyObject *self, PyObject *args)
+{
+    PyObject * engineObj;
+    PyObject * streamsObj;
+    PyObject * statusObj;
+    striped_get_t * engine;
+    int i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &engineObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    engine = striped_get_from_object(engineObj);
+    if (engine == NULL){
+        return NULL;
+    }
+
+    streamsObj = PyList_New(engine -> nstreams);
+    if (streamsObj == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+    for (i = 0; i < engine -> nstreams; i++){
+        PyList_SET_ITEM(streamsObj, i, PyLong_FromLongLong((PY_LONG_LONG) engine -> streams[i].nbytes));
+    }
+    statusObj = Py_BuildValue("{s:L,s:L,s:O,s:O}",
+        "size", (PY_LONG_LONG) engine -> size,
+        "nbytes", (PY_LONG_LONG) engine -> nbytes,
+        "done", engine -> done ? Py_True : Py_False,
+        "streams", streamsObj);
+    globus_mutex_unlock(&(engine -> mutex));
+
+    Py_DECREF(streamsObj);
+
+    return statusObj;
+}
+
+// abort a striped get; the completion is still reported, with an error
+PyObject * gridftp_striped_get_abort(PyObject *self, PyObject *args)
+{
+    PyObject * engineObj;
+    striped_get_t * engine;
+    globus_bool_t abort_all;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &engineObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    engine = striped_get_from_object(engineObj);
+    if (engine == NULL){
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+
+    globus_mutex_lock(&(engine -> mutex));
+    abort_all = !(engine -> done) && striped_get_fail(engine, "gridftpwrapper: striped get aborted");
+    globus_mutex_unlock(&(engine -> mutex));
+
+    if (abort_all){
+        striped_get_abort_streams(engine);
+    }
+
+    Py_END_ALLOW_THREADS
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// destroy a striped get and its handles, which is only possible once
+// its completion has been reported
+PyObject * gridftp_striped_get_destroy(PyObject *self, PyObject *args)
+{
+    PyObject * engineObj;
+    striped_get_t * engine;
+    globus_bool_t done;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &engineObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    engine = striped_get_from_object(engineObj);
+    if (engine == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(engine -> mutex));
+    done = engine -> done;
+    globus_mutex_unlock(&(engine -> mutex));
+
+    if (!done){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: striped get still in progress");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    striped_get_free(engine, engine -> nstreams);
+    Py_END_ALLOW_THREADS
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// create a handle pool from a handle attr
+//
+// the pool takes its own copy of the attributes, with caching of every
+// URL turned on, and keeps at most max_per_host handles, idle or
+// leased, for each host:port
+PyObject * gridftp_handle_pool_init(PyObject *self, PyObject *args)
+{
+    globus_ftp_client_handleattr_t * handle_attrp = NULL;
+    PyObject * handleAttrObj;
+    handle_pool_t * pool;
+    int max_per_host = 0;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oi", &handleAttrObj, &max_per_host)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (max_per_host < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: max_per_host must be positive");
+        return NULL;
+    }
+
+    handle_attrp = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttrObj);
+
+    pool = (handle_pool_t *) globus_malloc(sizeof(handle_pool_t));
+    memset(pool, 0, sizeof(handle_pool_t));
+    pool -> max_per_host = max_per_host;
+
+    gridftp_result = globus_ftp_client_handleattr_copy(&(pool -> attr), handle_attrp);
+    if (gridftp_result == GLOBUS_SUCCESS){
+        gridftp_result = globus_ftp_client_handleattr_set_cache_all(&(pool -> attr), GLOBUS_TRUE);
+        if (gridftp_result != GLOBUS_SUCCESS){
+            globus_ftp_client_handleattr_destroy(&(pool -> attr));
+        }
+    }
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        globus_libc_free(pool);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to copy handle attributes", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    globus_mutex_init(&(pool -> mutex), NULL);
+    globus_cond_init(&(pool -> cond), NULL);
+    globus_mutex_init(&(pool -> dirs_mutex), NULL);
+    globus_cond_init(&(pool -> dirs_cond), NULL);
+
+    return PyCObject_FromVoidPtrAndDesc((void *) pool, (void *) handle_pool_tag, NULL);
+}
+
+// lease a handle from a handle pool for the host:port of a URL
+//
+// the most recently returned idle handle for the host is handed out
+// first, since it is the most likely to still have its control
+// connection open; with none idle a new handle is created unless the
+// host is at its cap, in which case the call waits, without the GIL,
+// for a handle to come back if block is true and timeout (in seconds,
+// negative for no limit) allows. Returns the handle or None
+PyObject * gridftp_handle_pool_lease(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    handle_pool_t * pool;
+    handle_pool_entry_t * entry = NULL;
+    char * url = NULL;
+    int block = 1;
+    double timeout = -1.0;
+    char key[1024];
+    int rc;
+
+    globus_result_t gridftp_result = GLOBUS_SUCCESS;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Os|id", &poolObj, &url, &block, &timeout)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    handle_pool_key(url, key, sizeof(key));
+
+    Py_BEGIN_ALLOW_THREADS
+    rc = handle_pool_acquire(pool, key, block, timeout, &entry, &gridftp_result);
+    Py_END_ALLOW_THREADS
+
+    if (rc != 0){
+        if (gridftp_result != GLOBUS_SUCCESS){
+            sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle", gridftp_result);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+        } else{
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to allocate handle pool entry");
+        }
+        return NULL;
+    }
+
+    if (entry == NULL){
+        Py_RETURN_NONE;
+    }
+
+    return PyCObject_FromVoidPtrAndDesc((void *) &(entry -> handle), (void *) handle_pool_handle_tag, NULL);
+}
+
+// return a leased handle to its handle pool
+//
+// the handle is kept as the first idle handle of its host unless
+// discard is true, for instance after an error that may have left its
+// connection unusable, in which case it is destroyed. This may be
+// called from the callbacks of the handle itself
+PyObject * gridftp_handle_pool_release(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * handleObj;
+    handle_pool_t * pool;
+    handle_pool_entry_t * entry;
+    int discard = 0;
+    int rc;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OO|i", &poolObj, &handleObj, &discard)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    if (!PyCObject_Check(handleObj) || PyCObject_GetDesc(handleObj) != (void *) handle_pool_handle_tag){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a pooled handle");
+        return NULL;
+    }
+
+    entry = (handle_pool_entry_t *) PyCObject_AsVoidPtr(handleObj);
+    if (entry -> pool != pool){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: handle was not leased from this pool");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    rc = handle_pool_put(entry, discard);
+    Py_END_ALLOW_THREADS
+
+    if (rc != 0){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: handle is not leased, it has already been released");
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// open and authenticate, in the background, a control connection to
+// the host:port of each URL that has no idle handle in a handle pool
+//
+// a handle is leased without waiting for each such host, its URL state
+// is cached and an exists operation is started on the URL; once it
+// completes the handle goes back to the pool with its connection open,
+// ready for the next lease. An error from the server, such as a missing
+// file, still means the connection is up; any other error discards the
+// handle. The Python callback, which may be None, is called for each
+// URL with (arg, url, error). Returns the number of URLs started
+PyObject * gridftp_handle_pool_prewarm(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * urlsObj;
+    PyObject * urlsSeq;
+    PyObject * opAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+    handle_pool_t * pool;
+    handle_pool_host_t * host;
+    handle_pool_entry_t * entry;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    prewarm_callback_bucket_t * callbackBucket;
+    globus_bool_t skip;
+    char * url;
+    char key[1024];
+    Py_ssize_t i;
+    int nstarted = 0;
+    int rc;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOOOO",
+            &poolObj,
+            &urlsObj,
+            &opAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+
+    urlsSeq = PySequence_Fast(urlsObj, "gridftpwrapper: urls must be a sequence");
+    if (urlsSeq == NULL){
+        return NULL;
+    }
+
+    for (i = 0; i < PySequence_Fast_GET_SIZE(urlsSeq); i++){
+        url = PyString_AsString(PySequence_Fast_GET_ITEM(urlsSeq, i));
+        if (url == NULL){
+            Py_DECREF(urlsSeq);
+            return NULL;
+        }
+
+        handle_pool_key(url, key, sizeof(key));
+
+        // a host with an idle handle is taken to be warm already, and
+        // the handle leased below makes later URLs of the same host
+        // look busy, so each host is warmed once
+        globus_mutex_lock(&(pool -> mutex));
+        host = handle_pool_host_for(pool, key);
+        skip = (host == NULL || host -> nidle > 0 || host -> nleased > 0);
+        globus_mutex_unlock(&(pool -> mutex));
+
+        if (skip){
+            continue;
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+        rc = handle_pool_acquire(pool, key, 0, 0.0, &entry, &gridftp_result);
+        Py_END_ALLOW_THREADS
+
+        if (rc != 0 || entry == NULL){
+            continue;
+        }
+
+        callbackBucket = (prewarm_callback_bucket_t *) globus_malloc(sizeof(prewarm_callback_bucket_t));
+        callbackBucket -> pyfunction = completeCallbackFunctionObj;
+        callbackBucket -> pyarg = completeCallbackArgObj;
+        callbackBucket -> entry = entry;
+        callbackBucket -> url = globus_libc_strdup(url);
+
+        // since we are holding pointers to these objects we need to
+        // increase the reference count for each
+        Py_XINCREF(callbackBucket -> pyfunction);
+        Py_XINCREF(callbackBucket -> pyarg);
+
+        Py_BEGIN_ALLOW_THREADS
+
+        gridftp_result = globus_ftp_client_handle_cache_url_state(&(entry -> handle), callbackBucket -> url);
+        if (gridftp_result == GLOBUS_SUCCESS){
+            gridftp_result = globus_ftp_client_exists(
+                                &(entry -> handle),
+                                callbackBucket -> url,
+                                operation_attrp,
+                                prewarm_complete_callback,
+                                (void *) callbackBucket
+                                );
+        }
+
+        if (gridftp_result != GLOBUS_SUCCESS){
+            handle_pool_put(entry, 1);
+        }
+
+        Py_END_ALLOW_THREADS
+
+        if (gridftp_result != GLOBUS_SUCCESS){
+            Py_XDECREF(callbackBucket -> pyfunction);
+            Py_XDECREF(callbackBucket -> pyarg);
+            globus_libc_free(callbackBucket -> url);
+            free(callbackBucket);
+            Py_DECREF(urlsSeq);
+            sprintf(msg, "gridftpwrapper: rc = %d: unable to start prewarm of %s", gridftp_result, key);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            return NULL;
+        }
+
+        nstarted++;
+    }
+
+    Py_DECREF(urlsSeq);
+
+    return Py_BuildValue("i", nstarted);
+}
+
+// run one metadata operation on each of a list of URLs over handles
+// leased from a handle pool, with at most window operations in flight
+//
+// op is one of "exists", "mkdir", "rmdir", "delete", "chmod", taking
+// mode, or "move", for which items are (src, dst) tuples rather than
+// URLs. The call waits, without the GIL, for every operation, leasing
+// handles as the pool allows per host:port, and returns a string with
+// a C int per item, to be read into an array('i'): 0 for success, the
+// FTP reply code of a refusal, such as 550 for a missing path, -1 if
+// the server could not be reached or the operation not started, or -2
+// if no handle could be leased within the optional timeout, 30 seconds
+// by default, while none of the batch was in flight
+PyObject * gridftp_handle_pool_metadata_many(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * itemsObj;
+    PyObject * itemsSeq;
+    PyObject * opAttrObj;
+    PyObject * resultsObj;
+    handle_pool_t * pool;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    int * results;
+    char ** src;
+    char ** dst = NULL;
+    char * s;
+    char * d;
+    char * opname;
+    int mode = 0;
+    int window = 0;
+    double timeout = METADATA_ACQUIRE_TIMEOUT;
+    int op;
+    int rc;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOOii|d",
+            &poolObj,
+            &opname,
+            &itemsObj,
+            &opAttrObj,
+            &mode,
+            &window,
+            &timeout
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (strcmp(opname, "exists") == 0){
+        op = METADATA_EXISTS;
+    } else if (strcmp(opname, "mkdir") == 0){
+        op = METADATA_MKDIR;
+    } else if (strcmp(opname, "rmdir") == 0){
+        op = METADATA_RMDIR;
+    } else if (strcmp(opname, "delete") == 0){
+        op = METADATA_DELETE;
+    } else if (strcmp(opname, "chmod") == 0){
+        op = METADATA_CHMOD;
+    } else if (strcmp(opname, "move") == 0){
+        op = METADATA_MOVE;
+    } else{
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unknown metadata operation");
+        return NULL;
+    }
+
+    if (window < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: window must be positive");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    itemsSeq = PySequence_Fast(itemsObj, "gridftpwrapper: items must be a sequence");
+    if (itemsSeq == NULL){
+        return NULL;
+    }
+
+    // the batch keeps its own copy of the URLs since it runs without
+    // the GIL
+    n = PySequence_Fast_GET_SIZE(itemsSeq);
+    src = (char **) globus_malloc(sizeof(char *) * (n ? n : 1));
+    memset(src, 0, sizeof(char *) * (n ? n : 1));
+    if (op == METADATA_MOVE){
+        dst = (char **) globus_malloc(sizeof(char *) * (n ? n : 1));
+        memset(dst, 0, sizeof(char *) * (n ? n : 1));
+    }
+
+    for (i = 0; i < n; i++){
+        if (op == METADATA_MOVE){
+            rc = PyArg_ParseTuple(PySequence_Fast_GET_ITEM(itemsSeq, i), "ss", &s, &d);
+        } else{
+            s = PyString_AsString(PySequence_Fast_GET_ITEM(itemsSeq, i));
+            rc = (s != NULL);
+        }
+
+        if (!rc){
+            for (i--; i >= 0; i--){
+                globus_libc_free(src[i]);
+                if (dst){
+                    globus_libc_free(dst[i]);
+                }
+            }
+            globus_libc_free(src);
+            globus_libc_free(dst);
+            Py_DECREF(itemsSeq);
+            PyErr_SetString(PyExc_RuntimeError, op == METADATA_MOVE ?
+                "gridftpwrapper: each item must be a (src, dst) tuple of strings" :
+                "gridftpwrapper: each item must be a string");
+            return NULL;
+        }
+
+        src[i] = globus_libc_strdup(s);
+        if (dst){
+            dst[i] = globus_libc_strdup(d);
+        }
+    }
+
+    Py_DECREF(itemsSeq);
+
+    resultsObj = PyString_FromStringAndSize(NULL, sizeof(int) * n);
+    if (resultsObj == NULL){
+        for (i = 0; i < n; i++){
+            globus_libc_free(src[i]);
+            if (dst){
+                globus_libc_free(dst[i]);
+            }
+        }
+        globus_libc_free(src);
+        globus_libc_free(dst);
+        return NULL;
+    }
+
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+    results = (int *) PyString_AS_STRING(resultsObj);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    metadata_run(pool, operation_attrp, op, src, dst, mode, NULL, (int) n, window, timeout, results);
+
+    for (i = 0; i < n; i++){
+        globus_libc_free(src[i]);
+        if (dst){
+            globus_libc_free(dst[i]);
+        }
+    }
+
+    Py_END_ALLOW_THREADS
+
+    globus_libc_free(src);
+    globus_libc_free(dst);
+
+    return resultsObj;
+}
+
+// free the URLs and checksum buffers of a checksum batch
+static void cksm_many_free(char ** src, metadata_cksm_t * cksm, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++){
+        globus_libc_free(src[i]);
+        globus_libc_free(cksm -> cksms[i]);
+    }
+    globus_libc_free(src);
+    globus_libc_free(cksm -> cksms);
+    globus_libc_free(cksm -> offsets);
+    globus_libc_free(cksm -> lengths);
+}
+
+// checksum a range of a file per item over handles leased from a
+// handle pool, with at most window requests in flight
+//
+// items are (url, offset, length) tuples, length -1 for the rest of the
+// file, and all use one algorithm. The call waits, without the GIL, for
+// every request, and returns a list of (cksm, code) tuples in the same
+// order: the checksum and 0, or None with the FTP reply code of a
+// refusal, -1 if the server could not be reached or -2 if no handle
+// could be leased within the optional timeout, 30 seconds by default
+PyObject * gridftp_handle_pool_cksm_many(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * itemsObj;
+    PyObject * itemsSeq;
+    PyObject * opAttrObj;
+    PyObject * resultObj;
+    PyObject * itemObj;
+    handle_pool_t * pool;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    metadata_cksm_t cksm;
+    PY_LONG_LONG offset;
+    PY_LONG_LONG length;
+    char * algorithm;
+    char ** src;
+    int * results;
+    char * s;
+    int window = 0;
+    double timeout = METADATA_ACQUIRE_TIMEOUT;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOsOi|d",
+            &poolObj,
+            &itemsObj,
+            &algorithm,
+            &opAttrObj,
+            &window,
+            &timeout
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (cksm_algorithm_check(algorithm) < 0){
+        return NULL;
+    }
+
+    if (window < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: window must be positive");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    itemsSeq = PySequence_Fast(itemsObj, "gridftpwrapper: items must be a sequence");
+    if (itemsSeq == NULL){
+        return NULL;
+    }
+
+    // the batch keeps its own copy of the URLs since it runs without
+    // the GIL
+    n = PySequence_Fast_GET_SIZE(itemsSeq);
+    src = (char **) globus_malloc(sizeof(char *) * (n ? n : 1));
+    cksm.algorithm = algorithm;
+    cksm.offsets = (long long *) globus_malloc(sizeof(long long) * (n ? n : 1));
+    cksm.lengths = (long long *) globus_malloc(sizeof(long long) * (n ? n : 1));
+    cksm.cksms = (char **) globus_malloc(sizeof(char *) * (n ? n : 1));
+    results = (int *) globus_malloc(sizeof(int) * (n ? n : 1));
+    if (src == NULL || cksm.offsets == NULL || cksm.lengths == NULL || cksm.cksms == NULL || results == NULL){
+        globus_libc_free(src);
+        globus_libc_free(cksm.offsets);
+        globus_libc_free(cksm.lengths);
+        globus_libc_free(cksm.cksms);
+        globus_libc_free(results);
+        Py_DECREF(itemsSeq);
+        return PyErr_NoMemory();
+    }
+    memset(src, 0, sizeof(char *) * (n ? n : 1));
+    memset(cksm.cksms, 0, sizeof(char *) * (n ? n : 1));
+
+    for (i = 0; i < n; i++){
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(itemsSeq, i), "sLL", &s, &offset, &length)){
+            cksm_many_free(src, &cksm, n);
+            globus_libc_free(results);
+            Py_DECREF(itemsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each item must be a (url, offset, length) tuple");
+            return NULL;
+        }
+
+        src[i] = globus_libc_strdup(s);
+        cksm.offsets[i] = (long long) offset;
+        cksm.lengths[i] = (long long) length;
+        cksm.cksms[i] = (char *) globus_malloc(cksm_digest_size(algorithm));
+
+        // none of the batch is started unless all of it can be
+        if (src[i] == NULL || cksm.cksms[i] == NULL){
+            cksm_many_free(src, &cksm, n);
+            globus_libc_free(results);
+            Py_DECREF(itemsSeq);
+            return PyErr_NoMemory();
+        }
+        cksm.cksms[i][0] = '\0';
+    }
+
+    Py_DECREF(itemsSeq);
+
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    metadata_run(pool, operation_attrp, METADATA_CKSM, src, NULL, 0, &cksm, (int) n, window, timeout, results);
+
+    Py_END_ALLOW_THREADS
+
+    resultObj = PyList_New(n);
+    for (i = 0; i < n; i++){
+        if (results[i] == 0){
+            itemObj = Py_BuildValue("(si)", cksm.cksms[i], 0);
+        } else{
+            itemObj = Py_BuildValue("(zi)", NULL, results[i]);
+        }
+        PyList_SetItem(resultObj, i, itemObj);
+    }
+
+    cksm_many_free(src, &cksm, n);
+    globus_libc_free(results);
+
+    return resultObj;
+}
+
+// make directories and all their parents, like mkdir -p, over handles
+// leased from a handle pool
+//
+// the directories are made one level at a time, those of a level in
+// parallel with at most window operations in flight, waiting without
+// the GIL. The pool keeps the directories it made or found to exist,
+// so later calls skip them, and a directory another call is making is
+// waited for rather than made twice. Returns a string with a C int per
+// URL, to be read into an array('i'): 0 for success or the FTP reply
+// code, -1, or -2 for a handle not leased within the optional timeout,
+// of the first directory on its path that failed
+PyObject * gridftp_handle_pool_makedirs(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * urlsObj;
+    PyObject * urlsSeq;
+    PyObject * opAttrObj;
+    PyObject * resultsObj;
+    handle_pool_t * pool;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    makedirs_leaf_t * leaves;
+    int * results;
+    char * url;
+    int window = 0;
+    double timeout = METADATA_ACQUIRE_TIMEOUT;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOOi|d", &poolObj, &urlsObj, &opAttrObj, &window, &timeout)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (window < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: window must be positive");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(opAttrObj);
+
+    urlsSeq = PySequence_Fast(urlsObj, "gridftpwrapper: urls must be a sequence");
+    if (urlsSeq == NULL){
+        return NULL;
+    }
+
+    n = PySequence_Fast_GET_SIZE(urlsSeq);
+    resultsObj = PyString_FromStringAndSize(NULL, sizeof(int) * n);
+    if (resultsObj == NULL){
+        Py_DECREF(urlsSeq);
+        return NULL;
+    }
+    results = (int *) PyString_AS_STRING(resultsObj);
+
+    // the call keeps its own normalized copy of the URLs since it runs
+    // without the GIL
+    leaves = (makedirs_leaf_t *) globus_malloc(sizeof(makedirs_leaf_t) * (n ? n : 1));
+    memset(leaves, 0, sizeof(makedirs_leaf_t) * (n ? n : 1));
+
+    for (i = 0; i < n; i++){
+        url = PyString_AsString(PySequence_Fast_GET_ITEM(urlsSeq, i));
+        if (url){
+            leaves[i].url = dir_cache_normalize(url, &(leaves[i].end));
+        }
+
+        if (url == NULL || leaves[i].url == NULL){
+            for (i--; i >= 0; i--){
+                globus_libc_free(leaves[i].url);
+            }
+            globus_libc_free(leaves);
+            Py_DECREF(urlsSeq);
+            Py_DECREF(resultsObj);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each URL must be a string");
+            return NULL;
+        }
+
+        leaves[i].index = (int) i;
+        results[i] = 0;
+    }
+
+    Py_DECREF(urlsSeq);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    qsort(leaves, n, sizeof(makedirs_leaf_t), makedirs_leaf_compare);
+    makedirs_run(pool, operation_attrp, leaves, (int) n, window, timeout, results);
+
+    for (i = 0; i < n; i++){
+        globus_libc_free(leaves[i].url);
+    }
+    globus_libc_free(leaves);
+
+    Py_END_ALLOW_THREADS
+
+    return resultsObj;
+}
+
+// forget the directories a handle pool knows to exist, so that the
+// next gridftp_handle_pool_makedirs checks them again, and return how
+// many were forgotten; given a URL, only the directory there and those
+// under it are forgotten
+PyObject * gridftp_handle_pool_forget_dirs(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    handle_pool_t * pool;
+    char * url = NULL;
+    long n;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O|z", &poolObj, &url)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    if (url){
+        n = dir_cache_forget_url(pool, url);
+        if (n < 0){
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to allocate normalized URL");
+            return NULL;
+        }
+        return Py_BuildValue("l", n);
+    }
+
+    globus_mutex_lock(&(pool -> dirs_mutex));
+    n = dir_cache_forget(pool, NULL, 0);
+    globus_mutex_unlock(&(pool -> dirs_mutex));
+
+    return Py_BuildValue("l", n);
+}
+
+// record directories as known to exist in the directory cache of a
+// handle pool, for instance those made by another client, so that
+// gridftp_handle_pool_makedirs skips them; the parents of a directory
+// are not recorded. Returns how many were not known before
+PyObject * gridftp_handle_pool_remember_dirs(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * urlsObj;
+    PyObject * urlsSeq;
+    handle_pool_t * pool;
+    dir_cache_entry_t * entry;
+    unsigned long bucket;
+    char * url;
+    char * norm;
+    int path;
+    long n = 0;
+    Py_ssize_t i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OO", &poolObj, &urlsObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    urlsSeq = PySequence_Fast(urlsObj, "gridftpwrapper: urls must be a sequence");
+    if (urlsSeq == NULL){
+        return NULL;
+    }
+
+    for (i = 0; i < PySequence_Fast_GET_SIZE(urlsSeq); i++){
+        url = PyString_AsString(PySequence_Fast_GET_ITEM(urlsSeq, i));
+        if (url == NULL){
+            Py_DECREF(urlsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each URL must be a string");
+            return NULL;
+        }
+
+        norm = dir_cache_normalize(url, &path);
+        if (norm == NULL){
+            Py_DECREF(urlsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to allocate normalized URL");
+            return NULL;
+        }
+
+        globus_mutex_lock(&(pool -> dirs_mutex));
+        entry = dir_cache_find(pool, norm, (int) strlen(norm), &bucket);
+        if (entry == NULL){
+            entry = dir_cache_add(pool, norm, (int) strlen(norm), bucket);
+            if (entry){
+                entry -> creating = GLOBUS_FALSE;
+                n++;
+            }
+        }
+        globus_mutex_unlock(&(pool -> dirs_mutex));
+
+        globus_libc_free(norm);
+
+        if (entry == NULL){
+            Py_DECREF(urlsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to allocate directory cache entry");
+            return NULL;
+        }
+    }
+
+    Py_DECREF(urlsSeq);
+
+    return Py_BuildValue("l", n);
+}
+
+// return a list of the normalized URLs of the directories a handle pool
+// knows to exist, in no particular order, leaving out those being made
+PyObject * gridftp_handle_pool_known_dirs(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * listObj;
+    PyObject * urlObj;
+    handle_pool_t * pool;
+    dir_cache_entry_t * entry;
+    int rc = 0;
+    int i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &poolObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    listObj = PyList_New(0);
+    if (listObj == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(pool -> dirs_mutex));
+    for (i = 0; pool -> dirs && i < DIR_CACHE_NBUCKETS && rc == 0; i++){
+        for (entry = pool -> dirs[i]; entry && rc == 0; entry = entry -> next){
+            if (entry -> creating){
+                continue;
+            }
+            urlObj = PyString_FromString(entry -> url);
+            rc = urlObj ? PyList_Append(listObj, urlObj) : -1;
+            Py_XDECREF(urlObj);
+        }
+    }
+    globus_mutex_unlock(&(pool -> dirs_mutex));
+
+    if (rc != 0){
+        Py_DECREF(listObj);
+        return NULL;
+    }
+
+    return listObj;
+}
+
+// destroy the idle handles of a handle pool, closing their cached
+// connections, and return how many were destroyed
+PyObject * gridftp_handle_pool_trim(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    handle_pool_t * pool;
+    int n;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &poolObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    n = handle_pool_trim(pool);
+    Py_END_ALLOW_THREADS
+
+    return Py_BuildValue("i", n);
+}
+
+// return a dictionary mapping each host:port of a handle pool to a
+// tuple of its number of idle and leased handles
+PyObject * gridftp_handle_pool_stats(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * statsObj;
+    PyObject * valueObj;
+    handle_pool_t * pool;
+    handle_pool_host_t * host;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &poolObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    statsObj = PyDict_New();
+
+    globus_mutex_lock(&(pool -> mutex));
+    for (host = pool -> hosts; host; host = host -> next){
+        valueObj = Py_BuildValue("(ii)", host -> nidle, host -> nleased);
+        PyDict_SetItemString(statsObj, host -> key, valueObj);
+        Py_XDECREF(valueObj);
+    }
+    globus_mutex_unlock(&(pool -> mutex));
+
+    return statsObj;
+}
+
+// destroy a handle pool and its idle handles; every leased handle must
+// have been released first
+PyObject * gridftp_handle_pool_destroy(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    handle_pool_t * pool;
+    handle_pool_host_t * host;
+    int busy = 0;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &poolObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(pool -> mutex));
+    busy = pool -> waiting;
+    for (host = pool -> hosts; host; host = host -> next){
+        busy += host -> nleased;
+    }
+    globus_mutex_unlock(&(pool -> mutex));
+
+    if (busy){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: handle pool still has leased handles");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    handle_pool_trim(pool);
+    Py_END_ALLOW_THREADS
+
+    while (pool -> hosts){
+        host = pool -> hosts;
+        pool -> hosts = host -> next;
+        globus_libc_free(host -> key);
+        globus_libc_free(host);
+    }
+
+    dir_cache_forget(pool, NULL, 0);
+    globus_libc_free(pool -> dirs);
+
+    globus_ftp_client_handleattr_destroy(&(pool -> attr));
+    globus_cond_destroy(&(pool -> cond));
+    globus_mutex_destroy(&(pool -> mutex));
+    globus_cond_destroy(&(pool -> dirs_cond));
+    globus_mutex_destroy(&(pool -> dirs_mutex));
+    globus_libc_free(pool);
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// create a transfer queue over a handle pool
+//
+// jobs are reported to the Python callback, or completion queue, given
+// here with (arg, src, dst, error). At most max_active transfers run at
+// once, and at most max_per_pair between one source and destination;
+// the handles are leased from the pool under the key of the pair, so
+// the cap of the pool applies per pair as well
+PyObject * gridftp_transfer_queue_init(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * srcOpAttrObj;
+    PyObject * dstOpAttrObj;
+    handle_pool_t * pool;
+    transfer_queue_t * tq;
+    globus_ftp_client_operationattr_t * src_operation_attrp = NULL;
+    globus_ftp_client_operationattr_t * dst_operation_attrp = NULL;
+    int max_active = 0;
+    int max_per_pair = 0;
+
+    globus_result_t gridftp_result = GLOBUS_SUCCESS;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOiiOO",
+            &poolObj,
+            &completeCallbackFunctionObj,
+            &max_active,
+            &max_per_pair,
+            &srcOpAttrObj,
+            &dstOpAttrObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (max_active < 1 || max_per_pair < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: max_active and max_per_pair must be positive");
+        return NULL;
+    }
+
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
+
+    src_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(srcOpAttrObj);
+    dst_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(dstOpAttrObj);
+
+    tq = (transfer_queue_t *) globus_malloc(sizeof(transfer_queue_t));
+    memset(tq, 0, sizeof(transfer_queue_t));
+    tq -> pool = pool;
+    tq -> max_active = max_active;
+    tq -> max_per_pair = max_per_pair;
+    tq -> batch_max = 1;
+
+    // the queue keeps its own copy of the attributes since jobs start
+    // long after this call returns
+    if (src_operation_attrp){
+        gridftp_result = globus_ftp_client_operationattr_copy(&(tq -> src_attr), src_operation_attrp);
+        tq -> has_src_attr = (gridftp_result == GLOBUS_SUCCESS);
+    }
+    if (gridftp_result == GLOBUS_SUCCESS && dst_operation_attrp){
+        gridftp_result = globus_ftp_client_operationattr_copy(&(tq -> dst_attr), dst_operation_attrp);
+        tq -> has_dst_attr = (gridftp_result == GLOBUS_SUCCESS);
+    }
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        if (tq -> has_src_attr){
+            globus_ftp_client_operationattr_destroy(&(tq -> src_attr));
+        }
+        globus_libc_free(tq);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to copy operation attributes", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    globus_mutex_init(&(tq -> mutex), NULL);
+    globus_cond_init(&(tq -> cond), NULL);
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    tq -> pyfunction = completeCallbackFunctionObj;
+    tq -> poolObj = poolObj;
+    Py_INCREF(tq -> pyfunction);
+    Py_INCREF(tq -> poolObj);
+
+    return PyCObject_FromVoidPtrAndDesc((void *) tq, (void *) transfer_queue_tag, NULL);
+}
+
+// set the size policy of a transfer queue
+//
+// files of at least chunk_threshold bytes are split into chunks of
+// chunk_size bytes and files under small_threshold bytes are pipelined
+// up to batch_max at a time; a threshold of 0 turns that part off and
+// both at 0 stop the size queries. Applies to jobs not yet started
+PyObject * gridftp_transfer_queue_set_policy(PyObject *self, PyObject *args)
+{
+    PyObject * tqObj;
+    transfer_queue_t * tq;
+    PY_LONG_LONG chunk_threshold = 0;
+    PY_LONG_LONG chunk_size = 0;
+    PY_LONG_LONG small_threshold = 0;
+    int batch_max = 0;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OLLLi", &tqObj, &chunk_threshold, &chunk_size, &small_threshold, &batch_max)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (chunk_threshold < 0 || small_threshold < 0 || batch_max < 1 || (chunk_threshold > 0 && chunk_size < 1)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: thresholds must not be negative, and chunk_size and batch_max must be positive");
+        return NULL;
+    }
+
+    tq = transfer_queue_from_object(tqObj);
+    if (tq == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(tq -> mutex));
+    tq -> chunk_threshold = (globus_off_t) chunk_threshold;
+    tq -> chunk_size = (globus_off_t) chunk_size;
+    tq -> small_threshold = (globus_off_t) small_threshold;
+    tq -> batch_max = batch_max;
+    tq -> sizing = (chunk_threshold > 0 || small_threshold > 0);
+    globus_mutex_unlock(&(tq -> mutex));
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
+
+// add jobs to a transfer queue and start as many as the limits allow
+//
+// jobs is a sequence of (src, dst[, priority[, arg[, size]]]) tuples,
+// priority being from 0, the highest, to TRANSFER_PRIORITIES - 1 and 0
+// if not given. A size of 0 or more spares the size query of the size
+// policy for the job. Returns the number of jobs added
+PyObject * gridftp_transfer_queue_submit(PyObject *self, PyObject *args)
+{
+    PyObject * tqObj;
+    PyObject * jobsObj;
+    PyObject * jobsSeq;
+    PyObject * argObj;
+    transfer_queue_t * tq;
+    transfer_job_t * jobs = NULL;
+    transfer_job_t * failed = NULL;
+    transfer_job_t * job;
+    transfer_pair_t * pair;
+    char srckey[1024];
+    char dstkey[1024];
+    char key[2056];
+    char * src;
+    char * dst;
+    int priority;
+    PY_LONG_LONG size;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OO", &tqObj, &jobsObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    tq = transfer_queue_from_object(tqObj);
+    if (tq == NULL){
+        return NULL;
+    }
+
+    jobsSeq = PySequence_Fast(jobsObj, "gridftpwrapper: jobs must be a sequence");
+    if (jobsSeq == NULL){
+        return NULL;
+    }
+
+    // build every job first so that a bad one adds none of them
+    n = PySequence_Fast_GET_SIZE(jobsSeq);
+    jobs = (transfer_job_t *) globus_malloc(sizeof(transfer_job_t) * (n ? n : 1));
+    memset(jobs, 0, sizeof(transfer_job_t) * (n ? n : 1));
+
+    for (i = 0; i < n; i++){
+        priority = 0;
+        argObj = Py_None;
+        size = -1;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(jobsSeq, i), "ss|iOL", &src, &dst, &priority, &argObj, &size)
+                || priority < 0 || priority >= TRANSFER_QUEUE_NPRIORITIES){
+            for (i--; i >= 0; i--){
+                globus_libc_free(jobs[i].src);
+                globus_libc_free(jobs[i].dst);
+                Py_DECREF(jobs[i].pyarg);
+            }
+            globus_libc_free(jobs);
+            Py_DECREF(jobsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each job must be a (src, dst[, priority[, arg[, size]]]) tuple with a valid priority");
+            return NULL;
+        }
+
+        jobs[i].queue = tq;
+        jobs[i].src = globus_libc_strdup(src);
+        jobs[i].dst = globus_libc_strdup(dst);
+        jobs[i].priority = priority;
+        jobs[i].size = (globus_off_t) (size < 0 ? -1 : size);
+        jobs[i].sized = (size >= 0);
+        jobs[i].pyarg = argObj;
+        Py_INCREF(argObj);
+    }
+
+    Py_DECREF(jobsSeq);
+
+    // each job holds a reference to the callback function, which a
+    // completion record takes over like the job argument
+    for (i = 0; i < n; i++){
+        Py_INCREF(tq -> pyfunction);
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+
+    // the job array only carries the jobs in; each is queued on its own
+    for (i = 0; i < n; i++){
+        handle_pool_key(jobs[i].src, srckey, sizeof(srckey));
+        handle_pool_key(jobs[i].dst, dstkey, sizeof(dstkey));
+        snprintf(key, sizeof(key), "%s>%s", srckey, dstkey);
+
+        job = (transfer_job_t *) globus_malloc(sizeof(transfer_job_t));
+        memcpy(job, &(jobs[i]), sizeof(transfer_job_t));
+
+        globus_mutex_lock(&(tq -> mutex));
+        pair = transfer_queue_pair_for(tq, key);
+        if (pair){
+            job -> pair = pair;
+            transfer_queue_enqueue(tq, job, GLOBUS_FALSE);
+        }
+        globus_mutex_unlock(&(tq -> mutex));
+
+        // out of memory, report the job as failed once the others are in
+        if (pair == NULL){
+            job -> next = failed;
+            failed = job;
+        }
+    }
+
+    while (failed){
+        job = failed;
+        failed = job -> next;
+        transfer_queue_report(job, "gridftpwrapper: unable to allocate transfer queue pair");
+    }
+
+    transfer_queue_schedule(tq);
+
+    Py_END_ALLOW_THREADS
+
+    globus_libc_free(jobs);
+
+    return Py_BuildValue("n", n);
+}
+
+// return a dictionary with the number of jobs of a transfer queue that
+// are queued, counting each chunk, and completed, the number of its
+// transfers running, its number of endpoint pairs, and the number of
+// chunk and pipelined transfers it started
+PyObject * gridftp_transfer_queue_stats(PyObject *self, PyObject *args)
+{
+    PyObject * tqObj;
+    PyObject * statsObj;
+    transfer_queue_t * tq;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &tqObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    tq = transfer_queue_from_object(tqObj);
+    if (tq == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(tq -> mutex));
+    statsObj = Py_BuildValue("{s:l,s:i,s:l,s:i,s:l,s:l}",
+        "queued", tq -> queued,
+        "active", tq -> active,
+        "completed", tq -> completed,
+        "pairs", tq -> npairs,
+        "chunks", tq -> chunks,
+        "batches", tq -> batches);
+    globus_mutex_unlock(&(tq -> mutex));
+
+    return statsObj;
+}
+
+// destroy a transfer queue
+//
+// jobs not yet started are dropped without being reported, then the
+// call waits, without the GIL, for the running transfers to complete
+// and be reported. Returns the number of jobs dropped
+PyObject * gridftp_transfer_queue_destroy(PyObject *self, PyObject *args)
+{
+    PyObject * tqObj;
+    transfer_queue_t * tq;
+    transfer_job_t * dropped = NULL;
+    transfer_job_t * job;
+    long ndropped = 0;
+    int pass;
+    int i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &tqObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    tq = transfer_queue_from_object(tqObj);
+    if (tq == NULL){
+        return NULL;
+    }
 
-    // now call the Python callback function
-    result = PyEval_CallObject(func, arglist);
+    // jobs are dropped again once nothing runs, since size queries and
+    // pipelined transfers completing meanwhile queue jobs back
+    for (pass = 0; pass < 2; pass++){
+        globus_mutex_lock(&(tq -> mutex));
+        tq -> closed = GLOBUS_TRUE;
+        for (i = 0; i < tq -> npairs; i++){
+            transfer_queue_drop_pair(tq, tq -> pairs[i], &dropped);
+        }
+        tq -> queued = 0;
+        memset(tq -> queued_per_priority, 0, sizeof(tq -> queued_per_priority));
+        globus_mutex_unlock(&(tq -> mutex));
+
+        while (dropped){
+            job = dropped;
+            dropped = job -> next;
+            Py_XDECREF(job -> pyarg);
+            Py_DECREF(tq -> pyfunction);
+            globus_libc_free(job -> src);
+            globus_libc_free(job -> dst);
+            globus_libc_free(job -> error);
+            globus_libc_free(job);
+            ndropped++;
+        }
 
-    if (result == NULL) {
+        if (pass > 0){
+            break;
+        }
 
-        // something went wrong so print to stderr
-        PyErr_Print();
+        Py_BEGIN_ALLOW_THREADS
+
+        globus_mutex_lock(&(tq -> mutex));
+        while (tq -> active > 0 || tq -> pending > 0){
+            globus_cond_wait(&(tq -> cond), &(tq -> mutex));
+        }
+        globus_mutex_unlock(&(tq -> mutex));
+
+        Py_END_ALLOW_THREADS
     }
 
-    // take care of reference handling
-    Py_DECREF(handleObj);
-    Py_DECREF(arglist);
-    Py_XDECREF(result);
-    Py_XDECREF(errorObject);
+    for (i = 0; i < tq -> npairs; i++){
+        globus_libc_free(tq -> pairs[i] -> key);
+        globus_libc_free(tq -> pairs[i]);
+    }
+    globus_libc_free(tq -> pairs);
 
-    // release the Python GIL from this thread
-    PyGILState_Release(gstate);
+    if (tq -> has_src_attr){
+        globus_ftp_client_operationattr_destroy(&(tq -> src_attr));
+    }
+    if (tq -> has_dst_attr){
+        globus_ftp_client_operationattr_destroy(&(tq -> dst_attr));
+    }
 
-    // free the space the callback bucket was holding
-    free(callbackBucket);
+    globus_cond_destroy(&(tq -> cond));
+    globus_mutex_destroy(&(tq -> mutex));
+    Py_DECREF(tq -> pyfunction);
+    Py_DECREF(tq -> poolObj);
+    globus_libc_free(tq);
 
-    return;
+    return Py_BuildValue("l", ndropped);
 }
 
+// create a tree walker that lists the directories below roots over
+// handles leased from a handle pool, with MLSD, up to max_active at
+// once, and start it
+//
+// roots is a sequence of directory URLs. Directories found more than
+// max_depth levels below a root are not listed, unless max_depth is
+// negative. Returns the walker, to be drained with gridftp_walker_next
+PyObject * gridftp_walker_init(PyObject *self, PyObject *args)
+{
+    PyObject * poolObj;
+    PyObject * rootsObj;
+    PyObject * rootsSeq;
+    PyObject * OpAttrObj;
+    handle_pool_t * pool;
+    walker_t * walker;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    int max_active = 0;
+    int max_depth = -1;
+    char * root;
+    Py_ssize_t n;
+    Py_ssize_t i;
 
+    globus_result_t gridftp_result = GLOBUS_SUCCESS;
+    char msg[2048] = "";
 
-//
-// This section of the code is for functions called 
-// by the Python module.
-//
-//
-//
-//
-//
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOOii",
+            &poolObj,
+            &rootsObj,
+            &OpAttrObj,
+            &max_active,
+            &max_depth
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
 
+    if (max_active < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: max_active must be positive");
+        return NULL;
+    }
 
-// activate the Globus modules
-PyObject * gridftp_modules_activate(PyObject * self, PyObject * args)
-{
-    int           i;
-    int           rc;
+    pool = handle_pool_from_object(poolObj);
+    if (pool == NULL){
+        return NULL;
+    }
 
-    // this is new with Globus 5.2.x
-    Py_BEGIN_ALLOW_THREADS
-	globus_thread_set_model("pthread");
-    Py_END_ALLOW_THREADS
-	
+    rootsSeq = PySequence_Fast(rootsObj, "gridftpwrapper: roots must be a sequence");
+    if (rootsSeq == NULL){
+        return NULL;
+    }
 
+    n = PySequence_Fast_GET_SIZE(rootsSeq);
+    for (i = 0; i < n; i++){
+        if (!PyString_Check(PySequence_Fast_GET_ITEM(rootsSeq, i))){
+            Py_DECREF(rootsSeq);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: each root must be a string");
+            return NULL;
+        }
+    }
 
-    for (i = 0; i < NMODS; i++){
-    
-        Py_BEGIN_ALLOW_THREADS
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-        rc = globus_module_activate(modules[i]);
+    walker = (walker_t *) globus_malloc(sizeof(walker_t));
+    if (walker == NULL){
+        Py_DECREF(rootsSeq);
+        return PyErr_NoMemory();
+    }
+    memset(walker, 0, sizeof(walker_t));
+    walker -> pool = pool;
+    walker -> max_active = max_active;
+    walker -> max_depth = max_depth;
+
+    // the walker keeps its own copy of the attributes since listings
+    // start long after this call returns
+    if (operation_attrp){
+        gridftp_result = globus_ftp_client_operationattr_copy(&(walker -> attr), operation_attrp);
+        walker -> has_attr = (gridftp_result == GLOBUS_SUCCESS);
+    }
 
-        Py_END_ALLOW_THREADS
+    if (gridftp_result != GLOBUS_SUCCESS){
+        Py_DECREF(rootsSeq);
+        globus_libc_free(walker);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to copy operation attributes", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
 
-        if (rc != GLOBUS_SUCCESS) {
-	  PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to activate Globus module");
+    globus_mutex_init(&(walker -> mutex), NULL);
+    globus_cond_init(&(walker -> cond), NULL);
+
+    // the roots are pushed last first so they are listed in order
+    for (i = n - 1; i >= 0; i--){
+        root = globus_libc_strdup(PyString_AsString(PySequence_Fast_GET_ITEM(rootsSeq, i)));
+        if (root){
+            walker_push(walker, root, 0);
         }
     }
 
-    // one of the globus modules changes the signal handling behavior.
-    // http://jira.globus.org/browse/GT-360
-    // The next line ensures that any forked subprocesses still catch
-    // SIGTERM, SIGHUP, SIGINT. Without this line, these signals are
-    // not passed along and forked processes will miss these messages.
+    Py_DECREF(rootsSeq);
+
+    // since we are holding a pointer to the pool object we need to
+    // increase its reference count
+    walker -> poolObj = poolObj;
+    Py_INCREF(walker -> poolObj);
+
     Py_BEGIN_ALLOW_THREADS
-      pthread_atfork(&prepare, &parent, &child);
+    walker_schedule(walker);
     Py_END_ALLOW_THREADS
 
-
-    Py_RETURN_NONE;
+    return PyCObject_FromVoidPtrAndDesc((void *) walker, (void *) walker_tag, NULL);
 }
 
-// deactivate the Globus modules
-PyObject * gridftp_modules_deactivate(PyObject * self, PyObject * args)
+// take the directory listings of a tree walker that are ready, up to
+// max_results, waiting without the GIL up to timeout seconds for one
+// if none is, or for ever if timeout is negative
+//
+// returns a (done, results) tuple, done being true once every directory
+// has been listed and taken, and results a list of (url, listing, error)
+// tuples, listing being the columns built by listing_to_python and
+// error the error text or None
+PyObject * gridftp_walker_next(PyObject *self, PyObject *args)
 {
-    int   i;
+    PyObject * walkerObj;
+    PyObject * resultsObj;
+    PyObject * listingObj;
+    PyObject * itemObj;
+    walker_t * walker;
+    walker_result_t * taken = NULL;
+    walker_result_t * tail = NULL;
+    walker_result_t * result;
+    globus_abstime_t abstime;
+    globus_bool_t done = GLOBUS_FALSE;
+    int max_results = 0;
+    double timeout = -1.0;
+    int rc = 0;
+    int k = 0;
 
-    for (i = NMODS - 1; i >= 0; i--){
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "Oid", &walkerObj, &max_results, &timeout)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
 
-        Py_BEGIN_ALLOW_THREADS
+    if (max_results < 1){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: max_results must be positive");
+        return NULL;
+    }
 
-        globus_module_deactivate(modules[i]);
+    walker = walker_from_object(walkerObj);
+    if (walker == NULL){
+        return NULL;
+    }
 
-        Py_END_ALLOW_THREADS
+    Py_BEGIN_ALLOW_THREADS
 
+    if (timeout > 0){
+        gridftp_abstime_after(timeout, &abstime);
     }
-    
-    Py_RETURN_NONE;
-}
 
-// create a buffer for storing data from a get or put operation
-// and return a wrapped pointer to the buffer
-PyObject * gridftp_create_buffer(PyObject * self, PyObject * args)
-{
+    globus_mutex_lock(&(walker -> mutex));
+    while (walker -> ready == NULL && (walker -> queued > 0 || walker -> active > 0)
+            && timeout != 0 && rc != ETIMEDOUT){
+        if (timeout > 0){
+            rc = globus_cond_timedwait(&(walker -> cond), &(walker -> mutex), &abstime);
+        } else{
+            globus_cond_wait(&(walker -> cond), &(walker -> mutex));
+        }
+    }
 
-    globus_byte_t * buffer = NULL;
-    unsigned long size;
-    char msg[2048] = "";
+    while (walker -> ready && k < max_results){
+        result = walker -> ready;
+        walker -> ready = result -> next;
+        result -> next = NULL;
+        if (tail){
+            tail -> next = result;
+        } else{
+            taken = result;
+        }
+        tail = result;
+        k++;
+    }
+    if (walker -> ready == NULL){
+        walker -> ready_tail = NULL;
+    }
+    walker -> nready -= k;
 
-    PyObject * bufferObj;
+    done = (walker -> ready == NULL && walker -> queued == 0 && walker -> active == 0);
+    globus_mutex_unlock(&(walker -> mutex));
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "k", &size)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
-        return NULL;
+    // taking listings makes room for more
+    if (k > 0 && !done){
+        walker_schedule(walker);
     }
 
-    // allocate the memory
-    Py_BEGIN_ALLOW_THREADS
+    Py_END_ALLOW_THREADS
 
-    buffer = globus_malloc(sizeof(globus_byte_t) * size);
+    resultsObj = PyList_New(0);
+    while (taken){
+        result = taken;
+        taken = result -> next;
+
+        if (resultsObj){
+            listingObj = listing_to_python(&(result -> listing));
+            itemObj = listingObj ? Py_BuildValue("(sNz)", result -> url, listingObj, result -> error) : NULL;
+            if (itemObj == NULL || PyList_Append(resultsObj, itemObj) < 0){
+                Py_CLEAR(resultsObj);
+            }
+            Py_XDECREF(itemObj);
+        }
 
-    Py_END_ALLOW_THREADS
+        listing_free(&(result -> listing));
+        globus_libc_free(result -> url);
+        globus_libc_free(result -> error);
+        globus_libc_free(result);
+    }
 
-    if (buffer == NULL) {
-        sprintf(msg, "gridftpwrapper: unable to create buffer");
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    if (resultsObj == NULL){
         return NULL;
     }
 
-    // set the memory contents to zero
-    memset(buffer, 0, (size_t) size);
+    return Py_BuildValue("(NN)", PyBool_FromLong(done), resultsObj);
+}
 
-    // wrap pointer to buffer and return
-    bufferObj = PyCObject_FromVoidPtr((void *) buffer, NULL);
+// return a dictionary with the number of directories of a tree walker
+// that are queued, being listed, listed and waiting for Python, and
+// listed in all, and the number of entries found
+PyObject * gridftp_walker_stats(PyObject *self, PyObject *args)
+{
+    PyObject * walkerObj;
+    PyObject * statsObj;
+    walker_t * walker;
 
-    return bufferObj;
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &walkerObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    walker = walker_from_object(walkerObj);
+    if (walker == NULL){
+        return NULL;
+    }
+
+    globus_mutex_lock(&(walker -> mutex));
+    statsObj = Py_BuildValue("{s:l,s:i,s:l,s:l,s:l,s:l}",
+        "queued", walker -> queued,
+        "active", walker -> active,
+        "ready", walker -> nready,
+        "dirs", walker -> ndirs,
+        "entries", walker -> nentries,
+        "errors", walker -> nerrors);
+    globus_mutex_unlock(&(walker -> mutex));
+
+    return statsObj;
 }
 
-// destroy a buffer previously created
-PyObject * gridftp_destroy_buffer(PyObject * self, PyObject * args)
+// destroy a tree walker
+//
+// directories not yet listed are dropped, then the call waits, without
+// the GIL, for the running listings to complete. Listings not taken are
+// freed. Returns the number of directories dropped
+PyObject * gridftp_walker_destroy(PyObject *self, PyObject *args)
 {
-
-    globus_byte_t * buffer = NULL;
-    PyObject * bufferObj;
+    PyObject * walkerObj;
+    walker_t * walker;
+    walker_host_t * host;
+    walker_dir_t * dir;
+    walker_result_t * result;
+    long ndropped;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &bufferObj)){
+    if (!PyArg_ParseTuple(args, "O", &walkerObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
+    walker = walker_from_object(walkerObj);
+    if (walker == NULL){
+        return NULL;
+    }
 
-    // free the memory
     Py_BEGIN_ALLOW_THREADS
 
-    globus_libc_free(buffer);
+    // once closed no directory is queued, so those left are final
+    globus_mutex_lock(&(walker -> mutex));
+    walker -> closed = GLOBUS_TRUE;
+    while (walker -> active > 0 || walker -> pending > 0){
+        globus_cond_wait(&(walker -> cond), &(walker -> mutex));
+    }
+    ndropped = walker -> queued;
+    globus_mutex_unlock(&(walker -> mutex));
 
     Py_END_ALLOW_THREADS
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    while (walker -> hosts){
+        host = walker -> hosts;
+        walker -> hosts = host -> next;
+        while (host -> dirs){
+            dir = host -> dirs;
+            host -> dirs = dir -> next;
+            globus_libc_free(dir -> url);
+            globus_libc_free(dir);
+        }
+        globus_libc_free(host -> key);
+        globus_libc_free(host);
+    }
+
+    while (walker -> ready){
+        result = walker -> ready;
+        walker -> ready = result -> next;
+        listing_free(&(result -> listing));
+        globus_libc_free(result -> url);
+        globus_libc_free(result -> error);
+        globus_libc_free(result);
+    }
+
+    if (walker -> has_attr){
+        globus_ftp_client_operationattr_destroy(&(walker -> attr));
+    }
+
+    globus_cond_destroy(&(walker -> cond));
+    globus_mutex_destroy(&(walker -> mutex));
+    Py_DECREF(walker -> poolObj);
+    globus_libc_free(walker);
+
+    return Py_BuildValue("l", ndropped);
 }
 
-// return a Python string representation of the data in a buffer
-PyObject * gridftp_buffer_to_string(PyObject * self, PyObject * args)
+// abort whatever operation is currently going on for a handle
+PyObject * gridftp_abort(PyObject *self, PyObject *args)
 {
+    globus_ftp_client_handle_t * handlep = NULL;
 
-    globus_byte_t * buffer = NULL;
-    unsigned long size;
-    PyObject * bufferObj;
-    PyObject * pyString;
+    PyObject * handleObj;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = ""; 
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "Ok", &bufferObj, &size)){
+    if (!PyArg_ParseTuple(args, "O", &handleObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
+ 
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
 
-    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
+    // abort the current operation
 
-    // free the memory
     Py_BEGIN_ALLOW_THREADS
 
-    pyString = PyString_FromStringAndSize((char*) buffer, size);
+    gridftp_result = globus_ftp_client_abort(handlep);
 
     Py_END_ALLOW_THREADS
 
-    return pyString; 
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to abort", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // return None to indicate success
+    Py_RETURN_NONE;
+
 }
 
-// initialize a handle attribute and return a wrapped pointer
-// to it
-PyObject * gridftp_handleattr_init(PyObject *self, PyObject *args)
+// initialize a performance marker plugin and return a wrapped
+// pointer to it and a wrapped pointer to the callback struct
+// that is used to carry around the pointers to the Python 
+// callback functions that should be called when a transfer
+// starts, when a performance marker is received, and when the
+// transfer completes
+PyObject * gridftp_perf_plugin_init(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handleattr_t  * handle_attr = NULL;
+    globus_ftp_client_plugin_t * pluginp = NULL;
+    PyObject * pluginObj;
+
+    PyObject * perfBeginCB = NULL;
+    PyObject * perfMarkerCB = NULL;
+    PyObject * perfCompleteCB = NULL;
+    PyObject * userArg = NULL;
+
+    perf_plugin_callback_bucket_t * callbackBucket;
+    PyObject * callbackObj = NULL;
+
     globus_result_t gridftp_result;
-    PyObject * handleAttr = NULL;
     char msg[2048] = "";
 
-    handle_attr = (globus_ftp_client_handleattr_t *) globus_malloc(sizeof(globus_ftp_client_handleattr_t));
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OOOO", &perfBeginCB, &perfMarkerCB, &perfCompleteCB, &userArg)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+ 
+    // create memory for the globus_ftp_client_plugin_t
+    pluginp = (globus_ftp_client_plugin_t *) globus_malloc(sizeof(globus_ftp_client_plugin_t));
+
+    // create a callback struct to hold the callback information
+    callbackBucket = (perf_plugin_callback_bucket_t *) globus_malloc(sizeof(perf_plugin_callback_bucket_t));
+    callbackBucket -> begincb = perfBeginCB;
+    callbackBucket -> markercb = perfMarkerCB;
+    callbackBucket -> completecb = perfCompleteCB;
+    callbackBucket -> userarg = userArg;
+    callbackBucket -> refs = 1;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> begincb);
+    Py_XINCREF(callbackBucket -> markercb);
+    Py_XINCREF(callbackBucket -> completecb);
+    Py_XINCREF(callbackBucket -> userarg);
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handleattr_init(handle_attr);
+    gridftp_result = globus_ftp_client_perf_plugin_init(
+        pluginp,
+        perf_plugin_begin_cb,
+        perf_plugin_marker_cb,
+        perf_plugin_complete_cb,
+        callbackBucket);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle attribute", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize perf plugin", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
     
 
-    // wrap pointer to handle attribute and return
-    handleAttr = PyCObject_FromVoidPtr((void *) handle_attr, NULL);
+    // wrap pointer to plugin and callback struct and return
+    pluginObj = PyCObject_FromVoidPtr((void *) pluginp, NULL);
+    callbackObj = PyCObject_FromVoidPtr((void *) callbackBucket, NULL);
+
+    return Py_BuildValue("(OO)", (void *) pluginObj, (void *) callbackObj);
 
-    return handleAttr;
 }
 
-// initialize a handle and return a wrapper pointer to it
-PyObject * gridftp_handle_init(PyObject *self, PyObject *args)
+// destroy a previously created performance marker plugin and the
+// callback that was created at the same time
+PyObject * gridftp_perf_plugin_destroy(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handle_t * handle = NULL;
-    globus_ftp_client_handleattr_t * handle_attr = NULL;
-    PyObject * handleAttr = NULL;
-    PyObject * handleObject = NULL;
+    globus_ftp_client_plugin_t * pluginp = NULL;
+    PyObject * pluginObj;
+    PyObject * callbackObj;
+    perf_plugin_callback_bucket_t * callbackBucket = NULL;
+
     globus_result_t gridftp_result;
     char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &handleAttr)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle attr object");
-        return NULL;
-    }
- 
-    if PyCObject_Check(handleAttr){
-        handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
-    } else {
-        sprintf(msg, "gridftpwrapper: unable to obtain pointer to handle_attr");
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    if (!PyArg_ParseTuple(args, "OO", &pluginObj, &callbackObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-    handle = (globus_ftp_client_handle_t *) globus_malloc(sizeof(globus_ftp_client_handle_t));
+   // obtain the C pointers from the Python pointers 
+   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
+   callbackBucket = (perf_plugin_callback_bucket_t *) PyCObject_AsVoidPtr(callbackObj);
+ 
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handle_init(handle, handle_attr);
+    gridftp_result = globus_ftp_client_perf_plugin_destroy(pluginp);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize handle", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy perf plugin", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
 
-    // wrap pointer to handle and return
-    handleObject = PyCObject_FromVoidPtr((void *) handle, NULL);
+    // free the memory used by the plugin
+    globus_free(pluginp);
 
-    return handleObject;
+    // free the memory used by the perf callback struct, or leave that to
+    // the last of its records still waiting in a completion queue
+    perf_plugin_bucket_release(callbackBucket);
 
+    // return None to indicate success
+    Py_RETURN_NONE;
 }
 
-// destroy a previously created handle attribute
-PyObject * gridftp_handleattr_destroy(PyObject *self, PyObject *args)
+// add a plugin to a handle
+PyObject * gridftp_handle_add_plugin(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handleattr_t * handle_attr = NULL;
-    PyObject * handleAttr = NULL;
+    globus_ftp_client_handle_t * handlep = NULL;
+    globus_ftp_client_plugin_t * pluginp = NULL;
+    PyObject * handleObj;
+    PyObject * pluginObj;
+
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &handleAttr)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle attr object");
+    if (!PyArg_ParseTuple(args, "OO", &handleObj, &pluginObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+
+   // obtain the C pointers from the Python pointers 
+   handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handleattr_destroy(handle_attr);
+    gridftp_result = globus_ftp_client_handle_add_plugin(handlep, pluginp);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy handle attr", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to add plugin to handle", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
+
     // return None to indicate success
     Py_RETURN_NONE;
 
 }
 
-// set the 'cache all' setting on a handle attribute
-PyObject * gridftp_handleattr_set_cache_all(PyObject *self, PyObject *args)
+// remove a plugin from a handle
+PyObject * gridftp_handle_remove_plugin(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handleattr_t * handle_attr = NULL;
-    PyObject * handleAttr = NULL;
-    int cache_all;
+    globus_ftp_client_handle_t * handlep = NULL;
+    globus_ftp_client_plugin_t * pluginp = NULL;
+    PyObject * handleObj;
+    PyObject * pluginObj;
+
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &handleAttr, &cache_all)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to arguments");
+    if (!PyArg_ParseTuple(args, "OO", &handleObj, &pluginObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    handle_attr = (globus_ftp_client_handleattr_t *) PyCObject_AsVoidPtr(handleAttr);
+
+   // obtain the C pointers from the Python pointers 
+   handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handleattr_set_cache_all(handle_attr, (globus_bool_t) cache_all);
+    gridftp_result = globus_ftp_client_handle_remove_plugin(handlep, pluginp);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to set cache all boolean", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to remove plugin from handle", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
+
     // return None to indicate success
     Py_RETURN_NONE;
 
 }
 
-// destroy a previously created handle
-PyObject * gridftp_handle_destroy(PyObject *self, PyObject *args)
+// check for existence of a file or directory, i.e. a URL
+// the status is returned in a callback, along with the FTP reply code
+// of the error if withCode is true: 550 for a missing path, or 0
+PyObject * gridftp_exists(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handle_t * handle = NULL;
-    PyObject * handleObject = NULL;
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * completeCallbackFunctionObj;
+    PyObject * completeCallbackArgObj;
+
+    exists_callback_bucket_t * callbackBucket = NULL;
+    int withCode = 0;
+
     globus_result_t gridftp_result;
     char msg[2048] = ""; 
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &handleObject)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse handle object");
+    if (!PyArg_ParseTuple(args, "OsOOO|i", 
+            &handleObj, 
+            &url, 
+            &OpAttrObj,
+            &completeCallbackFunctionObj,
+            &completeCallbackArgObj,
+            &withCode
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
  
-    handle = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObject);
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
+
+    // create an exists callback struct to hold the callback information
+    callbackBucket = (exists_callback_bucket_t *) globus_malloc(sizeof(exists_callback_bucket_t));
+    callbackBucket -> pyfunction = completeCallbackFunctionObj;
+    callbackBucket -> pyarg = completeCallbackArgObj;
+    callbackBucket -> with_code = withCode;
+
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_XINCREF(callbackBucket -> pyfunction);
+    Py_XINCREF(callbackBucket -> pyarg);
+
+    // kick off the exists operation
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handle_destroy(handle);
+    gridftp_result = globus_ftp_client_exists(
+		         handlep,
+                        url,
+                        operation_attrp,
+                        exists_complete_callback,
+                        (void *) callbackBucket
+                        );
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy handle", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to start exists operation", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
+
     // return None to indicate success
     Py_RETURN_NONE;
 
 }
 
-// initialize an operation attribute and return a wrapped pointer
-// to it
-PyObject * gridftp_operationattr_init(PyObject *self, PyObject *args)
-{
-    globus_ftp_client_operationattr_t  * operation_attr = NULL;
-    globus_result_t gridftp_result;
-    PyObject * opAttr = NULL;
-    char msg[2048] = "";
-
-    operation_attr = (globus_ftp_client_operationattr_t *) globus_malloc(sizeof(globus_ftp_client_operationattr_t));
-
-    Py_BEGIN_ALLOW_THREADS
-
-    gridftp_result = globus_ftp_client_operationattr_init(operation_attr);
-
-    Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize operation attribute", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
-    }
-    
-    // wrap pointer to operation attribute and return
-    opAttr = PyCObject_FromVoidPtr((void *) operation_attr, NULL);
+// call a Python function with a tuple of arguments from a Globus
+// thread, as the completion callbacks are, rather than from the
+// calling thread; used to deliver answers that need no round trip
+PyObject * gridftp_callback_oneshot(PyObject *self, PyObject *args)
+{
+    PyObject * functionObj;
+    PyObject * argsObj;
 
-    return opAttr;
-}
+    oneshot_callback_bucket_t * callbackBucket = NULL;
 
-// destroy a previously created operation attribute
-PyObject * gridftp_operationattr_destroy(PyObject *self, PyObject *args)
-{
-    globus_ftp_client_operationattr_t * operation_attr = NULL;
-    PyObject * opAttr = NULL;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &opAttr)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse operation attr object");
+    if (!PyArg_ParseTuple(args, "OO!",
+            &functionObj,
+            &PyTuple_Type,
+            &argsObj
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
 
-    Py_BEGIN_ALLOW_THREADS
+    callbackBucket = (oneshot_callback_bucket_t *) globus_malloc(sizeof(oneshot_callback_bucket_t));
+    if (callbackBucket == NULL){
+        return PyErr_NoMemory();
+    }
+    callbackBucket -> pyfunction = functionObj;
+    callbackBucket -> pyargs = argsObj;
 
-    gridftp_result = globus_ftp_client_operationattr_destroy(operation_attr);
+    // since we are holding pointers to these objects we need to increase
+    // the reference count for each
+    Py_INCREF(callbackBucket -> pyfunction);
+    Py_INCREF(callbackBucket -> pyargs);
 
-    Py_END_ALLOW_THREADS
+    gridftp_result = globus_callback_register_oneshot(NULL, NULL, oneshot_callback, (void *) callbackBucket);
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy operation attr", gridftp_result);
+        Py_DECREF(callbackBucket -> pyfunction);
+        Py_DECREF(callbackBucket -> pyargs);
+        free(callbackBucket);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to register callback", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
+
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// set the mode on an operation attribute
-PyObject * gridftp_operationattr_set_mode(PyObject *self, PyObject *args)
+// create a completion queue
+//
+// the returned object may be passed to any operation in place of its
+// callback function; the events are then collected with
+// gridftp_completion_queue_drain instead of calling into Python on the
+// Globus threads
+PyObject * gridftp_completion_queue_init(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_operationattr_t * operation_attr = NULL;
-    PyObject * opAttr = NULL;
-    int mode = -1;
-    globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    completion_queue_t * queue;
+    char msg[2048] = "";
+    int i;
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &opAttr, &mode)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+    queue = (completion_queue_t *) globus_malloc(sizeof(completion_queue_t));
+    if (queue == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to allocate completion queue");
         return NULL;
     }
- 
-    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
-
-    Py_BEGIN_ALLOW_THREADS
-
-    gridftp_result = globus_ftp_client_operationattr_set_mode(operation_attr, (globus_ftp_control_mode_t) mode);
 
-    Py_END_ALLOW_THREADS
+    memset(queue, 0, sizeof(completion_queue_t));
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to set mode", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
+    // both ends are non-blocking so that neither a producer nor an event
+    // loop can ever be stalled by the notification descriptor
+#ifdef __linux__
+    queue -> notify_fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    queue -> notify_fd[1] = queue -> notify_fd[0];
+    if (queue -> notify_fd[0] < 0)
+#endif
+    {
+        if (pipe(queue -> notify_fd) != 0){
+            sprintf(msg, "gridftpwrapper: unable to create completion queue notification: %s", strerror(errno));
+            globus_libc_free(queue);
+            PyErr_SetString(PyExc_RuntimeError, msg);
+            return NULL;
+        }
+        for (i = 0; i < 2; i++){
+            fcntl(queue -> notify_fd[i], F_SETFL, fcntl(queue -> notify_fd[i], F_GETFL) | O_NONBLOCK);
+            fcntl(queue -> notify_fd[i], F_SETFD, FD_CLOEXEC);
+        }
     }
-    
-    // return None to indicate success
-    Py_RETURN_NONE;
 
+    globus_mutex_init(&(queue -> mutex), GLOBUS_NULL);
+    globus_cond_init(&(queue -> cond), GLOBUS_NULL);
+
+    // the queue is freed when the last reference goes away, and each
+    // operation using the queue holds a reference until its events
+    // have been drained
+    return PyCObject_FromVoidPtrAndDesc((void *) queue, (void *) completion_queue_tag, completion_queue_free);
 }
 
-// set the parallelism for an operation attribute
-PyObject * gridftp_operationattr_set_parallelism(PyObject *self, PyObject *args)
+// drain up to max_events events from a completion queue, waiting up to
+// timeout seconds (forever if negative) for the first one
+//
+// returns a list of (kind, args) tuples in the order the events
+// happened, where args are the arguments the callback function would
+// have been called with
+PyObject * gridftp_completion_queue_drain(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_operationattr_t * operation_attr = NULL;
-    globus_ftp_control_parallelism_t * parallelism = NULL;
-    PyObject * opAttr = NULL;
-    PyObject * parallelObj = NULL;
-    globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    PyObject * queueObj;
+    PyObject * eventList;
+    PyObject * event;
+    completion_queue_t * queue;
+    completion_record_t * record;
+    int max_events;
+    double timeout;
+    globus_abstime_t abstime;
+    int rc;
+    int n;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OO", &opAttr, &parallelObj)){
+    if (!PyArg_ParseTuple(args, "Oid", 
+            &queueObj,
+            &max_events,
+            &timeout
+            )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
-    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelObj);
 
-    Py_BEGIN_ALLOW_THREADS
+    queue = completion_queue_from_object(queueObj);
+    if (queue == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a completion queue");
+        return NULL;
+    }
 
-    gridftp_result = globus_ftp_client_operationattr_set_parallelism(operation_attr, parallelism);
+    completion_queue_collect(queue);
 
-    Py_END_ALLOW_THREADS
+    // block without the GIL until something is pushed
+    if (queue -> pending == NULL && timeout != 0.0){
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to set parallelism", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
+        Py_BEGIN_ALLOW_THREADS
+
+        if (timeout > 0.0){
+            gridftp_abstime_after(timeout, &abstime);
+        }
+
+        globus_mutex_lock(&(queue -> mutex));
+        __atomic_add_fetch(&(queue -> waiting), 1, __ATOMIC_SEQ_CST);
+
+        while (__atomic_load_n(&(queue -> head), __ATOMIC_SEQ_CST) == NULL){
+            if (timeout < 0.0){
+                globus_cond_wait(&(queue -> cond), &(queue -> mutex));
+            } else{
+                rc = globus_cond_timedwait(&(queue -> cond), &(queue -> mutex), &abstime);
+                if (rc == ETIMEDOUT){
+                    break;
+                }
+            }
+        }
+
+        __atomic_sub_fetch(&(queue -> waiting), 1, __ATOMIC_SEQ_CST);
+        globus_mutex_unlock(&(queue -> mutex));
+
+        Py_END_ALLOW_THREADS
+
+        completion_queue_collect(queue);
     }
-    
-    // return None to indicate success
-    Py_RETURN_NONE;
 
-}
+    eventList = PyList_New(0);
 
+    for (n = 0; queue -> pending && (max_events <= 0 || n < max_events); n++){
+        record = queue -> pending;
+        queue -> pending = record -> next;
+        if (queue -> pending == NULL){
+            queue -> pending_tail = NULL;
+        }
 
+        event = completion_record_to_python(record, queueObj);
+        PyList_Append(eventList, event);
+        Py_XDECREF(event);
+    }
 
-// FIXME
-PyObject * gridftp_operationattr_set_disk_stack(PyObject *self, PyObject *args)
+    // records left over for the next drain must keep the descriptor
+    // readable or an event loop would never come back for them
+    if (queue -> pending && __atomic_exchange_n(&(queue -> signaled), 1, __ATOMIC_SEQ_CST) == 0){
+        completion_queue_notify(queue);
+    }
+
+    return eventList;
+}
+
+// return the file descriptor that is readable whenever a completion
+// queue has events to drain, for use with select, poll or epoll
+PyObject * gridftp_completion_queue_fileno(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_operationattr_t * operation_attr = NULL;
-    PyObject * opAttr = NULL;
-    char * driver_list="";
-    globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    PyObject * queueObj;
+    completion_queue_t * queue;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "Os", &opAttr, &driver_list)){
+    if (!PyArg_ParseTuple(args, "O", &queueObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
-
-    Py_BEGIN_ALLOW_THREADS
-    gridftp_result = globus_ftp_client_operationattr_set_disk_stack(operation_attr, driver_list);
-    Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to set_disk_stack", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    queue = completion_queue_from_object(queueObj);
+    if (queue == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a completion queue");
         return NULL;
     }
-    
-    // return None to indicate success
-    Py_RETURN_NONE;
+
+    return Py_BuildValue("i", queue -> notify_fd[0]);
 }
 
 
-// set the tcp buffer for an operation attribute
-PyObject * gridftp_operationattr_set_tcp_buffer(PyObject *self, PyObject *args)
+// start a third party transfer and wait for it to complete
+// any error is raised as an exception
+PyObject * gridftp_third_party_transfer_sync(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_operationattr_t * operation_attr = NULL;
-    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
-    PyObject * opAttr = NULL;
-    PyObject * tcpbufferObj = NULL;
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * src = NULL;
+    globus_ftp_client_operationattr_t * src_operation_attrp = NULL;
+    char * dst = NULL;
+    globus_ftp_client_operationattr_t * dst_operation_attrp = NULL;
+    PyObject * srcOpAttrObj;
+    PyObject * dstOpAttrObj;
+    PyObject * restartMarkerObj = NULL;
+    restart_marker_t * restart_markerp = NULL;
+    PyObject * handleObj;
+
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OO", &opAttr, &tcpbufferObj)){
+    if (!PyArg_ParseTuple(args, "OsOsO|O", 
+            &handleObj,
+            &src,
+            &srcOpAttrObj,
+            &dst,
+            &dstOpAttrObj,
+            &restartMarkerObj
+            )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    operation_attr = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttr);
-    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    src_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(srcOpAttrObj);
+    dst_operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(dstOpAttrObj);
+    if (gridftp_restart_marker_from_object(restartMarkerObj, &restart_markerp) != 0){
+        return NULL;
+    }
+
+    sync_bucket_init(&bucket);
+
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_operationattr_set_tcp_buffer(operation_attr, tcpbuffer);
+    // Globus copies the restart marker when the transfer starts
+    if (restart_markerp){
+        globus_mutex_lock(&(restart_markerp -> mutex));
+    }
+
+    gridftp_result = globus_ftp_client_third_party_transfer(
+                        handlep,
+                        src,
+                        src_operation_attrp,
+                        dst,
+                        dst_operation_attrp,
+                        restart_markerp ? &(restart_markerp -> marker) : NULL,
+                        sync_complete_callback,
+                        (void *) &bucket
+                        );
+
+    if (restart_markerp){
+        globus_mutex_unlock(&(restart_markerp -> mutex));
+    }
+
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
 
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to set tcpbuffer", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "third party transfer", 0);
+    if (rc < 0){
         return NULL;
     }
-    
+
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// initialize a parallelism type and return a wrapper pointer to it
-PyObject * gridftp_parallelism_init(PyObject *self, PyObject *args)
+// compute the checksum of a file on the server with an algorithm, MD5
+// if none is given, and wait for the result
+// the checksum is returned as a string
+PyObject * gridftp_cksm_sync(PyObject *self, PyObject *args)
 {
-    globus_ftp_control_parallelism_t  * parallelism = NULL;
-    PyObject * parallelismObj = NULL;
-    char msg[2048] = "";
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    PyObject * OpAttrObj;
+    PY_LONG_LONG offset;
+    PY_LONG_LONG length;
+    PyObject * handleObj;
+    PyObject * cksmObj;
+    char * algorithm = "MD5";
+    char * cksm;
 
-    parallelism = (globus_ftp_control_parallelism_t *) globus_malloc(sizeof(globus_ftp_control_parallelism_t));
+    sync_bucket_t bucket;
+    globus_result_t gridftp_result;
+    int rc;
 
-    if (parallelism == NULL){
-        sprintf(msg, "gridftpwrapper: unable to initialize parallelism");
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OsOLL|s", 
+            &handleObj,
+            &url,
+            &OpAttrObj,
+            &offset,
+            &length,
+            &algorithm
+            )){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
-    
-    // wrap pointer to parallelism_t and return
-    parallelismObj = PyCObject_FromVoidPtr((void *) parallelism, NULL);
 
-    return parallelismObj;
-}
+    if (cksm_algorithm_check(algorithm) < 0){
+        return NULL;
+    }
 
-// destroy a previously created parallelism type
-PyObject * gridftp_parallelism_destroy(PyObject *self, PyObject *args)
-{
-    globus_ftp_control_parallelism_t * parallelism = NULL;
-    PyObject * parallelismObj = NULL;
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &parallelismObj)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
-        return NULL;
+    cksm = (char *) globus_malloc(cksm_digest_size(algorithm));
+    if (cksm == NULL){
+        return PyErr_NoMemory();
     }
- 
-    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
+    cksm[0] = '\0';
 
-    free(parallelism);
+    sync_bucket_init(&bucket);
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    // start the operation and wait for it to complete, all without the GIL
 
-}
+    Py_BEGIN_ALLOW_THREADS
 
-// set the mode on a parallelism type
-PyObject * gridftp_parallelism_set_mode(PyObject *self, PyObject *args)
-{
-    globus_ftp_control_parallelism_t * parallelism = NULL;
-    PyObject * parallelismObj = NULL;
-    int mode = -1;
+    gridftp_result = globus_ftp_client_cksm(
+                        handlep,
+                        url,
+                        operation_attrp,
+                        cksm,
+                        (globus_off_t) offset,
+                        (globus_off_t) length,
+                        algorithm,
+                        sync_complete_callback,
+                        (void *) &bucket
+                        );
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &parallelismObj, &mode)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
-        return NULL;
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
     }
- 
-    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
-    parallelism -> mode = mode;
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    Py_END_ALLOW_THREADS
+
+    rc = sync_bucket_finish(&bucket, gridftp_result, "checksum", 0);
 
+    // return the checksum
+    cksmObj = rc < 0 ? NULL : Py_BuildValue("s", cksm);
+    globus_libc_free(cksm);
+
+    return cksmObj;
 }
 
-// set the size on a parallelism type
-PyObject * gridftp_parallelism_set_size(PyObject *self, PyObject *args)
+// the checksum algorithms a FEAT reply advertised, filled in by the
+// response function of a checksum feature plugin
+typedef struct
 {
-    globus_ftp_control_parallelism_t * parallelism = NULL;
-    PyObject * parallelismObj = NULL;
-    int size = -1;
+    char * algorithms;      // the text after CKSM in the feature line, or NULL
+} cksm_feat_t;
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &parallelismObj, &size)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
-        return NULL;
+static globus_result_t cksm_feat_plugin_init(globus_ftp_client_plugin_t * plugin, cksm_feat_t * feat);
+
+// response function of a checksum feature plugin, which keeps the
+// algorithm list of the CKSM line of a FEAT reply
+static void cksm_feat_plugin_response(
+    globus_ftp_client_plugin_t * plugin,
+    void * plugin_specific,
+    globus_ftp_client_handle_t * handle,
+    const char * url,
+    globus_object_t * error,
+    const globus_ftp_control_response_t * ftp_response)
+{
+    cksm_feat_t * feat = (cksm_feat_t *) plugin_specific;
+    const char * line;
+    const char * end;
+    const char * eol;
+    const char * list;
+
+    if (ftp_response == NULL || ftp_response -> code != 211 || ftp_response -> response_buffer == NULL || feat -> algorithms){
+        return;
     }
- 
-    parallelism = (globus_ftp_control_parallelism_t *) PyCObject_AsVoidPtr(parallelismObj);
-    parallelism -> fixed.size = size;
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    line = (const char *) ftp_response -> response_buffer;
+    end = line + ftp_response -> response_length;
+    for (; line < end; line = eol + 1){
+        eol = memchr(line, '\n', end - line);
+        if (eol == NULL){
+            eol = end;
+        }
+
+        // feature lines start with a space
+        while (line < eol && *line == ' '){
+            line++;
+        }
+        if (eol - line < 5 || strncasecmp(line, "CKSM ", 5) != 0){
+            continue;
+        }
 
+        list = line + 5;
+        while (list < eol && (*list == ' ' || *list == '\r')){
+            list++;
+        }
+        while (eol > list && (eol[-1] == ' ' || eol[-1] == '\r')){
+            eol--;
+        }
+        if (eol > list){
+            feat -> algorithms = (char *) globus_malloc(eol - list + 1);
+            if (feat -> algorithms){
+                memcpy(feat -> algorithms, list, eol - list);
+                feat -> algorithms[eol - list] = '\0';
+            }
+        }
+        return;
+    }
 }
 
-// initialize a tcpbuffer type and return a wrapped pointer to it
-PyObject * gridftp_tcpbuffer_init(PyObject *self, PyObject *args)
+// copy function of a checksum feature plugin, giving the handle its
+// own plugin that fills in the same cksm_feat_t
+static globus_ftp_client_plugin_t * cksm_feat_plugin_copy(globus_ftp_client_plugin_t * plugin_template, void * plugin_specific)
 {
-    globus_ftp_control_tcpbuffer_t  * tcpbuffer = NULL;
-    PyObject * tcpbufferObj = NULL;
-    char msg[2048] = "";
+    globus_ftp_client_plugin_t * plugin;
 
-    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) globus_malloc(sizeof(globus_ftp_control_tcpbuffer_t));
+    plugin = (globus_ftp_client_plugin_t *) globus_malloc(sizeof(globus_ftp_client_plugin_t));
+    if (plugin == NULL){
+        return NULL;
+    }
 
-    if (tcpbuffer == NULL){
-        sprintf(msg, "gridftpwrapper: unable to initialize tcpbuffer");
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    if (cksm_feat_plugin_init(plugin, (cksm_feat_t *) plugin_specific) != GLOBUS_SUCCESS){
+        globus_free(plugin);
         return NULL;
     }
-    
-    // wrap pointer to tcpbuffer_t and return
-    tcpbufferObj = PyCObject_FromVoidPtr((void *) tcpbuffer, NULL);
 
-    return tcpbufferObj;
+    return plugin;
 }
 
-// destroy a previously created tcpbuffer type
-PyObject * gridftp_tcpbuffer_destroy(PyObject *self, PyObject *args)
+// destroy function of a checksum feature plugin, for the copy a handle
+// made when the plugin was added
+static void cksm_feat_plugin_destroy(globus_ftp_client_plugin_t * plugin, void * plugin_specific)
 {
-    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
-    PyObject * tcpbufferObj = NULL;
+    globus_ftp_client_plugin_destroy(plugin);
+    globus_free(plugin);
+}
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &tcpbufferObj)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
-        return NULL;
-    }
- 
-    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
+// initialize a plugin that looks for the CKSM line in the FEAT reply of
+// the operations of the handle it is added to
+static globus_result_t cksm_feat_plugin_init(globus_ftp_client_plugin_t * plugin, cksm_feat_t * feat)
+{
+    globus_result_t gridftp_result;
 
-    free(tcpbuffer);
+    gridftp_result = globus_ftp_client_plugin_init(plugin, "gridftpwrapper_cksm_feat", GLOBUS_FTP_CLIENT_CMD_MASK_ALL, (void *) feat);
+    if (gridftp_result != GLOBUS_SUCCESS){
+        return gridftp_result;
+    }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    gridftp_result = globus_ftp_client_plugin_set_copy_func(plugin, cksm_feat_plugin_copy);
+    if (gridftp_result == GLOBUS_SUCCESS){
+        gridftp_result = globus_ftp_client_plugin_set_destroy_func(plugin, cksm_feat_plugin_destroy);
+    }
+    if (gridftp_result == GLOBUS_SUCCESS){
+        gridftp_result = globus_ftp_client_plugin_set_response_func(plugin, cksm_feat_plugin_response);
+    }
+    if (gridftp_result != GLOBUS_SUCCESS){
+        globus_ftp_client_plugin_destroy(plugin);
+    }
 
+    return gridftp_result;
 }
 
-// set the mode for a tcpbuffer type
-PyObject * gridftp_tcpbuffer_set_mode(PyObject *self, PyObject *args)
+// ask the server of a URL for its features, without the GIL, and return
+// the checksum algorithms its CKSM feature line lists, as the server
+// wrote them, or None if no such line was seen. The client library
+// only sends FEAT when it opens a connection, so a handle with the
+// connection to the server cached sees none
+PyObject * gridftp_cksm_feat(PyObject *self, PyObject *args)
 {
-    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
-    PyObject * tcpbufferObj = NULL;
-    int mode = -1;
+    globus_ftp_client_handle_t * handlep = NULL;
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
+    globus_ftp_client_plugin_t plugin;
+    globus_ftp_client_features_t features;
+    PyObject * handleObj;
+    PyObject * OpAttrObj;
+    PyObject * algorithmsObj;
+    cksm_feat_t feat;
+
+    sync_bucket_t bucket;
+    globus_result_t gridftp_result;
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &tcpbufferObj, &mode)){
+    if (!PyArg_ParseTuple(args, "OsO",
+            &handleObj,
+            &url,
+            &OpAttrObj
+            )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
-    tcpbuffer -> mode = mode;
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    // get the bare pointers from the python objects
+    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-}
+    feat.algorithms = NULL;
+    sync_bucket_init(&bucket);
 
-// set the size for a tcpbuffer type
-PyObject * gridftp_tcpbuffer_set_size(PyObject *self, PyObject *args)
-{
-    globus_ftp_control_tcpbuffer_t * tcpbuffer = NULL;
-    PyObject * tcpbufferObj = NULL;
-    int size = -1;
+    Py_BEGIN_ALLOW_THREADS
 
-    // get Python arguments
-    if (!PyArg_ParseTuple(args, "Oi", &tcpbufferObj, &size)){
-        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+    gridftp_result = cksm_feat_plugin_init(&plugin, &feat);
+    if (gridftp_result == GLOBUS_SUCCESS){
+        gridftp_result = globus_ftp_client_handle_add_plugin(handlep, &plugin);
+        if (gridftp_result == GLOBUS_SUCCESS){
+            globus_ftp_client_features_init(&features);
+
+            gridftp_result = globus_ftp_client_feat(
+                                handlep,
+                                url,
+                                operation_attrp,
+                                &features,
+                                sync_complete_callback,
+                                (void *) &bucket
+                                );
+
+            if (gridftp_result == GLOBUS_SUCCESS){
+                sync_bucket_wait(&bucket);
+            }
+
+            globus_ftp_client_features_destroy(&features);
+            globus_ftp_client_handle_remove_plugin(handlep, &plugin);
+        }
+        globus_ftp_client_plugin_destroy(&plugin);
+    }
+
+    Py_END_ALLOW_THREADS
+
+    rc = sync_bucket_finish(&bucket, gridftp_result, "feat", 0);
+    if (rc < 0){
+        globus_libc_free(feat.algorithms);
         return NULL;
     }
- 
-    tcpbuffer = (globus_ftp_control_tcpbuffer_t *) PyCObject_AsVoidPtr(tcpbufferObj);
-    tcpbuffer -> fixed.size = size;
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    if (feat.algorithms){
+        algorithmsObj = Py_BuildValue("s", feat.algorithms);
+        globus_libc_free(feat.algorithms);
+        return algorithmsObj;
+    }
 
+    Py_RETURN_NONE;
 }
 
-// initialize a third party transfer
-PyObject * gridftp_third_party_transfer(PyObject *self, PyObject *args)
+// find which of a list of checksum algorithms the server of a file
+// supports, by asking it for the checksum of the first byte of the file
+// with each in turn, without the GIL; the file must not be empty
+//
+// an algorithm the server refuses with a 5xx reply is left out. A 550
+// reply or an error carrying no reply code is about the file or the
+// connection rather than the algorithm, and raises. Returns the list
+// of the algorithms supported, in the order given
+PyObject * gridftp_cksm_probe(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
-    char * src = NULL;
-    globus_ftp_client_operationattr_t * src_operation_attrp = NULL;
-    char * dst = NULL;
-    globus_ftp_client_operationattr_t * dst_operation_attrp = NULL;
-    // globus_ftp_client_restart_marker_t * restart_markerp = NULL;
-
+    char * url = NULL;
+    globus_ftp_client_operationattr_t * operation_attrp = NULL;
     PyObject * handleObj;
-    PyObject * srcOpAttrObj;
-    PyObject * dstOpAttrObj;
-    PyObject * restartMarkerObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    third_party_callback_bucket_t * callbackBucket = NULL;
-
-    globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    PyObject * OpAttrObj;
+    PyObject * algorithmsObj;
+    PyObject * algorithmsSeq;
+    PyObject * supportedObj = NULL;
+    char ** algorithms = NULL;
+    char * supported = NULL;
+    char * cksm = NULL;
+    Py_ssize_t n;
+    Py_ssize_t i;
+
+    sync_bucket_t bucket;
+    globus_result_t gridftp_result = GLOBUS_SUCCESS;
+    int rc = 0;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOsOOOO", 
-            &handleObj, 
-            &src, 
-            &srcOpAttrObj,
-            &dst,
-            &dstOpAttrObj,
-            &restartMarkerObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsOO",
+            &handleObj,
+            &url,
+            &OpAttrObj,
+            &algorithmsObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
+    algorithmsSeq = PySequence_Fast(algorithmsObj, "gridftpwrapper: algorithms must be a sequence");
+    if (algorithmsSeq == NULL){
+        return NULL;
+    }
+
+    // the names are checked and their strings held by the sequence
+    // while the GIL is released
+    n = PySequence_Fast_GET_SIZE(algorithmsSeq);
+    algorithms = (char **) globus_malloc((n ? n : 1) * sizeof(char *));
+    supported = (char *) globus_malloc(n ? n : 1);
+    cksm = (char *) globus_malloc(CKSM_UNKNOWN_DIGEST);
+    if (algorithms == NULL || supported == NULL || cksm == NULL){
+        PyErr_NoMemory();
+        goto done;
+    }
+
+    for (i = 0; i < n; i++){
+        algorithms[i] = PyString_AsString(PySequence_Fast_GET_ITEM(algorithmsSeq, i));
+        if (algorithms[i] == NULL || cksm_algorithm_check(algorithms[i]) < 0){
+            goto done;
+        }
+    }
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    src_operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(srcOpAttrObj);
-    dst_operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(dstOpAttrObj);
-    //restart_markerp = (globus_ftp_client_restart_marker_t *) PyCObject_AsVoidPtr(restartMarkerObj);
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // create a third party callback struct to hold the callback information
-    callbackBucket = (third_party_callback_bucket_t *) globus_malloc(sizeof(third_party_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    memset(supported, 0, n ? n : 1);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    for (i = 0; i < n && rc == 0; i++){
+        sync_bucket_init(&bucket);
 
-    // kick off the third party transfer 
+        Py_BEGIN_ALLOW_THREADS
 
-    Py_BEGIN_ALLOW_THREADS
+        gridftp_result = globus_ftp_client_cksm(
+                            handlep,
+                            url,
+                            operation_attrp,
+                            cksm,
+                            (globus_off_t) 0,
+                            (globus_off_t) 1,
+                            algorithms[i],
+                            sync_complete_callback,
+                            (void *) &bucket
+                            );
+
+        if (gridftp_result == GLOBUS_SUCCESS){
+            sync_bucket_wait(&bucket);
+        }
 
-    gridftp_result = globus_ftp_client_third_party_transfer(
-                        handlep,
-                        src,
-                        src_operation_attrp,
-                        dst,
-                        dst_operation_attrp,
-                        // restart_markerp,
-                        NULL,
-                        third_party_complete_callback,
-                        (void *) callbackBucket
-                        );
+        Py_END_ALLOW_THREADS
 
-    Py_END_ALLOW_THREADS
+        // a refusal leaves the algorithm out, anything else that fails
+        // ends the probe with the exception set here
+        if (gridftp_result == GLOBUS_SUCCESS && bucket.error && bucket.error_code >= 500 && bucket.error_code != 550){
+            sync_bucket_finish(&bucket, gridftp_result, "checksum", bucket.error_code);
+        } else{
+            rc = sync_bucket_finish(&bucket, gridftp_result, "checksum", 0);
+            supported[i] = (rc == 0);
+        }
+    }
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start third party transfer", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
+    if (rc < 0){
+        goto done;
+    }
+
+    supportedObj = PyList_New(0);
+    for (i = 0; supportedObj && i < n; i++){
+        if (supported[i] && PyList_Append(supportedObj, PySequence_Fast_GET_ITEM(algorithmsSeq, i)) < 0){
+            Py_CLEAR(supportedObj);
+        }
     }
-    
-    // return None to indicate success
-    Py_RETURN_NONE;
 
+done:
+    Py_DECREF(algorithmsSeq);
+    globus_libc_free(algorithms);
+    globus_libc_free(supported);
+    globus_libc_free(cksm);
+
+    return supportedObj;
 }
 
-// compute the md5 checksum 
-// note that it is returned in a callback
-PyObject * gridftp_cksm(PyObject *self, PyObject *args)
+// check for the existence of a file or directory and wait for the answer
+// returns True or False; errors other than "not found" (FTP reply 550)
+// are raised as exceptions
+PyObject * gridftp_exists_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-    int offset = -1;
-    int length = -1;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    cksm_callback_bucket_t * callbackBucket = NULL;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOiiOO", 
-            &handleObj, 
-            &url, 
-            &OpAttrObj,
-            &offset,
-            &length,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO", 
+            &handleObj,
+            &url,
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a cksm callback struct to hold the callback information
-    callbackBucket = (cksm_callback_bucket_t *) globus_malloc(sizeof(cksm_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the checksum operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_cksm(
+    gridftp_result = globus_ftp_client_exists(
                         handlep,
                         url,
                         operation_attrp,
-                        callbackBucket -> cksm,
-                        (globus_off_t) offset,
-                        (globus_off_t ) length,
-                        "MD5",
-                        cksm_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start checksum operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "exists", 550);
+    if (rc < 0){
         return NULL;
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    // a 550 reply means the path does not exist
+    if (rc == 1){
+        Py_RETURN_FALSE;
+    }
 
+    Py_RETURN_TRUE;
 }
 
-// make a directory
-// the status is returned in a callback
-PyObject * gridftp_mkdir(PyObject *self, PyObject *args)
+// make a directory and wait for the operation to complete
+PyObject * gridftp_mkdir_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    mkdir_callback_bucket_t * callbackBucket = NULL;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOO", 
-            &handleObj, 
-            &url, 
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO", 
+            &handleObj,
+            &url,
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a mkdir callback struct to hold the callback information
-    callbackBucket = (mkdir_callback_bucket_t *) globus_malloc(sizeof(mkdir_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the checksum operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
@@ -1949,68 +12083,55 @@ PyObject * gridftp_mkdir(PyObject *self, PyObject *args)
                         handlep,
                         url,
                         operation_attrp,
-                        mkdir_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start mkdir operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "mkdir", 0);
+    if (rc < 0){
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// remove a directory
-// the status is returned in a callback
-PyObject * gridftp_rmdir(PyObject *self, PyObject *args)
+// remove a directory and wait for the operation to complete
+PyObject * gridftp_rmdir_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    rmdir_callback_bucket_t * callbackBucket = NULL;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOO", 
-            &handleObj, 
-            &url, 
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO", 
+            &handleObj,
+            &url,
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a rmdir callback struct to hold the callback information
-    callbackBucket = (rmdir_callback_bucket_t *) globus_malloc(sizeof(rmdir_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the checksum operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
@@ -2018,68 +12139,55 @@ PyObject * gridftp_rmdir(PyObject *self, PyObject *args)
                         handlep,
                         url,
                         operation_attrp,
-                        rmdir_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start rmdir operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "rmdir", 0);
+    if (rc < 0){
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// delete a file
-// the status is returned in a callback
-PyObject * gridftp_delete(PyObject *self, PyObject *args)
+// delete a file and wait for the operation to complete
+PyObject * gridftp_delete_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    delete_callback_bucket_t * callbackBucket = NULL;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOO", 
-            &handleObj, 
-            &url, 
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO", 
+            &handleObj,
+            &url,
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a delete callback struct to hold the callback information
-    callbackBucket = (delete_callback_bucket_t *) globus_malloc(sizeof(delete_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the checksum operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
@@ -2087,70 +12195,57 @@ PyObject * gridftp_delete(PyObject *self, PyObject *args)
                         handlep,
                         url,
                         operation_attrp,
-                        delete_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start delete operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "delete", 0);
+    if (rc < 0){
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// move (that is, rename) a file
-// the status is returned in a callback
-PyObject * gridftp_move(PyObject *self, PyObject *args)
+// move a file and wait for the operation to complete
+PyObject * gridftp_move_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * src = NULL;
     char * dst = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    move_callback_bucket_t * callbackBucket = NULL;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OssOOO", 
-            &handleObj, 
-            &src, 
+    if (!PyArg_ParseTuple(args, "OssO", 
+            &handleObj,
+            &src,
             &dst,
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a move callback struct to hold the callback information
-    callbackBucket = (move_callback_bucket_t *) globus_malloc(sizeof(move_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the checksum operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
@@ -2159,70 +12254,57 @@ PyObject * gridftp_move(PyObject *self, PyObject *args)
                         src,
                         dst,
                         operation_attrp,
-                        move_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start move operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "move", 0);
+    if (rc < 0){
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// chmod a file
-// the status is returned in a callback
-PyObject * gridftp_chmod(PyObject *self, PyObject *args)
+// change the mode of a file and wait for the operation to complete
+PyObject * gridftp_chmod_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
-    int mode = 0;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
     PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    chmod_callback_bucket_t * callbackBucket = NULL;
+    int mode;
+    PyObject * handleObj;
 
+    sync_bucket_t bucket;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsiOOO", 
-            &handleObj, 
-            &url, 
+    if (!PyArg_ParseTuple(args, "OsiO", 
+            &handleObj,
+            &url,
             &mode,
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
-
-    // create a chmod callback struct to hold the callback information
-    callbackBucket = (chmod_callback_bucket_t *) globus_malloc(sizeof(chmod_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
 
-    // kick off the chmod operation
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
@@ -2231,533 +12313,736 @@ PyObject * gridftp_chmod(PyObject *self, PyObject *args)
                         url,
                         mode,
                         operation_attrp,
-                        chmod_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start chmod operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    rc = sync_bucket_finish(&bucket, gridftp_result, "chmod", 0);
+    if (rc < 0){
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// start a gridftp get operation
-PyObject * gridftp_get(PyObject *self, PyObject *args)
+// list a directory with MLSD and wait for the listing, which is read
+// and parsed in C without the GIL
+//
+// returns the columns of the listing as built by listing_to_python,
+// leaving out the cdir and pdir entries if skip_dots is true
+PyObject * gridftp_machine_list_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
-    char * src = NULL;
+    char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-    // globus_ftp_client_restart_marker_t * restart_markerp = NULL;
-
+    PyObject * OpAttrObj;
     PyObject * handleObj;
-    PyObject * opAttrObj;
-    PyObject * restartMarkerObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    get_complete_callback_bucket_t * callbackBucket = NULL;
+    PyObject * listingObj;
+    int skip_dots = 1;
 
+    listing_read_t * read;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOOO", 
-            &handleObj, 
-            &src, 
-            &opAttrObj,
-            &restartMarkerObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO|i", 
+            &handleObj,
+            &url,
+            &OpAttrObj,
+            &skip_dots
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
-    //restart_markerp = (globus_ftp_client_restart_marker_t *) PyCObject_AsVoidPtr(restartMarkerObj);
-
-    // create a get callback struct to hold the callback information
-    callbackBucket = (get_complete_callback_bucket_t *) globus_malloc(sizeof(get_complete_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    // the read buffer is too large for the stack
+    read = (listing_read_t *) globus_malloc(sizeof(listing_read_t));
+    if (read == NULL){
+        return PyErr_NoMemory();
+    }
+    sync_bucket_init(&(read -> bucket));
+    listing_init(&(read -> listing), skip_dots ? GLOBUS_TRUE : GLOBUS_FALSE);
 
-    // kick off the get transfer 
+    // start the operation, read the listing and wait for it to
+    // complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_get(
+    gridftp_result = globus_ftp_client_machine_list(
                         handlep,
-                        src,
+                        url,
                         operation_attrp,
-                        NULL,
-                        get_complete_callback,
-                        (void *) callbackBucket
+                        sync_complete_callback,
+                        (void *) &(read -> bucket)
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        if (globus_ftp_client_register_read(
+                handlep,
+                read -> buffer,
+                LISTING_READ_BUFFER,
+                listing_read_callback,
+                (void *) read
+                ) != GLOBUS_SUCCESS){
+            globus_ftp_client_abort(handlep);
+        }
+        sync_bucket_wait(&(read -> bucket));
+        listing_finish(&(read -> listing));
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start get transfer", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
+    rc = sync_bucket_finish(&(read -> bucket), gridftp_result, "machine list", 0);
+    if (rc == 0 && read -> listing.failed){
+        PyErr_NoMemory();
+        rc = -1;
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    listingObj = rc < 0 ? NULL : listing_to_python(&(read -> listing));
 
+    listing_free(&(read -> listing));
+    globus_libc_free(read);
+
+    return listingObj;
 }
 
-// start a gridftp verbose list operation
-PyObject * gridftp_verbose_list(PyObject *self, PyObject *args)
+// get the facts of one file or directory with MLST and wait for them
+//
+// returns the columns of a one entry listing as built by
+// listing_to_python, the name being the path the server gives
+PyObject * gridftp_mlst_sync(PyObject *self, PyObject *args)
 {
     globus_ftp_client_handle_t * handlep = NULL;
     char * url = NULL;
     globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
+    PyObject * OpAttrObj;
     PyObject * handleObj;
-    PyObject * opAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    verbose_list_complete_callback_bucket_t * callbackBucket = NULL;
+    PyObject * listingObj;
 
+    sync_bucket_t bucket;
+    listing_t listing;
+    globus_byte_t * buffer = NULL;
+    globus_size_t length = 0;
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    int rc;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOO", 
-            &handleObj, 
-            &url, 
-            &opAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
+    if (!PyArg_ParseTuple(args, "OsO", 
+            &handleObj,
+            &url,
+            &OpAttrObj
             )){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
     // get the bare pointers from the python objects
     handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(opAttrObj);
-
-    // create a verbose list callback struct to hold the callback information
-    callbackBucket = (verbose_list_complete_callback_bucket_t *) globus_malloc(sizeof(verbose_list_complete_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    operation_attrp = (globus_ftp_client_operationattr_t *) gridftp_optional_ptr(OpAttrObj);
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    sync_bucket_init(&bucket);
+    listing_init(&listing, GLOBUS_FALSE);
 
-    // kick off the verbose list operation 
+    // start the operation and wait for it to complete, all without the GIL
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_verbose_list(
+    gridftp_result = globus_ftp_client_mlst(
                         handlep,
                         url,
                         operation_attrp,
-                        get_complete_callback,
-                        (void *) callbackBucket
+                        &buffer,
+                        &length,
+                        sync_complete_callback,
+                        (void *) &bucket
                         );
 
+    if (gridftp_result == GLOBUS_SUCCESS){
+        sync_bucket_wait(&bucket);
+        if (buffer){
+            listing_feed(&listing, buffer, (long) length);
+            listing_finish(&listing);
+        }
+    }
+
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start verbose list operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    // Globus allocates the fact line, which is ours to free
+    globus_libc_free(buffer);
+
+    rc = sync_bucket_finish(&bucket, gridftp_result, "mlst", 0);
+    if (rc == 0 && listing.failed){
+        PyErr_NoMemory();
+        rc = -1;
+    }
+
+    listingObj = rc < 0 ? NULL : listing_to_python(&listing);
+
+    listing_free(&listing);
+
+    return listingObj;
+}
+
+// parse MLSD or MLST fact lines, fed blocksize bytes at a time as they
+// would arrive from the server, or all at once if blocksize is 0, and
+// return the columns of the listing as built by listing_to_python
+PyObject * gridftp_listing_parse(PyObject *self, PyObject *args)
+{
+    PyObject * listingObj;
+    listing_t listing;
+    const char * data;
+    int length;
+    int skip_dots = 0;
+    int blocksize = 0;
+    int i;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "s#|ii", &data, &length, &skip_dots, &blocksize)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    if (blocksize <= 0){
+        blocksize = length ? length : 1;
+    }
+
+    listing_init(&listing, skip_dots ? GLOBUS_TRUE : GLOBUS_FALSE);
+    for (i = 0; i < length; i += blocksize){
+        listing_feed(&listing, (const globus_byte_t *) data + i, (long) (length - i < blocksize ? length - i : blocksize));
+    }
+    listing_finish(&listing);
 
+    if (listing.failed){
+        listing_free(&listing);
+        return PyErr_NoMemory();
+    }
+
+    listingObj = listing_to_python(&listing);
+    listing_free(&listing);
+
+    return listingObj;
 }
 
-// register the data callback function for a get operation
-PyObject * gridftp_register_read(PyObject *self, PyObject *args)
+// destructor for the Python object wrapping a restart marker; the get
+// sinks and restart marker plugins updating the marker hold references
+// to the Python object, so it is only freed once they are all done
+static void restart_marker_object_free(void * ptr, void * desc)
 {
-    globus_ftp_client_handle_t * handlep = NULL;
-    globus_byte_t * buffer = NULL;
-    unsigned long buffer_length = 0;
+    restart_marker_t * marker = (restart_marker_t *) ptr;
 
-    PyObject * handleObj;
-    PyObject * bufferObj;
-    PyObject * dataCallbackFunctionObj;
-    PyObject * dataCallbackArgObj;
+    globus_ftp_client_restart_marker_destroy(&(marker -> marker));
+    globus_mutex_destroy(&(marker -> mutex));
+    globus_free(marker);
+}
 
-    get_data_callback_bucket_t * callbackBucket = NULL;
+// create a restart marker, empty or from its string form
+PyObject * gridftp_restart_marker_init(PyObject *self, PyObject *args)
+{
+    restart_marker_t * marker;
+    char * markerString = NULL;
 
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OOkOO", 
-            &handleObj, 
-            &bufferObj, 
-            &buffer_length,
-            &dataCallbackFunctionObj,
-            &dataCallbackArgObj
-            )){
+    if (!PyArg_ParseTuple(args, "|z", &markerString)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    // get the bare pointers from the python objects
-    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    buffer = (globus_byte_t *) PyCObject_AsVoidPtr(bufferObj);
 
-    // create a data callback struct to hold the callback information
-    callbackBucket = (get_data_callback_bucket_t *) globus_malloc(sizeof(get_data_callback_bucket_t));
-    callbackBucket -> pyfunction = dataCallbackFunctionObj;
-    callbackBucket -> pyarg = dataCallbackArgObj;
-    callbackBucket -> pybuffer = bufferObj;
+    marker = (restart_marker_t *) globus_malloc(sizeof(restart_marker_t));
+
+    if (markerString){
+        gridftp_result = globus_ftp_client_restart_marker_from_string(&(marker -> marker), markerString);
+    } else{
+        gridftp_result = globus_ftp_client_restart_marker_init(&(marker -> marker));
+    }
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        globus_free(marker);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize restart marker", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    globus_mutex_init(&(marker -> mutex), GLOBUS_NULL);
+
+    return PyCObject_FromVoidPtrAndDesc((void *) marker, (void *) restart_marker_tag, restart_marker_object_free);
+}
+
+// return the string form of a restart marker, which can be stored and
+// later turned back into a marker with gridftp_restart_marker_init
+PyObject * gridftp_restart_marker_to_string(PyObject *self, PyObject *args)
+{
+    PyObject * markerObj;
+    PyObject * stringObj;
+    restart_marker_t * marker;
+    char * markerString = NULL;
+
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &markerObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (gridftp_restart_marker_from_object(markerObj, &marker) != 0 || marker == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a restart marker");
+        return NULL;
+    }
+
+    globus_mutex_lock(&(marker -> mutex));
+    gridftp_result = globus_ftp_client_restart_marker_to_string(&(marker -> marker), &markerString);
+    globus_mutex_unlock(&(marker -> mutex));
+
+    if (gridftp_result != GLOBUS_SUCCESS){
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to convert restart marker to string", gridftp_result);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
+
+    // an empty marker has no string form
+    stringObj = Py_BuildValue("s", markerString ? markerString : "");
+    globus_libc_free(markerString);
+
+    return stringObj;
+}
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
-    Py_XINCREF(callbackBucket -> pybuffer);
+// record a range of bytes, from offset up to but not including end, as
+// already transferred
+PyObject * gridftp_restart_marker_insert_range(PyObject *self, PyObject *args)
+{
+    PyObject * markerObj;
+    restart_marker_t * marker;
+    PY_LONG_LONG offset;
+    PY_LONG_LONG end;
 
-    // register the read
+    globus_result_t gridftp_result;
+    char msg[2048] = "";
 
-    Py_BEGIN_ALLOW_THREADS
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "OLL", &markerObj, &offset, &end)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
 
-    gridftp_result = globus_ftp_client_register_read(
-                        handlep,
-                        buffer,
-                        (globus_size_t) buffer_length,
-                        get_data_callback,
-                        (void *) callbackBucket
-                        );
+    if (gridftp_restart_marker_from_object(markerObj, &marker) != 0 || marker == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a restart marker");
+        return NULL;
+    }
 
-    Py_END_ALLOW_THREADS
+    globus_mutex_lock(&(marker -> mutex));
+    gridftp_result = globus_ftp_client_restart_marker_insert_range(&(marker -> marker), (globus_off_t) offset, (globus_off_t) end);
+    globus_mutex_unlock(&(marker -> mutex));
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to register read", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to insert range into restart marker", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// abort whatever operation is currently going on for a handle
-PyObject * gridftp_abort(PyObject *self, PyObject *args)
+// return the total number of bytes a restart marker records as
+// already transferred
+PyObject * gridftp_restart_marker_get_total(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handle_t * handlep = NULL;
-
-    PyObject * handleObj;
+    PyObject * markerObj;
+    restart_marker_t * marker;
+    globus_off_t total = 0;
 
     globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "O", &handleObj)){
+    if (!PyArg_ParseTuple(args, "O", &markerObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    // get the bare pointers from the python objects
-    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-
-    // abort the current operation
 
-    Py_BEGIN_ALLOW_THREADS
-
-    gridftp_result = globus_ftp_client_abort(handlep);
+    if (gridftp_restart_marker_from_object(markerObj, &marker) != 0 || marker == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a restart marker");
+        return NULL;
+    }
 
-    Py_END_ALLOW_THREADS
+    globus_mutex_lock(&(marker -> mutex));
+    gridftp_result = globus_ftp_client_restart_marker_get_total(&(marker -> marker), &total);
+    globus_mutex_unlock(&(marker -> mutex));
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to abort", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to get total from restart marker", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
-
+    return Py_BuildValue("L", (PY_LONG_LONG) total);
 }
 
-// initialize a performance marker plugin and return a wrapped
-// pointer to it and a wrapped pointer to the callback struct
-// that is used to carry around the pointers to the Python 
-// callback functions that should be called when a transfer
-// starts, when a performance marker is received, and when the
-// transfer completes
-PyObject * gridftp_perf_plugin_init(PyObject *self, PyObject *args)
+// create a restart marker plugin that keeps the given restart marker
+// up to date with the restart markers the server sends during third
+// party transfers and puts
+PyObject * gridftp_restart_marker_plugin_init(PyObject *self, PyObject *args)
 {
     globus_ftp_client_plugin_t * pluginp = NULL;
     PyObject * pluginObj;
+    PyObject * markerObj;
+    PyObject * bucketObj;
+    restart_marker_t * marker;
 
-    PyObject * perfBeginCB = NULL;
-    PyObject * perfMarkerCB = NULL;
-    PyObject * perfCompleteCB = NULL;
-    PyObject * userArg = NULL;
-
-    perf_plugin_callback_bucket_t * callbackBucket;
-    PyObject * callbackObj = NULL;
+    restart_marker_plugin_bucket_t * bucket;
 
     globus_result_t gridftp_result;
     char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OOOO", &perfBeginCB, &perfMarkerCB, &perfCompleteCB, &userArg)){
+    if (!PyArg_ParseTuple(args, "O", &markerObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
+
+    if (gridftp_restart_marker_from_object(markerObj, &marker) != 0 || marker == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a restart marker");
+        return NULL;
+    }
+
     // create memory for the globus_ftp_client_plugin_t
     pluginp = (globus_ftp_client_plugin_t *) globus_malloc(sizeof(globus_ftp_client_plugin_t));
 
-    // create a callback struct to hold the callback information
-    callbackBucket = (perf_plugin_callback_bucket_t *) globus_malloc(sizeof(perf_plugin_callback_bucket_t));
-    callbackBucket -> begincb = perfBeginCB;
-    callbackBucket -> markercb = perfMarkerCB;
-    callbackBucket -> completecb = perfCompleteCB;
-    callbackBucket -> userarg = userArg;
-
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> begincb);
-    Py_XINCREF(callbackBucket -> markercb);
-    Py_XINCREF(callbackBucket -> completecb);
-    Py_XINCREF(callbackBucket -> userarg);
+    // the plugin keeps the marker alive for as long as it exists
+    bucket = (restart_marker_plugin_bucket_t *) globus_malloc(sizeof(restart_marker_plugin_bucket_t));
+    bucket -> marker = marker;
+    bucket -> pymarker = markerObj;
+    Py_XINCREF(bucket -> pymarker);
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_perf_plugin_init(
+    gridftp_result = globus_ftp_client_restart_marker_plugin_init(
         pluginp,
-        perf_plugin_begin_cb,
-        perf_plugin_marker_cb,
-        perf_plugin_complete_cb,
-        callbackBucket);
+        restart_marker_plugin_begin_cb,
+        restart_marker_plugin_marker_cb,
+        restart_marker_plugin_complete_cb,
+        bucket);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize perf plugin", gridftp_result);
+        Py_XDECREF(bucket -> pymarker);
+        globus_free(bucket);
+        globus_free(pluginp);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to initialize restart marker plugin", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
-    
 
-    // wrap pointer to plugin and callback struct and return
+    // wrap pointer to plugin and its state and return
     pluginObj = PyCObject_FromVoidPtr((void *) pluginp, NULL);
-    callbackObj = PyCObject_FromVoidPtr((void *) callbackBucket, NULL);
-
-    return Py_BuildValue("(OO)", (void *) pluginObj, (void *) callbackObj);
+    bucketObj = PyCObject_FromVoidPtr((void *) bucket, NULL);
 
+    return Py_BuildValue("(NN)", pluginObj, bucketObj);
 }
 
-// destroy a previously created performance marker plugin and the
-// callback that was created at the same time
-PyObject * gridftp_perf_plugin_destroy(PyObject *self, PyObject *args)
+// destroy a restart marker plugin
+PyObject * gridftp_restart_marker_plugin_destroy(PyObject *self, PyObject *args)
 {
     globus_ftp_client_plugin_t * pluginp = NULL;
     PyObject * pluginObj;
-    PyObject * callbackObj;
-    perf_plugin_callback_bucket_t * callbackBucket = NULL;
+    PyObject * bucketObj;
+    restart_marker_plugin_bucket_t * bucket = NULL;
 
     globus_result_t gridftp_result;
     char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OO", &pluginObj, &callbackObj)){
+    if (!PyArg_ParseTuple(args, "OO", &pluginObj, &bucketObj)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-   // obtain the C pointers from the Python pointers 
-   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
-   callbackBucket = (perf_plugin_callback_bucket_t *) PyCObject_AsVoidPtr(callbackObj);
- 
+    // obtain the C pointers from the Python pointers 
+    pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
+    bucket = (restart_marker_plugin_bucket_t *) PyCObject_AsVoidPtr(bucketObj);
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_perf_plugin_destroy(pluginp);
+    gridftp_result = globus_ftp_client_restart_marker_plugin_destroy(pluginp);
 
     Py_END_ALLOW_THREADS
 
     if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy perf plugin", gridftp_result);
+        sprintf(msg, "gridftpwrapper: rc = %d: unable to destroy restart marker plugin", gridftp_result);
         PyErr_SetString(PyExc_RuntimeError, msg);
         return NULL;
     }
 
-    // free the memory used by the plugin
+    // free the memory used by the plugin and let go of the marker
     globus_free(pluginp);
-
-    // free the memory used by the perf callback struct
-    globus_free(callbackBucket);
+    Py_XDECREF(bucket -> pymarker);
+    globus_free(bucket);
 
     // return None to indicate success
     Py_RETURN_NONE;
 }
 
-// add a plugin to a handle
-PyObject * gridftp_handle_add_plugin(PyObject *self, PyObject *args)
+// destructor for the Python object wrapping a stream digest; the
+// transfers still feeding the digest hold references of their own
+static void stream_digest_object_free(void * ptr, void * desc)
 {
-    globus_ftp_client_handle_t * handlep = NULL;
-    globus_ftp_client_plugin_t * pluginp = NULL;
-    PyObject * handleObj;
-    PyObject * pluginObj;
+    stream_digest_release((stream_digest_t *) ptr);
+}
+
+// create a stream digest, computed in C on the data of the gets it is
+// given to as the data arrives
+//
+// algorithm is MD5, ADLER32 or CRC32C and start is the offset in the
+// file of the first byte the digest covers. The blocks of a get with
+// parallel streams arrive out of order; MD5 holds early blocks until
+// the gap before them fills, and fails once more than maxPending bytes
+// are held
+PyObject * gridftp_stream_digest_init(PyObject *self, PyObject *args)
+{
+    char * algorithmName = NULL;
+    PY_LONG_LONG start = 0;
+    PY_LONG_LONG maxPending = 0;
+    int algorithm;
+    stream_digest_t * digest;
 
-    globus_result_t gridftp_result;
     char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OO", &handleObj, &pluginObj)){
+    if (!PyArg_ParseTuple(args, "sLL", &algorithmName, &start, &maxPending)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-   // obtain the C pointers from the Python pointers 
-   handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
+    algorithm = stream_digest_algorithm(algorithmName);
+    if (algorithm < 0){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: unsupported stream digest algorithm %s", algorithmName);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
 
-    Py_BEGIN_ALLOW_THREADS
+    if (start < 0 || maxPending < 0){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: start and maxPending must not be negative");
+        return NULL;
+    }
 
-    gridftp_result = globus_ftp_client_handle_add_plugin(handlep, pluginp);
+    digest = stream_digest_new(algorithm, (long long) start, (size_t) maxPending);
+    if (digest == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to create stream digest");
+        return NULL;
+    }
 
-    Py_END_ALLOW_THREADS
+    return PyCObject_FromVoidPtrAndDesc((void *) digest, (void *) stream_digest_tag, stream_digest_object_free);
+}
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to add plugin to handle", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+// return the outcome of a stream digest as (digest, nbytes, reason):
+// the hex digest once the get has completed, or None with the reason
+// it failed, None if neither has happened yet
+PyObject * gridftp_stream_digest_result(PyObject *self, PyObject *args)
+{
+    PyObject * digestObj;
+    stream_digest_t * digest;
+    char hex[STREAM_DIGEST_HEX_MAX];
+    long long nbytes;
+    const char * reason;
+    int rc;
+
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &digestObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    if (gridftp_stream_digest_from_object(digestObj, &digest) != 0){
+        return NULL;
+    }
+    if (digest == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a stream digest");
+        return NULL;
+    }
 
+    rc = stream_digest_result(digest, hex, &nbytes, &reason);
+
+    return Py_BuildValue("(zLz)", rc == 1 ? hex : NULL, (PY_LONG_LONG) nbytes, reason);
 }
 
-// remove a plugin from a handle
-PyObject * gridftp_handle_remove_plugin(PyObject *self, PyObject *args)
+// feed a block of data at offset to a stream digest, as a get does with
+// the data it reads, without the GIL
+PyObject * gridftp_stream_digest_update(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handle_t * handlep = NULL;
-    globus_ftp_client_plugin_t * pluginp = NULL;
-    PyObject * handleObj;
-    PyObject * pluginObj;
-
-    globus_result_t gridftp_result;
-    char msg[2048] = "";
+    PyObject * digestObj;
+    stream_digest_t * digest;
+    PY_LONG_LONG offset;
+    const char * data;
+    int length;
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OO", &handleObj, &pluginObj)){
+    if (!PyArg_ParseTuple(args, "OLs#", &digestObj, &offset, &data, &length)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
 
-   // obtain the C pointers from the Python pointers 
-   handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-   pluginp = (globus_ftp_client_plugin_t *) PyCObject_AsVoidPtr(pluginObj);
+    if (gridftp_stream_digest_from_object(digestObj, &digest) != 0){
+        return NULL;
+    }
+    if (digest == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a stream digest");
+        return NULL;
+    }
+
+    if (offset < 0){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: offset must not be negative");
+        return NULL;
+    }
 
     Py_BEGIN_ALLOW_THREADS
+    stream_digest_update(digest, (long long) offset, (const unsigned char *) data, (size_t) length);
+    Py_END_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_handle_remove_plugin(handlep, pluginp);
+    // return None to indicate success
+    Py_RETURN_NONE;
+}
 
-    Py_END_ALLOW_THREADS
+// finish a stream digest fed with gridftp_stream_digest_update, as a
+// get does when it completes
+PyObject * gridftp_stream_digest_finish(PyObject *self, PyObject *args)
+{
+    PyObject * digestObj;
+    stream_digest_t * digest;
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to remove plugin from handle", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
+    // get Python arguments
+    if (!PyArg_ParseTuple(args, "O", &digestObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    if (gridftp_stream_digest_from_object(digestObj, &digest) != 0){
         return NULL;
     }
+    if (digest == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: object is not a stream digest");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    stream_digest_finish(digest);
+    Py_END_ALLOW_THREADS
 
     // return None to indicate success
     Py_RETURN_NONE;
-
 }
 
-// check for existence of a file or directory, i.e. a URL
-// the status is returned in a callback
-PyObject * gridftp_exists(PyObject *self, PyObject *args)
+// compute digests of byte ranges of local files, without the GIL
+//
+// ranges is a list of (path, offset, length) tuples, length -1 for the
+// rest of the file. MD5 ranges are hashed several at once with the
+// multi-buffer kernel. Returns a list of (digest, nbytes, error) tuples
+// in the same order, digest None and error a string if the file could
+// not be read
+PyObject * gridftp_file_digests(PyObject *self, PyObject *args)
 {
-    globus_ftp_client_handle_t * handlep = NULL;
-    char * url = NULL;
-    globus_ftp_client_operationattr_t * operation_attrp = NULL;
-
-    PyObject * handleObj;
-    PyObject * OpAttrObj;
-    PyObject * completeCallbackFunctionObj;
-    PyObject * completeCallbackArgObj;
-
-    exists_callback_bucket_t * callbackBucket = NULL;
+    char * algorithmName = NULL;
+    PyObject * rangesObj;
+    PyObject * rangeObj;
+    PyObject * resultObj;
+    PyObject * itemObj;
+    unsigned long bufsize = 1048576;
+    PY_LONG_LONG offset;
+    PY_LONG_LONG length;
+    file_digest_t * files;
+    char * path;
+    int algorithm;
+    int nfiles;
+    int i;
 
-    globus_result_t gridftp_result;
-    char msg[2048] = ""; 
+    char msg[2048] = "";
 
     // get Python arguments
-    if (!PyArg_ParseTuple(args, "OsOOO", 
-            &handleObj, 
-            &url, 
-            &OpAttrObj,
-            &completeCallbackFunctionObj,
-            &completeCallbackArgObj
-            )){
+    if (!PyArg_ParseTuple(args, "sO|k", &algorithmName, &rangesObj, &bufsize)){
         PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
         return NULL;
     }
- 
-    // get the bare pointers from the python objects
-    handlep = (globus_ftp_client_handle_t *) PyCObject_AsVoidPtr(handleObj);
-    operation_attrp = (globus_ftp_client_operationattr_t *) PyCObject_AsVoidPtr(OpAttrObj);
 
-    // create an exists callback struct to hold the callback information
-    callbackBucket = (exists_callback_bucket_t *) globus_malloc(sizeof(exists_callback_bucket_t));
-    callbackBucket -> pyfunction = completeCallbackFunctionObj;
-    callbackBucket -> pyarg = completeCallbackArgObj;
+    algorithm = stream_digest_algorithm(algorithmName);
+    if (algorithm < 0){
+        snprintf(msg, sizeof(msg), "gridftpwrapper: unsupported digest algorithm %s", algorithmName);
+        PyErr_SetString(PyExc_RuntimeError, msg);
+        return NULL;
+    }
 
-    // since we are holding pointers to these objects we need to increase
-    // the reference count for each
-    Py_XINCREF(callbackBucket -> pyfunction);
-    Py_XINCREF(callbackBucket -> pyarg);
+    if (!PyList_Check(rangesObj)){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: ranges must be a list");
+        return NULL;
+    }
 
-    // kick off the exists operation
+    nfiles = (int) PyList_Size(rangesObj);
+    files = (file_digest_t *) globus_malloc(sizeof(file_digest_t) * (nfiles > 0 ? nfiles : 1));
+    memset(files, 0, sizeof(file_digest_t) * (nfiles > 0 ? nfiles : 1));
+
+    // the paths stay owned by the strings in the list, which is held
+    // by the caller for the whole call
+    for (i = 0; i < nfiles; i++){
+        rangeObj = PyList_GetItem(rangesObj, i);
+        if (!PyArg_ParseTuple(rangeObj, "sLL", &path, &offset, &length)){
+            globus_libc_free(files);
+            PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: ranges must be (path, offset, length) tuples");
+            return NULL;
+        }
+        files[i].path = path;
+        files[i].offset = (long long) offset;
+        files[i].length = (long long) length;
+    }
 
     Py_BEGIN_ALLOW_THREADS
 
-    gridftp_result = globus_ftp_client_exists(
-		         handlep,
-                        url,
-                        operation_attrp,
-                        exists_complete_callback,
-                        (void *) callbackBucket
-                        );
+    cksm_file_digests(algorithm, files, nfiles, (size_t) bufsize);
 
     Py_END_ALLOW_THREADS
 
-    if (gridftp_result != GLOBUS_SUCCESS){
-        sprintf(msg, "gridftpwrapper: rc = %d: unable to start exists operation", gridftp_result);
-        PyErr_SetString(PyExc_RuntimeError, msg);
-        return NULL;
+    resultObj = PyList_New(nfiles);
+    for (i = 0; i < nfiles; i++){
+        if (files[i].error){
+            itemObj = Py_BuildValue("(zLs)", NULL, (PY_LONG_LONG) files[i].nbytes, strerror(files[i].error));
+        } else{
+            itemObj = Py_BuildValue("(sLz)", files[i].hex, (PY_LONG_LONG) files[i].nbytes, NULL);
+        }
+        PyList_SetItem(resultObj, i, itemObj);
     }
 
-    // return None to indicate success
-    Py_RETURN_NONE;
+    globus_libc_free(files);
 
+    return resultObj;
 }
 
+// return a dictionary mapping each digest algorithm to the name of the
+// kernel picked for it on this CPU
+PyObject * gridftp_cksm_kernels(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, "")){
+        PyErr_SetString(PyExc_RuntimeError, "gridftpwrapper: unable to parse arguments");
+        return NULL;
+    }
+
+    return Py_BuildValue("{s:s,s:s,s:s}",
+        "MD5", cksm_kernel_name(STREAM_DIGEST_MD5),
+        "ADLER32", cksm_kernel_name(STREAM_DIGEST_ADLER32),
+        "CRC32C", cksm_kernel_name(STREAM_DIGEST_CRC32C));
+}
 
 
 //
@@ -2773,11 +13058,42 @@ PyObject * gridftp_exists(PyObject *self, PyObject *args)
 static PyMethodDef gridftpwrappermethods[] = {
     {"gridftp_modules_activate", gridftp_modules_activate, METH_VARARGS},
     {"gridftp_modules_deactivate", gridftp_modules_deactivate, METH_VARARGS},
+    {"gridftp_third_party_transfer_sync", gridftp_third_party_transfer_sync, METH_VARARGS},
+    {"gridftp_cksm_sync", gridftp_cksm_sync, METH_VARARGS},
+    {"gridftp_cksm_feat", gridftp_cksm_feat, METH_VARARGS},
+    {"gridftp_cksm_probe", gridftp_cksm_probe, METH_VARARGS},
+    {"gridftp_exists_sync", gridftp_exists_sync, METH_VARARGS},
+    {"gridftp_mkdir_sync", gridftp_mkdir_sync, METH_VARARGS},
+    {"gridftp_rmdir_sync", gridftp_rmdir_sync, METH_VARARGS},
+    {"gridftp_delete_sync", gridftp_delete_sync, METH_VARARGS},
+    {"gridftp_move_sync", gridftp_move_sync, METH_VARARGS},
+    {"gridftp_chmod_sync", gridftp_chmod_sync, METH_VARARGS},
+    {"gridftp_machine_list_sync", gridftp_machine_list_sync, METH_VARARGS},
+    {"gridftp_mlst_sync", gridftp_mlst_sync, METH_VARARGS},
+    {"gridftp_listing_parse", gridftp_listing_parse, METH_VARARGS},
+    {"gridftp_restart_marker_init", gridftp_restart_marker_init, METH_VARARGS},
+    {"gridftp_restart_marker_to_string", gridftp_restart_marker_to_string, METH_VARARGS},
+    {"gridftp_restart_marker_insert_range", gridftp_restart_marker_insert_range, METH_VARARGS},
+    {"gridftp_restart_marker_get_total", gridftp_restart_marker_get_total, METH_VARARGS},
+    {"gridftp_restart_marker_plugin_init", gridftp_restart_marker_plugin_init, METH_VARARGS},
+    {"gridftp_restart_marker_plugin_destroy", gridftp_restart_marker_plugin_destroy, METH_VARARGS},
+    {"gridftp_stream_digest_init", gridftp_stream_digest_init, METH_VARARGS},
+    {"gridftp_stream_digest_result", gridftp_stream_digest_result, METH_VARARGS},
+    {"gridftp_stream_digest_update", gridftp_stream_digest_update, METH_VARARGS},
+    {"gridftp_stream_digest_finish", gridftp_stream_digest_finish, METH_VARARGS},
+    {"gridftp_file_digests", gridftp_file_digests, METH_VARARGS},
+    {"gridftp_cksm_kernels", gridftp_cksm_kernels, METH_VARARGS},
+    {"gridftp_completion_queue_init", gridftp_completion_queue_init, METH_VARARGS},
+    {"gridftp_completion_queue_drain", gridftp_completion_queue_drain, METH_VARARGS},
+    {"gridftp_completion_queue_fileno", gridftp_completion_queue_fileno, METH_VARARGS},
     {"gridftp_handleattr_init", gridftp_handleattr_init, METH_VARARGS},
     {"gridftp_handle_init", gridftp_handle_init, METH_VARARGS},
     {"gridftp_handleattr_destroy", gridftp_handleattr_destroy, METH_VARARGS},
     {"gridftp_handleattr_set_cache_all", gridftp_handleattr_set_cache_all, METH_VARARGS},
+    {"gridftp_handleattr_set_pipeline", gridftp_handleattr_set_pipeline, METH_VARARGS},
     {"gridftp_handle_destroy", gridftp_handle_destroy, METH_VARARGS},
+    {"gridftp_handle_cache_url_state", gridftp_handle_cache_url_state, METH_VARARGS},
+    {"gridftp_handle_flush_url_state", gridftp_handle_flush_url_state, METH_VARARGS},
     {"gridftp_operationattr_init", gridftp_operationattr_init, METH_VARARGS},
     {"gridftp_operationattr_destroy", gridftp_operationattr_destroy, METH_VARARGS},
     {"gridftp_operationattr_set_mode", gridftp_operationattr_set_mode, METH_VARARGS},
@@ -2793,6 +13109,7 @@ static PyMethodDef gridftpwrappermethods[] = {
     {"gridftp_tcpbuffer_set_mode", gridftp_tcpbuffer_set_mode, METH_VARARGS},
     {"gridftp_tcpbuffer_set_size", gridftp_tcpbuffer_set_size, METH_VARARGS},
     {"gridftp_third_party_transfer", gridftp_third_party_transfer, METH_VARARGS},
+    {"gridftp_third_party_transfer_pipelined", gridftp_third_party_transfer_pipelined, METH_VARARGS},
     {"gridftp_cksm", gridftp_cksm, METH_VARARGS},
     {"gridftp_mkdir", gridftp_mkdir, METH_VARARGS},
     {"gridftp_rmdir", gridftp_rmdir, METH_VARARGS},
@@ -2800,11 +13117,47 @@ static PyMethodDef gridftpwrappermethods[] = {
     {"gridftp_move", gridftp_move, METH_VARARGS},
     {"gridftp_chmod", gridftp_chmod, METH_VARARGS},
     {"gridftp_exists", gridftp_exists, METH_VARARGS},
+    {"gridftp_callback_oneshot", gridftp_callback_oneshot, METH_VARARGS},
     {"gridftp_get", gridftp_get, METH_VARARGS},
+    {"gridftp_partial_get", gridftp_partial_get, METH_VARARGS},
     {"gridftp_verbose_list", gridftp_verbose_list, METH_VARARGS},
+    {"gridftp_machine_list", gridftp_machine_list, METH_VARARGS},
     {"gridftp_register_read", gridftp_register_read, METH_VARARGS},
+    {"gridftp_register_read_ring", gridftp_register_read_ring, METH_VARARGS},
+    {"gridftp_put", gridftp_put, METH_VARARGS},
+    {"gridftp_register_write", gridftp_register_write, METH_VARARGS},
+    {"gridftp_get_to_file", gridftp_get_to_file, METH_VARARGS},
+    {"gridftp_striped_get", gridftp_striped_get, METH_VARARGS},
+    {"gridftp_striped_get_status", gridftp_striped_get_status, METH_VARARGS},
+    {"gridftp_striped_get_abort", gridftp_striped_get_abort, METH_VARARGS},
+    {"gridftp_striped_get_destroy", gridftp_striped_get_destroy, METH_VARARGS},
+    {"gridftp_handle_pool_init", gridftp_handle_pool_init, METH_VARARGS},
+    {"gridftp_handle_pool_lease", gridftp_handle_pool_lease, METH_VARARGS},
+    {"gridftp_handle_pool_release", gridftp_handle_pool_release, METH_VARARGS},
+    {"gridftp_handle_pool_prewarm", gridftp_handle_pool_prewarm, METH_VARARGS},
+    {"gridftp_handle_pool_metadata_many", gridftp_handle_pool_metadata_many, METH_VARARGS},
+    {"gridftp_handle_pool_cksm_many", gridftp_handle_pool_cksm_many, METH_VARARGS},
+    {"gridftp_handle_pool_makedirs", gridftp_handle_pool_makedirs, METH_VARARGS},
+    {"gridftp_handle_pool_forget_dirs", gridftp_handle_pool_forget_dirs, METH_VARARGS},
+    {"gridftp_handle_pool_remember_dirs", gridftp_handle_pool_remember_dirs, METH_VARARGS},
+    {"gridftp_handle_pool_known_dirs", gridftp_handle_pool_known_dirs, METH_VARARGS},
+    {"gridftp_handle_pool_trim", gridftp_handle_pool_trim, METH_VARARGS},
+    {"gridftp_handle_pool_stats", gridftp_handle_pool_stats, METH_VARARGS},
+    {"gridftp_handle_pool_destroy", gridftp_handle_pool_destroy, METH_VARARGS},
+    {"gridftp_transfer_queue_init", gridftp_transfer_queue_init, METH_VARARGS},
+    {"gridftp_transfer_queue_set_policy", gridftp_transfer_queue_set_policy, METH_VARARGS},
+    {"gridftp_transfer_queue_submit", gridftp_transfer_queue_submit, METH_VARARGS},
+    {"gridftp_transfer_queue_stats", gridftp_transfer_queue_stats, METH_VARARGS},
+    {"gridftp_transfer_queue_destroy", gridftp_transfer_queue_destroy, METH_VARARGS},
+    {"gridftp_walker_init", gridftp_walker_init, METH_VARARGS},
+    {"gridftp_walker_next", gridftp_walker_next, METH_VARARGS},
+    {"gridftp_walker_stats", gridftp_walker_stats, METH_VARARGS},
+    {"gridftp_walker_destroy", gridftp_walker_destroy, METH_VARARGS},
     {"gridftp_create_buffer", gridftp_create_buffer, METH_VARARGS},
     {"gridftp_destroy_buffer", gridftp_destroy_buffer, METH_VARARGS},
+    {"gridftp_buffer_pool_configure", gridftp_buffer_pool_configure, METH_VARARGS},
+    {"gridftp_buffer_pool_trim", gridftp_buffer_pool_trim, METH_VARARGS},
+    {"gridftp_buffer_pool_stats", gridftp_buffer_pool_stats, METH_VARARGS},
     {"gridftp_buffer_to_string", gridftp_buffer_to_string, METH_VARARGS},
     {"gridftp_abort", gridftp_abort, METH_VARARGS},
     {"gridftp_perf_plugin_init", gridftp_perf_plugin_init, METH_VARARGS},
@@ -2838,6 +13191,10 @@ void initgridftpwrapper(){
     // initialize the necessary Globus modules
     gridftp_modules_activate(NULL, NULL);
 
+    // set up the buffer pool now that Globus threads are available
+    buffer_pool_init();
+    globus_mutex_init(&(pipeline_registry.mutex), NULL);
+
     // get handle to the module dictionary
     module = Py_InitModule("gridftpwrapper", gridftpwrappermethods);
     moduleDict = PyModule_GetDict(module);
@@ -2847,4 +13204,27 @@ void initgridftpwrapper(){
     PyDict_SetItemString(moduleDict, "GLOBUS_FTP_CONTROL_PARALLELISM_FIXED", Py_BuildValue("i", (int) GLOBUS_FTP_CONTROL_PARALLELISM_FIXED));
     PyDict_SetItemString(moduleDict, "GLOBUS_FTP_CONTROL_TCPBUFFER_FIXED", Py_BuildValue("i", (int) GLOBUS_FTP_CONTROL_TCPBUFFER_FIXED));
 
+    // kinds of events drained from a completion queue
+    PyDict_SetItemString(moduleDict, "COMPLETION_THIRD_PARTY", Py_BuildValue("i", COMPLETION_THIRD_PARTY));
+    PyDict_SetItemString(moduleDict, "COMPLETION_CKSM", Py_BuildValue("i", COMPLETION_CKSM));
+    PyDict_SetItemString(moduleDict, "COMPLETION_MKDIR", Py_BuildValue("i", COMPLETION_MKDIR));
+    PyDict_SetItemString(moduleDict, "COMPLETION_RMDIR", Py_BuildValue("i", COMPLETION_RMDIR));
+    PyDict_SetItemString(moduleDict, "COMPLETION_DELETE", Py_BuildValue("i", COMPLETION_DELETE));
+    PyDict_SetItemString(moduleDict, "COMPLETION_MOVE", Py_BuildValue("i", COMPLETION_MOVE));
+    PyDict_SetItemString(moduleDict, "COMPLETION_CHMOD", Py_BuildValue("i", COMPLETION_CHMOD));
+    PyDict_SetItemString(moduleDict, "COMPLETION_GET", Py_BuildValue("i", COMPLETION_GET));
+    PyDict_SetItemString(moduleDict, "COMPLETION_GET_DATA", Py_BuildValue("i", COMPLETION_GET_DATA));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PUT", Py_BuildValue("i", COMPLETION_PUT));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PUT_DATA", Py_BuildValue("i", COMPLETION_PUT_DATA));
+    PyDict_SetItemString(moduleDict, "COMPLETION_GET_TO_FILE", Py_BuildValue("i", COMPLETION_GET_TO_FILE));
+    PyDict_SetItemString(moduleDict, "COMPLETION_EXISTS", Py_BuildValue("i", COMPLETION_EXISTS));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PERF_BEGIN", Py_BuildValue("i", COMPLETION_PERF_BEGIN));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PERF_MARKER", Py_BuildValue("i", COMPLETION_PERF_MARKER));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PERF_COMPLETE", Py_BuildValue("i", COMPLETION_PERF_COMPLETE));
+    PyDict_SetItemString(moduleDict, "COMPLETION_STRIPED_GET", Py_BuildValue("i", COMPLETION_STRIPED_GET));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PREWARM", Py_BuildValue("i", COMPLETION_PREWARM));
+    PyDict_SetItemString(moduleDict, "COMPLETION_PIPELINED", Py_BuildValue("i", COMPLETION_PIPELINED));
+    PyDict_SetItemString(moduleDict, "COMPLETION_TRANSFER", Py_BuildValue("i", COMPLETION_TRANSFER));
+    PyDict_SetItemString(moduleDict, "TRANSFER_PRIORITIES", Py_BuildValue("i", TRANSFER_QUEUE_NPRIORITIES));
+
 }
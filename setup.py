@@ -31,7 +31,8 @@ else:
 
 e = Extension(
         "gridftpwrapper",
-        ["gridftpwrapper.c"],
+        ["gridftpwrapper.c", "gridftpcksm.c"],
+        depends=["gridftpcksm.h"],
         include_dirs=my_include_dirs,
         extra_compile_args=["-O1", "-Wno-strict-prototypes", "-D_FORTIFY_SOURCE=2", "-fstack-protector"],
         extra_link_args=linkFlags
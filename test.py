@@ -284,6 +284,181 @@ try:
         exists_event.wait()
         exists_event.clear()
         print f, bool(exists_arg[0])
+
+    put_event = Event()
+    def put_cb(arg, handle, error):
+        if error is not None:
+            print "put error: %s" % error
+        put_event.set()
+
+    payload = bytearray('python-gridftp put test\n' * 4096)
+    put_dst = 'gsiftp://%s:%d%s' % (getfqdn(), gridftp_server.port,
+                                    join(gridftp_server.basedir, 'put_test'))
+    cli.put(put_dst, put_cb, None, op)
+    half = len(payload) / 2
+    cli.register_write(buffer(payload, 0, half), None, None, 0, False)
+    cli.register_write(buffer(payload, half), None, None, half, True)
+    put_event.wait()
+    print put_dst, getsize(join(gridftp_server.basedir, 'put_test')) == len(payload)
+
+    # fetch just the first line back with a partial get
+    get_event = Event()
+    def get_cb(arg, handle, error):
+        if error is not None:
+            print "partial get error: %s" % error
+        get_event.set()
+
+    head = []
+    def head_cb(arg, handle, error, buf, length, offset, eof):
+        head.append((offset, str(buf[:length])))
+        if not eof:
+            cli.register_read(arg, head_cb, arg)
+
+    line = len('python-gridftp put test\n')
+    head_buf = Buffer(64)
+    cli.partial_get(put_dst, 0, line, get_cb, None, op)
+    cli.register_read(head_buf, head_cb, head_buf)
+    get_event.wait()
+    head_buf.destroy()
+    print put_dst, ''.join(d for o, d in sorted(head)) == str(payload[:line])
+
+    # read the whole file back through a ring of small buffers, once
+    # with the data copied out and once with views of the ring buffers
+    for copy_mode in (True, False):
+        ring_event = Event()
+        def ring_done_cb(arg, handle, error):
+            if error is not None:
+                print "ring get error: %s" % error
+            ring_event.set()
+
+        blocks = {}
+        def ring_cb(arg, handle, error, buf, length, offset, eof):
+            if length:
+                arg[offset] = str(buf[:length])
+
+        cli.get(put_dst, ring_done_cb, None, op)
+        cli.register_read_ring(4, 4096, ring_cb, blocks, copy_mode)
+        ring_event.wait()
+        data = ''.join(blocks[o] for o in sorted(blocks))
+        print put_dst, 'ring copy=%s' % copy_mode, data == str(payload)
+
+    # resume a get into a local file that already holds the first half
+    resume_event = Event()
+    def resume_cb(arg, handle, error, nbytes):
+        if error is not None:
+            print "resume error: %s" % error
+        arg.append(nbytes)
+        resume_event.set()
+
+    resume_path = join(gridftp_server.basedir, 'resume_test')
+    with open(resume_path, 'wb') as f:
+        f.write(str(payload[:half]))
+    marker = RestartMarker()
+    marker.insert_range(0, half)
+    resumed = []
+    cli.get_to_file(put_dst, resume_path, resume_cb, resumed, op, marker = marker)
+    resume_event.wait()
+    resume_event.clear()
+    with open(resume_path, 'rb') as f:
+        print put_dst, 'resumed', resumed == [len(payload) - half], \
+            marker.total() == len(payload), f.read() == str(payload)
+
+    # a marker dropped while a get is still recording into it stays
+    # alive until the get is done with it
+    unlink(resume_path)
+    marker = RestartMarker()
+    resumed = []
+    cli.get_to_file(put_dst, resume_path, resume_cb, resumed, op, marker = marker)
+    marker.destroy()
+    del marker
+    resume_event.wait()
+    print put_dst, 'marker dropped', resumed == [len(payload)], \
+        getsize(resume_path) == len(payload)
+
+    # fetch the file over several handles in small ranges; in stream mode
+    # the data arrives in order, so streams that run dry split the ranges
+    # of the others while their blocks are still being written
+    stream_op = OperationAttr()
+    for mode, attr in (('eblock', op), ('stream', stream_op)):
+        striped_event = Event()
+        striped = []
+        def striped_cb(arg, handle, error, nbytes):
+            if error is not None:
+                print "striped get error: %s" % error
+            arg.append(nbytes)
+            striped_event.set()
+
+        striped_path = join(gridftp_server.basedir, 'striped_test_%s' % mode)
+        sg = StripedGet(hattr, put_dst, striped_path, striped_cb, striped,
+                        attr, streams = 4, nbuffers = 2, bufsize = 2048,
+                        minChunk = 4096)
+        striped_event.wait()
+        sg.destroy()
+        with open(striped_path, 'rb') as f:
+            print put_dst, 'striped %s' % mode, striped == [len(payload)], \
+                f.read() == str(payload)
+    stream_op.destroy()
+
+    # third party transfers from a queue that runs one at a time start
+    # by priority class, and in submission order within a class
+    url = lambda path: 'gsiftp://%s:%d%s' % (getfqdn(), gridftp_server.port,
+                                             join(gridftp_server.basedir, path))
+    for i in range(6):
+        with open(join(gridftp_server.basedir, 'tq_src_%d' % i), 'wb') as f:
+            f.write('transfer queue job %d\n' % i * (i + 1))
+
+    pool = HandlePool(hattr, maxPerHost = 2)
+    events = CompletionQueue()
+    tq = TransferQueue(pool, events, maxActive = 1, maxPerPair = 1)
+    priorities = [2, 1, 0, 2, 0, 1]
+    tq.submit([(url('tq_src_%d' % i), url('tq_dst_%d' % i), priorities[i], i)
+               for i in range(6)])
+    order = []
+    while len(order) < 6:
+        for kind, (i, src, dst, error) in events.drain(timeout = 30):
+            if error is not None:
+                print "transfer queue error: %s" % error
+            order.append(i)
+    tq.destroy()
+    copied = all(open(join(gridftp_server.basedir, 'tq_dst_%d' % i), 'rb').read() ==
+                 open(join(gridftp_server.basedir, 'tq_src_%d' % i), 'rb').read()
+                 for i in range(6))
+    print 'transfer queue order', order == [2, 4, 1, 5, 0, 3], copied
+
+    # destroying the queue drops the jobs that have not started, without
+    # reporting them, and the running one still completes
+    tq = TransferQueue(pool, events, maxActive = 1, maxPerPair = 1)
+    tq.submit([(url('tq_src_%d' % i), url('tq_cancel_%d' % i), 0, i)
+               for i in range(6)])
+    ndropped = tq.destroy()
+    reported = [i for kind, (i, src, dst, error) in events.drain(timeout = 0)]
+    landed = [i for i in range(6)
+              if isfile(join(gridftp_server.basedir, 'tq_cancel_%d' % i))]
+    print 'transfer queue cancel', ndropped + len(reported) == 6, \
+        ndropped > 0, landed == sorted(reported)
+
+    # walk a small tree, including a name that has to be percent-encoded
+    # in the URL it is listed by
+    walk_root = join(gridftp_server.basedir, 'walk_test')
+    for d in ('a/deep', 'b', 'sub dir'):
+        makedirs(join(walk_root, d))
+    for path, size in (('top', 3), ('a/one', 5), ('a/deep/two', 7), ('sub dir/three', 11)):
+        with open(join(walk_root, path), 'wb') as f:
+            f.write('x' * size)
+
+    walked = {}
+    for dirUrl, listing, error in pool.walk(url('walk_test')):
+        if error is not None:
+            print "walk error: %s" % error
+        walked[dirUrl[len(url('walk_test')):]] = sorted(zip(listing.names, listing.sizes))
+    print 'walk dirs', sorted(walked) == ['', '/a', '/a/deep', '/b', '/sub%20dir']
+    print 'walk entries', walked[''][-1] == ('top', 3), \
+        ('one', 5) in walked['/a'], walked['/a/deep'] == [('two', 7)], \
+        walked['/b'] == [], walked['/sub%20dir'] == [('three', 11)]
+
+    shallow = [dirUrl for dirUrl, listing, error in pool.walk(url('walk_test'), maxDepth = 0)]
+    print 'walk depth 0', shallow == [url('walk_test')]
+    pool.destroy()
         
 finally:
     op.destroy()
@@ -0,0 +1,351 @@
+'''
+checks of the parts of gridftpClient that need no server; prints one
+line per check and exits with 1 if any of them failed
+'''
+from gridftpClient import *
+import gridftpClient
+from threading import Event
+from time import sleep
+import hashlib
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import zlib
+
+failed = []
+def check(name, ok):
+    print name, bool(ok)
+    if not ok:
+        failed.append(name)
+
+# MetadataCache
+url = 'gsiftp://host:2811/data/dir'
+cache = MetadataCache(ttl = 0.5, negativeTtl = 0.2)
+
+cache.set(url, 'stat', 'facts')
+check('cache fact', cache.get(url, 'stat') == (True, 'facts'))
+check('cache fact implies exists', cache.get(url, 'exists') == (True, True))
+check('cache trailing slash', cache.get(url + '//', 'stat') == (True, 'facts'))
+check('cache other fact', cache.get(url, 'cksm') == (False, None))
+sleep(0.6)
+check('cache ttl', cache.get(url, 'stat') == (False, None))
+
+cache.set(url, 'stat', 'facts')
+cache.set(url, 'exists', False, True)
+check('cache negative', cache.get(url, 'exists') == (True, False))
+check('cache negative drops facts', cache.get(url, 'stat') == (False, None))
+sleep(0.3)
+check('cache negative ttl', cache.get(url, 'exists') == (False, None))
+
+cache.set(url, 'exists', True)
+cache.set(url + '/a', 'exists', True)
+cache.set(url + '/a/b', 'stat', 'facts')
+cache.set(url + 'x', 'exists', True)
+check('cache invalidate', cache.invalidate(url + '/a/b') == 1)
+check('cache invalidated', cache.get(url + '/a/b', 'stat') == (False, None))
+check('cache invalidate recursive', cache.invalidate(url, True) == 2)
+check('cache invalidate keeps sibling', cache.get(url + 'x', 'exists') == (True, True))
+
+# the same path named the ways a HandlePool takes as the same host
+cache.set('gsiftp://Host:2811/data//dir/', 'stat', 'same')
+check('cache key host case and default port', cache.get('gsiftp://host/data/dir', 'stat') == (True, 'same'))
+check('cache key user information', cache.get('gsiftp://user@host/data/dir', 'stat') == (False, None))
+check('cache key other port', cache.get('gsiftp://host:2812/data/dir', 'stat') == (False, None))
+cache.set('ftp://HOST:21', 'exists', True)
+check('cache key ftp default port and root', cache.get('ftp://host//', 'exists') == (True, True))
+check('cache invalidate normalized', cache.invalidate('GSIFTP://host:2811/data', True) == 2)
+check('cache invalidated normalized', cache.get(url + 'x', 'exists') == (False, None))
+
+nottl = MetadataCache(ttl = 0, negativeTtl = 10)
+nottl.set(url, 'exists', True)
+nottl.set(url + '/gone', 'exists', False, True)
+check('cache ttl 0', nottl.get(url, 'exists') == (False, None))
+check('cache ttl 0 negative', nottl.get(url + '/gone', 'exists') == (True, False))
+
+small = MetadataCache(ttl = 10, maxEntries = 2)
+for i in range(3):
+    small.set('%s/%d' % (url, i), 'exists', True)
+check('cache max entries', small.stats()['entries'] <= 2)
+
+# Listing parser, fed whole and in pieces that cut lines and facts
+lines = ('type=file;size=123;modify=20240102030405;UNIX.mode=0644; a b\r\n'
+         'type=cdir;modify=20240102030405.5; .\r\n'
+         'type=dir;modify=20240102030405.123; d\r\n'
+         'type=OS.unix=slink:/x;size=9; l\r\n')
+for blocksize in (0, 1, 7):
+    listing = Listing.parse(lines, False, blocksize)
+    check('listing parse blocksize %d' % blocksize,
+          listing.names == ['a b', '.', 'd', 'l'] and listing.types == 'fcdl' and
+          list(listing.sizes) == [123, -1, -1, 9] and
+          list(listing.mtimes) == [1704164645] * 3 + [-1] and
+          list(listing.modes) == [0644, -1, -1, -1])
+check('listing parse skip dots', Listing.parse(lines, True).names == ['a b', 'd', 'l'])
+
+# a last line with no name is no entry, even cut off in the middle of
+# a number with nothing after it in the buffer
+for blocksize in (0, 3):
+    listing = Listing.parse('type=file;size=5; x\r\nsize=123', False, blocksize)
+    check('listing trailing facts without name %d' % blocksize, listing.names == ['x'])
+check('listing trailing size only', len(Listing.parse('size=123')) == 0)
+check('listing last line unterminated', Listing.parse('type=file;size=7; last', False, 3)[0].size == 7)
+
+# malformed values leave the fact out rather than giving a wrong one
+bad = Listing.parse('type=file;size=12x; a\r\n'
+                    'type=file;size=-1; b\r\n'
+                    'type=file;size=99999999999999999999999; c\r\n'
+                    'type=file;modify=2024010203040; d\r\n'
+                    'type=file;modify=2024010203040x; e\r\n'
+                    'type=file;modify=20241302030405; f\r\n'
+                    'type=file;UNIX.mode=0899; g\r\n', False, 5)
+check('listing malformed facts', bad.names == list('abcdefg') and
+      list(bad.sizes) == [-1] * 7 and list(bad.mtimes) == [-1] * 7 and
+      list(bad.modes) == [-1] * 7)
+
+# HandlePool; leasing creates handles without connecting anywhere
+hattr = HandleAttr()
+pool = HandlePool(hattr, maxPerHost = 2)
+try:
+    a = pool.lease('gsiftp://Data.Example.ORG:2811/a//x', False)
+    b = pool.lease('gsiftp://user@data.example.org/b/', False)
+    c = pool.lease('gsiftp://data.example.org:2812/', False)
+    d = pool.lease('ftp://DATA.example.org/c', False)
+    check('pool key host case and default port',
+          pool.stats().get('data.example.org:2811') == (0, 2))
+    check('pool key other port', pool.stats().get('data.example.org:2812') == (0, 1))
+    check('pool key ftp default port', pool.stats().get('data.example.org:21') == (0, 1))
+    check('pool at max per host', pool.lease('gsiftp://data.example.org/', False) is None)
+
+    handle = a._handle
+    pool.release(a)
+    check('pool release', pool.stats().get('data.example.org:2811') == (1, 1))
+    try:
+        pool.release(a)
+        check('pool double release rejected', False)
+    except GridFTPClientException:
+        check('pool double release rejected', True)
+
+    # a stale copy of the handle is refused by the wrapper itself
+    stale = FTPClient.__new__(FTPClient)
+    stale._handle = handle
+    try:
+        pool.release(stale)
+        check('pool stale release rejected', False)
+    except GridFTPClientException:
+        check('pool stale release rejected', True)
+    check('pool stale release kept counts',
+          pool.stats().get('data.example.org:2811') == (1, 1))
+
+    e = pool.lease('gsiftp://data.example.org/', False)
+    check('pool reuses idle handle', e._handle is not None and
+          pool.stats().get('data.example.org:2811') == (0, 2))
+    for client in (b, c, d, e):
+        pool.release(client)
+
+    # the directory cache spells each directory one way
+    host = 'gsiftp://data.example.org'
+    check('dirs remember', pool.remember_dirs([
+        'gsiftp://Data.Example.ORG/a//b/', host + ':2811/a/b', host + '/a/b/c',
+        host + '/a/bc', host + ':2812/a']) == 4)
+    check('dirs normalized', pool.known_dirs() == [
+        host + ':2811/a/b', host + ':2811/a/b/c', host + ':2811/a/bc', host + ':2812/a'])
+    check('dirs forget subtree', pool.forget_dirs('GSIFTP://DATA.example.org/a/b/') == 2)
+    check('dirs forget keeps siblings', pool.known_dirs() == [
+        host + ':2811/a/bc', host + ':2812/a'])
+    check('dirs forget all', pool.forget_dirs() == 2 and pool.known_dirs() == [])
+
+    # removing or moving a directory through the pool forgets it, even
+    # when the server cannot be reached to do it
+    dead = 'gsiftp://127.0.0.1:1'
+    pool.remember_dirs([dead + '/r/x', dead + '/m/x', dead + '/d', dead + '/keep'])
+    check('dirs rmdir_many fails', list(pool.rmdir_many([dead + '/r'])) == [-1])
+    check('dirs rmdir_many forgets', dead + '/r/x' not in pool.known_dirs())
+    pool.move_many([(dead + '/m', dead + '/n')])
+    check('dirs move_many forgets', dead + '/m/x' not in pool.known_dirs())
+    pool.delete_many([dead + '/d'])
+    check('dirs delete_many forgets', dead + '/d' not in pool.known_dirs())
+    check('dirs others kept', pool.known_dirs() == [dead + '/keep'])
+
+    # a batch that can lease no handle for its host, all of them held
+    # by the caller, gives up after its timeout
+    held = [pool.lease(dead + '/', False) for i in range(2)]
+    codes = pool.exists_many([dead + '/x', dead + '/y'], timeout = 1)
+    check('pool batch acquire timed out', list(codes) == [HANDLE_ACQUIRE_TIMED_OUT] * 2)
+    check('pool batch timeout error', batch_error(codes[0]) == 'handle acquire timed out')
+    check('pool batch unreachable error', batch_error(-1) != batch_error(codes[0]))
+    for client in held:
+        pool.release(client)
+
+    # so does a leased client, as soon as it starts the rmdir
+    pool.remember_dirs([dead + '/keep/x'])
+    client = pool.lease(dead + '/', False)
+    done = Event()
+    def rmdir_cb(arg, handle, error):
+        done.set()
+    opattr = OperationAttr()
+    client.rmdir(dead + '/keep', rmdir_cb, None, opattr)
+    check('dirs leased rmdir forgets', pool.known_dirs() == [])
+    done.wait(30)
+    pool.release(client, True)
+    opattr.destroy()
+finally:
+    pool.destroy()
+    hattr.destroy()
+
+# checksum kernels, against hashlib, zlib and a table CRC32C
+crc32cTable = []
+for i in range(256):
+    c = i
+    for k in range(8):
+        c = (c >> 1) ^ (0x82f63b78 if c & 1 else 0)
+    crc32cTable.append(c)
+
+def crc32c(data):
+    c = 0xffffffff
+    for ch in data:
+        c = crc32cTable[(c ^ ord(ch)) & 0xff] ^ (c >> 8)
+    return c ^ 0xffffffff
+
+def reference(algorithm, data):
+    if algorithm == 'MD5':
+        return hashlib.md5(data).hexdigest()
+    if algorithm == 'ADLER32':
+        return '%08x' % (zlib.adler32(data) & 0xffffffff)
+    return '%08x' % crc32c(data)
+
+kernels = cksm_kernels()
+print 'kernels', kernels
+check('cksm crc32c reference', crc32c('123456789') == 0xe3069283)
+
+# lengths around the vector widths, the Adler-32 NMAX of 5552 and the
+# file read size, at offsets that leave the data unaligned
+random.seed(4)
+data = ''.join([chr(random.randrange(256)) for i in range(300000)])
+lengths = [0, 1, 3, 15, 16, 17, 31, 32, 33, 55, 56, 63, 64, 65, 127, 129,
+           1000, 5551, 5552, 5553, 11105, 65537, 131071]
+fd, path = tempfile.mkstemp()
+os.write(fd, data)
+os.close(fd)
+try:
+    for algorithm in ('MD5', 'ADLER32', 'CRC32C'):
+        ranges = [(path, (i * 7) % 61, n) for i, n in enumerate(lengths)]
+        expected = [reference(algorithm, data[o:o + n]) for p, o, n in ranges]
+        for bufsize in (4097, 1048576):
+            result = file_digests(ranges, algorithm, bufsize)
+            check('cksm %s file ranges bufsize %d' % (algorithm, bufsize),
+                  [r[0] for r in result] == expected and
+                  [r[1] for r in result] == lengths)
+        check('cksm %s whole file' % algorithm,
+              file_digest(path, algorithm) == reference(algorithm, data))
+        check('cksm %s past the end' % algorithm,
+              file_digests([(path, len(data) - 5, 100)], algorithm)[0][:2] ==
+              (reference(algorithm, data[-5:]), 5))
+
+        # blocks of odd sizes fed in order, reversed and shuffled, from
+        # an unaligned start
+        start = 13
+        expected = reference(algorithm, data[start:start + 200000])
+        blocks = []
+        offset = start
+        while offset < start + 200000:
+            n = min(random.choice(lengths[1:]), start + 200000 - offset)
+            blocks.append((offset, data[offset:offset + n]))
+            offset += n
+        shuffled = blocks[:]
+        random.shuffle(shuffled)
+        for order, feed in (('in order', blocks), ('reversed', blocks[::-1]),
+                            ('shuffled', shuffled)):
+            digest = StreamDigest(algorithm, start)
+            for offset, block in feed:
+                digest.update(offset, block)
+            digest.finish()
+            check('cksm %s stream %s' % (algorithm, order),
+                  digest.result() == (expected, 200000, None))
+
+        digest = StreamDigest(algorithm, start)
+        digest.update(start, blocks[0][1])
+        digest.update(blocks[2][0], blocks[2][1])
+        digest.finish()
+        check('cksm %s stream gap fails' % algorithm,
+              digest.hexdigest() is None and digest.result()[2] is not None)
+finally:
+    os.unlink(path)
+
+# checksum comparison and algorithm choice
+check('cksm equal 32 bit leading zeros', gridftpClient._cksm_equal('ADLER32', '0001abcd', '1ABCD '))
+check('cksm equal md5 case', gridftpClient._cksm_equal('md5', 'D41D8CD98F00B204E9800998ECF8427E', 'd41d8cd98f00b204e9800998ecf8427e'))
+check('cksm equal md5 leading zeros count', not gridftpClient._cksm_equal('MD5', '0abc', 'abc'))
+check('cksm equal missing', not gridftpClient._cksm_equal('ADLER32', None, '0'))
+check('cksm equal not hex', not gridftpClient._cksm_equal('CRC32C', 'xyz', 'xyz'))
+check('cksm choose cheapest', choose_cksm_algorithm(['MD5', 'adler32', 'SHA1']) == 'adler32')
+check('cksm choose accepted', choose_cksm_algorithm(['MD5', 'ADLER32'], ['md5', 'sha1']) == 'MD5')
+check('cksm choose none shared', choose_cksm_algorithm(['MD5'], ['SHA1']) is None)
+check('cksm choose unknown last', choose_cksm_algorithm(['FOO', 'SHA512', 'BAR']) == 'SHA512')
+check('cksm choose unknown in order', choose_cksm_algorithm(['FOO', 'BAR']) == 'FOO')
+
+# verify_ranges against canned server replies: the chunks, which differ
+# and which could not be checked
+check('ranges split', gridftpClient._split_ranges(9500, 1000)[-2:] == [(8000, 1000), (9000, 500)] and
+      len(gridftpClient._split_ranges(9500, 1000)) == 10)
+check('ranges split exact', gridftpClient._split_ranges(8, 4) == [(0, 4), (4, 4)])
+check('ranges split empty', gridftpClient._split_ranges(0, 4) == [])
+check('ranges merge', gridftpClient._merge_ranges([(0, 4), (4, 4), (12, 4), (16, 2), (20, 1)]) ==
+      [(0, 8), (12, 6), (20, 1)])
+
+class CannedServer(object):
+    def __init__(self, size, replies):
+        self.size = size
+        self.replies = replies
+    def lease(self, url):
+        return self
+    def release(self, client):
+        pass
+    def mlst_sync(self, url, opAttr):
+        return self
+    def cksm_many(self, items, algorithm, window, opAttr, timeout):
+        self.items = items
+        return self.replies
+
+local = ''.join([chr(random.randrange(256)) for i in range(9500)])
+fd, path = tempfile.mkstemp()
+os.write(fd, local)
+os.close(fd)
+try:
+    replies = [(hashlib.md5(local[o:o + 1000]).hexdigest(), 0) for o in range(0, 9500, 1000)]
+    replies[2] = replies[3] = ('0' * 32, 0)
+    replies[5] = (None, 550)
+    replies[7] = (None, -1)
+    replies[8] = (None, 421)
+    server = CannedServer(9500, replies)
+    result = HandlePool.verify_ranges.im_func(server, 'gsiftp://host/f', path, 1000)
+    check('verify ranges split', server.items[-1] == ('gsiftp://host/f', 9000, 500))
+    check('verify ranges mismatched', result[0] == [(2000, 2000), (5000, 1000)])
+    check('verify ranges unverified', result[1] == [(7000, 2000)])
+
+    server = CannedServer(9500, [(hashlib.md5(local[o:o + 1000]).hexdigest(), 0) for o in range(0, 9500, 1000)])
+    check('verify ranges match', HandlePool.verify_ranges.im_func(server, 'gsiftp://host/f', path, 1000) == ([], []))
+
+    # the remote file runs past the local copy
+    server = CannedServer(10500, server.replies + [('0' * 32, 0)])
+    check('verify ranges short local copy',
+          HandlePool.verify_ranges.im_func(server, 'gsiftp://host/f', path, 1000) == ([(9000, 1500)], []))
+finally:
+    os.unlink(path)
+
+# each slower kernel, picked by hiding CPU features from a child
+if 'GRIDFTP_CKSM_DISABLE' not in os.environ:
+    for disable in ('avx2', 'avx2,ssse3,sse4.2'):
+        env = dict(os.environ)
+        env['GRIDFTP_CKSM_DISABLE'] = disable
+        print 'GRIDFTP_CKSM_DISABLE=%s' % disable
+        sys.stdout.flush()
+        check('cksm kernels without %s' % disable,
+              subprocess.call([sys.executable, sys.argv[0]], env = env) == 0)
+elif os.environ['GRIDFTP_CKSM_DISABLE'] == 'avx2,ssse3,sse4.2':
+    check('cksm generic kernels', kernels['ADLER32'] == 'generic' and
+          kernels['CRC32C'] == 'slicing-by-8' and
+          kernels['MD5'] == 'multi-buffer x4')
+
+if failed:
+    sys.exit(1)